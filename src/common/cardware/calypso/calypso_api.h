@@ -100,6 +100,8 @@ CALYPSO_PROC CalypsoCardSelectEF(P_CALYPSO_CTX ctx, WORD file_id, BYTE resp[], C
 CALYPSO_PROC CalypsoCardReadBinary(P_CALYPSO_CTX ctx, BYTE sfi, WORD offset, BYTE ask_size, BYTE data[], CALYPSO_SZ* datasize);
 CALYPSO_PROC CalypsoCardUpdateBinary(P_CALYPSO_CTX ctx, BYTE sfi, WORD offset, const BYTE data[], BYTE length);
 CALYPSO_PROC CalypsoCardReadRecord(P_CALYPSO_CTX ctx, BYTE sfi, BYTE rec_no, BYTE rec_size, BYTE data[], CALYPSO_SZ* datasize);
+CALYPSO_PROC CalypsoCardReadRecords(P_CALYPSO_CTX ctx, BYTE sfi, BYTE rec_no, BYTE ask_size, BYTE data[], CALYPSO_SZ* datasize);
+CALYPSO_LIB BOOL CALYPSO_API CalypsoCardNextRecord(const BYTE data[], CALYPSO_SZ datasize, CALYPSO_SZ* offset, BYTE* rec_no, const BYTE** record, BYTE* rec_size);
 CALYPSO_PROC CalypsoCardAppendRecord(P_CALYPSO_CTX ctx, BYTE sfi, const BYTE data[], BYTE datasize);
 CALYPSO_PROC CalypsoCardUpdateRecord(P_CALYPSO_CTX ctx, BYTE sfi, BYTE rec_no, const BYTE data[], BYTE datasize);
 CALYPSO_PROC CalypsoCardWriteRecord(P_CALYPSO_CTX ctx, BYTE sfi, BYTE rec_no, const BYTE data[], BYTE datasize);
@@ -126,6 +128,7 @@ CALYPSO_PROC CalypsoCardChangePinCipher(P_CALYPSO_CTX ctx, const BYTE new_pin[4]
 
 CALYPSO_PROC CalypsoCardActivate(P_CALYPSO_CTX ctx, const BYTE aid[], CALYPSO_SZ aidsize);
 CALYPSO_PROC CalypsoCardActivateHex(P_CALYPSO_CTX ctx, const char* aid);
+CALYPSO_PROC CalypsoCardSetProfileCache(P_CALYPSO_CTX ctx, BOOL enable);
 CALYPSO_PROC CalypsoCardDispose(P_CALYPSO_CTX ctx);
 
 CALYPSO_PROC CalypsoCardSerialNumber(P_CALYPSO_CTX ctx, BYTE card_uid[8]);
@@ -140,9 +143,12 @@ CALYPSO_PROC CalypsoCardSessionModifsMax(P_CALYPSO_CTX ctx);
 
 CALYPSO_PROC CalypsoSamSelectDiversifier(P_CALYPSO_CTX ctx, const BYTE card_uid[8]);
 CALYPSO_PROC CalypsoSamGetChallenge(P_CALYPSO_CTX ctx, BYTE sam_chal[4]);
+CALYPSO_PROC CalypsoSamSetChallengePrefetch(P_CALYPSO_CTX ctx, BOOL enable);
+CALYPSO_PROC CalypsoSamPrefetchChallenge(P_CALYPSO_CTX ctx, const BYTE card_uid[8]);
 CALYPSO_PROC CalypsoSamDigestInit(P_CALYPSO_CTX ctx, BYTE kif, BYTE kvc, const BYTE card_resp_buffer[], CALYPSO_SZ card_resp_length);
 CALYPSO_PROC CalypsoSamDigestInitCompat(P_CALYPSO_CTX ctx, BYTE kno, const BYTE card_resp_buffer[], CALYPSO_SZ card_resp_length);
 CALYPSO_PROC CalypsoSamDigestUpdate(P_CALYPSO_CTX ctx, const BYTE card_buffer[], CALYPSO_SZ card_buflen);
+CALYPSO_PROC CalypsoSamDigestFlush(P_CALYPSO_CTX ctx);
 CALYPSO_PROC CalypsoSamDigestClose(P_CALYPSO_CTX ctx, BYTE sam_sign[4]);
 CALYPSO_PROC CalypsoSamDigestAuthenticate(P_CALYPSO_CTX ctx, const BYTE card_sign[4]);
 CALYPSO_PROC CalypsoSamDispose(P_CALYPSO_CTX ctx);
@@ -151,6 +157,7 @@ CALYPSO_PROC CalypsoSamCipherCardDataEx(P_CALYPSO_CTX ctx, BYTE apdu_p1, BYTE ap
 
 CALYPSO_PROC CalypsoSamSetAutoUpdate(P_CALYPSO_CTX ctx, BOOL enable);
 CALYPSO_PROC CalypsoSamSetCommSpeed(P_CALYPSO_CTX ctx, BOOL fast);
+CALYPSO_PROC CalypsoSamSetAsync(P_CALYPSO_CTX ctx, BOOL enable);
 
 CALYPSO_PROC CalypsoSamSerialNumber(P_CALYPSO_CTX ctx, BYTE sam_uid[4]);
 
@@ -192,16 +199,37 @@ CALYPSO_PROC CalypsoDecodeContractRecord(P_CALYPSO_CTX ctx, const BYTE data[], C
 
 CALYPSO_PROC CalypsoEncodeEventRecord(P_CALYPSO_CTX ctx, BYTE data[], BYTE size, CALYPSO_EVENT_ST* values);
 
-/* Intercode decoder - XML (or INI) output */
-/* --------------------------------------- */
+/* Intercode decoder - XML (or INI, JSON, binary) output */
+/* ----------------------------------------------------- */
 
 CALYPSO_PROC CalypsoSetOutputOptions(P_CALYPSO_CTX ctx, BYTE options);
 CALYPSO_PROC CalypsoSetXmlOutput(P_CALYPSO_CTX ctx, const char* filename);
 CALYPSO_PROC CalypsoSetIniOutput(P_CALYPSO_CTX ctx, const char* filename);
 CALYPSO_PROC CalypsoSetXmlOutputStr(P_CALYPSO_CTX ctx, char* target, CALYPSO_SZ length);
 CALYPSO_PROC CalypsoSetIniOutputStr(P_CALYPSO_CTX ctx, char* target, CALYPSO_SZ length);
+CALYPSO_PROC CalypsoSetXmlOutputBuilder(P_CALYPSO_CTX ctx);
+CALYPSO_PROC CalypsoSetIniOutputBuilder(P_CALYPSO_CTX ctx);
+CALYPSO_PROC CalypsoSetJsonOutput(P_CALYPSO_CTX ctx, const char* filename);
+CALYPSO_PROC CalypsoSetJsonOutputStr(P_CALYPSO_CTX ctx, char* target, CALYPSO_SZ length);
+CALYPSO_PROC CalypsoSetJsonOutputBuilder(P_CALYPSO_CTX ctx);
+CALYPSO_PROC CalypsoSetBinOutput(P_CALYPSO_CTX ctx, const char* filename);
+CALYPSO_PROC CalypsoSetBinOutputStr(P_CALYPSO_CTX ctx, BYTE target[], CALYPSO_SZ length);
+CALYPSO_PROC CalypsoSetBinOutputBuilder(P_CALYPSO_CTX ctx);
+CALYPSO_PROC CalypsoGetOutputLength(P_CALYPSO_CTX ctx, CALYPSO_SZ* length);
+CALYPSO_PROC CalypsoDetachOutput(P_CALYPSO_CTX ctx, char** text, CALYPSO_SZ* length);
+CALYPSO_LIB void CALYPSO_API CalypsoFreeOutput(char* text);
 CALYPSO_PROC CalypsoClearOutput(P_CALYPSO_CTX ctx);
 
+/* Items of the binary output, see calypso_intercode_to_bin_pc.c */
+#define CALYPSO_BIN_UINT           0
+#define CALYPSO_BIN_ID             1
+#define CALYPSO_BIN_BYTES          2
+#define CALYPSO_BIN_TEXT           3
+#define CALYPSO_BIN_FIELD          4
+#define CALYPSO_BIN_SECTION_BEGIN  5
+#define CALYPSO_BIN_SECTION_END    6
+#define CALYPSO_BIN_NAME           7
+
 CALYPSO_PROC CalypsoOutputCardAtr(P_CALYPSO_CTX ctx, const BYTE atr[], CALYPSO_SZ atrsize);
 CALYPSO_PROC CalypsoOutputCardInfo(P_CALYPSO_CTX ctx);
 CALYPSO_PROC CalypsoOutputFileInfo(P_CALYPSO_CTX ctx, FILE_INFO_ST* file_info);
@@ -212,6 +240,22 @@ CALYPSO_PROC CalypsoOutputEnvAndHolderRecordEx(P_CALYPSO_CTX ctx, const BYTE dat
 CALYPSO_PROC CalypsoOutputContractRecordEx(P_CALYPSO_CTX ctx, const BYTE data[], CALYPSO_SZ datasize);
 CALYPSO_PROC CalypsoOutputEventRecordEx(P_CALYPSO_CTX ctx, const BYTE data[], CALYPSO_SZ datasize);
 
+/* Intercode decoder - stored records, without library context (reentrant) */
+/* ------------------------------------------------------------------------ */
+
+#define CALYPSO_RECORD_ENV_HOLDER  0x01
+#define CALYPSO_RECORD_CONTRACT    0x02
+#define CALYPSO_RECORD_EVENT       0x03
+
+#define CALYPSO_OUTPUT_XML         0x01
+#define CALYPSO_OUTPUT_INI         0x02
+#define CALYPSO_OUTPUT_JSON        0x03
+#define CALYPSO_OUTPUT_BIN         0x04
+
+CALYPSO_PROC CalypsoDecodeStoredRecord(BYTE record_type, BYTE env_version, BYTE output_format, BYTE output_options, const BYTE data[], CALYPSO_SZ datasize, BYTE target[], CALYPSO_SZ* length);
+CALYPSO_PROC CalypsoDecodeStoredEnvAndHolder(const BYTE data[], CALYPSO_SZ datasize, CALYPSO_ENVANDHOLDER_ST* target);
+CALYPSO_PROC CalypsoDecodeStoredContract(BYTE env_version, const BYTE data[], CALYPSO_SZ datasize, CALYPSO_CONTRACT_ST* target);
+
 
 CALYPSO_PROC CalypsoExploreAndParse(P_CALYPSO_CTX ctx);
 
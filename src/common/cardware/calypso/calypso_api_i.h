@@ -108,6 +108,22 @@
 #ifndef CALYPSO_MAX_FCI_SZ
 #define CALYPSO_MAX_FCI_SZ CALYPSO_MAX_DATA_SZ
 #endif
+#ifndef CALYPSO_DIGEST_JOURNAL_SZ
+#define CALYPSO_DIGEST_JOURNAL_SZ 1024
+#endif
+
+#ifdef CALYPSO_HOST
+#define CALYPSO_CARD_PROFILES       4
+#define CALYPSO_CARD_PROFILE_KEY_SZ 64
+
+/* A kind of card (reader protocol, ATR, AID) that has no application to select */
+typedef struct
+{
+	BYTE        Key[CALYPSO_CARD_PROFILE_KEY_SZ];
+	BYTE        KeyLen;
+	BYTE        Revision;
+} CALYPSO_CARD_PROFILE_ST;
+#endif
 
 #ifndef CALYPSO_TRACE
 #ifdef SPROX_INS_LIB_TRACE
@@ -166,6 +182,8 @@ typedef struct
 } LEGACY_CTX_ST;
 #endif
 
+typedef struct _CALYPSO_PARSER_SINK_ST CALYPSO_PARSER_SINK_ST;
+
 typedef struct
 {
 
@@ -281,6 +299,26 @@ typedef struct
 		BYTE          Buffer[CALYPSO_MAX_APDU_SZ];
 		WORD          SW;
 
+#ifdef CALYPSO_HOST
+		/* Card APDUs of the current session, not yet given to the SAM */
+		BYTE          DigestJournal[CALYPSO_DIGEST_JOURNAL_SZ];
+		CALYPSO_SZ    DigestJournalLen;
+		BOOL          DigestFlushing;
+		BOOL          NoDigestUpdateMultiple;
+
+		/* Background worker, when the SAM runs in parallel with the card */
+		void*         Async;
+
+		/* What the SAM is ready for, to prefetch the challenge of the next session */
+		/* (written by the worker too : no bit-fields, and only read or written by */
+		/* the application's thread once CalypsoSamAsyncWait has returned)        */
+		BYTE          Diversifier[8];
+		BYTE          Challenge[4];
+		BOOL          DiversifierValid;
+		BOOL          ChallengeValid;
+		BOOL          ChallengePrefetch;
+#endif
+
 	} Sam;
 #endif
 
@@ -289,6 +327,15 @@ typedef struct
 
 	BYTE        LastError;
 
+#ifdef CALYPSO_HOST
+	struct
+	{
+		BOOL        Enabled;
+		BYTE        Next;
+		CALYPSO_CARD_PROFILE_ST Entry[CALYPSO_CARD_PROFILES];
+	} CardProfiles;
+#endif
+
 #ifdef CALYPSO_BENCHMARK
 	struct
 	{
@@ -311,6 +358,13 @@ typedef struct
 		FILE* TargetFile;
 		char* TargetString;
 		DWORD     TargetLength;
+		DWORD     TargetUsed;    /* Length of the text in TargetString        */
+		DWORD     TargetNeeded;  /* Length of the whole text, even if dropped */
+		BOOL      TargetOwned;   /* TargetString is ours, and grows           */
+		const CALYPSO_PARSER_SINK_ST* Sink; /* JSON or binary output, NULL for XML/INI */
+		void*     SinkData;
+		BOOL      SinkComma;
+		BOOL      SinkRecord;    /* A record is being output out of any section */
 #endif
 
 	} Parser;
@@ -332,6 +386,7 @@ typedef struct
 #define PARSER_OUT_NO_BITMAP   0x02
 #define PARSER_OUT_NO_EXPLAIN  0x04
 #define PARSER_OUT_NO_AUTH_C   0x08
+#define PARSER_OUT_NO_FILE_INFO 0x10
 #define PARSER_OUT_NO_TABS     0x40
 #define PARSER_OUT_DIRTY       0x80
 
@@ -366,10 +421,34 @@ void  ParserOut_Remark(CALYPSO_CTX_ST* ctx, const char* remark);
 void  ParserOut_SectionBegin(CALYPSO_CTX_ST* ctx, const char* sectionname);
 void  ParserOut_SectionBeginId(CALYPSO_CTX_ST* ctx, const char* sectionname, DWORD sectionid);
 void  ParserOut_SectionEnd(CALYPSO_CTX_ST* ctx, const char* sectionname);
+void  ParserOut_RecordBegin(CALYPSO_CTX_ST* ctx);
+void  ParserOut_RecordEnd(CALYPSO_CTX_ST* ctx);
 void  ParserOut_IdfZones(CALYPSO_CTX_ST* ctx, const char* varname, DWORD value);
 void  ParserOut_SectionXml(CALYPSO_CTX_ST* ctx, const char* sectionname, const char* xmlcontent);
 void  ParserOut_SectionRaw(CALYPSO_CTX_ST* ctx, const char* sectionname, const char* rawcontent);
 
+#ifdef CALYPSO_HOST
+/* Structured outputs : the ParserOut_xxx functions hand the typed values over to the sink */
+struct _CALYPSO_PARSER_SINK_ST
+{
+	void (*SectionBegin)(CALYPSO_CTX_ST* ctx, const char* name, const DWORD* id);
+	void (*SectionEnd)(CALYPSO_CTX_ST* ctx);
+	void (*Number)(CALYPSO_CTX_ST* ctx, const char* name, const DWORD* id, DWORD value);
+	void (*Bytes)(CALYPSO_CTX_ST* ctx, const char* name, const BYTE value[], CALYPSO_SZ size);
+	void (*Text)(CALYPSO_CTX_ST* ctx, const char* name, const DWORD* id, const char* value);
+	void (*RecordBegin)(CALYPSO_CTX_ST* ctx); /* Optional */
+	void (*RecordEnd)(CALYPSO_CTX_ST* ctx);   /* Optional */
+};
+
+extern const CALYPSO_PARSER_SINK_ST CalypsoParserJsonSink;
+extern const CALYPSO_PARSER_SINK_ST CalypsoParserBinSink;
+
+void       ParserWrite(CALYPSO_CTX_ST* ctx, const char* text, DWORD size);
+CALYPSO_RC ParserSetFile(CALYPSO_CTX_ST* ctx, const char* filename, const char* mode);
+CALYPSO_RC ParserSetString(CALYPSO_CTX_ST* ctx, char* target, CALYPSO_SZ length);
+CALYPSO_RC ParserSetBuilder(CALYPSO_CTX_ST* ctx);
+#endif
+
 void  CalypsoRecognizeRevision(CALYPSO_CTX_ST* ctx);
 
 #define TR_CARD     0x10
@@ -421,6 +500,24 @@ CALYPSO_RC CalypsoPcscTransmit(PCSC_CTX_ST* pcsc_ctx, const BYTE in_buffer[], CA
 CALYPSO_RC CalypsoPcscGetAtr(PCSC_CTX_ST* pcsc_ctx, BYTE atr[], CALYPSO_SZ* atrlen);
 #endif
 
+#if (CALYPSO_WITH_SAM) && defined(CALYPSO_HOST)
+CALYPSO_RC CalypsoSamDigestPush(CALYPSO_CTX_ST* ctx, const BYTE cardapdu[], CALYPSO_SZ cardapdusize);
+
+typedef CALYPSO_RC(*CALYPSO_SAM_JOB) (CALYPSO_CTX_ST* ctx, const BYTE param[], CALYPSO_SZ paramsize);
+
+CALYPSO_RC CalypsoSamAsyncPost(CALYPSO_CTX_ST* ctx, CALYPSO_SAM_JOB job, const BYTE param[], CALYPSO_SZ paramsize);
+CALYPSO_RC CalypsoSamAsyncWait(CALYPSO_CTX_ST* ctx);
+BOOL CalypsoSamAsyncIsWorker(CALYPSO_CTX_ST* ctx);
+void CalypsoSamAsyncDispose(CALYPSO_CTX_ST* ctx);
+
+CALYPSO_RC CalypsoSamTakeChallenge(CALYPSO_CTX_ST* ctx, const BYTE card_uid[8], BYTE sam_chal[4]);
+
+/* Every SAM command waits for the job running in background before it touches ctx->Sam */
+#define CALYPSO_SAM_WAIT_JOB(ctx) { CALYPSO_RC rc_job = CalypsoSamAsyncWait(ctx); if (rc_job) return rc_job; }
+#elif (CALYPSO_WITH_SAM)
+#define CALYPSO_SAM_WAIT_JOB(ctx)
+#endif
+
 #ifdef CALYPSO_LEGACY
 CALYPSO_RC CalypsoLegacyTransmit(LEGACY_CTX_ST* legacy_ctx, const BYTE in_buffer[], CALYPSO_SZ in_length, BYTE out_buffer[], CALYPSO_SZ* out_length);
 CALYPSO_RC CalypsoLegacyGetAtr(BYTE atr[], CALYPSO_SZ* atrlen);
@@ -449,12 +546,100 @@ BOOL  isbcdb(BYTE b);
 
 
 
+/* Sequential reader of a bitstream, through a window of up to 64 bits */
+#if defined(WIN32)
+typedef ULONGLONG CALYPSO_BITS_WINDOW;
+#elif defined(LINUX)
+typedef QWORD CALYPSO_BITS_WINDOW;
+#else
+typedef DWORD CALYPSO_BITS_WINDOW;
+#endif
+#define CALYPSO_BITS_WINDOW_SZ (8 * sizeof(CALYPSO_BITS_WINDOW))
+
+typedef struct
+{
+	const BYTE*         Data;
+	CALYPSO_SZ          Size;
+	CALYPSO_SZ          Next;   /* Next byte to enter the window */
+	CALYPSO_BITS_WINDOW Window; /* Available bits are the lowest ones */
+	BYTE                Avail;
+} CALYPSO_BITS_READER_ST;
+
+void bits_reader_init(CALYPSO_BITS_READER_ST* reader, const BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ bit_offset);
+BOOL bits_reader_get(CALYPSO_BITS_READER_ST* reader, BYTE bit_count, DWORD* value);
+CALYPSO_BITS_SZ bits_reader_offset(const CALYPSO_BITS_READER_ST* reader);
+
 BOOL get_char5_bits(const BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, BYTE bit_count, char value[], BYTE length);
 BOOL get_dword_bits(const BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, BYTE bit_count, DWORD* value);
 BOOL set_dword_bits(BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, BYTE bit_count, DWORD value);
 
 CALYPSO_BITS_SZ count_zeros(const BYTE buffer[], CALYPSO_BITS_SZ bit_count);
 
+/* Intercode schema : layout of the records, shared by the decoders and the encoders */
+#define INTERCODE_FMT_NONE      0 /* Not read (TODO in the specification)     */
+#define INTERCODE_FMT_DEC       1
+#define INTERCODE_FMT_VERSION   2 /* Decimal, and gives ctx->CardData.EnvVersion */
+#define INTERCODE_FMT_NETWORK   3 /* Hex24, plus country and index           */
+#define INTERCODE_FMT_HEX16     4
+#define INTERCODE_FMT_AUTH      5 /* 8 or 16 bits, depending on EnvVersion    */
+#define INTERCODE_FMT_BIN       6
+#define INTERCODE_FMT_DATE      7 /* Datestamp, 14 bits                       */
+#define INTERCODE_FMT_TIME      8 /* Timestamp, 11 bits                       */
+#define INTERCODE_FMT_PAYPTR    9 /* 4 payment pointers, 8 bits each          */
+#define INTERCODE_FMT_ZONES    10 /* Decimal, plus the list of zones          */
+#define INTERCODE_FMT_BITMAP   11 /* Nested bitmap, see Sub                   */
+
+#define INTERCODE_ID_NONE                    0
+#define INTERCODE_ID_ENV_NETWORK_ID          1
+#define INTERCODE_ID_ENV_ISSUER_ID           2
+#define INTERCODE_ID_ENV_END_DATE            3
+#define INTERCODE_ID_ENV_AUTHENTICATOR       4
+#define INTERCODE_ID_ENV_DATA_STATUS         5
+#define INTERCODE_ID_ENV_VERSION             6
+#define INTERCODE_ID_CONTRACT_NETWORK_ID    10
+#define INTERCODE_ID_CONTRACT_PROVIDER      11
+#define INTERCODE_ID_CONTRACT_TARIFF        12
+#define INTERCODE_ID_CONTRACT_SERIAL_NUMBER 13
+#define INTERCODE_ID_CONTRACT_START_DATE    14
+#define INTERCODE_ID_CONTRACT_END_DATE      15
+#define INTERCODE_ID_CONTRACT_ZONES         16
+#define INTERCODE_ID_CONTRACT_STATUS        17
+#define INTERCODE_ID_CONTRACT_AUTHENTICATOR 18
+
+#define INTERCODE_EV_VALUE      0 /* A field has been read                    */
+#define INTERCODE_EV_BITMAP     1 /* The main bitmap has been read            */
+#define INTERCODE_EV_BEGIN      2 /* Entering a nested bitmap (not empty)     */
+#define INTERCODE_EV_END        3 /* Leaving a nested bitmap                  */
+#define INTERCODE_EV_ZEROS      4 /* Count of zeros before the status (Authenticator_C) */
+
+typedef struct _CALYPSO_INTERCODE_MAP_ST CALYPSO_INTERCODE_MAP_ST;
+
+typedef struct
+{
+	BYTE        Width;  /* Bits, 0 for INTERCODE_FMT_AUTH and INTERCODE_FMT_BITMAP */
+	BYTE        Format; /* INTERCODE_FMT_xxx */
+	BYTE        Id;     /* INTERCODE_ID_xxx, for the structures */
+	const char* Name;   /* XML/INI tag */
+	const CALYPSO_INTERCODE_MAP_ST* Sub;
+} CALYPSO_INTERCODE_FIELD_ST;
+
+struct _CALYPSO_INTERCODE_MAP_ST
+{
+	BYTE        Fixed;        /* Fields always present, before the bitmap */
+	BYTE        BitmapWidth;
+	BYTE        ZerosAt;      /* Bit before which the zeros are counted, 0 if none */
+	const CALYPSO_INTERCODE_FIELD_ST* Fields; /* Fixed fields, then one per bit of the bitmap */
+};
+
+extern const CALYPSO_INTERCODE_MAP_ST CalypsoIntercodeEnvironment;
+extern const CALYPSO_INTERCODE_MAP_ST CalypsoIntercodeContract;
+extern const CALYPSO_INTERCODE_MAP_ST CalypsoIntercodeEvent;
+
+typedef void (*CALYPSO_INTERCODE_VISITOR) (CALYPSO_CTX_ST* ctx, void* param, BYTE event, const CALYPSO_INTERCODE_FIELD_ST* field, BYTE width, DWORD value);
+
+CALYPSO_RC CalypsoIntercodeDecode(CALYPSO_CTX_ST* ctx, const CALYPSO_INTERCODE_MAP_ST* map, CALYPSO_BITS_READER_ST* reader, CALYPSO_INTERCODE_VISITOR visitor, void* param);
+CALYPSO_RC CalypsoIntercodeEncode(CALYPSO_CTX_ST* ctx, const CALYPSO_INTERCODE_MAP_ST* map, BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, DWORD bitmap, const DWORD values[]);
+
 #ifndef UNUSED_PARAMETER
 #define UNUSED_PARAMETER(a) (void) (a)
 #endif
@@ -152,6 +152,9 @@ CALYPSO_PROC CalypsoCardDispose(CALYPSO_CTX_ST* ctx)
 CALYPSO_PROC CalypsoSamDispose(CALYPSO_CTX_ST* ctx)
 {
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+#ifdef CALYPSO_HOST
+	CalypsoSamAsyncDispose(ctx);
+#endif
 	return 0;
 }
 #endif
@@ -11,6 +11,7 @@
  *
  * HISTORY
  *   JDA 21/10/2008 : first public release
+ *   AGT 19/10/2026 : whole files read at once on Rev.3 cards
  *
  **/
 #include "../calypso_api_i.h"
@@ -53,6 +54,114 @@ static BYTE div_by_10(BYTE data[], BYTE size)
 	return (BYTE)rest;
 }
 
+#define EXPLORE_ENV_HOLDER  0
+#define EXPLORE_CONTRACT    1
+#define EXPLORE_EVENT       2
+
+static void CalypsoExploreOutputRecord(CALYPSO_CTX_ST* ctx, BYTE kind, BYTE rec_no, const BYTE data[], CALYPSO_SZ datasize)
+{
+	ParserOut_SectionBeginId(ctx, strRecord, rec_no);
+	switch (kind)
+	{
+	case EXPLORE_ENV_HOLDER: CalypsoOutputEnvAndHolderRecordEx(ctx, data, datasize, FALSE); break;
+	case EXPLORE_CONTRACT: CalypsoOutputContractRecordEx(ctx, data, datasize); break;
+	case EXPLORE_EVENT: CalypsoOutputEventRecordEx(ctx, data, datasize); break;
+	default: break;
+	}
+	ParserOut_SectionEnd(ctx, strRecord);
+}
+
+/*
+ * Read and explain all the records of a file.
+ * Rev.3 cards return the whole file with a single Read Records. If the
+ * file information is not wanted (PARSER_OUT_NO_FILE_INFO), the file is not
+ * even selected but read through its SFI. Older cards are read one record
+ * at a time.
+ */
+static CALYPSO_RC CalypsoExploreFile(CALYPSO_CTX_ST* ctx, WORD file_id, BYTE sfi, const char* section, BYTE kind)
+{
+	CALYPSO_RC rc;
+	CALYPSO_SZ RecDataSize;
+	BYTE RecData[252];
+	BYTE RecNo = 1;
+	FILE_INFO_ST file_info;
+	BOOL multiple = (ctx->CardApplication.Revision >= 3) ? TRUE : FALSE;
+	BOOL by_sfi = (multiple && (ctx->Parser.OutputOptions & PARSER_OUT_NO_FILE_INFO)) ? TRUE : FALSE;
+
+	memset(&file_info, 0, sizeof(file_info));
+
+	if (by_sfi)
+	{
+		ParserOut_SectionBegin(ctx, section);
+	}
+	else
+	{
+		/* Select the file */
+		rc = CalypsoCardSelectEF(ctx, file_id, NULL, NULL);
+		if (rc & CALYPSO_ERR_FATAL_) return rc;
+
+		ParserOut_SectionBegin(ctx, section);
+
+		/* Explain the FCI */
+		rc = CalypsoParseSelectResp(ctx, NULL, 0, &file_info);
+		if (rc) return rc;
+		if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_FILE_INFO))
+		{
+			ParserOut_SectionBegin(ctx, strFileInfo);
+			rc = CalypsoOutputFileInfo(ctx, &file_info);
+			ParserOut_SectionEnd(ctx, strFileInfo);
+			if (rc) return rc;
+		}
+	}
+
+	while (multiple && (by_sfi || (RecNo <= file_info.NumRec)))
+	{
+		CALYPSO_SZ offset = 0;
+		const BYTE* record;
+		BYTE record_no, record_size;
+		BYTE count = 0;
+
+		/* As many records as the card's response may hold */
+		RecDataSize = sizeof(RecData);
+		rc = CalypsoCardReadRecords(ctx, by_sfi ? sfi : 0, RecNo, 0, RecData, &RecDataSize);
+		if (rc & CALYPSO_ERR_FATAL_) return rc;
+		if (rc == CALYPSO_CARD_FILE_OVERFLOW) break; /* No record after RecNo */
+		if (rc)
+		{
+			/* Not supported after all, fallback to one record at a time */
+			multiple = FALSE;
+			break;
+		}
+
+		while (CalypsoCardNextRecord(RecData, RecDataSize, &offset, &record_no, &record, &record_size))
+		{
+			if (record_no < RecNo) break;
+			CalypsoExploreOutputRecord(ctx, kind, record_no, record, record_size);
+			RecNo = record_no + 1;
+			count++;
+		}
+		if (!count || !RecNo) break;
+	}
+
+	if (!multiple)
+	{
+		/* Read all records */
+		for (; by_sfi || (RecNo <= file_info.NumRec); RecNo++)
+		{
+			RecDataSize = sizeof(RecData);
+			rc = CalypsoCardReadRecord(ctx, by_sfi ? sfi : 0, RecNo, file_info.RecSize, RecData, &RecDataSize);
+			if (rc & CALYPSO_ERR_FATAL_) return rc;
+			if (rc && by_sfi) break;
+
+			CalypsoExploreOutputRecord(ctx, kind, RecNo, RecData, RecDataSize);
+			if (RecNo == 0xFF) break;
+		}
+	}
+
+	ParserOut_SectionEnd(ctx, section);
+	return 0;
+}
+
 /**f* CSB6_Calypso/CalypsoExploreAndParse
  *
  * NAME
@@ -79,8 +188,6 @@ CALYPSO_PROC CalypsoExploreAndParse(CALYPSO_CTX_ST* ctx)
 	DWORD rc;
 	CALYPSO_SZ RecDataSize;
 	BYTE RecData[252];
-	BYTE RecNo;
-	FILE_INFO_ST file_info;
 
 	if (ctx == NULL)
 	{
@@ -146,108 +253,34 @@ CALYPSO_PROC CalypsoExploreAndParse(CALYPSO_CTX_ST* ctx)
 	}
 
 	/* Ready to go deep in the Ticketing application !!! */
-	/* Select the DF */
-	rc = CalypsoCardSelectDF(ctx, 0x2000, NULL, NULL);
-	if (rc == CALYPSO_ERR_STATUS_WORD)
+	if (!((ctx->CardApplication.Revision >= 3) && (ctx->Parser.OutputOptions & PARSER_OUT_NO_FILE_INFO)))
 	{
-		/* Classical selection failed -> dummy read record to make sure... */
-		RecDataSize = sizeof(RecData);
-		rc = CalypsoCardReadRecord(ctx, 7, 1, CALYPSO_MIN_RECORD_SIZE, RecData, &RecDataSize);
+		/* Select the DF (not needed when the files are read through their SFI) */
+		rc = CalypsoCardSelectDF(ctx, 0x2000, NULL, NULL);
+		if (rc == CALYPSO_ERR_STATUS_WORD)
+		{
+			/* Classical selection failed -> dummy read record to make sure... */
+			RecDataSize = sizeof(RecData);
+			rc = CalypsoCardReadRecord(ctx, 7, 1, CALYPSO_MIN_RECORD_SIZE, RecData, &RecDataSize);
+		}
+		if (rc & CALYPSO_ERR_FATAL_) goto failed;
 	}
-	if (rc & CALYPSO_ERR_FATAL_) goto failed;
 
 	/* Environment file */
 	/* ---------------- */
-
-	/* Select the file */
-	rc = CalypsoCardSelectEF(ctx, 0x2001, NULL, NULL);
-	if (rc & CALYPSO_ERR_FATAL_) goto failed;
-
-	ParserOut_SectionBegin(ctx, strEnvHolder);
-
-	/* Explain the FCI */
-	rc = CalypsoParseSelectResp(ctx, NULL, 0, &file_info);
-	if (rc) goto failed;
-	ParserOut_SectionBegin(ctx, strFileInfo);
-	rc = CalypsoOutputFileInfo(ctx, &file_info);
-	ParserOut_SectionEnd(ctx, strFileInfo);
+	rc = CalypsoExploreFile(ctx, 0x2001, CALYPSO_SFI_ENVIRONMENT, strEnvHolder, EXPLORE_ENV_HOLDER);
 	if (rc) goto failed;
 
-	/* Read all records */
-	for (RecNo = 1; RecNo <= file_info.NumRec; RecNo++)
-	{
-		RecDataSize = sizeof(RecData);
-
-		rc = CalypsoCardReadRecord(ctx, 0, RecNo, file_info.RecSize, RecData, &RecDataSize);
-		if (rc & CALYPSO_ERR_FATAL_) goto failed;
-
-		ParserOut_SectionBeginId(ctx, strRecord, RecNo);
-		CalypsoOutputEnvAndHolderRecordEx(ctx, RecData, RecDataSize, FALSE);
-		ParserOut_SectionEnd(ctx, strRecord);
-	}
-	ParserOut_SectionEnd(ctx, strEnvHolder);
-
 	/* Contracts file */
 	/* -------------- */
-
-	/* Select the file */
-	rc = CalypsoCardSelectEF(ctx, 0x2020, NULL, NULL);
-	if (rc & CALYPSO_ERR_FATAL_) goto failed;
-
-	ParserOut_SectionBegin(ctx, strContracts);
-
-	/* Explain the FCI */
-	rc = CalypsoParseSelectResp(ctx, NULL, 0, &file_info);
-	if (rc) goto failed;
-	ParserOut_SectionBegin(ctx, strFileInfo);
-	rc = CalypsoOutputFileInfo(ctx, &file_info);
-	ParserOut_SectionEnd(ctx, strFileInfo);
+	rc = CalypsoExploreFile(ctx, 0x2020, CALYPSO_SFI_CONTRACTS, strContracts, EXPLORE_CONTRACT);
 	if (rc) goto failed;
 
-	/* Read all records */
-	for (RecNo = 1; RecNo <= file_info.NumRec; RecNo++)
-	{
-		RecDataSize = sizeof(RecData);
-		rc = CalypsoCardReadRecord(ctx, 0, RecNo, file_info.RecSize, RecData, &RecDataSize);
-		if (rc & CALYPSO_ERR_FATAL_) goto failed;
-
-		ParserOut_SectionBeginId(ctx, strRecord, RecNo);
-		CalypsoOutputContractRecordEx(ctx, RecData, RecDataSize);
-		ParserOut_SectionEnd(ctx, strRecord);
-	}
-	ParserOut_SectionEnd(ctx, strContracts);
-
 	/* Transport log file */
 	/* ------------------ */
-
-	/* Select the file */
-	rc = CalypsoCardSelectEF(ctx, 0x2010, NULL, NULL);
-	if (rc & CALYPSO_ERR_FATAL_) goto failed;
-
-	ParserOut_SectionBegin(ctx, strTransportLog);
-
-	/* Explain the FCI */
-	rc = CalypsoParseSelectResp(ctx, NULL, 0, &file_info);
-	if (rc) goto failed;
-	ParserOut_SectionBegin(ctx, strFileInfo);
-	rc = CalypsoOutputFileInfo(ctx, &file_info);
-	ParserOut_SectionEnd(ctx, strFileInfo);
+	rc = CalypsoExploreFile(ctx, 0x2010, CALYPSO_SFI_TRANSPORT_LOG, strTransportLog, EXPLORE_EVENT);
 	if (rc) goto failed;
 
-	/* Read all records */
-	for (RecNo = 1; RecNo <= file_info.NumRec; RecNo++)
-	{
-		RecDataSize = sizeof(RecData);
-		rc = CalypsoCardReadRecord(ctx, 0, RecNo, file_info.RecSize, RecData, &RecDataSize);
-		if (rc & CALYPSO_ERR_FATAL_) goto failed;
-
-		ParserOut_SectionBeginId(ctx, strRecord, RecNo);
-		CalypsoOutputEventRecordEx(ctx, RecData, RecDataSize);
-		ParserOut_SectionEnd(ctx, strRecord);
-	}
-	ParserOut_SectionEnd(ctx, strTransportLog);
-
-
 	ParserOut_SectionEnd(ctx, strCard);
 	return 0;
 
@@ -15,6 +15,7 @@
  *
  * HISTORY
  *   JDA 21/10/2008 : first public release
+ *   AGT 19/10/2026 : cache of the cards that have no application to select
  *
  **/
 #include "../calypso_api_i.h"
@@ -45,6 +46,152 @@ CALYPSO_PROC CalypsoCardActivateHex(CALYPSO_CTX_ST* ctx, const char* aid)
 	return CalypsoCardActivate(ctx, buffer, length);
 }
 
+/*
+ * Activation of a card without ticketing application (or whose application
+ * could not be selected): the ATR tells us what we need to know
+ */
+static CALYPSO_RC CalypsoCardActivateAtr(CALYPSO_CTX_ST* ctx, CALYPSO_RC rc)
+{
+	/* Parse the ATR instead */
+#ifdef CALYPSO_HOST
+	if (!ctx->Card.AtrLen)
+	{
+		/* Get ATR as returned by the reader */
+		CALYPSO_RC atr_rc = CalypsoCardGetAtr(ctx, NULL, NULL);
+		CalypsoTraceRC(TR_TRACE | TR_CARD, "- CardGetAtr ->", atr_rc);
+		if (atr_rc & CALYPSO_ERR_FATAL_) return rc;
+	}
+#endif
+
+	rc = CalypsoParseCardAtr(ctx, NULL, 0);
+	CalypsoTraceRC(TR_TRACE | TR_CARD, "- ParseCardAtr ->", rc);
+
+#ifdef CALYPSO_HOST
+	if ((rc == CALYPSO_ERR_ATR_INVALID) || (rc == CALYPSO_ERR_STATUS_WORD))
+	{
+		/* Ask the reader the real ATR (if reader is compliant with this specific command...) */
+		CALYPSO_SZ recv_len, send_len;
+
+		send_len = 0;
+		ctx->Card.Buffer[send_len++] = 0xFF; /* Embedded APDU interpreter CLA */
+		ctx->Card.Buffer[send_len++] = 0xCA; /* Get Data */
+		ctx->Card.Buffer[send_len++] = 0xFA; /* ATR */
+		ctx->Card.Buffer[send_len++] = 0x01; /* Actual Calypso ATR, no a computed one */
+		ctx->Card.Buffer[send_len++] = 0x00;
+
+		recv_len = sizeof(ctx->Card.Buffer);
+		if ((CalypsoCardTransmit(ctx, ctx->Card.Buffer, send_len, ctx->Card.Buffer, &recv_len) == CALYPSO_SUCCESS)
+			&& (recv_len > 2) && (ctx->Card.Buffer[recv_len - 2] == 0x90) && (ctx->Card.Buffer[recv_len - 1] == 0x00))
+		{
+			/* Everything is OK */
+			ctx->Card.AtrLen = recv_len - 2;
+			if (ctx->Card.AtrLen > sizeof(ctx->Card.Atr))
+				ctx->Card.AtrLen = sizeof(ctx->Card.Atr);
+			memcpy(ctx->Card.Atr, ctx->Card.Buffer, ctx->Card.AtrLen);
+
+			CalypsoTraceHex(TR_TRACE | TR_CARD, "- New ATR =", ctx->Card.Atr, ctx->Card.AtrLen);
+
+			rc = CalypsoParseCardAtr(ctx, NULL, 0);
+			CalypsoTraceRC(TR_TRACE | TR_CARD, "- ParseCardAtr ->", rc);
+		}
+	}
+#endif
+
+	if (!ctx->CardApplication.Revision)
+	{
+		/* At least try to select the Transport DF */
+		CALYPSO_SZ recv_len;
+		recv_len = sizeof(ctx->Card.Buffer);
+		rc = CalypsoCardSelectDF(ctx, 0x2000, ctx->Card.Buffer, &recv_len);
+		if (rc & CALYPSO_ERR_FATAL_) return rc;
+		if (rc == 0)
+		{
+			/* Success */
+
+			CalypsoTraceHex(TR_TRACE | TR_CARD, "- Transport DF ", ctx->Card.Buffer, recv_len);
+			ctx->CardApplication.Revision = 1;
+		}
+	}
+
+	return rc;
+}
+
+#ifdef CALYPSO_HOST
+/*
+ * Build the key of the card's profile: reader type and protocol, ATR, AID
+ */
+static CALYPSO_SZ CalypsoCardProfileKey(CALYPSO_CTX_ST* ctx, const BYTE aid[], CALYPSO_SZ aidsize, BYTE key[CALYPSO_CARD_PROFILE_KEY_SZ])
+{
+	CALYPSO_SZ keylen = 0;
+
+	if (aid == NULL)
+		aidsize = 0;
+	if ((ctx->Card.AtrLen + aidsize + 5) > CALYPSO_CARD_PROFILE_KEY_SZ)
+		return 0;
+
+	key[keylen++] = ctx->Card.Type;
+#ifdef CALYPSO_LEGACY
+	if (ctx->Card.Type == CALYPSO_TYPE_LEGACY)
+	{
+		key[keylen++] = (BYTE)(ctx->Card.Legacy.Proto >> 8);
+		key[keylen++] = (BYTE)(ctx->Card.Legacy.Proto);
+	}
+#endif
+	key[keylen++] = (BYTE)ctx->Card.AtrLen;
+	memcpy(&key[keylen], ctx->Card.Atr, ctx->Card.AtrLen);
+	keylen += ctx->Card.AtrLen;
+	key[keylen++] = (BYTE)aidsize;
+	if (aidsize)
+		memcpy(&key[keylen], aid, aidsize);
+	keylen += aidsize;
+
+	return keylen;
+}
+
+static CALYPSO_CARD_PROFILE_ST* CalypsoCardProfileFind(CALYPSO_CTX_ST* ctx, const BYTE key[], CALYPSO_SZ keylen)
+{
+	BYTE i;
+
+	for (i = 0; i < CALYPSO_CARD_PROFILES; i++)
+	{
+		CALYPSO_CARD_PROFILE_ST* profile = &ctx->CardProfiles.Entry[i];
+		if ((profile->KeyLen == keylen) && !memcmp(profile->Key, key, keylen))
+			return profile;
+	}
+	return NULL;
+}
+
+/**f* CSB6_Calypso/CalypsoCardSetProfileCache
+ *
+ * NAME
+ *   CalypsoCardSetProfileCache
+ *
+ * DESCRIPTION
+ *   Let CalypsoCardActivate remember the cards (identified by the reader's protocol,
+ *   their ATR and the requested AID) that don't have a ticketing application, so the
+ *   next card of the same kind is activated from its ATR without sending a Select
+ *   Application that will fail anyway.
+ *   If such a card finally can't be recognized from its ATR, the profile is forgotten
+ *   and the activation goes on normally.
+ *
+ * INPUTS
+ *   P_CSB6_CALYPSO_CTX  p_ctx          : library context
+ *   BOOL               enable         : TRUE to enable the cache, FALSE to disable and clear it
+ *
+ * RETURNS
+ *   DWORD                             : S_SUCCESS or an error code
+ *
+ **/
+CALYPSO_PROC CalypsoCardSetProfileCache(CALYPSO_CTX_ST* ctx, BOOL enable)
+{
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+
+	memset(&ctx->CardProfiles, 0, sizeof(ctx->CardProfiles));
+	ctx->CardProfiles.Enabled = enable ? TRUE : FALSE;
+	return CALYPSO_SUCCESS;
+}
+#endif
+
 /**f* CSB6_Calypso/CalypsoCardActivate
  *
  * NAME
@@ -71,11 +218,42 @@ CALYPSO_PROC CalypsoCardActivateHex(CALYPSO_CTX_ST* ctx, const char* aid)
 CALYPSO_PROC CalypsoCardActivate(CALYPSO_CTX_ST* ctx, const BYTE aid[], CALYPSO_SZ aidsize)
 {
 	CALYPSO_RC rc;
+#ifdef CALYPSO_HOST
+	BYTE key[CALYPSO_CARD_PROFILE_KEY_SZ];
+	CALYPSO_SZ keylen = 0;
+	CALYPSO_CARD_PROFILE_ST* profile = NULL;
+#endif
 
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
 
 	memset(&ctx->CardApplication, 0, sizeof(ctx->CardApplication));
 
+#ifdef CALYPSO_HOST
+	if (ctx->CardProfiles.Enabled)
+	{
+		if (!ctx->Card.AtrLen)
+			CalypsoCardGetAtr(ctx, NULL, NULL);
+
+		keylen = CalypsoCardProfileKey(ctx, aid, aidsize, key);
+		if (keylen)
+			profile = CalypsoCardProfileFind(ctx, key, keylen);
+	}
+
+	if (profile != NULL)
+	{
+		/* We already know that this kind of card doesn't have the application */
+		CalypsoTraceValD(TR_TRACE | TR_CARD, "- Known card, Revision ", profile->Revision, 0);
+
+		rc = CalypsoCardActivateAtr(ctx, CALYPSO_CARD_NOT_SUPPORTED);
+		if (rc & CALYPSO_ERR_FATAL_) return rc;
+		if (ctx->CardApplication.Revision) return rc;
+
+		/* Wrong guess, forget it and do the whole job */
+		memset(profile, 0, sizeof(CALYPSO_CARD_PROFILE_ST));
+		memset(&ctx->CardApplication, 0, sizeof(ctx->CardApplication));
+	}
+#endif
+
 	/* Select the Ticketing application. May fail (old cards don't have it) */
 	rc = CalypsoCardSelectApplication(ctx, aid, aidsize, NULL, NULL);
 	CalypsoTraceRC(TR_TRACE | TR_CARD, "- CardSelectApplication ->", rc);
@@ -90,67 +268,20 @@ CALYPSO_PROC CalypsoCardActivate(CALYPSO_CTX_ST* ctx, const BYTE aid[], CALYPSO_
 	}
 	else
 	{
-		/* Parse the ATR instead */
-#ifdef CALYPSO_HOST
-		if (!ctx->Card.AtrLen)
-		{
-			/* Get ATR as returned by the reader */
-			CALYPSO_RC atr_rc = CalypsoCardGetAtr(ctx, NULL, NULL);
-			CalypsoTraceRC(TR_TRACE | TR_CARD, "- CardGetAtr ->", atr_rc);
-			if (atr_rc & CALYPSO_ERR_FATAL_) return rc;
-		}
-#endif
-
-		rc = CalypsoParseCardAtr(ctx, NULL, 0);
-		CalypsoTraceRC(TR_TRACE | TR_CARD, "- ParseCardAtr ->", rc);
+		rc = CalypsoCardActivateAtr(ctx, rc);
+		if (rc & CALYPSO_ERR_FATAL_) return rc;
 
 #ifdef CALYPSO_HOST
-		if ((rc == CALYPSO_ERR_ATR_INVALID) || (rc == CALYPSO_ERR_STATUS_WORD))
+		if (keylen && ctx->CardApplication.Revision)
 		{
-			/* Ask the reader the real ATR (if reader is compliant with this specific command...) */
-			CALYPSO_SZ recv_len, send_len;
-
-			send_len = 0;
-			ctx->Card.Buffer[send_len++] = 0xFF; /* Embedded APDU interpreter CLA */
-			ctx->Card.Buffer[send_len++] = 0xCA; /* Get Data */
-			ctx->Card.Buffer[send_len++] = 0xFA; /* ATR */
-			ctx->Card.Buffer[send_len++] = 0x01; /* Actual Calypso ATR, no a computed one */
-			ctx->Card.Buffer[send_len++] = 0x00;
-
-			recv_len = sizeof(ctx->Card.Buffer);
-			if ((CalypsoCardTransmit(ctx, ctx->Card.Buffer, send_len, ctx->Card.Buffer, &recv_len) == CALYPSO_SUCCESS)
-				&& (recv_len > 2) && (ctx->Card.Buffer[recv_len - 2] == 0x90) && (ctx->Card.Buffer[recv_len - 1] == 0x00))
-			{
-				/* Everything is OK */
-				ctx->Card.AtrLen = recv_len - 2;
-				if (ctx->Card.AtrLen > sizeof(ctx->Card.Atr))
-					ctx->Card.AtrLen = sizeof(ctx->Card.Atr);
-				memcpy(ctx->Card.Atr, ctx->Card.Buffer, ctx->Card.AtrLen);
-
-				CalypsoTraceHex(TR_TRACE | TR_CARD, "- New ATR =", ctx->Card.Atr, ctx->Card.AtrLen);
-
-				rc = CalypsoParseCardAtr(ctx, NULL, 0);
-				CalypsoTraceRC(TR_TRACE | TR_CARD, "- ParseCardAtr ->", rc);
-			}
+			/* Remember this kind of card, next time we won't try to select the application */
+			profile = &ctx->CardProfiles.Entry[ctx->CardProfiles.Next];
+			ctx->CardProfiles.Next = (ctx->CardProfiles.Next + 1) % CALYPSO_CARD_PROFILES;
+			memcpy(profile->Key, key, keylen);
+			profile->KeyLen = (BYTE)keylen;
+			profile->Revision = ctx->CardApplication.Revision;
 		}
 #endif
-
-		if (!ctx->CardApplication.Revision)
-		{
-			/* At least try to select the Transport DF */
-			CALYPSO_SZ recv_len;
-			recv_len = sizeof(ctx->Card.Buffer);
-			rc = CalypsoCardSelectDF(ctx, 0x2000, ctx->Card.Buffer, &recv_len);
-			if (rc & CALYPSO_ERR_FATAL_) return rc;
-			if (rc == 0)
-			{
-				/* Success */
-
-				CalypsoTraceHex(TR_TRACE | TR_CARD, "- Transport DF ", ctx->Card.Buffer, recv_len);
-				ctx->CardApplication.Revision = 1;
-			}
-		}
-
 	}
 
 	if (!ctx->CardApplication.Revision)
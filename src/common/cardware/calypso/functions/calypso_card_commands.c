@@ -53,7 +53,8 @@ CALYPSO_RC CalypsoCardGetResponse(CALYPSO_CTX_ST* ctx, CALYPSO_SZ* recv_len)
 
 	old_recv_len = *recv_len;
 
-	cla = 0x00;
+	/* Once the revision is known, so is the class of the card */
+	cla = ctx->CardApplication.Revision ? ctx->Card.CLA : 0x00;
 
 	if ((ctx->Card.SW & 0xFF00) == 0x6100)
 	{
@@ -88,10 +89,10 @@ again:
 	case 0x6D00: break; /* No data */
 
 	case 0x6E00: /* CLA invalid */
-		if (first_time && (cla != ctx->Card.CLA))
+		if (first_time && (ctx->Card.CLA != 0x00))
 		{
 			first_time = FALSE;
-			cla = ctx->Card.CLA;
+			cla = (cla == 0x00) ? ctx->Card.CLA : 0x00;
 			*recv_len = old_recv_len;
 			goto again;
 		}
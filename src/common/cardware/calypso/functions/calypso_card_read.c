@@ -11,6 +11,7 @@
  *
  * HISTORY
  *   JDA 21/10/2008 : first public release
+ *   AGT 19/10/2026 : added CalypsoCardReadRecords (multiple records)
  *
  **/
 #include "../calypso_api_i.h"
@@ -450,36 +451,17 @@ done:
 	RETURN("ReadBinary");
 }
 
-/**f* SpringProxINS/CalypsoCardReadRecord
- *
- * NAME
- *   CalypsoCardReadRecord
- *
- * DESCRIPTION
- *   Read one record from the current EF (either cyclic or linear)
- *
- * INPUTS
- *   CALYPSO_CTX_ST *ctx      : library context
- *   BYTE           sfi       : identifier of the file (0 for current file)
- *   BYTE           rec_no    : identifier of the record
- *   BYTE           rec_size  : expected size of the record ('Le' parameter in APDU - may be 0)
- *   BYTE           data[]    : buffer to receive the data
- *   CALYPSO_SZ     *datasize : input  = size of the data buffer
- *                              output = actual length of the data
- *
- * RETURNS
- *   CALYPSO_RC               : 0 or an error code
- *
- **/
-CALYPSO_PROC CalypsoCardReadRecord(CALYPSO_CTX_ST* ctx, BYTE sfi, BYTE rec_no, BYTE rec_size, BYTE data[], CALYPSO_SZ* datasize)
+/*
+ * Read Record, the mode (P2 lowest bits) tells whether one record (4) or all the records
+ * starting at rec_no (5) are returned
+ */
+static CALYPSO_RC CalypsoCardReadRecordMode(CALYPSO_CTX_ST* ctx, BYTE sfi, BYTE rec_no, BYTE mode, BYTE rec_size, BYTE data[], CALYPSO_SZ* datasize)
 {
 	CALYPSO_RC rc;
 	CALYPSO_SZ recv_len, send_len;
 	CALYPSO_SZ old_datasize = 0;
 	BOOL first_time = TRUE;
 
-	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
-
 #ifdef CALYPSO_BENCHMARK
 	ctx->benchmark.nb_read++;
 #endif
@@ -490,15 +472,13 @@ CALYPSO_PROC CalypsoCardReadRecord(CALYPSO_CTX_ST* ctx, BYTE sfi, BYTE rec_no, B
 		*datasize = 0;
 	}
 
-	CalypsoTraceStr(TR_TRACE | TR_CARD, "ReadRecord");
-
 again:
 
 	send_len = 0;
 	ctx->Card.Buffer[send_len++] = ctx->Card.CLA;
 	ctx->Card.Buffer[send_len++] = CALYPSO_INS_READ_RECORD;
 	ctx->Card.Buffer[send_len++] = rec_no;
-	ctx->Card.Buffer[send_len++] = (sfi * 8) + 4;
+	ctx->Card.Buffer[send_len++] = (sfi * 8) + mode;
 	ctx->Card.Buffer[send_len++] = rec_size;
 
 	recv_len = sizeof(ctx->Card.Buffer);
@@ -545,5 +525,122 @@ again:
 		*datasize = recv_len - 2;
 
 done:
+	return rc;
+}
+
+/**f* SpringProxINS/CalypsoCardReadRecord
+ *
+ * NAME
+ *   CalypsoCardReadRecord
+ *
+ * DESCRIPTION
+ *   Read one record from the current EF (either cyclic or linear)
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx      : library context
+ *   BYTE           sfi       : identifier of the file (0 for current file)
+ *   BYTE           rec_no    : identifier of the record
+ *   BYTE           rec_size  : expected size of the record ('Le' parameter in APDU - may be 0)
+ *   BYTE           data[]    : buffer to receive the data
+ *   CALYPSO_SZ     *datasize : input  = size of the data buffer
+ *                              output = actual length of the data
+ *
+ * RETURNS
+ *   CALYPSO_RC               : 0 or an error code
+ *
+ **/
+CALYPSO_PROC CalypsoCardReadRecord(CALYPSO_CTX_ST* ctx, BYTE sfi, BYTE rec_no, BYTE rec_size, BYTE data[], CALYPSO_SZ* datasize)
+{
+	CALYPSO_RC rc;
+
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+
+	CalypsoTraceStr(TR_TRACE | TR_CARD, "ReadRecord");
+
+	rc = CalypsoCardReadRecordMode(ctx, sfi, rec_no, 4, rec_size, data, datasize);
+
 	RETURN("ReadRecord");
 }
+
+/**f* SpringProxINS/CalypsoCardReadRecords
+ *
+ * NAME
+ *   CalypsoCardReadRecords
+ *
+ * DESCRIPTION
+ *   Read all the records of an EF, starting at rec_no, in a single command.
+ *   The card returns as many records as its response may hold, each one being
+ *   prefixed by its number (1 byte) and its length (1 byte).
+ *   Use CalypsoCardNextRecord to walk through the response.
+ *
+ * WARNING
+ *   This function is only supported by Rev.3 cards
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx      : library context
+ *   BYTE           sfi       : identifier of the file (0 for current file)
+ *   BYTE           rec_no    : identifier of the first record
+ *   BYTE           ask_size  : expected size of the response ('Le' parameter in APDU - may be 0)
+ *   BYTE           data[]    : buffer to receive the data
+ *   CALYPSO_SZ     *datasize : input  = size of the data buffer
+ *                              output = actual length of the data
+ *
+ * RETURNS
+ *   CALYPSO_RC               : 0 or an error code
+ *
+ **/
+CALYPSO_PROC CalypsoCardReadRecords(CALYPSO_CTX_ST* ctx, BYTE sfi, BYTE rec_no, BYTE ask_size, BYTE data[], CALYPSO_SZ* datasize)
+{
+	CALYPSO_RC rc;
+
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+	if (ctx->CardApplication.Revision < 3) return CALYPSO_CARD_NOT_SUPPORTED;
+
+	CalypsoTraceStr(TR_TRACE | TR_CARD, "ReadRecords");
+
+	rc = CalypsoCardReadRecordMode(ctx, sfi, rec_no, 5, ask_size, data, datasize);
+
+	RETURN("ReadRecords");
+}
+
+/**f* SpringProxINS/CalypsoCardNextRecord
+ *
+ * NAME
+ *   CalypsoCardNextRecord
+ *
+ * DESCRIPTION
+ *   Walk through the response of CalypsoCardReadRecords
+ *
+ * INPUTS
+ *   const BYTE     data[]    : response of CalypsoCardReadRecords
+ *   CALYPSO_SZ     datasize  : length of the response
+ *   CALYPSO_SZ     *offset   : input  = offset of the record in the response (0 for the first one)
+ *                              output = offset of the next record
+ *   BYTE           *rec_no   : number of the record
+ *   const BYTE     **record  : pointer to the record's data in the response
+ *   BYTE           *rec_size : length of the record
+ *
+ * RETURNS
+ *   BOOL                     : TRUE if a record has been found, FALSE at the end of the response
+ *
+ **/
+CALYPSO_LIB BOOL CALYPSO_API CalypsoCardNextRecord(const BYTE data[], CALYPSO_SZ datasize, CALYPSO_SZ* offset, BYTE* rec_no, const BYTE** record, BYTE* rec_size)
+{
+	CALYPSO_SZ o;
+
+	if ((data == NULL) || (offset == NULL)) return FALSE;
+
+	o = *offset;
+	if ((o + 2) > datasize) return FALSE;
+	if ((o + 2 + data[o + 1]) > datasize) return FALSE;
+
+	if (rec_no != NULL)
+		*rec_no = data[o];
+	if (rec_size != NULL)
+		*rec_size = data[o + 1];
+	if (record != NULL)
+		*record = &data[o + 2];
+
+	*offset = o + 2 + data[o + 1];
+	return TRUE;
+}
@@ -43,6 +43,7 @@ CALYPSO_PROC CalypsoSamGetSW(CALYPSO_CTX_ST* ctx, BYTE sw[2])
 {
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
 	if (sw == NULL)  return CALYPSO_ERR_INVALID_PARAM;
+	CALYPSO_SAM_WAIT_JOB(ctx);
 
 	sw[0] = (BYTE)((ctx->Sam.SW >> 8) & 0x00FF);
 	sw[1] = (BYTE)(ctx->Sam.SW & 0x00FF);
@@ -138,12 +139,17 @@ CALYPSO_PROC CalypsoSamSelectDiversifier(CALYPSO_CTX_ST* ctx, const BYTE card_ui
 
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
 	if (card_uid == NULL) return CALYPSO_ERR_INVALID_PARAM;
+	CALYPSO_SAM_WAIT_JOB(ctx);
 
 again:
 	CalypsoTraceStr(TR_TRACE | TR_SAM, "SelectDiversifier");
 	CalypsoTraceHex(TR_TRACE | TR_SAM, "C'UID=", card_uid, 8);
 	CalypsoTraceValH(TR_TRACE | TR_SAM, "CLA=", ctx->Sam.CLA, 2);
 
+#ifdef CALYPSO_HOST
+	ctx->Sam.DiversifierValid = FALSE;
+#endif
+
 	send_len = 0;
 	ctx->Sam.Buffer[send_len++] = ctx->Sam.CLA;
 	ctx->Sam.Buffer[send_len++] = 0x14;
@@ -164,6 +170,14 @@ again:
 	{
 		if (recv_len > 2)
 			rc = CALYPSO_ERR_RESPONSE_SIZE;
+#ifdef CALYPSO_HOST
+		else
+		{
+			/* Remember the diversifier, no need to select it again for the same card */
+			memcpy(ctx->Sam.Diversifier, card_uid, 8);
+			ctx->Sam.DiversifierValid = TRUE;
+		}
+#endif
 	}
 	else
 	{
@@ -210,6 +224,7 @@ CALYPSO_PROC CalypsoSamGetChallenge(CALYPSO_CTX_ST* ctx, BYTE sam_chal[4])
 	CALYPSO_SZ recv_len, send_len = 0;
 
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+	CALYPSO_SAM_WAIT_JOB(ctx);
 
 	CalypsoTraceStr(TR_TRACE | TR_SAM, "GetChallenge");
 
@@ -255,6 +270,146 @@ done:
 	RETURN("GetChallenge");
 }
 
+#ifdef CALYPSO_HOST
+
+/**f* SpringProxINS/CalypsoSamSetChallengePrefetch
+ *
+ * NAME
+ *   CalypsoSamSetChallengePrefetch
+ *
+ * DESCRIPTION
+ *   Enable or disable the prefetch of the SAM challenge. When enabled,
+ *   CalypsoStartTransaction uses the challenge obtained by the last
+ *   CalypsoSamPrefetchChallenge instead of asking a new one, and doesn't
+ *   select the diversifier again if the SAM is already working with the
+ *   same card.
+ *   Enabling the SAM worker (CalypsoSamSetAsync) makes the library prefetch
+ *   the next challenge in background at the end of every transaction.
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx        : library context
+ *   BOOL           enable      : TRUE to enable the prefetch
+ *
+ * RETURNS
+ *   CALYPSO_RC                 : 0 or an error code
+ *
+ * SEE ALSO
+ *   CalypsoSamPrefetchChallenge
+ *
+ **/
+CALYPSO_PROC CalypsoSamSetChallengePrefetch(CALYPSO_CTX_ST* ctx, BOOL enable)
+{
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+
+	CalypsoSamAsyncWait(ctx);
+
+	ctx->Sam.ChallengePrefetch = enable ? TRUE : FALSE;
+	ctx->Sam.ChallengeValid = FALSE;
+	return 0;
+}
+
+/*
+ * Prefetch, as a job for the SAM worker
+ * param = UID of the card (optional)
+ */
+static CALYPSO_RC CalypsoSamPrefetchJob(CALYPSO_CTX_ST* ctx, const BYTE param[], CALYPSO_SZ paramsize)
+{
+	CALYPSO_RC rc;
+
+	if ((paramsize == 8) && (!ctx->Sam.DiversifierValid || memcmp(ctx->Sam.Diversifier, param, 8)))
+	{
+		rc = CalypsoSamSelectDiversifier(ctx, param);
+		if (rc) return rc;
+	}
+
+	rc = CalypsoSamGetChallenge(ctx, ctx->Sam.Challenge);
+	if (rc) return rc;
+
+	ctx->Sam.ChallengeValid = TRUE;
+	return 0;
+}
+
+/**f* SpringProxINS/CalypsoSamPrefetchChallenge
+ *
+ * NAME
+ *   CalypsoSamPrefetchChallenge
+ *
+ * DESCRIPTION
+ *   Ask the SAM for the challenge of the next session, and keep it until
+ *   CalypsoStartTransaction needs it.
+ *   The SAM forgets its challenge as soon as it receives another command,
+ *   including a Select Diversifier. Therefore the challenge is only kept
+ *   if the next session is opened on the card given here (or on the card
+ *   of the previous session, if card_uid is NULL), and if no other SAM
+ *   command occurs meanwhile.
+ *   Typical usage is to call this function as soon as the card has been
+ *   selected. With the SAM worker enabled, the SAM then works while the
+ *   application is reading the card.
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx        : library context
+ *   const BYTE     card_uid[8] : UID of the card, NULL to keep the current diversifier
+ *
+ * RETURNS
+ *   CALYPSO_RC                 : 0 or an error code (with the SAM worker, the
+ *                                error is reported by the next SAM command)
+ *
+ * SEE ALSO
+ *   CalypsoSamSetChallengePrefetch
+ *
+ **/
+CALYPSO_PROC CalypsoSamPrefetchChallenge(CALYPSO_CTX_ST* ctx, const BYTE card_uid[8])
+{
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+	if (!ctx->Sam.ChallengePrefetch) return CALYPSO_ERR_INVALID_PARAM;
+
+	CalypsoTraceStr(TR_TRACE | TR_SAM, "PrefetchChallenge");
+
+	return CalypsoSamAsyncPost(ctx, CalypsoSamPrefetchJob, card_uid, (card_uid != NULL) ? 8 : 0);
+}
+
+/*
+ * Select the diversifier and get the challenge for a new session, using
+ * the prefetched challenge when possible
+ */
+CALYPSO_RC CalypsoSamTakeChallenge(CALYPSO_CTX_ST* ctx, const BYTE card_uid[8], BYTE sam_chal[4])
+{
+	CALYPSO_RC rc;
+
+	if (ctx->Sam.ChallengePrefetch)
+	{
+		/* A failed prefetch only means that we have to do the job again */
+		rc = CalypsoSamAsyncWait(ctx);
+		if (rc)
+			CalypsoTraceRC(TR_TRACE | TR_SAM, "Prefetch err.", rc);
+
+		if (ctx->Sam.DiversifierValid && !memcmp(ctx->Sam.Diversifier, card_uid, 8))
+		{
+			if (ctx->Sam.ChallengeValid)
+			{
+				CalypsoTraceHex(TR_TRACE | TR_SAM, "S'Chal (prefetched)=", ctx->Sam.Challenge, 4);
+				memcpy(sam_chal, ctx->Sam.Challenge, 4);
+				ctx->Sam.ChallengeValid = FALSE;
+				return 0;
+			}
+		}
+		else
+		{
+			rc = CalypsoSamSelectDiversifier(ctx, card_uid);
+			if (rc) return rc;
+		}
+	}
+	else
+	{
+		rc = CalypsoSamSelectDiversifier(ctx, card_uid);
+		if (rc) return rc;
+	}
+
+	return CalypsoSamGetChallenge(ctx, sam_chal);
+}
+
+#endif
+
 CALYPSO_PROC CalypsoSamDigestInitCompat(CALYPSO_CTX_ST* ctx, BYTE kno, const BYTE cardresp[], CALYPSO_SZ cardrespsize)
 {
 	CALYPSO_RC rc;
@@ -263,6 +418,14 @@ CALYPSO_PROC CalypsoSamDigestInitCompat(CALYPSO_CTX_ST* ctx, BYTE kno, const BYT
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
 	if (cardresp == NULL) return CALYPSO_ERR_INVALID_PARAM;
 	if (cardrespsize > CALYPSO_MAX_DATA_SZ) return CALYPSO_ERR_INTERNAL_OVERFLOW;
+	CALYPSO_SAM_WAIT_JOB(ctx);
+
+#ifdef CALYPSO_HOST
+	/* New session, forget whatever remains from the previous one */
+	/* (when running in background, the caller has already done it) */
+	if (!CalypsoSamAsyncIsWorker(ctx))
+		ctx->Sam.DigestJournalLen = 0;
+#endif
 
 	CalypsoTraceStr(TR_TRACE | TR_SAM, "DigestInitCompat");
 	CalypsoTraceValH(TR_TRACE | TR_SAM, "KNO=", kno, 2);
@@ -343,6 +506,14 @@ CALYPSO_PROC CalypsoSamDigestInit(CALYPSO_CTX_ST* ctx, BYTE kif, BYTE kvc, const
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
 	if (cardresp == NULL) return CALYPSO_ERR_INVALID_PARAM;
 	if (cardrespsize > CALYPSO_MAX_DATA_SZ) return CALYPSO_ERR_INTERNAL_OVERFLOW;
+	CALYPSO_SAM_WAIT_JOB(ctx);
+
+#ifdef CALYPSO_HOST
+	/* New session, forget whatever remains from the previous one */
+	/* (when running in background, the caller has already done it) */
+	if (!CalypsoSamAsyncIsWorker(ctx))
+		ctx->Sam.DigestJournalLen = 0;
+#endif
 
 	CalypsoTraceStr(TR_TRACE | TR_SAM, "DigestInit");
 	CalypsoTraceValH(TR_TRACE | TR_SAM, "KIF=", kif, 2);
@@ -422,6 +593,7 @@ CALYPSO_PROC CalypsoSamDigestUpdate(CALYPSO_CTX_ST* ctx, const BYTE cardapdu[],
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
 	if (cardapdu == NULL) return CALYPSO_ERR_INVALID_PARAM;
 	if (cardapdusize > CALYPSO_MAX_DATA_SZ) return CALYPSO_ERR_INTERNAL_OVERFLOW;
+	CALYPSO_SAM_WAIT_JOB(ctx);
 
 	CalypsoTraceStr(TR_TRACE | TR_SAM, "DigestUpdate");
 	CalypsoTraceHex(TR_TRACE | TR_SAM, "C'APDU=", cardapdu, cardapdusize);
@@ -467,6 +639,179 @@ done:
 	RETURN("DigestUpdate");
 }
 
+#ifdef CALYPSO_HOST
+/*
+ * Send one Digest Update (P1=00) or Digest Update Multiple (P1=80) command.
+ * The command is built in a private buffer, since ctx->Sam.Buffer may hold the
+ * command that has triggered the flush of the journal
+ */
+static CALYPSO_RC CalypsoSamDigestSend(CALYPSO_CTX_ST* ctx, BYTE p1, const BYTE data[], CALYPSO_SZ datasize)
+{
+	BYTE buffer[CALYPSO_MAX_APDU_SZ];
+	CALYPSO_RC rc;
+	CALYPSO_SZ recv_len, send_len = 0;
+
+	buffer[send_len++] = ctx->Sam.CLA;
+	buffer[send_len++] = 0x8C;
+	buffer[send_len++] = p1;
+	buffer[send_len++] = 0x00;
+	buffer[send_len++] = (BYTE)datasize;
+	memcpy(&buffer[send_len], data, datasize);
+	send_len += datasize;
+
+#ifdef SPROX_LIB_INSIDE
+	if (calypso_sam_dirty)
+	{
+		CalypsoSamTransmitDirty(ctx, buffer, send_len);
+		return CALYPSO_SUCCESS;
+	}
+#endif
+
+	recv_len = sizeof(buffer);
+	rc = CalypsoSamTransmit(ctx, buffer, send_len, buffer, &recv_len);
+	if (rc) return rc;
+
+	if (recv_len < 2) return CALYPSO_ERR_RESPONSE_MISSING;
+
+	ctx->Sam.SW = buffer[recv_len - 2];
+	ctx->Sam.SW <<= 8;
+	ctx->Sam.SW |= buffer[recv_len - 1];
+
+	switch (ctx->Sam.SW)
+	{
+	case 0x9000: if (recv_len != 2) rc = CALYPSO_ERR_RESPONSE_SIZE; break;
+	case 0x6700: rc = CALYPSO_ERR_SW_WRONG_P3; break;
+	case 0x6985: rc = CALYPSO_SAM_NOT_IN_SESSION; break;
+	default: rc = CALYPSO_ERR_STATUS_WORD;
+	}
+
+	return rc;
+}
+
+/*
+ * Record a card's APDU (in/out) in the digest journal. The journal is given to the SAM
+ * by CalypsoSamDigestFlush, either explicitly or before the next command sent to the SAM
+ */
+CALYPSO_RC CalypsoSamDigestPush(CALYPSO_CTX_ST* ctx, const BYTE cardapdu[], CALYPSO_SZ cardapdusize)
+{
+	CALYPSO_RC rc;
+
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+	if (cardapdu == NULL) return CALYPSO_ERR_INVALID_PARAM;
+
+#ifdef SPROX_LIB_INSIDE
+	if (calypso_sam_dirty)
+	{
+		/* The SAM is fed on the fly, CalypsoSamDigestUpdate won't wait for its answer */
+		rc = CalypsoSamDigestFlush(ctx);
+		if (rc) return rc;
+		return CalypsoSamDigestUpdate(ctx, cardapdu, cardapdusize);
+	}
+#endif
+
+	if (cardapdusize > 254)
+	{
+		/* Too long to be part of a Digest Update Multiple, send it on its own */
+		rc = CalypsoSamDigestFlush(ctx);
+		if (rc) return rc;
+		return CalypsoSamDigestUpdate(ctx, cardapdu, cardapdusize);
+	}
+
+	if ((ctx->Sam.DigestJournalLen + 1 + cardapdusize) > sizeof(ctx->Sam.DigestJournal))
+	{
+		/* Journal is full */
+		rc = CalypsoSamDigestFlush(ctx);
+		if (rc) return rc;
+	}
+
+	ctx->Sam.DigestJournal[ctx->Sam.DigestJournalLen++] = (BYTE)cardapdusize;
+	memcpy(&ctx->Sam.DigestJournal[ctx->Sam.DigestJournalLen], cardapdu, cardapdusize);
+	ctx->Sam.DigestJournalLen += cardapdusize;
+
+	return CALYPSO_SUCCESS;
+}
+
+/**f* SpringProxINS/CalypsoSamDigestFlush
+ *
+ * NAME
+ *   CalypsoSamDigestFlush
+ *
+ * DESCRIPTION
+ *   Forward to the SAM the card's APDUs that have been recorded since the last flush
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx         : library context
+ *
+ * RETURNS
+ *   CALYPSO_RC                  : 0 or an error code
+ *
+ * NOTES
+ *   When a session is active, CalypsoCardTransmit doesn't call CalypsoSamDigestUpdate
+ *   anymore, but records the APDUs in a journal. The journal is flushed automatically
+ *   before any other command is sent to the SAM (CalypsoSamDigestClose typically),
+ *   so the SAM sees the same APDUs in the same order.
+ *   A SAM with CLA=80 receives as many APDUs as possible in each Digest Update Multiple
+ *   command ; other SAMs receive one Digest Update command per APDU.
+ *
+ **/
+CALYPSO_PROC CalypsoSamDigestFlush(CALYPSO_CTX_ST* ctx)
+{
+	CALYPSO_RC rc = CALYPSO_SUCCESS;
+	CALYPSO_SZ offset = 0, length;
+
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+	CALYPSO_SAM_WAIT_JOB(ctx);
+	if (ctx->Sam.DigestFlushing) return CALYPSO_SUCCESS;
+	if (ctx->Sam.DigestJournalLen == 0) return CALYPSO_SUCCESS;
+
+	CalypsoTraceValD(TR_TRACE | TR_SAM, "DigestFlush ", ctx->Sam.DigestJournalLen, 0);
+
+	ctx->Sam.DigestFlushing = TRUE;
+
+	while (offset < ctx->Sam.DigestJournalLen)
+	{
+		if ((ctx->Sam.CLA == 0x80) && !ctx->Sam.NoDigestUpdateMultiple)
+		{
+			/* As many APDUs as possible, each one prefixed by its length */
+			length = 0;
+			while (((offset + length) < ctx->Sam.DigestJournalLen) && ((length + 1 + ctx->Sam.DigestJournal[offset + length]) <= 255))
+				length += 1 + ctx->Sam.DigestJournal[offset + length];
+
+			rc = CalypsoSamDigestSend(ctx, 0x80, &ctx->Sam.DigestJournal[offset], length);
+			if (rc == CALYPSO_ERR_STATUS_WORD)
+			{
+				switch (ctx->Sam.SW)
+				{
+				case 0x6A86:
+				case 0x6B00:
+				case 0x6D00:
+				case 0x6E00:
+					/* Digest Update Multiple not supported, retry with one APDU at a time */
+					CalypsoTraceStr(TR_TRACE | TR_SAM, "DigestUpdateMultiple not supported");
+					ctx->Sam.NoDigestUpdateMultiple = TRUE;
+					continue;
+				default:
+					break;
+				}
+			}
+		}
+		else
+		{
+			length = 1 + ctx->Sam.DigestJournal[offset];
+			rc = CalypsoSamDigestSend(ctx, 0x00, &ctx->Sam.DigestJournal[offset + 1], length - 1);
+		}
+
+		if (rc) break;
+		offset += length;
+	}
+
+	ctx->Sam.DigestJournalLen = 0;
+	ctx->Sam.DigestFlushing = FALSE;
+
+	RETURN("DigestFlush");
+}
+#endif
+
 /**f* SpringProxINS/CalypsoSamDigestClose
  *
  * NAME
@@ -490,6 +835,7 @@ CALYPSO_PROC CalypsoSamDigestClose(CALYPSO_CTX_ST* ctx, BYTE sam_sign[4])
 	CALYPSO_SZ recv_len, send_len = 0;
 
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+	CALYPSO_SAM_WAIT_JOB(ctx);
 
 	CalypsoTraceStr(TR_TRACE | TR_SAM, "DigestClose");
 
@@ -558,6 +904,7 @@ CALYPSO_PROC CalypsoSamDigestAuthenticate(CALYPSO_CTX_ST* ctx, const BYTE card_s
 
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
 	if (card_sign == NULL) return CALYPSO_ERR_INVALID_PARAM;
+	CALYPSO_SAM_WAIT_JOB(ctx);
 
 	CalypsoTraceStr(TR_TRACE | TR_SAM, "DigestAuthenticate");
 	CalypsoTraceHex(TR_TRACE | TR_SAM, "C'Sign=", card_sign, 4);
@@ -623,6 +970,7 @@ CALYPSO_PROC CalypsoSamGiveRandom(CALYPSO_CTX_ST* ctx, const BYTE challenge[8])
 
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
 	if (challenge == NULL) return CALYPSO_ERR_INVALID_PARAM;
+	CALYPSO_SAM_WAIT_JOB(ctx);
 
 again:
 	CalypsoTraceStr(TR_TRACE | TR_SAM, "GiveRandom");
@@ -701,6 +1049,7 @@ CALYPSO_PROC CalypsoSamCipherCardDataEx(P_CALYPSO_CTX ctx, BYTE apdu_p1, BYTE ap
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
 	if (plain == NULL) return CALYPSO_ERR_INTERNAL_ERROR;
 	if (plainsize > CALYPSO_MAX_DATA_SZ) return CALYPSO_ERR_INTERNAL_ERROR;
+	CALYPSO_SAM_WAIT_JOB(ctx);
 
 	CalypsoTraceStr(TR_TRACE | TR_SAM, "CipherCardData");
 	CalypsoTraceValH(TR_TRACE | TR_SAM, "P1=", apdu_p1, 2);
@@ -382,6 +382,8 @@ CALYPSO_PROC CalypsoCardStoredValueDebit(CALYPSO_CTX_ST* ctx, const BYTE get_sv_
 	}
 	ctx->Card.Buffer[card_send_len++] = kvc; /* KVC */
 
+	CALYPSO_SAM_WAIT_JOB(ctx);
+
 	/* Generate the SAM command */
 	/* ------------------------ */
 
@@ -623,6 +625,8 @@ CALYPSO_PROC CalypsoCardStoredValueReload(CALYPSO_CTX_ST* ctx, const BYTE get_sv
 	}
 
 
+	CALYPSO_SAM_WAIT_JOB(ctx);
+
 	/* Generate the SAM command */
 	/* ------------------------ */
 
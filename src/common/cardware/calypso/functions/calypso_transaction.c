@@ -12,12 +12,44 @@
  * HISTORY
  *   JDA 21/10/2008 : first public release
  *   JDA 15/08/2009 : implemented Revision 3
+ *   AGT 19/10/2026 : Digest Init may run in background (CalypsoSamSetAsync)
  *
  **/
 #include "../calypso_api_i.h"
 
 #ifndef CALYPSO_NO_TRANS
 
+#if (CALYPSO_WITH_SAM) && defined(CALYPSO_HOST)
+/*
+ * Digest Init, as a job for the SAM worker
+ * param = compat flag, KIF (or key number), KVC, card's response to Open Secure Session
+ */
+static CALYPSO_RC CalypsoSamDigestInitJob(CALYPSO_CTX_ST* ctx, const BYTE param[], CALYPSO_SZ paramsize)
+{
+	if (param[0])
+		return CalypsoSamDigestInitCompat(ctx, param[1], &param[3], paramsize - 3);
+	return CalypsoSamDigestInit(ctx, param[1], param[2], &param[3], paramsize - 3);
+}
+
+static CALYPSO_RC CalypsoSamDigestInitPost(CALYPSO_CTX_ST* ctx, BOOL compat, BYTE kif, BYTE kvc, const BYTE card_resp[], CALYPSO_SZ card_respsize)
+{
+	BYTE param[3 + 64];
+
+	if (card_respsize > sizeof(param) - 3)
+		return CALYPSO_ERR_INTERNAL_OVERFLOW;
+
+	param[0] = compat ? 1 : 0;
+	param[1] = kif;
+	param[2] = kvc;
+	memcpy(&param[3], card_resp, card_respsize);
+
+	/* Card APDUs sent while the SAM is busy go to the journal of the new session */
+	ctx->Sam.DigestJournalLen = 0;
+
+	return CalypsoSamAsyncPost(ctx, CalypsoSamDigestInitJob, param, 3 + card_respsize);
+}
+#endif
+
  /**f* SpringProxINS/CalypsoStartTransaction
   *
   * NAME
@@ -126,6 +158,11 @@ CALYPSO_PROC CalypsoStartTransactionEx(CALYPSO_CTX_ST* ctx, BOOL* ratified, BYTE
 	}
 
 #if (CALYPSO_WITH_SAM)
+#ifdef CALYPSO_HOST
+	/* Feed the SAM with card's UID and get its challenge (maybe already prefetched) */
+	rc = CalypsoSamTakeChallenge(ctx, ctx->CardApplication.UID, sam_chal);
+	if (rc) goto done;
+#else
 	/* Feed the SAM with card's UID */
 	rc = CalypsoSamSelectDiversifier(ctx, ctx->CardApplication.UID);
 	if (rc) goto done;
@@ -133,6 +170,7 @@ CALYPSO_PROC CalypsoStartTransactionEx(CALYPSO_CTX_ST* ctx, BOOL* ratified, BYTE
 	/* Ask the SAM to provide a challenge */
 	rc = CalypsoSamGetChallenge(ctx, sam_chal);
 	if (rc) goto done;
+#endif
 
 #else
 
@@ -183,7 +221,11 @@ CALYPSO_PROC CalypsoStartTransactionEx(CALYPSO_CTX_ST* ctx, BOOL* ratified, BYTE
 		default: rc = CALYPSO_KIF_IS_UNKNOWN_FOR_KEY; goto done;
 		}
 
+#ifdef CALYPSO_HOST
+		rc = CalypsoSamDigestInitPost(ctx, TRUE, kno, 0, resp, respsize);
+#else
 		rc = CalypsoSamDigestInitCompat(ctx, kno, resp, respsize);
+#endif
 	}
 	else
 	{
@@ -200,7 +242,11 @@ CALYPSO_PROC CalypsoStartTransactionEx(CALYPSO_CTX_ST* ctx, BOOL* ratified, BYTE
 			CalypsoTraceValH(TR_TRACE | TR_TRANS, "KIF used=", kif, 2);
 		}
 
+#ifdef CALYPSO_HOST
+		rc = CalypsoSamDigestInitPost(ctx, FALSE, kif, kvc, resp, respsize);
+#else
 		rc = CalypsoSamDigestInit(ctx, kif, kvc, resp, respsize);
+#endif
 	}
 #endif
 
@@ -272,7 +318,12 @@ CALYPSO_PROC CalypsoCommitTransaction(CALYPSO_CTX_ST* ctx, BOOL ratify_now)
 
 	/* Ask the SAM to compute the signature */
 	rc = CalypsoSamDigestClose(ctx, sam_sign);
-	if (rc) goto done;
+	if (rc)
+	{
+		/* No signature (maybe Digest Init has failed in background), rollback on the card side */
+		CalypsoCardCloseSecureSession(ctx, FALSE, NULL, NULL, NULL);
+		goto done;
+	}
 
 	/* Ask the card to close its session */
 	rc = CalypsoCardCloseSecureSession(ctx, ratify_now, sam_sign, resp, &respsize);
@@ -293,6 +344,12 @@ CALYPSO_PROC CalypsoCommitTransaction(CALYPSO_CTX_ST* ctx, BOOL ratify_now)
 	rc = CalypsoSamDigestAuthenticate(ctx, card_sign);
 	if (rc) goto done;
 
+#if (CALYPSO_WITH_SAM) && defined(CALYPSO_HOST)
+	/* The SAM is idle until the next session, let it prepare its challenge */
+	if (ctx->Sam.ChallengePrefetch && (ctx->Sam.Async != NULL))
+		CalypsoSamPrefetchChallenge(ctx, NULL);
+#endif
+
 done:
 	return rc;
 }
@@ -334,9 +391,22 @@ CALYPSO_PROC CalypsoCancelTransaction(CALYPSO_CTX_ST* ctx)
 
 	ctx->CardApplication.SessionActive = FALSE;
 
+#if (CALYPSO_WITH_SAM) && defined(CALYPSO_HOST)
+	/* The SAM doesn't need the APDUs of a cancelled session */
+	ctx->Sam.DigestJournalLen = 0;
+	/* Nor the result of its Digest Init, if still running in background */
+	CalypsoSamAsyncWait(ctx);
+#endif
+
 	/* Ask the card to close its session */
 	rc = CalypsoCardCloseSecureSession(ctx, FALSE, NULL, resp, &respsize);
 
+#if (CALYPSO_WITH_SAM) && defined(CALYPSO_HOST)
+	/* The SAM is idle until the next session, let it prepare its challenge */
+	if (ctx->Sam.ChallengePrefetch && (ctx->Sam.Async != NULL))
+		CalypsoSamPrefetchChallenge(ctx, NULL);
+#endif
+
 	return rc;
 }
 
@@ -1,87 +1,74 @@
 #include "../calypso_api_i.h"
 
+/* Date and time come before the bitmap */
+#define CALYPSO_EVENT_FIXED 2
+#define EVENT_FIELD(n) fields[CALYPSO_EVENT_FIXED + (n)]
+
 CALYPSO_PROC CalypsoEncodeEventRecord(P_CALYPSO_CTX ctx, BYTE data[], BYTE size, CALYPSO_EVENT_ST* values)
 {
+	DWORD fields[CALYPSO_EVENT_FIXED + 28];
 	DWORD gen_bitmap = 0;
-	CALYPSO_BITS_SZ pos_bitmap = 0;
 	CALYPSO_BITS_SZ bit_offset = 0;
 
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
 	if ((data == NULL) || (values == NULL)) return CALYPSO_ERR_INVALID_PARAM;
 
 	memset(data, 0, size);
+	memset(fields, 0, sizeof(fields));
 
-	/* Put date and time */
-	if (!set_dword_bits(data, size, &bit_offset, 14, values->EventDate)) goto failed;
-	if (!set_dword_bits(data, size, &bit_offset, 11, values->EventTime)) goto failed;
+	/* Date and time */
+	fields[0] = values->EventDate;
+	fields[1] = values->EventTime;
 
-	/* Leave room for the general bitmap (will be update later) */
-	pos_bitmap = bit_offset;
-	if (!set_dword_bits(data, size, &bit_offset, 28, 0)) goto failed;
+	/* Code */
+	gen_bitmap |= 0x00000004;
+	EVENT_FIELD(2) = values->Code;
+
+	/* Service provider */
+	gen_bitmap |= 0x00000010;
+	EVENT_FIELD(4) = values->ServiceProvider;
 
-	if (TRUE)
-	{
-		/* Code */
-		gen_bitmap |= 0x00000004;
-		if (!set_dword_bits(data, size, &bit_offset, 8, values->Code)) goto failed;
-	}
-	if (TRUE)
-	{
-		/* Service provider */
-		gen_bitmap |= 0x00000010;
-		if (!set_dword_bits(data, size, &bit_offset, 8, values->ServiceProvider)) goto failed;
-	}
 	if (values->_NotOKCounter)
 	{
 		/* Not OK Counter */
 		gen_bitmap |= 0x00000020;
-		if (!set_dword_bits(data, size, &bit_offset, 8, values->NotOKCounter)) goto failed;
+		EVENT_FIELD(5) = values->NotOKCounter;
 	}
 	if (values->_LocationId)
 	{
 		/* LocationId */
 		gen_bitmap |= 0x00000100;
-		if (!set_dword_bits(data, size, &bit_offset, 16, values->LocationId)) goto failed;
+		EVENT_FIELD(8) = values->LocationId;
 	}
 	if (values->_Device)
 	{
 		/* Device */
 		gen_bitmap |= 0x00000400;
-		if (!set_dword_bits(data, size, &bit_offset, 16, values->Device)) goto failed;
+		EVENT_FIELD(10) = values->Device;
 	}
 	if (values->_RouteNumber)
 	{
 		/* RouteNumber */
 		gen_bitmap |= 0x00000800;
-		if (!set_dword_bits(data, size, &bit_offset, 16, values->RouteNumber)) goto failed;
+		EVENT_FIELD(11) = values->RouteNumber;
 	}
 	if (values->_JourneyRun)
 	{
 		/* JourneyRun */
 		gen_bitmap |= 0x00002000;
-		if (!set_dword_bits(data, size, &bit_offset, 16, values->JourneyRun)) goto failed;
+		EVENT_FIELD(13) = values->JourneyRun;
 	}
 	if (values->_VehicleId)
 	{
 		/* VehicleId */
 		gen_bitmap |= 0x00004000;
-		if (!set_dword_bits(data, size, &bit_offset, 16, values->VehicleId)) goto failed;
-	}
-	if (TRUE)
-	{
-		/* ContractPointer */
-		gen_bitmap |= 0x02000000;
-		if (!set_dword_bits(data, size, &bit_offset, 5, values->ContractPointer)) goto failed;
+		EVENT_FIELD(14) = values->VehicleId;
 	}
 
-	/* Put back the actual bitmap */
-	set_dword_bits(data, size, &pos_bitmap, 28, gen_bitmap);
+	/* ContractPointer */
+	gen_bitmap |= 0x02000000;
+	EVENT_FIELD(25) = values->ContractPointer;
 
 	/* Here we go ! */
-	return 0;
-
-failed:
-	return CALYPSO_ERR_BUFFER_TOO_SHORT;
+	return CalypsoIntercodeEncode(ctx, &CalypsoIntercodeEvent, data, size, &bit_offset, gen_bitmap, fields);
 }
-
-
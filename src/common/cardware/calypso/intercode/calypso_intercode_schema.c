@@ -0,0 +1,336 @@
+/**h* CalypsoAPI/calypso_intercode_schema.c
+ *
+ * NAME
+ *   calypso_intercode_schema.c
+ *
+ * DESCRIPTION
+ *   Layout of the INTERCODE records, and the generic decoder and encoder
+ *   that walk them. The structure output, the XML output and the encoder
+ *   only differ by what they do with the fields.
+ *
+ * COPYRIGHT
+ *   (c) 2026 SpringCard - www.springcard.com
+ *
+ * HISTORY
+ *   AGT 19/10/2026 : created from the hand-written parsers
+ *
+ **/
+#include "../calypso_api_i.h"
+
+/*
+ **********************************************************************************************************************
+ *
+ * SCHEMA
+ *
+ **********************************************************************************************************************
+ */
+
+/* Environment */
+/* ----------- */
+
+static const CALYPSO_INTERCODE_FIELD_ST EnvDataFields[] =
+{
+	{  1, INTERCODE_FMT_DEC,     INTERCODE_ID_ENV_DATA_STATUS,   strStatus,        NULL }, /* 0 */
+	{  0, INTERCODE_FMT_NONE,    INTERCODE_ID_NONE,              NULL,             NULL }, /* 1 : TODO */
+};
+static const CALYPSO_INTERCODE_MAP_ST EnvData = { 0, 2, 0, EnvDataFields };
+
+static const CALYPSO_INTERCODE_FIELD_ST EnvironmentFields[] =
+{
+	{  6, INTERCODE_FMT_VERSION, INTERCODE_ID_ENV_VERSION,       strVersion,       NULL },
+	{ 24, INTERCODE_FMT_NETWORK, INTERCODE_ID_ENV_NETWORK_ID,    strNetwork,       NULL }, /* 0 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_ENV_ISSUER_ID,     strIssuer,        NULL }, /* 1 */
+	{ 14, INTERCODE_FMT_DATE,    INTERCODE_ID_ENV_END_DATE,      strEndDate,       NULL }, /* 2 */
+	{ 11, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strPayMethod,     NULL }, /* 3 */
+	{ 16, INTERCODE_FMT_HEX16,   INTERCODE_ID_ENV_AUTHENTICATOR, strAuthenticator, NULL }, /* 4 */
+	{ 32, INTERCODE_FMT_BIN,     INTERCODE_ID_NONE,              strSelect,        NULL }, /* 5 */
+	{  0, INTERCODE_FMT_BITMAP,  INTERCODE_ID_NONE,              strData,          &EnvData }, /* 6 */
+};
+const CALYPSO_INTERCODE_MAP_ST CalypsoIntercodeEnvironment = { 1, 7, 0, EnvironmentFields };
+
+/* Contract */
+/* -------- */
+
+static const CALYPSO_INTERCODE_FIELD_ST ContractCustomerFields[] =
+{
+	{  6, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strProfile,       NULL }, /* 0 */
+	{ 32, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strNumber,        NULL }, /* 1 */
+};
+static const CALYPSO_INTERCODE_MAP_ST ContractCustomer = { 0, 2, 0, ContractCustomerFields };
+
+static const CALYPSO_INTERCODE_FIELD_ST ContractPassengerFields[] =
+{
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strClass,         NULL }, /* 0 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strTotal,         NULL }, /* 1 */
+};
+static const CALYPSO_INTERCODE_MAP_ST ContractPassenger = { 0, 2, 0, ContractPassengerFields };
+
+static const CALYPSO_INTERCODE_FIELD_ST ContractRestrictFields[] =
+{
+	{ 11, INTERCODE_FMT_TIME,    INTERCODE_ID_NONE,              strStart,         NULL }, /* 0 */
+	{ 11, INTERCODE_FMT_TIME,    INTERCODE_ID_NONE,              strEnd,           NULL }, /* 1 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strDay,           NULL }, /* 2 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strTimeCode,      NULL }, /* 3 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strCode,          NULL }, /* 4 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strProduct,       NULL }, /* 5 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strLocation,      NULL }, /* 6 */
+};
+static const CALYPSO_INTERCODE_MAP_ST ContractRestrict = { 0, 7, 0, ContractRestrictFields };
+
+static const CALYPSO_INTERCODE_FIELD_ST ContractValidityFields[] =
+{
+	{ 14, INTERCODE_FMT_DATE,    INTERCODE_ID_CONTRACT_START_DATE, strStartDate,   NULL }, /* 0 */
+	{ 11, INTERCODE_FMT_TIME,    INTERCODE_ID_NONE,              strStartTime,     NULL }, /* 1 */
+	{ 14, INTERCODE_FMT_DATE,    INTERCODE_ID_CONTRACT_END_DATE, strEndDate,       NULL }, /* 2 */
+	{ 11, INTERCODE_FMT_TIME,    INTERCODE_ID_NONE,              strEndTime,       NULL }, /* 3 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strDuration,      NULL }, /* 4 */
+	{ 14, INTERCODE_FMT_DATE,    INTERCODE_ID_NONE,              strLimitDate,     NULL }, /* 5 */
+	{  8, INTERCODE_FMT_ZONES,   INTERCODE_ID_CONTRACT_ZONES,    strZones,         NULL }, /* 6 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strValidJourneys, NULL }, /* 7 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strPeriodJourneys, NULL }, /* 8 */
+};
+static const CALYPSO_INTERCODE_MAP_ST ContractValidity = { 0, 9, 0, ContractValidityFields };
+
+static const CALYPSO_INTERCODE_FIELD_ST ContractJourneyFields[] =
+{
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strOrigin,        NULL }, /* 0 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strDestination,   NULL }, /* 1 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strRouteNumbers,  NULL }, /* 2 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strRouteVariants, NULL }, /* 3 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strRun,           NULL }, /* 4 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strVia,           NULL }, /* 5 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strDistance,      NULL }, /* 6 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strInterchanges,  NULL }, /* 7 */
+};
+static const CALYPSO_INTERCODE_MAP_ST ContractJourney = { 0, 8, 0, ContractJourneyFields };
+
+static const CALYPSO_INTERCODE_FIELD_ST ContractSaleFields[] =
+{
+	{ 14, INTERCODE_FMT_DATE,    INTERCODE_ID_NONE,              strDate,          NULL }, /* 0 */
+	{ 11, INTERCODE_FMT_TIME,    INTERCODE_ID_NONE,              strTime,          NULL }, /* 1 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strProvider,      NULL }, /* 2 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strDevice,        NULL }, /* 3 */
+};
+static const CALYPSO_INTERCODE_MAP_ST ContractSale = { 0, 4, 0, ContractSaleFields };
+
+static const CALYPSO_INTERCODE_FIELD_ST ContractFields[] =
+{
+	{ 24, INTERCODE_FMT_NETWORK, INTERCODE_ID_CONTRACT_NETWORK_ID, strNetwork,     NULL }, /* 0 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_CONTRACT_PROVIDER, strProvider,      NULL }, /* 1 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_CONTRACT_TARIFF,   strTariff,        NULL }, /* 2 */
+	{ 32, INTERCODE_FMT_DEC,     INTERCODE_ID_CONTRACT_SERIAL_NUMBER, strNumber,   NULL }, /* 3 */
+	{  0, INTERCODE_FMT_BITMAP,  INTERCODE_ID_NONE,              strCustomer,      &ContractCustomer }, /* 4 */
+	{  0, INTERCODE_FMT_BITMAP,  INTERCODE_ID_NONE,              strPassenger,     &ContractPassenger }, /* 5 */
+	{  6, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strClassAllowed,  NULL }, /* 6 */
+	{ 32, INTERCODE_FMT_PAYPTR,  INTERCODE_ID_NONE,              strPayPointer,    NULL }, /* 7 */
+	{ 11, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strPayMethod,     NULL }, /* 8 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strServices,      NULL }, /* 9 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strPriceAmount,   NULL }, /* 10 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strPriceUnit,     NULL }, /* 11 */
+	{  0, INTERCODE_FMT_BITMAP,  INTERCODE_ID_NONE,              strRestrict,      &ContractRestrict }, /* 12 */
+	{  0, INTERCODE_FMT_BITMAP,  INTERCODE_ID_NONE,              strValidity,      &ContractValidity }, /* 13 */
+	{  0, INTERCODE_FMT_BITMAP,  INTERCODE_ID_NONE,              strJourney,       &ContractJourney }, /* 14 */
+	{  0, INTERCODE_FMT_BITMAP,  INTERCODE_ID_NONE,              strSale,          &ContractSale }, /* 15 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_CONTRACT_STATUS,   strStatus,        NULL }, /* 16 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strLoyalty,       NULL }, /* 17 */
+	{  0, INTERCODE_FMT_AUTH,    INTERCODE_ID_CONTRACT_AUTHENTICATOR, strAuthenticator, NULL }, /* 18 */
+	{  0, INTERCODE_FMT_NONE,    INTERCODE_ID_NONE,              NULL,             NULL }, /* 19 : TODO */
+};
+const CALYPSO_INTERCODE_MAP_ST CalypsoIntercodeContract = { 0, 20, 16, ContractFields };
+
+/* Event */
+/* ----- */
+
+static const CALYPSO_INTERCODE_FIELD_ST EventDataFields[] =
+{
+	{ 14, INTERCODE_FMT_DATE,    INTERCODE_ID_NONE,              strStartDate,     NULL }, /* 0 */
+	{ 11, INTERCODE_FMT_TIME,    INTERCODE_ID_NONE,              strStartTime,     NULL }, /* 1 */
+	{  1, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strSimul,         NULL }, /* 2 */
+	{  2, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strTrip,          NULL }, /* 3 */
+	{  2, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strDirection,     NULL }, /* 4 */
+};
+static const CALYPSO_INTERCODE_MAP_ST EventData = { 0, 5, 0, EventDataFields };
+
+static const CALYPSO_INTERCODE_FIELD_ST EventFields[] =
+{
+	{ 14, INTERCODE_FMT_DATE,    INTERCODE_ID_NONE,              strDate,          NULL },
+	{ 11, INTERCODE_FMT_TIME,    INTERCODE_ID_NONE,              strTime,          NULL },
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strDisplayData,   NULL }, /* 0 */
+	{ 24, INTERCODE_FMT_NETWORK, INTERCODE_ID_NONE,              strNetwork,       NULL }, /* 1 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strCode,          NULL }, /* 2 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strResult,        NULL }, /* 3 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strProvider,      NULL }, /* 4 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strNotOKCounter,  NULL }, /* 5 */
+	{ 24, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strNumber,        NULL }, /* 6 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strDestination,   NULL }, /* 7 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strLocation,      NULL }, /* 8 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strLocationGate,  NULL }, /* 9 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strDevice,        NULL }, /* 10 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strRouteNumber,   NULL }, /* 11 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strRouteVariant,  NULL }, /* 12 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strJourneyRun,    NULL }, /* 13 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strVehicle,       NULL }, /* 14 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strVehicleClass,  NULL }, /* 15 */
+	{  5, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strLocationType,  NULL }, /* 16 */
+	{ 24, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strEmployee,      NULL }, /* 17 : TODO */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strLocationRef,   NULL }, /* 18 */
+	{  8, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strJourneyInterchanges, NULL }, /* 19 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strPeriodJourneys, NULL }, /* 20 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strTotalJourneys, NULL }, /* 21 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strJourneyDistance, NULL }, /* 22 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strPriceAmount,   NULL }, /* 23 */
+	{ 16, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strPriceUnit,     NULL }, /* 24 */
+	{  5, INTERCODE_FMT_DEC,     INTERCODE_ID_NONE,              strContract,      NULL }, /* 25 */
+	{  0, INTERCODE_FMT_AUTH,    INTERCODE_ID_NONE,              strAuthenticator, NULL }, /* 26 */
+	{  0, INTERCODE_FMT_BITMAP,  INTERCODE_ID_NONE,              strData,          &EventData }, /* 27 */
+};
+const CALYPSO_INTERCODE_MAP_ST CalypsoIntercodeEvent = { 2, 28, 0, EventFields };
+
+/*
+ **********************************************************************************************************************
+ *
+ * DECODER AND ENCODER
+ *
+ **********************************************************************************************************************
+ */
+
+/* Index of the lowest bit set in a (non zero) bitmap, De Bruijn sequence */
+static const BYTE lowest_bit_index[32] =
+{
+	0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+	31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+};
+#define LOWEST_BIT(b) lowest_bit_index[(DWORD)(((b) & (0 - (b))) * 0x077CB531UL) >> 27]
+
+static BYTE CalypsoIntercodeWidth(CALYPSO_CTX_ST* ctx, const CALYPSO_INTERCODE_FIELD_ST* field)
+{
+	if (field->Format == INTERCODE_FMT_AUTH)
+		return (ctx->CardData.EnvVersion & 0x38) ? 16 : 8;
+	return field->Width;
+}
+
+static BOOL CalypsoIntercodeDecodeBits(CALYPSO_CTX_ST* ctx, const CALYPSO_INTERCODE_FIELD_ST fields[], DWORD bitmap, CALYPSO_BITS_READER_ST* reader, CALYPSO_INTERCODE_VISITOR visitor, void* param);
+
+static BOOL CalypsoIntercodeDecodeField(CALYPSO_CTX_ST* ctx, const CALYPSO_INTERCODE_FIELD_ST* field, CALYPSO_BITS_READER_ST* reader, CALYPSO_INTERCODE_VISITOR visitor, void* param)
+{
+	const CALYPSO_INTERCODE_MAP_ST* sub;
+	DWORD value;
+	BYTE width;
+	BOOL rc;
+
+	switch (field->Format)
+	{
+	case INTERCODE_FMT_NONE:
+		return TRUE;
+
+	case INTERCODE_FMT_BITMAP:
+		sub = field->Sub;
+		if (!bits_reader_get(reader, sub->BitmapWidth, &value)) return FALSE;
+		if (!value) return TRUE;
+
+		visitor(ctx, param, INTERCODE_EV_BEGIN, field, sub->BitmapWidth, value);
+		rc = CalypsoIntercodeDecodeBits(ctx, sub->Fields + sub->Fixed, value, reader, visitor, param);
+		visitor(ctx, param, INTERCODE_EV_END, field, sub->BitmapWidth, value);
+		return rc;
+
+	default:
+		break;
+	}
+
+	width = CalypsoIntercodeWidth(ctx, field);
+	if (!bits_reader_get(reader, width, &value)) return FALSE;
+
+	if (field->Format == INTERCODE_FMT_VERSION)
+		ctx->CardData.EnvVersion = (BYTE)value;
+
+	visitor(ctx, param, INTERCODE_EV_VALUE, field, width, value);
+	return TRUE;
+}
+
+/*
+ * Only the fields that are present are visited : the loop runs once per bit
+ * set in the bitmap, never tests the absent ones
+ */
+static BOOL CalypsoIntercodeDecodeBits(CALYPSO_CTX_ST* ctx, const CALYPSO_INTERCODE_FIELD_ST fields[], DWORD bitmap, CALYPSO_BITS_READER_ST* reader, CALYPSO_INTERCODE_VISITOR visitor, void* param)
+{
+	while (bitmap)
+	{
+		if (!CalypsoIntercodeDecodeField(ctx, &fields[LOWEST_BIT(bitmap)], reader, visitor, param))
+			return FALSE;
+		bitmap &= bitmap - 1;
+	}
+	return TRUE;
+}
+
+/*
+ * Decode a record (or the part of a record) described by map, starting at the
+ * reader's position. The visitor is called for every field that is present.
+ */
+CALYPSO_RC CalypsoIntercodeDecode(CALYPSO_CTX_ST* ctx, const CALYPSO_INTERCODE_MAP_ST* map, CALYPSO_BITS_READER_ST* reader, CALYPSO_INTERCODE_VISITOR visitor, void* param)
+{
+	const CALYPSO_INTERCODE_FIELD_ST* fields;
+	DWORD bitmap, low_mask;
+	BYTE i;
+
+	for (i = 0; i < map->Fixed; i++)
+		if (!CalypsoIntercodeDecodeField(ctx, &map->Fields[i], reader, visitor, param))
+			return CALYPSO_CARD_DATA_MALFORMED;
+
+	if (!bits_reader_get(reader, map->BitmapWidth, &bitmap))
+		return CALYPSO_CARD_DATA_MALFORMED;
+	visitor(ctx, param, INTERCODE_EV_BITMAP, NULL, map->BitmapWidth, bitmap);
+
+	fields = map->Fields + map->Fixed;
+
+	if (map->ZerosAt)
+	{
+		/* The Authenticator_C counts the zeros of the record, up to the status */
+		low_mask = (1UL << map->ZerosAt) - 1;
+		if (!CalypsoIntercodeDecodeBits(ctx, fields, bitmap & low_mask, reader, visitor, param))
+			return CALYPSO_CARD_DATA_MALFORMED;
+		visitor(ctx, param, INTERCODE_EV_ZEROS, NULL, 0, (DWORD)count_zeros(reader->Data, bits_reader_offset(reader)));
+		bitmap &= ~low_mask;
+	}
+
+	if (!CalypsoIntercodeDecodeBits(ctx, fields, bitmap, reader, visitor, param))
+		return CALYPSO_CARD_DATA_MALFORMED;
+
+	return CALYPSO_SUCCESS;
+}
+
+/*
+ * Encode a record described by map. values[] is indexed as map->Fields ;
+ * only the fixed fields and the fields whose bit is set in bitmap are written.
+ * Nested bitmaps are not supported.
+ */
+CALYPSO_RC CalypsoIntercodeEncode(CALYPSO_CTX_ST* ctx, const CALYPSO_INTERCODE_MAP_ST* map, BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, DWORD bitmap, const DWORD values[])
+{
+	const CALYPSO_INTERCODE_FIELD_ST* field;
+	BYTE i;
+
+	for (i = 0; i < map->Fixed; i++)
+		if (!set_dword_bits(data, size, bit_offset, CalypsoIntercodeWidth(ctx, &map->Fields[i]), values[i]))
+			return CALYPSO_ERR_BUFFER_TOO_SHORT;
+
+	if (!set_dword_bits(data, size, bit_offset, map->BitmapWidth, bitmap))
+		return CALYPSO_ERR_BUFFER_TOO_SHORT;
+
+	while (bitmap)
+	{
+		i = LOWEST_BIT(bitmap);
+		if (i >= map->BitmapWidth)
+			return CALYPSO_ERR_INVALID_PARAM;
+
+		field = &map->Fields[map->Fixed + i];
+		if (field->Format == INTERCODE_FMT_BITMAP)
+			return CALYPSO_ERR_INVALID_PARAM;
+
+		if (field->Format != INTERCODE_FMT_NONE)
+			if (!set_dword_bits(data, size, bit_offset, CalypsoIntercodeWidth(ctx, field), values[map->Fixed + i]))
+				return CALYPSO_ERR_BUFFER_TOO_SHORT;
+
+		bitmap &= bitmap - 1;
+	}
+
+	return CALYPSO_SUCCESS;
+}
@@ -0,0 +1,141 @@
+/**h* CalypsoAPI/calypso_intercode_stored_pc.c
+ *
+ * NAME
+ *   calypso_intercode_stored_pc.c
+ *
+ * DESCRIPTION
+ *   Decoding of INTERCODE records that have been stored (validation logs,
+ *   card dumps...), without library context.
+ *   Everything the decoder needs is given by the caller with each record
+ *   (including the version of the Environment, which gives the layout of the
+ *   other records), and the state of the decoder lives on the stack : those
+ *   functions may run on any number of threads at the same time.
+ *
+ * COPYRIGHT
+ *   (c) 2026 SpringCard - www.springcard.com
+ *
+ * HISTORY
+ *   AGT 19/10/2026 : created
+ *
+ **/
+#include "../calypso_api_i.h"
+
+/**f* CSB6_Calypso/CalypsoDecodeStoredRecord
+ *
+ * NAME
+ *   CalypsoDecodeStoredRecord
+ *
+ * DESCRIPTION
+ *   Explain a record, in the same terms as CalypsoExploreAndParse does. The
+ *   record is written as one section named "Record" (one line with the JSON
+ *   output). The binary output is self-contained : it gives its own names.
+ *
+ * INPUTS
+ *   BYTE            record_type    : CALYPSO_RECORD_ENV_HOLDER, CALYPSO_RECORD_CONTRACT or CALYPSO_RECORD_EVENT
+ *   BYTE            env_version    : EnvVersionNumber from the Environment of the same card
+ *   BYTE            output_format  : CALYPSO_OUTPUT_XML, CALYPSO_OUTPUT_INI, CALYPSO_OUTPUT_JSON or CALYPSO_OUTPUT_BIN
+ *   BYTE            output_options : same as CalypsoSetOutputOptions
+ *   const BYTE      data[]         : the record
+ *   CALYPSO_SZ      datasize       : size of the record
+ *   BYTE            target[]       : buffer to receive the output
+ *   CALYPSO_SZ     *length         : size of target buffer on input,
+ *                                    length of the output on return
+ *
+ * RETURNS
+ *   CALYPSO_SUCCESS
+ *   CALYPSO_ERR_BUFFER_TOO_SHORT   : target is too short, length tells the size needed
+ *   CALYPSO_CARD_DATA_MALFORMED    : the record has been explained up to the error
+ *
+ **/
+CALYPSO_PROC CalypsoDecodeStoredRecord(BYTE record_type, BYTE env_version, BYTE output_format, BYTE output_options, const BYTE data[], CALYPSO_SZ datasize, BYTE target[], CALYPSO_SZ* length)
+{
+	CALYPSO_CTX_ST ctx;
+	CALYPSO_RC rc, rc_length;
+
+	if (length == NULL) return CALYPSO_ERR_INVALID_PARAM;
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	switch (output_format)
+	{
+	case CALYPSO_OUTPUT_XML: rc = CalypsoSetXmlOutputStr(&ctx, (char*)target, *length); break;
+	case CALYPSO_OUTPUT_INI: rc = CalypsoSetIniOutputStr(&ctx, (char*)target, *length); break;
+	case CALYPSO_OUTPUT_JSON: rc = CalypsoSetJsonOutputStr(&ctx, (char*)target, *length); break;
+	case CALYPSO_OUTPUT_BIN: rc = CalypsoSetBinOutputStr(&ctx, target, *length); break;
+	default: rc = CALYPSO_ERR_INVALID_PARAM; break;
+	}
+	if (rc)
+		return rc;
+
+	ctx.Parser.OutputOptions = output_options;
+	ctx.CardData.EnvVersion = env_version;
+
+	ParserOut_SectionBegin(&ctx, strRecord);
+	switch (record_type)
+	{
+	case CALYPSO_RECORD_ENV_HOLDER: rc = CalypsoOutputEnvAndHolderRecordEx(&ctx, data, datasize, FALSE); break;
+	case CALYPSO_RECORD_CONTRACT: rc = CalypsoOutputContractRecordEx(&ctx, data, datasize); break;
+	case CALYPSO_RECORD_EVENT: rc = CalypsoOutputEventRecordEx(&ctx, data, datasize); break;
+	default: rc = CALYPSO_ERR_INVALID_PARAM; break;
+	}
+	ParserOut_SectionEnd(&ctx, strRecord);
+
+	rc_length = CalypsoGetOutputLength(&ctx, length);
+	CalypsoClearOutput(&ctx);
+
+	if (rc_length)
+		return rc_length;
+	return rc;
+}
+
+/**f* CSB6_Calypso/CalypsoDecodeStoredEnvAndHolder
+ *
+ * NAME
+ *   CalypsoDecodeStoredEnvAndHolder
+ *
+ * DESCRIPTION
+ *   Same as CalypsoDecodeEnvAndHolderRecord, without library context
+ *
+ * INPUTS
+ *   const BYTE      data[]         : the record
+ *   CALYPSO_SZ      datasize       : size of the record
+ *   CALYPSO_ENVANDHOLDER_ST *target : the decoded record
+ *
+ * RETURNS
+ *   CALYPSO_RC
+ *
+ **/
+CALYPSO_PROC CalypsoDecodeStoredEnvAndHolder(const BYTE data[], CALYPSO_SZ datasize, CALYPSO_ENVANDHOLDER_ST* target)
+{
+	CALYPSO_CTX_ST ctx;
+
+	memset(&ctx, 0, sizeof(ctx));
+	return CalypsoDecodeEnvAndHolderRecord(&ctx, data, datasize, target);
+}
+
+/**f* CSB6_Calypso/CalypsoDecodeStoredContract
+ *
+ * NAME
+ *   CalypsoDecodeStoredContract
+ *
+ * DESCRIPTION
+ *   Same as CalypsoDecodeContractRecord, without library context
+ *
+ * INPUTS
+ *   BYTE            env_version    : EnvVersionNumber from the Environment of the same card
+ *   const BYTE      data[]         : the record
+ *   CALYPSO_SZ      datasize       : size of the record
+ *   CALYPSO_CONTRACT_ST *target    : the decoded record
+ *
+ * RETURNS
+ *   CALYPSO_RC
+ *
+ **/
+CALYPSO_PROC CalypsoDecodeStoredContract(BYTE env_version, const BYTE data[], CALYPSO_SZ datasize, CALYPSO_CONTRACT_ST* target)
+{
+	CALYPSO_CTX_ST ctx;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.CardData.EnvVersion = env_version;
+	return CalypsoDecodeContractRecord(&ctx, data, datasize, target);
+}
@@ -0,0 +1,277 @@
+/**h* CalypsoAPI/calypso_intercode_to_bin_pc.c
+ *
+ * NAME
+ *   calypso_intercode_to_bin_pc.c
+ *
+ * DESCRIPTION
+ *   Translation of INTERCODE types to a compact binary stream, for PC
+ *
+ *   The stream is a sequence of items. Each item starts with a byte made of
+ *   its type (3 high bits, CALYPSO_BIN_xxx) and of its argument (5 low bits).
+ *   Arguments 0 to 23 are stored in the byte itself ; 24, 25 and 26 mean that
+ *   the argument follows on 1, 2 or 4 bytes, MSB first (as in CBOR).
+ *
+ *   CALYPSO_BIN_UINT          argument is the value
+ *   CALYPSO_BIN_ID            argument is the id of the next FIELD or SECTION_BEGIN
+ *   CALYPSO_BIN_BYTES         argument is the length, the bytes follow
+ *   CALYPSO_BIN_TEXT          argument is the length, the characters follow
+ *   CALYPSO_BIN_FIELD         argument is the index of the name, the value
+ *                             (UINT, BYTES or TEXT) follows
+ *   CALYPSO_BIN_SECTION_BEGIN argument is the index of the name
+ *   CALYPSO_BIN_SECTION_END   argument is 0
+ *   CALYPSO_BIN_NAME          argument is the length, the characters follow ;
+ *                             this name takes the next index, starting at 0
+ *
+ *   The names are interned : a name is given once by a NAME item, just before
+ *   the first FIELD or SECTION_BEGIN that uses it, and then only by its index.
+ *   Numbers are UINT, byte arrays are BYTES, dates and times are TEXT as in
+ *   the XML output. Remarks are not written.
+ *
+ * COPYRIGHT
+ *   (c) 2026 SpringCard - www.springcard.com
+ *
+ * HISTORY
+ *   AGT 19/10/2026 : created
+ *
+ **/
+#include "../calypso_api_i.h"
+
+/* The names are looked-up by address : nearly all of them come from calypso_strings.c */
+#define BIN_NAMES_SLOTS  256 /* Power of 2 */
+#define BIN_NAMES_MAX    192
+
+typedef struct
+{
+	const char* Name[BIN_NAMES_SLOTS];
+	DWORD       Index[BIN_NAMES_SLOTS];
+	WORD        Count;  /* Names in the table                        */
+	DWORD       Next;   /* Index to be given to the next NAME item   */
+} CALYPSO_BIN_NAMES_ST;
+
+static void BinWriteHead(CALYPSO_CTX_ST* ctx, BYTE type, DWORD value)
+{
+	char buffer[5];
+	DWORD size;
+
+	type <<= 5;
+
+	if (value < 24)
+	{
+		buffer[0] = (char)(type | value);
+		size = 1;
+	}
+	else
+		if (value <= 0x000000FF)
+		{
+			buffer[0] = (char)(type | 24);
+			buffer[1] = (char)value;
+			size = 2;
+		}
+		else
+			if (value <= 0x0000FFFF)
+			{
+				buffer[0] = (char)(type | 25);
+				buffer[1] = (char)(value >> 8);
+				buffer[2] = (char)value;
+				size = 3;
+			}
+			else
+			{
+				buffer[0] = (char)(type | 26);
+				buffer[1] = (char)(value >> 24);
+				buffer[2] = (char)(value >> 16);
+				buffer[3] = (char)(value >> 8);
+				buffer[4] = (char)value;
+				size = 5;
+			}
+
+	ParserWrite(ctx, buffer, size);
+}
+
+static void BinWriteData(CALYPSO_CTX_ST* ctx, BYTE type, const char* data, DWORD size)
+{
+	BinWriteHead(ctx, type, size);
+	if (size)
+		ParserWrite(ctx, data, size);
+}
+
+static DWORD BinName(CALYPSO_CTX_ST* ctx, const char* name)
+{
+	CALYPSO_BIN_NAMES_ST* names = ctx->Parser.SinkData;
+	DWORD slot = (DWORD)((((size_t)name) >> 2) ^ (((size_t)name) >> 11)) & (BIN_NAMES_SLOTS - 1);
+
+	while (names->Name[slot] != NULL)
+	{
+		if (names->Name[slot] == name)
+			return names->Index[slot];
+		slot = (slot + 1) & (BIN_NAMES_SLOTS - 1);
+	}
+
+	BinWriteData(ctx, CALYPSO_BIN_NAME, name, (DWORD)strlen(name));
+
+	/* Table is full : the name will be given again next time, under a new index */
+	if (names->Count < BIN_NAMES_MAX)
+	{
+		names->Name[slot] = name;
+		names->Index[slot] = names->Next;
+		names->Count++;
+	}
+
+	return names->Next++;
+}
+
+static void BinWriteKey(CALYPSO_CTX_ST* ctx, BYTE type, const char* name, const DWORD* id)
+{
+	DWORD index = BinName(ctx, name);
+
+	if (id != NULL)
+		BinWriteHead(ctx, CALYPSO_BIN_ID, *id);
+	BinWriteHead(ctx, type, index);
+}
+
+static void BinSectionBegin(CALYPSO_CTX_ST* ctx, const char* name, const DWORD* id)
+{
+	BinWriteKey(ctx, CALYPSO_BIN_SECTION_BEGIN, name, id);
+}
+
+static void BinSectionEnd(CALYPSO_CTX_ST* ctx)
+{
+	BinWriteHead(ctx, CALYPSO_BIN_SECTION_END, 0);
+}
+
+static void BinNumber(CALYPSO_CTX_ST* ctx, const char* name, const DWORD* id, DWORD value)
+{
+	BinWriteKey(ctx, CALYPSO_BIN_FIELD, name, id);
+	BinWriteHead(ctx, CALYPSO_BIN_UINT, value);
+}
+
+static void BinBytes(CALYPSO_CTX_ST* ctx, const char* name, const BYTE value[], CALYPSO_SZ size)
+{
+	BinWriteKey(ctx, CALYPSO_BIN_FIELD, name, NULL);
+	BinWriteData(ctx, CALYPSO_BIN_BYTES, (const char*)value, (DWORD)size);
+}
+
+static void BinText(CALYPSO_CTX_ST* ctx, const char* name, const DWORD* id, const char* value)
+{
+	BinWriteKey(ctx, CALYPSO_BIN_FIELD, name, id);
+	BinWriteData(ctx, CALYPSO_BIN_TEXT, value, (DWORD)strlen(value));
+}
+
+const CALYPSO_PARSER_SINK_ST CalypsoParserBinSink =
+{
+	BinSectionBegin,
+	BinSectionEnd,
+	BinNumber,
+	BinBytes,
+	BinText,
+	NULL,
+	NULL
+};
+
+static CALYPSO_RC BinSetSink(CALYPSO_CTX_ST* ctx)
+{
+	ctx->Parser.SinkData = malloc(sizeof(CALYPSO_BIN_NAMES_ST));
+	if (ctx->Parser.SinkData == NULL)
+	{
+		CalypsoClearOutput(ctx);
+		return CALYPSO_ERR_INTERNAL_ERROR;
+	}
+
+	memset(ctx->Parser.SinkData, 0, sizeof(CALYPSO_BIN_NAMES_ST));
+	ctx->Parser.Sink = &CalypsoParserBinSink;
+
+	return 0;
+}
+
+/**f* CSB6_Calypso/CalypsoSetBinOutput
+ *
+ * NAME
+ *   CalypsoSetBinOutput
+ *
+ * DESCRIPTION
+ *   Instanciate a parser object with binary output
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx      : library context
+ *   const char     *filename : target file, NULL for the standard output
+ *
+ * RETURNS
+ *   DWORD                             : S_SUCCESS or an error code
+ *
+ * SEE ALSO
+ *   CalypsoClearOutput
+ *   CalypsoSetBinOutputStr
+ *   CalypsoSetBinOutputBuilder
+ *
+ **/
+CALYPSO_PROC CalypsoSetBinOutput(CALYPSO_CTX_ST* ctx, const char* filename)
+{
+	CALYPSO_RC rc = ParserSetFile(ctx, filename, "wb");
+
+	if (rc)
+		return rc;
+
+	return BinSetSink(ctx);
+}
+
+/**f* CSB6_Calypso/CalypsoSetBinOutputStr
+ *
+ * NAME
+ *   CalypsoSetBinOutputStr
+ *
+ * DESCRIPTION
+ *   Same as CalypsoSetBinOutput, but the binary output is constructed in memory instead of
+ *   being written in a file. Use CalypsoGetOutputLength to know its length.
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx      : library context
+ *   BYTE            target[] : buffer to receive the binary output
+ *   DWORD          length    : size of target buffer
+ *
+ * RETURNS
+ *   DWORD                             : S_SUCCESS or an error code
+ *
+ * SEE ALSO
+ *   CalypsoGetOutputLength
+ *   CalypsoClearOutput
+ *
+ **/
+CALYPSO_PROC CalypsoSetBinOutputStr(CALYPSO_CTX_ST* ctx, BYTE target[], CALYPSO_SZ length)
+{
+	CALYPSO_RC rc = ParserSetString(ctx, (char*)target, length);
+
+	if (rc)
+		return rc;
+
+	return BinSetSink(ctx);
+}
+
+/**f* CSB6_Calypso/CalypsoSetBinOutputBuilder
+ *
+ * NAME
+ *   CalypsoSetBinOutputBuilder
+ *
+ * DESCRIPTION
+ *   Same as CalypsoSetBinOutputStr, but the library allocates the buffer and
+ *   makes it grow as needed. Use CalypsoDetachOutput to retrieve it.
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx      : library context
+ *
+ * RETURNS
+ *   DWORD                             : S_SUCCESS or an error code
+ *
+ * SEE ALSO
+ *   CalypsoDetachOutput
+ *   CalypsoClearOutput
+ *
+ **/
+CALYPSO_PROC CalypsoSetBinOutputBuilder(CALYPSO_CTX_ST* ctx)
+{
+	CALYPSO_RC rc = ParserSetBuilder(ctx);
+
+	if (rc)
+		return rc;
+
+	return BinSetSink(ctx);
+}
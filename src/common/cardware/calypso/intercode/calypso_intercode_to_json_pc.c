@@ -0,0 +1,289 @@
+/**h* CalypsoAPI/calypso_intercode_to_json_pc.c
+ *
+ * NAME
+ *   calypso_intercode_to_json_pc.c
+ *
+ * DESCRIPTION
+ *   Translation of INTERCODE types to JSON, for PC
+ *
+ *   Each top-level section is written as a JSON object on its own line
+ *   (JSON Lines), so the output may be consumed as a stream :
+ *     {"Environment":{"Version":1,"Bitmap":5,"Network":2427,"EndDate":"01/01/2030"}}
+ *   A record that is output out of any section (CalypsoOutputContractRecordEx
+ *   called directly for instance) is one object as well, with all its fields :
+ *     {"Raw":"...","Bitmap":6,"Provider":1,"Tariff":256}
+ *   Numbers are JSON numbers, byte arrays are strings of hex digits,
+ *   dates and times are strings, as in the XML output.
+ *   A section or a field with an id is named "name.id", as in the INI output.
+ *   Remarks are not written.
+ *
+ * COPYRIGHT
+ *   (c) 2026 SpringCard - www.springcard.com
+ *
+ * HISTORY
+ *   AGT 19/10/2026 : created
+ *
+ **/
+#include "../calypso_api_i.h"
+
+static void JsonWriteString(CALYPSO_CTX_ST* ctx, const char* value)
+{
+	static const char hex[] = "0123456789abcdef";
+	const unsigned char* p = (const unsigned char*)value;
+	const unsigned char* run;
+	char escape[6];
+
+	ParserWrite(ctx, "\"", 1);
+
+	while (*p != '\0')
+	{
+		/* Copy the characters that need no escape all at once */
+		run = p;
+		while ((*p >= 0x20) && (*p < 0x80) && (*p != '"') && (*p != '\\'))
+			p++;
+		if (p != run)
+			ParserWrite(ctx, (const char*)run, (DWORD)(p - run));
+
+		if (*p != '\0')
+		{
+			if ((*p == '"') || (*p == '\\'))
+			{
+				escape[0] = '\\';
+				escape[1] = (char)*p;
+				ParserWrite(ctx, escape, 2);
+			}
+			else
+			{
+				/* Control characters, and bytes above 0x7F taken as Latin-1 */
+				memcpy(escape, "\\u00", 4);
+				escape[4] = hex[*p >> 4];
+				escape[5] = hex[*p & 0x0F];
+				ParserWrite(ctx, escape, 6);
+			}
+			p++;
+		}
+	}
+
+	ParserWrite(ctx, "\"", 1);
+}
+
+static void JsonWriteKey(CALYPSO_CTX_ST* ctx, const char* name, const DWORD* id)
+{
+	if ((ctx->Parser.SectionDepth == 0) && !ctx->Parser.SinkRecord)
+		ParserWrite(ctx, "{", 1);
+	else
+		if (ctx->Parser.SinkComma)
+			ParserWrite(ctx, ",", 1);
+
+	if (id != NULL)
+	{
+		char buffer[128];
+		snprintf(buffer, sizeof(buffer), "%s.%lu", name, (unsigned long)*id);
+		JsonWriteString(ctx, buffer);
+	}
+	else
+	{
+		JsonWriteString(ctx, name);
+	}
+
+	ParserWrite(ctx, ":", 1);
+}
+
+static void JsonEndValue(CALYPSO_CTX_ST* ctx)
+{
+	if ((ctx->Parser.SectionDepth == 0) && !ctx->Parser.SinkRecord)
+	{
+		ParserWrite(ctx, "}\n", 2);
+		ctx->Parser.SinkComma = FALSE;
+	}
+	else
+	{
+		ctx->Parser.SinkComma = TRUE;
+	}
+}
+
+static void JsonRecordBegin(CALYPSO_CTX_ST* ctx)
+{
+	if ((ctx->Parser.SectionDepth == 0) && !ctx->Parser.SinkRecord)
+	{
+		/* Out of any section, the fields of the record go to one object */
+		ParserWrite(ctx, "{", 1);
+		ctx->Parser.SinkRecord = TRUE;
+		ctx->Parser.SinkComma = FALSE;
+	}
+}
+
+static void JsonRecordEnd(CALYPSO_CTX_ST* ctx)
+{
+	if ((ctx->Parser.SectionDepth == 0) && ctx->Parser.SinkRecord)
+	{
+		ParserWrite(ctx, "}\n", 2);
+		ctx->Parser.SinkRecord = FALSE;
+		ctx->Parser.SinkComma = FALSE;
+	}
+}
+
+static void JsonSectionBegin(CALYPSO_CTX_ST* ctx, const char* name, const DWORD* id)
+{
+	JsonWriteKey(ctx, name, id);
+	ParserWrite(ctx, "{", 1);
+	ctx->Parser.SinkComma = FALSE;
+}
+
+static void JsonSectionEnd(CALYPSO_CTX_ST* ctx)
+{
+	ParserWrite(ctx, "}", 1);
+	JsonEndValue(ctx);
+}
+
+static void JsonNumber(CALYPSO_CTX_ST* ctx, const char* name, const DWORD* id, DWORD value)
+{
+	char buffer[16];
+	int length;
+
+	JsonWriteKey(ctx, name, id);
+	length = snprintf(buffer, sizeof(buffer), "%lu", (unsigned long)value);
+	ParserWrite(ctx, buffer, (DWORD)length);
+	JsonEndValue(ctx);
+}
+
+static void JsonBytes(CALYPSO_CTX_ST* ctx, const char* name, const BYTE value[], CALYPSO_SZ size)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	char buffer[2 * 32];
+	DWORD i, j = 0;
+
+	JsonWriteKey(ctx, name, NULL);
+	ParserWrite(ctx, "\"", 1);
+
+	for (i = 0; i < size; i++)
+	{
+		buffer[j++] = hex[value[i] >> 4];
+		buffer[j++] = hex[value[i] & 0x0F];
+		if (j == sizeof(buffer))
+		{
+			ParserWrite(ctx, buffer, j);
+			j = 0;
+		}
+	}
+	if (j)
+		ParserWrite(ctx, buffer, j);
+
+	ParserWrite(ctx, "\"", 1);
+	JsonEndValue(ctx);
+}
+
+static void JsonText(CALYPSO_CTX_ST* ctx, const char* name, const DWORD* id, const char* value)
+{
+	JsonWriteKey(ctx, name, id);
+	JsonWriteString(ctx, value);
+	JsonEndValue(ctx);
+}
+
+const CALYPSO_PARSER_SINK_ST CalypsoParserJsonSink =
+{
+	JsonSectionBegin,
+	JsonSectionEnd,
+	JsonNumber,
+	JsonBytes,
+	JsonText,
+	JsonRecordBegin,
+	JsonRecordEnd
+};
+
+/**f* CSB6_Calypso/CalypsoSetJsonOutput
+ *
+ * NAME
+ *   CalypsoSetJsonOutput
+ *
+ * DESCRIPTION
+ *   Instanciate a parser object with JSON output (one JSON object per line)
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx      : library context
+ *   const char     *filename : target JSON file, NULL for the standard output
+ *
+ * RETURNS
+ *   DWORD                             : S_SUCCESS or an error code
+ *
+ * SEE ALSO
+ *   CalypsoClearOutput
+ *   CalypsoSetJsonOutputStr
+ *   CalypsoSetJsonOutputBuilder
+ *
+ **/
+CALYPSO_PROC CalypsoSetJsonOutput(CALYPSO_CTX_ST* ctx, const char* filename)
+{
+	CALYPSO_RC rc = ParserSetFile(ctx, filename, "wt");
+
+	if (rc)
+		return rc;
+
+	ctx->Parser.Sink = &CalypsoParserJsonSink;
+
+	return 0;
+}
+
+/**f* CSB6_Calypso/CalypsoSetJsonOutputStr
+ *
+ * NAME
+ *   CalypsoSetJsonOutputStr
+ *
+ * DESCRIPTION
+ *   Same as CalypsoSetJsonOutput, but the JSON output is constructed in memory instead of
+ *   being written in a file
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx      : library context
+ *   char           *target   : buffer to receive the JSON text
+ *   DWORD          length    : size of target buffer
+ *
+ * RETURNS
+ *   DWORD                             : S_SUCCESS or an error code
+ *
+ * SEE ALSO
+ *   CalypsoGetOutputLength
+ *   CalypsoClearOutput
+ *
+ **/
+CALYPSO_PROC CalypsoSetJsonOutputStr(CALYPSO_CTX_ST* ctx, char* target, CALYPSO_SZ length)
+{
+	CALYPSO_RC rc = ParserSetString(ctx, target, length);
+
+	if (rc)
+		return rc;
+
+	ctx->Parser.Sink = &CalypsoParserJsonSink;
+
+	return 0;
+}
+
+/**f* CSB6_Calypso/CalypsoSetJsonOutputBuilder
+ *
+ * NAME
+ *   CalypsoSetJsonOutputBuilder
+ *
+ * DESCRIPTION
+ *   Same as CalypsoSetJsonOutputStr, but the library allocates the text and
+ *   makes it grow as needed. Use CalypsoDetachOutput to retrieve the text.
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx      : library context
+ *
+ * RETURNS
+ *   DWORD                             : S_SUCCESS or an error code
+ *
+ * SEE ALSO
+ *   CalypsoDetachOutput
+ *   CalypsoClearOutput
+ *
+ **/
+CALYPSO_PROC CalypsoSetJsonOutputBuilder(CALYPSO_CTX_ST* ctx)
+{
+	CALYPSO_RC rc = ParserSetBuilder(ctx);
+
+	if (!rc)
+		ctx->Parser.Sink = &CalypsoParserJsonSink;
+
+	return rc;
+}
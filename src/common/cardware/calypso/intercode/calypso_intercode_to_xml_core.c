@@ -15,127 +15,134 @@
  * HISTORY
  *   JDA 25/03/2009 : first public release
  *   JDA 16/12/2009 : major rework, separated pure parser from XML stuff
+ *   AGT 19/10/2026 : fields are decoded through the Intercode schema
  *
  **/
 #include "../calypso_api_i.h"
 
-CALYPSO_RC __CalypsoOutputEnvAndHolderRecordEx(CALYPSO_CTX_ST* ctx, const BYTE data[], CALYPSO_SZ datasize, BYTE param)
+typedef struct
 {
-	DWORD gen_bitmap, sub_bitmap;
-	DWORD value;
-	CALYPSO_BITS_SZ bit_offset = 0;
-	const char* in_section = NULL;
-
-	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+	BOOL  Quiet;  /* Environment only decoded to reach the Holder */
+	DWORD Zeros;
+} CALYPSO_OUTPUT_WALK_ST;
 
-	if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_RAW))
-		ParserOut_Hex(ctx, strRaw, data, datasize);
-
-	/* Environment part */
-	/* ---------------- */
+static void CalypsoOutputField(CALYPSO_CTX_ST* ctx, void* param, BYTE event, const CALYPSO_INTERCODE_FIELD_ST* field, BYTE width, DWORD value)
+{
+	CALYPSO_OUTPUT_WALK_ST* walk = param;
 
-	if (param == 0x03)
-		ParserOut_SectionBegin(ctx, strEnvironment);
+	if (event == INTERCODE_EV_ZEROS)
+	{
+		walk->Zeros = value;
+		return;
+	}
+	if (walk->Quiet)
+		return;
 
-	if (!get_dword_bits(data, datasize, &bit_offset, 6, &value)) goto malform_e;
-	if (param != 0x02)
-		ParserOut_Dec(ctx, strVersion, value);
+	switch (event)
+	{
+	case INTERCODE_EV_BITMAP:
+		if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_BITMAP))
+			ParserOut_Bin(ctx, strBitmap, value, width);
+		return;
 
-	ctx->CardData.EnvVersion = (BYTE)value;
+	case INTERCODE_EV_BEGIN:
+		ParserOut_SectionBegin(ctx, field->Name);
+		if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_BITMAP))
+			ParserOut_Bin(ctx, strBitmap, value, width);
+		return;
 
-	if (!get_dword_bits(data, datasize, &bit_offset, 7, &gen_bitmap)) goto malform_e;
+	case INTERCODE_EV_END:
+		ParserOut_SectionEnd(ctx, field->Name);
+		return;
 
-	if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_BITMAP))
-		if (param != 0x02)
-			ParserOut_Bin(ctx, strBitmap, gen_bitmap, 7);
+	default:
+		break;
+	}
 
-	if (gen_bitmap & 0x00000001) /* 0 */
+	switch (field->Format)
 	{
-		/* EnvNetworkId */
-		if (!get_dword_bits(data, datasize, &bit_offset, 24, &value)) goto malform_e;
-		if (param != 0x02)
-			ParserOut_Hex24(ctx, strNetwork, value);
+	case INTERCODE_FMT_DEC:
+	case INTERCODE_FMT_VERSION:
+		ParserOut_Dec(ctx, field->Name, value);
+		break;
 
+	case INTERCODE_FMT_NETWORK:
+		ParserOut_Hex24(ctx, field->Name, value);
 		if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_EXPLAIN))
 		{
-			if (param != 0x02)
-			{
-				ParserOut_Hex12(ctx, strNetworkCountry, value >> 12);
-				ParserOut_Hex12(ctx, strNetworkIndex, value);
-			}
+			ParserOut_Hex12(ctx, strNetworkCountry, value >> 12);
+			ParserOut_Hex12(ctx, strNetworkIndex, value);
 		}
-	}
-	if (gen_bitmap & 0x00000002) /* 1 */
-	{
-		/* EnvApplicationIssuerId */
-		if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform_e;
-		if (param != 0x02)
-			ParserOut_Dec(ctx, strIssuer, value);
-	}
-	if (gen_bitmap & 0x00000004) /* 2 */
-	{
-		/* EnvApplicationEndDate */
-		if (!get_dword_bits(data, datasize, &bit_offset, 14, &value)) goto malform_e;
-		if (param != 0x02)
-			ParserOut_Date(ctx, strEndDate, translate_datestamp_14(value));
-	}
-	if (gen_bitmap & 0x00000008) /* 3 */
-	{
-		/* EnvPayMethod */
-		if (!get_dword_bits(data, datasize, &bit_offset, 11, &value)) goto malform_e;
-		if (param != 0x02)
-			ParserOut_Dec(ctx, strPayMethod, value);
-	}
-	if (gen_bitmap & 0x00000010) /* 4 */
-	{
-		/* EnvAuthenticator */
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform_e;
-		if (param != 0x02)
-			ParserOut_Hex16(ctx, strAuthenticator, value);
-	}
-	if (gen_bitmap & 0x00000020) /* 5 */
-	{
-		/* EnvSelectList */
-		if (!get_dword_bits(data, datasize, &bit_offset, 32, &value)) goto malform_e;
-		if (param != 0x02)
-			ParserOut_Bin(ctx, strSelect, value, 32);
-	}
-	if (gen_bitmap & 0x00000040) /* 6 */
-	{
-		/* EnvData */
-		if (!get_dword_bits(data, datasize, &bit_offset, 2, &sub_bitmap)) goto malform_e;
+		break;
 
-		if (sub_bitmap)
-		{
-			if (param != 0x02)
-			{
-				in_section = strData;
-				ParserOut_SectionBegin(ctx, in_section);
-			}
+	case INTERCODE_FMT_HEX16:
+		ParserOut_Hex16(ctx, field->Name, value);
+		break;
 
-			if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_BITMAP))
-				if (param != 0x02)
-					ParserOut_Bin(ctx, strBitmap, sub_bitmap, 2);
+	case INTERCODE_FMT_AUTH:
+		if (width == 16)
+			ParserOut_Hex16(ctx, field->Name, value);
+		else
+			ParserOut_Hex8(ctx, field->Name, value);
+		break;
 
-			if (sub_bitmap & 0x00000001)
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 1, &value)) goto malform_e;
-				if (param != 0x02)
-					ParserOut_Dec(ctx, strStatus, value);
-			}
-			if (sub_bitmap & 0x00000002)
-			{
-				/* TODO */
-			}
+	case INTERCODE_FMT_BIN:
+		ParserOut_Bin(ctx, field->Name, value, width);
+		break;
 
-			if (param != 0x02)
-			{
-				ParserOut_SectionEnd(ctx, in_section);
-				in_section = NULL;
-			}
-		}
+	case INTERCODE_FMT_DATE:
+		ParserOut_Date(ctx, field->Name, translate_datestamp_14(value));
+		break;
+
+	case INTERCODE_FMT_TIME:
+		ParserOut_Time(ctx, field->Name, translate_timestamp_11(value));
+		break;
 
+	case INTERCODE_FMT_PAYPTR:
+		// TODO
+		ParserOut_DecId(ctx, field->Name, 1, (value >> 24) & 0x000000FF);
+		ParserOut_DecId(ctx, field->Name, 2, (value >> 16) & 0x000000FF);
+		ParserOut_DecId(ctx, field->Name, 3, (value >> 8) & 0x000000FF);
+		ParserOut_DecId(ctx, field->Name, 4, value & 0x000000FF);
+		break;
+
+	case INTERCODE_FMT_ZONES:
+		ParserOut_Dec(ctx, field->Name, value);
+		if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_EXPLAIN))
+			ParserOut_IdfZones(ctx, strZoneList, value);
+		break;
+
+	default:
+		break;
 	}
+}
+
+CALYPSO_RC __CalypsoOutputEnvAndHolderRecordEx(CALYPSO_CTX_ST* ctx, const BYTE data[], CALYPSO_SZ datasize, BYTE param)
+{
+	CALYPSO_OUTPUT_WALK_ST walk = { FALSE, 0 };
+	CALYPSO_BITS_READER_ST reader;
+	DWORD gen_bitmap, sub_bitmap;
+	DWORD value;
+	CALYPSO_BITS_SZ bit_offset = 0;
+	const char* in_section = NULL;
+
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+
+	if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_RAW))
+		ParserOut_Hex(ctx, strRaw, data, datasize);
+
+	/* Environment part */
+	/* ---------------- */
+
+	if (param == 0x03)
+		ParserOut_SectionBegin(ctx, strEnvironment);
+
+	if (data == NULL) goto malform_e;
+
+	walk.Quiet = (param == 0x02) ? TRUE : FALSE;
+	bits_reader_init(&reader, data, datasize, 0);
+	if (CalypsoIntercodeDecode(ctx, &CalypsoIntercodeEnvironment, &reader, CalypsoOutputField, &walk)) goto malform_e;
+	bit_offset = bits_reader_offset(&reader);
 
 	if (param == 0x03)
 		ParserOut_SectionEnd(ctx, strEnvironment);
@@ -400,14 +407,30 @@ malform_h:
 
 
 
+/*
+ * The whole record is one item of the output, even when not in a section
+ */
+static CALYPSO_RC CalypsoOutputEnvAndHolderRecord(CALYPSO_CTX_ST* ctx, const BYTE data[], CALYPSO_SZ datasize, BYTE param)
+{
+	CALYPSO_RC rc;
+
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+
+	ParserOut_RecordBegin(ctx);
+	rc = __CalypsoOutputEnvAndHolderRecordEx(ctx, data, datasize, param);
+	ParserOut_RecordEnd(ctx);
+
+	return rc;
+}
+
 CALYPSO_PROC CalypsoOutputEnvironmentRecordEx(CALYPSO_CTX_ST* ctx, const BYTE data[], CALYPSO_SZ datasize)
 {
-	return __CalypsoOutputEnvAndHolderRecordEx(ctx, data, datasize, 1);
+	return CalypsoOutputEnvAndHolderRecord(ctx, data, datasize, 1);
 }
 
 CALYPSO_PROC CalypsoOutputHolderRecordEx(CALYPSO_CTX_ST* ctx, const BYTE data[], CALYPSO_SZ datasize)
 {
-	return __CalypsoOutputEnvAndHolderRecordEx(ctx, data, datasize, 2);
+	return CalypsoOutputEnvAndHolderRecord(ctx, data, datasize, 2);
 }
 
 /**f* Calypso_API/CalypsoOutputEnvAndHolderRecordEx
@@ -431,9 +454,9 @@ CALYPSO_PROC CalypsoOutputHolderRecordEx(CALYPSO_CTX_ST* ctx, const BYTE data[],
 CALYPSO_PROC CalypsoOutputEnvAndHolderRecordEx(CALYPSO_CTX_ST* ctx, const BYTE data[], CALYPSO_SZ datasize, BOOL flat)
 {
 	if (flat)
-		return __CalypsoOutputEnvAndHolderRecordEx(ctx, data, datasize, 0);
+		return CalypsoOutputEnvAndHolderRecord(ctx, data, datasize, 0);
 	else
-		return __CalypsoOutputEnvAndHolderRecordEx(ctx, data, datasize, 3);
+		return CalypsoOutputEnvAndHolderRecord(ctx, data, datasize, 3);
 }
 
 
@@ -456,409 +479,33 @@ CALYPSO_PROC CalypsoOutputEnvAndHolderRecordEx(CALYPSO_CTX_ST* ctx, const BYTE d
  **/
 CALYPSO_PROC CalypsoOutputContractRecordEx(CALYPSO_CTX_ST* ctx, const BYTE data[], CALYPSO_SZ datasize)
 {
-	DWORD gen_bitmap, sub_bitmap;
-	DWORD value;
-	CALYPSO_BITS_SZ bit_offset = 0;
-	CALYPSO_SZ zeros;
-	const char* in_section = NULL;
+	CALYPSO_OUTPUT_WALK_ST walk = { FALSE, 0 };
+	CALYPSO_BITS_READER_ST reader;
+	CALYPSO_RC rc;
 
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
 
-	ParserOut_Hex(ctx, strRaw, data, datasize);
-
-	if (!get_dword_bits(data, datasize, &bit_offset, 20, &gen_bitmap)) goto malform;
-
-	if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_BITMAP))
-		ParserOut_Bin(ctx, strBitmap, gen_bitmap, 20);
-
-	if (gen_bitmap & 0x00000001) /* 0 */
-	{
-		/* ContractNetworkId */
-		if (!get_dword_bits(data, datasize, &bit_offset, 24, &value)) goto malform;
-		ParserOut_Hex24(ctx, strNetwork, value);
-
-		if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_EXPLAIN))
-		{
-			ParserOut_Hex12(ctx, strNetworkCountry, value >> 12);
-			ParserOut_Hex12(ctx, strNetworkIndex, value);
-		}
-	}
-	if (gen_bitmap & 0x00000002) /* 1 */
-	{
-		/* ContractProvider */
-		if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-		ParserOut_Dec(ctx, strProvider, value);
-	}
-	if (gen_bitmap & 0x00000004) /* 2 */
-	{
-		/* ContractTariff */
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strTariff, value);
-	}
-	if (gen_bitmap & 0x00000008) /* 3 */
-	{
-		/* ContractSerialNumber */
-		if (!get_dword_bits(data, datasize, &bit_offset, 32, &value)) goto malform;
-		ParserOut_Dec(ctx, strNumber, value);
-	}
-	if (gen_bitmap & 0x00000010) /* 4 */
-	{
-		/* ContractCustomer */
-		if (!get_dword_bits(data, datasize, &bit_offset, 2, &sub_bitmap)) goto malform;
-
-		if (sub_bitmap)
-		{
-			in_section = strCustomer;
-			ParserOut_SectionBegin(ctx, in_section);
-
-			if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_BITMAP))
-				ParserOut_Bin(ctx, strBitmap, sub_bitmap, 2);
-
-			if (sub_bitmap & 0x00000001)
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 6, &value)) goto malform;
-				ParserOut_Dec(ctx, strProfile, value);
-			}
-			if (sub_bitmap & 0x00000002)
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 32, &value)) goto malform;
-				ParserOut_Dec(ctx, strNumber, value);
-			}
-			ParserOut_SectionEnd(ctx, in_section);
-			in_section = NULL;
-		}
-	}
-	if (gen_bitmap & 0x00000020) /* 5 */
-	{
-		/* ContractPassenger */
-		if (!get_dword_bits(data, datasize, &bit_offset, 2, &sub_bitmap)) goto malform;
-
-		if (sub_bitmap)
-		{
-			in_section = strPassenger;
-			ParserOut_SectionBegin(ctx, in_section);
-
-			if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_BITMAP))
-				ParserOut_Bin(ctx, strBitmap, sub_bitmap, 2);
-
-			if (sub_bitmap & 0x00000001)
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-				ParserOut_Dec(ctx, strClass, value);
-			}
-			if (sub_bitmap & 0x00000002)
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-				ParserOut_Dec(ctx, strTotal, value);
-			}
-			ParserOut_SectionEnd(ctx, in_section);
-			in_section = NULL;
-		}
-	}
-	if (gen_bitmap & 0x00000040) /* 6 */
-	{
-		/* ContractVehicleClassAllowed */
-		if (!get_dword_bits(data, datasize, &bit_offset, 6, &value)) goto malform;
-		ParserOut_Dec(ctx, strClassAllowed, value);
-	}
-	if (gen_bitmap & 0x00000080) /* 7 */
-	{
-		// TODO
-		/* ContractPaymentPointer */
-		if (!get_dword_bits(data, datasize, &bit_offset, 32, &value)) goto malform;
-
-		ParserOut_DecId(ctx, strPayPointer, 1, (value >> 24) & 0x000000FF);
-		ParserOut_DecId(ctx, strPayPointer, 2, (value >> 16) & 0x000000FF);
-		ParserOut_DecId(ctx, strPayPointer, 3, (value >> 8) & 0x000000FF);
-		ParserOut_DecId(ctx, strPayPointer, 4, value & 0x000000FF);
-	}
-	if (gen_bitmap & 0x00000100) /* 8 */
-	{
-		/* ContractPayMethod */
-		if (!get_dword_bits(data, datasize, &bit_offset, 11, &value)) goto malform;
-		ParserOut_Dec(ctx, strPayMethod, value);
-	}
-	if (gen_bitmap & 0x00000200) /* 9 */
-	{
-		/* ContractServices */
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strServices, value);
-	}
-	if (gen_bitmap & 0x00000400) /* 10 */
-	{
-		/* ContractPriceAmount */
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strPriceAmount, value);
-	}
-	if (gen_bitmap & 0x00000800) /* 11 */
-	{
-		/* ContractPriceUnit */
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strPriceUnit, value);
-	}
-	if (gen_bitmap & 0x00001000) /* 12 */
-	{
-		/* ContractRestrict */
-		if (!get_dword_bits(data, datasize, &bit_offset, 7, &sub_bitmap)) goto malform;
-
-		if (sub_bitmap)
-		{
-			in_section = strRestrict;
-			ParserOut_SectionBegin(ctx, in_section);
-
-			if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_BITMAP))
-				ParserOut_Bin(ctx, strBitmap, sub_bitmap, 7);
-
-			if (sub_bitmap & 0x00000001) /* 0 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 11, &value)) goto malform;
-				ParserOut_Time(ctx, strStart, translate_timestamp_11(value));
-			}
-			if (sub_bitmap & 0x00000002) /* 1 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 11, &value)) goto malform;
-				ParserOut_Time(ctx, strEnd, translate_timestamp_11(value));
-			}
-			if (sub_bitmap & 0x00000004) /* 2 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-				ParserOut_Dec(ctx, strDay, value);
-			}
-			if (sub_bitmap & 0x00000008) /* 3 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-				ParserOut_Dec(ctx, strTimeCode, value);
-			}
-			if (sub_bitmap & 0x00000010) /* 4 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-				ParserOut_Dec(ctx, strCode, value);
-			}
-			if (sub_bitmap & 0x00000020) /* 5 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-				ParserOut_Dec(ctx, strProduct, value);
-			}
-			if (sub_bitmap & 0x00000040) /* 6 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-				ParserOut_Dec(ctx, strLocation, value);
-			}
-
-			ParserOut_SectionEnd(ctx, in_section);
-			in_section = NULL;
-		}
-	}
-	if (gen_bitmap & 0x00002000) /* 13 */
-	{
-		/* ContractValidity */
-		if (!get_dword_bits(data, datasize, &bit_offset, 9, &sub_bitmap)) goto malform;
-
-		if (sub_bitmap)
-		{
-			in_section = strValidity;
-			ParserOut_SectionBegin(ctx, in_section);
-
-			if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_BITMAP))
-				ParserOut_Bin(ctx, strBitmap, sub_bitmap, 9);
-
-			if (sub_bitmap & 0x00000001) /* 0 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 14, &value)) goto malform;
-				ParserOut_Date(ctx, strStartDate, translate_datestamp_14(value));
-			}
-			if (sub_bitmap & 0x00000002) /* 1 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 11, &value)) goto malform;
-				ParserOut_Time(ctx, strStartTime, translate_timestamp_11(value));
-			}
-			if (sub_bitmap & 0x00000004) /* 2 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 14, &value)) goto malform;
-				ParserOut_Date(ctx, strEndDate, translate_datestamp_14(value));
-			}
-			if (sub_bitmap & 0x00000008) /* 3 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 11, &value)) goto malform;
-				ParserOut_Time(ctx, strEndTime, translate_timestamp_11(value));
-			}
-			if (sub_bitmap & 0x00000010) /* 4 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-				ParserOut_Dec(ctx, strDuration, value);
-			}
-			if (sub_bitmap & 0x00000020) /* 5 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 14, &value)) goto malform;
-				ParserOut_Date(ctx, strLimitDate, translate_datestamp_14(value));
-			}
-			if (sub_bitmap & 0x00000040) /* 6 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-				ParserOut_Dec(ctx, strZones, value);
-
-				if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_EXPLAIN))
-					ParserOut_IdfZones(ctx, strZoneList, value);
-			}
-			if (sub_bitmap & 0x00000080) /* 7 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-				ParserOut_Dec(ctx, strValidJourneys, value);
-			}
-			if (sub_bitmap & 0x00000100) /* 8 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-				ParserOut_Dec(ctx, strPeriodJourneys, value);
-			}
-
-			ParserOut_SectionEnd(ctx, in_section);
-			in_section = NULL;
-		}
-	}
-	if (gen_bitmap & 0x00004000) /* 14 */
-	{
-		/* ContractJourney */
-		if (!get_dword_bits(data, datasize, &bit_offset, 8, &sub_bitmap)) goto malform;
-
-		if (sub_bitmap)
-		{
-			in_section = strJourney;
-			ParserOut_SectionBegin(ctx, in_section);
-
-			if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_BITMAP))
-				ParserOut_Bin(ctx, strBitmap, sub_bitmap, 8);
-
-			if (sub_bitmap & 0x00000001) /* 0 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-				ParserOut_Dec(ctx, strOrigin, value);
-			}
-			if (sub_bitmap & 0x00000002) /* 1 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-				ParserOut_Dec(ctx, strDestination, value);
-			}
-			if (sub_bitmap & 0x00000004) /* 2 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-				ParserOut_Dec(ctx, strRouteNumbers, value);
-			}
-			if (sub_bitmap & 0x00000008) /* 3 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-				ParserOut_Dec(ctx, strRouteVariants, value);
-			}
-			if (sub_bitmap & 0x00000010) /* 4 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-				ParserOut_Dec(ctx, strRun, value);
-			}
-			if (sub_bitmap & 0x00000020) /* 5 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-				ParserOut_Dec(ctx, strVia, value);
-			}
-			if (sub_bitmap & 0x00000040) /* 6 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-				ParserOut_Dec(ctx, strDistance, value);
-			}
-			if (sub_bitmap & 0x00000080) /* 7 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-				ParserOut_Dec(ctx, strInterchanges, value);
-			}
-			ParserOut_SectionEnd(ctx, in_section);
-			in_section = NULL;
-		}
-	}
-	if (gen_bitmap & 0x00008000) /* 15 */
-	{
-		/* ContractSale */
-		if (!get_dword_bits(data, datasize, &bit_offset, 4, &sub_bitmap)) goto malform;
-
-		if (sub_bitmap)
-		{
-			in_section = strSale;
-			ParserOut_SectionBegin(ctx, in_section);
-
-			if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_BITMAP))
-				ParserOut_Bin(ctx, strBitmap, sub_bitmap, 4);
+	ParserOut_RecordBegin(ctx);
 
-			if (sub_bitmap & 0x00000001) /* 0 */
-			{
-				/* ContractSaleDate */
-				if (!get_dword_bits(data, datasize, &bit_offset, 14, &value)) goto malform;
-				ParserOut_Date(ctx, strDate, translate_datestamp_14(value));
-			}
-			if (sub_bitmap & 0x00000002) /* 1 */
-			{
-				/* ContractSaleTime */
-				if (!get_dword_bits(data, datasize, &bit_offset, 11, &value)) goto malform;
-				ParserOut_Time(ctx, strTime, translate_timestamp_11(value));
-			}
-			if (sub_bitmap & 0x00000004) /* 2 */
-			{
-				/* ContractSaleCompany */
-				if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-				ParserOut_Dec(ctx, strProvider, value);
-			}
-			if (sub_bitmap & 0x00000008) /* 3 */
-			{
-				/* ContractSaleDevice */
-				if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-				ParserOut_Dec(ctx, strDevice, value);
-			}
-			ParserOut_SectionEnd(ctx, in_section);
-			in_section = NULL;
-		}
-	}
-
-	zeros = count_zeros(data, bit_offset);
+	ParserOut_Hex(ctx, strRaw, data, datasize);
 
-	if (gen_bitmap & 0x00010000) /* 16 */
+	if (data == NULL)
 	{
-		/* ContractStatus */
-		if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-		ParserOut_Dec(ctx, strStatus, value);
+		rc = CALYPSO_CARD_DATA_MALFORMED;
+		goto done;
 	}
-	if (gen_bitmap & 0x00020000) /* 17 */
-	{
-		/* ContractLoyaltyPoints */
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strLoyalty, value);
-	}
-	if (gen_bitmap & 0x00040000) /* 18 */
-	{
-		/* ContractAuthenticator */
-		if (ctx->CardData.EnvVersion & 0x38)
-		{
-			if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-			ParserOut_Hex16(ctx, strAuthenticator, value);
-		}
-		else
-		{
-			if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-			ParserOut_Hex8(ctx, strAuthenticator, value);
-		}
-	}
-
-	if (gen_bitmap & 0x00080000) /* 19 */
-	{
-		/* ContractData */
-		// TODO
 
-	}
+	bits_reader_init(&reader, data, datasize, 0);
+	rc = CalypsoIntercodeDecode(ctx, &CalypsoIntercodeContract, &reader, CalypsoOutputField, &walk);
+	if (rc)
+		goto done;
 
 	if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_AUTH_C))
-		ParserOut_Hex16(ctx, str_Authenticator_C, zeros + 5);
-
-	return 0;
+		ParserOut_Hex16(ctx, str_Authenticator_C, walk.Zeros + 5);
 
-malform:
-	if (in_section != NULL)
-		ParserOut_SectionEnd(ctx, in_section);
-	return CALYPSO_CARD_DATA_MALFORMED;
+done:
+	ParserOut_RecordEnd(ctx);
+	return rc;
 }
 
 /**f* Calypso_API/CalypsoOutputEventRecordEx
@@ -880,220 +527,28 @@ malform:
  **/
 CALYPSO_PROC CalypsoOutputEventRecordEx(CALYPSO_CTX_ST* ctx, const BYTE data[], CALYPSO_SZ datasize)
 {
-	DWORD gen_bitmap, sub_bitmap;
-	DWORD value;
-	CALYPSO_BITS_SZ bit_offset = 0;
-	const char* in_section = NULL;
+	CALYPSO_OUTPUT_WALK_ST walk = { FALSE, 0 };
+	CALYPSO_BITS_READER_ST reader;
+	CALYPSO_RC rc;
 
 	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
 
+	ParserOut_RecordBegin(ctx);
+
 	if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_RAW))
 		ParserOut_Hex(ctx, strRaw, data, datasize);
 
-	if (!get_dword_bits(data, datasize, &bit_offset, 14, &value)) goto malform;
-	ParserOut_Date(ctx, strDate, translate_datestamp_14(value));
-
-	if (!get_dword_bits(data, datasize, &bit_offset, 11, &value)) goto malform;
-	ParserOut_Time(ctx, strTime, translate_timestamp_11(value));
-
-	if (!get_dword_bits(data, datasize, &bit_offset, 28, &gen_bitmap)) goto malform;
-
-	if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_BITMAP))
-		ParserOut_Bin(ctx, strBitmap, gen_bitmap, 28);
-
-	if (gen_bitmap & 0x00000001) /* 0 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-		ParserOut_Dec(ctx, strDisplayData, value);
-	}
-	if (gen_bitmap & 0x00000002) /* 1 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 24, &value)) goto malform;
-		ParserOut_Hex24(ctx, strNetwork, value);
-
-		if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_EXPLAIN))
-		{
-			ParserOut_Hex12(ctx, strNetworkCountry, value >> 12);
-			ParserOut_Hex12(ctx, strNetworkIndex, value);
-		}
-	}
-	if (gen_bitmap & 0x00000004) /* 2 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-		ParserOut_Dec(ctx, strCode, value);
-	}
-	if (gen_bitmap & 0x00000008) /* 3 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-		ParserOut_Dec(ctx, strResult, value);
-	}
-	if (gen_bitmap & 0x00000010) /* 4 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-		ParserOut_Dec(ctx, strProvider, value);
-	}
-	if (gen_bitmap & 0x00000020) /* 5 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-		ParserOut_Dec(ctx, strNotOKCounter, value);
-	}
-	if (gen_bitmap & 0x00000040) /* 6 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 24, &value)) goto malform;
-		ParserOut_Dec(ctx, strNumber, value);
-	}
-	if (gen_bitmap & 0x00000080) /* 7 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strDestination, value);
-	}
-	if (gen_bitmap & 0x00000100) /* 8 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strLocation, value);
-	}
-	if (gen_bitmap & 0x00000200) /* 9 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-		ParserOut_Dec(ctx, strLocationGate, value);
-	}
-	if (gen_bitmap & 0x00000400) /* 10 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strDevice, value);
-	}
-	if (gen_bitmap & 0x00000800) /* 11 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strRouteNumber, value);
-	}
-	if (gen_bitmap & 0x00001000) /* 12 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-		ParserOut_Dec(ctx, strRouteVariant, value);
-	}
-	if (gen_bitmap & 0x00002000) /* 13 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strJourneyRun, value);
-	}
-	if (gen_bitmap & 0x00004000) /* 14 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strVehicle, value);
-	}
-	if (gen_bitmap & 0x00008000) /* 15 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-		ParserOut_Dec(ctx, strVehicleClass, value);
-	}
-	if (gen_bitmap & 0x00010000) /* 16 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 5, &value)) goto malform;
-		ParserOut_Dec(ctx, strLocationType, value);
-	}
-	if (gen_bitmap & 0x00020000) /* 17 */
-	{
-		// TODO
-		if (!get_dword_bits(data, datasize, &bit_offset, 24, &value)) goto malform;
-		ParserOut_Dec(ctx, strEmployee, value);
-	}
-	if (gen_bitmap & 0x00040000) /* 18 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strLocationRef, value);
-	}
-	if (gen_bitmap & 0x00080000) /* 19 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-		ParserOut_Dec(ctx, strJourneyInterchanges, value);
-	}
-	if (gen_bitmap & 0x00100000) /* 20 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strPeriodJourneys, value);
-	}
-	if (gen_bitmap & 0x00200000) /* 21 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strTotalJourneys, value);
-	}
-	if (gen_bitmap & 0x00400000) /* 22 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strJourneyDistance, value);
-	}
-	if (gen_bitmap & 0x00800000) /* 23 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strPriceAmount, value);
-	}
-	if (gen_bitmap & 0x01000000) /* 24 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-		ParserOut_Dec(ctx, strPriceUnit, value);
-	}
-	if (gen_bitmap & 0x02000000) /* 25 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 5, &value)) goto malform;
-		ParserOut_Dec(ctx, strContract, value);
-	}
-	if (gen_bitmap & 0x04000000) /* 26 */
+	if (data == NULL)
+		rc = CALYPSO_CARD_DATA_MALFORMED;
+	else
 	{
-		if (ctx->CardData.EnvVersion & 0x38)
-		{
-			if (!get_dword_bits(data, datasize, &bit_offset, 16, &value)) goto malform;
-			ParserOut_Hex16(ctx, strAuthenticator, value);
-		}
-		else
-		{
-			if (!get_dword_bits(data, datasize, &bit_offset, 8, &value)) goto malform;
-			ParserOut_Hex8(ctx, strAuthenticator, value);
-		}
+		bits_reader_init(&reader, data, datasize, 0);
+		rc = CalypsoIntercodeDecode(ctx, &CalypsoIntercodeEvent, &reader, CalypsoOutputField, &walk);
 	}
-	if (gen_bitmap & 0x08000000) /* 27 */
-	{
-		if (!get_dword_bits(data, datasize, &bit_offset, 5, &sub_bitmap)) goto malform;
-
-		if (sub_bitmap)
-		{
-			/* EventData */
-			in_section = strData;
-			ParserOut_SectionBegin(ctx, in_section);
-
-			if (!(ctx->Parser.OutputOptions & PARSER_OUT_NO_BITMAP))
-				ParserOut_Bin(ctx, strBitmap, sub_bitmap, 5);
-
-			if (sub_bitmap & 0x00000001) /* 0 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 14, &value)) goto malform;
-				ParserOut_Date(ctx, strStartDate, translate_datestamp_14(value));
-			}
-			if (sub_bitmap & 0x00000002) /* 1 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 11, &value)) goto malform;
-				ParserOut_Time(ctx, strStartTime, translate_timestamp_11(value));
-			}
-			if (sub_bitmap & 0x00000004) /* 2 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 1, &value)) goto malform;
-				ParserOut_Dec(ctx, strSimul, value);
-			}
-			if (sub_bitmap & 0x00000008) /* 3 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 2, &value)) goto malform;
-				ParserOut_Dec(ctx, strTrip, value);
-			}
-			if (sub_bitmap & 0x00000010) /* 4 */
-			{
-				if (!get_dword_bits(data, datasize, &bit_offset, 2, &value)) goto malform;
-				ParserOut_Dec(ctx, strDirection, value);
-			}
 
-			ParserOut_SectionEnd(ctx, in_section);
-			in_section = NULL;
-		}
-	}
+	ParserOut_RecordEnd(ctx);
+	if (rc)
+		return rc;
 
 	/*
 	  if (!get_dword_bits(data, datasize, &bit_offset, 4, &gen_bitmap)) return 0;
@@ -1121,10 +576,5 @@ CALYPSO_PROC CalypsoOutputEventRecordEx(CALYPSO_CTX_ST* ctx, const BYTE data[],
 	  ParserOut_Dec(ctx, strDiagnosticCounter, value);
 	*/
 	return 0;
-
-malform:
-	if (in_section != NULL)
-		ParserOut_SectionEnd(ctx, in_section);
-	return CALYPSO_CARD_DATA_MALFORMED;
 }
 
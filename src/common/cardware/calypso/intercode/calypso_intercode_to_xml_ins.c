@@ -423,6 +423,16 @@ void ParserOut_SectionBegin(CALYPSO_CTX_ST* ctx, const char* sectionname)
 	ctx->Parser.SectionDepth++;
 }
 
+void ParserOut_RecordBegin(CALYPSO_CTX_ST* ctx)
+{
+	UNUSED_PARAMETER(ctx);
+}
+
+void ParserOut_RecordEnd(CALYPSO_CTX_ST* ctx)
+{
+	UNUSED_PARAMETER(ctx);
+}
+
 void ParserOut_SectionBeginId(CALYPSO_CTX_ST* ctx, const char* sectionname, DWORD sectionid)
 {
 	DWORD i;
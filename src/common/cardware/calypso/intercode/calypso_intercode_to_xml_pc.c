@@ -15,6 +15,8 @@
  * HISTORY
  *   JDA 21/10/2008 : first public release
  *   JDA 04/09/2023 : refreshed the project to build with Visual Studio 2022
+ *   AGT 19/10/2026 : text output in linear time, growable output buffer
+ *   AGT 19/10/2026 : JSON and binary outputs
  *
  **/
 #include "../calypso_api_i.h"
@@ -24,6 +26,82 @@
 
 #include <stdarg.h>
 
+/* Initial size of the text built by the library, see CalypsoSetXmlOutputBuilder */
+#define PARSER_BUILDER_MIN_SZ 4096
+
+/*
+ * Make room for size more characters (and the terminating NUL) in the target string.
+ * A buffer given by the application never grows : once a fragment doesn't fit,
+ * all the following ones are dropped too, so the text is never cut in the middle
+ */
+static BOOL ParserReserve(CALYPSO_CTX_ST* ctx, DWORD size)
+{
+	DWORD length;
+	char* p;
+
+	ctx->Parser.TargetNeeded += size;
+	if (ctx->Parser.TargetUsed + size != ctx->Parser.TargetNeeded)
+		return FALSE; /* Already overflowed */
+
+	if (ctx->Parser.TargetUsed + size < ctx->Parser.TargetLength)
+		return TRUE;
+
+	if (!ctx->Parser.TargetOwned)
+		return FALSE;
+
+	length = ctx->Parser.TargetLength;
+	while (length <= ctx->Parser.TargetUsed + size)
+		length *= 2;
+
+	p = realloc(ctx->Parser.TargetString, length);
+	if (p == NULL)
+		return FALSE;
+
+	ctx->Parser.TargetString = p;
+	ctx->Parser.TargetLength = length;
+	return TRUE;
+}
+
+void ParserWrite(CALYPSO_CTX_ST* ctx, const char* text, DWORD size)
+{
+	if (ctx->Parser.TargetFile != NULL)
+	{
+		fwrite(text, 1, size, ctx->Parser.TargetFile);
+	}
+	else
+		if (ctx->Parser.TargetString != NULL)
+		{
+			if (!ParserReserve(ctx, size))
+				return;
+			memcpy(&ctx->Parser.TargetString[ctx->Parser.TargetUsed], text, size);
+			ctx->Parser.TargetUsed += size;
+			ctx->Parser.TargetString[ctx->Parser.TargetUsed] = '\0';
+		}
+		else
+		{
+			fwrite(text, 1, size, stdout);
+		}
+}
+
+static void ParserPuts(CALYPSO_CTX_ST* ctx, const char* text)
+{
+	ParserWrite(ctx, text, (DWORD)strlen(text));
+}
+
+static void ParserIndent(CALYPSO_CTX_ST* ctx)
+{
+	static const char spaces[] = "                                ";
+	DWORD length = 2 * ctx->Parser.SectionDepth;
+	DWORD chunk;
+
+	while (length)
+	{
+		chunk = (length < sizeof(spaces) - 1) ? length : (DWORD)(sizeof(spaces) - 1);
+		ParserWrite(ctx, spaces, chunk);
+		length -= chunk;
+	}
+}
+
 static void ParserPrintV(CALYPSO_CTX_ST* ctx, const char* fmt, va_list arg_ptr)
 {
 	if (ctx->Parser.TargetFile != NULL)
@@ -33,10 +111,28 @@ static void ParserPrintV(CALYPSO_CTX_ST* ctx, const char* fmt, va_list arg_ptr)
 	else
 		if (ctx->Parser.TargetString != NULL)
 		{
-			char buffer[512 + 1];
-			vsnprintf(buffer, sizeof(buffer), fmt, arg_ptr);
-			if ((strlen(buffer) + strlen(ctx->Parser.TargetString)) < ctx->Parser.TargetLength)
-				strlcat(ctx->Parser.TargetString, buffer, ctx->Parser.TargetLength);
+			char buffer[128];
+			va_list arg_copy;
+			int length;
+
+			/* Most fragments are short, and are formatted only once */
+			va_copy(arg_copy, arg_ptr);
+			length = vsnprintf(buffer, sizeof(buffer), fmt, arg_copy);
+			va_end(arg_copy);
+
+			if (length < 0)
+				return;
+
+			if (length < (int)sizeof(buffer))
+			{
+				ParserWrite(ctx, buffer, (DWORD)length);
+			}
+			else
+				if (ParserReserve(ctx, (DWORD)length))
+				{
+					vsnprintf(&ctx->Parser.TargetString[ctx->Parser.TargetUsed], length + 1, fmt, arg_ptr);
+					ctx->Parser.TargetUsed += length;
+				}
 		}
 		else
 		{
@@ -55,28 +151,25 @@ static void ParserPrint(CALYPSO_CTX_ST* ctx, const char* fmt, ...)
 
 static void ParserOutBefore(CALYPSO_CTX_ST* ctx, const char* varname)
 {
-	DWORD i;
-
 	if (ctx->Parser.OutputXml)
 	{
-		for (i = 0; i < ctx->Parser.SectionDepth; i++)
-			ParserPrint(ctx, "  ");
-		ParserPrint(ctx, "<%s>", varname);
+		ParserIndent(ctx);
+		ParserPuts(ctx, "<");
+		ParserPuts(ctx, varname);
+		ParserPuts(ctx, ">");
 	}
 	if (ctx->Parser.OutputIni)
 	{
-		ParserPrint(ctx, "%s=", varname);
+		ParserPuts(ctx, varname);
+		ParserPuts(ctx, "=");
 	}
 }
 
 static void ParserOutBeforeId(CALYPSO_CTX_ST* ctx, const char* varname, DWORD varid)
 {
-	DWORD i;
-
 	if (ctx->Parser.OutputXml)
 	{
-		for (i = 0; i < ctx->Parser.SectionDepth; i++)
-			ParserPrint(ctx, "  ");
+		ParserIndent(ctx);
 		ParserPrint(ctx, "<%s id=\"%ld\">", varname, varid);
 	}
 	if (ctx->Parser.OutputIni)
@@ -89,19 +182,51 @@ static void ParserOutAfter(CALYPSO_CTX_ST* ctx, const char* varname)
 {
 	if (ctx->Parser.OutputXml)
 	{
-		ParserPrint(ctx, "</%s>", varname);
-		ParserPrint(ctx, "\n");
+		ParserPuts(ctx, "</");
+		ParserPuts(ctx, varname);
+		ParserPuts(ctx, ">\n");
 	}
 	if (ctx->Parser.OutputIni)
 	{
-		ParserPrint(ctx, "\n");
+		ParserPuts(ctx, "\n");
 	}
 }
 
 
+/*
+ * Hand a value over to the JSON or binary sink, if some
+ */
+static BOOL ParserSinkNumber(CALYPSO_CTX_ST* ctx, const char* varname, const DWORD* varid, DWORD value)
+{
+	if (ctx->Parser.Sink == NULL)
+		return FALSE;
+
+	ctx->Parser.Sink->Number(ctx, varname, varid, value);
+	return TRUE;
+}
+
+static BOOL ParserSinkTextV(CALYPSO_CTX_ST* ctx, const char* varname, const DWORD* varid, const char* fmt, va_list arg_ptr)
+{
+	char buffer[256];
+
+	if (ctx->Parser.Sink == NULL)
+		return FALSE;
+
+	vsnprintf(buffer, sizeof(buffer), fmt, arg_ptr);
+	ctx->Parser.Sink->Text(ctx, varname, varid, buffer);
+	return TRUE;
+}
+
 static void ParserOut_VarEx(CALYPSO_CTX_ST* ctx, const char* varname, const char* fmt, ...)
 {
 	va_list arg_ptr;
+	BOOL done;
+
+	va_start(arg_ptr, fmt);
+	done = ParserSinkTextV(ctx, varname, NULL, fmt, arg_ptr);
+	va_end(arg_ptr);
+	if (done)
+		return;
 
 	ParserOutBefore(ctx, varname);
 
@@ -118,6 +243,13 @@ static void ParserOut_VarEx(CALYPSO_CTX_ST* ctx, const char* varname, const char
 static void ParserOut_VarIdEx(CALYPSO_CTX_ST* ctx, const char* varname, DWORD varid, const char* fmt, ...)
 {
 	va_list arg_ptr;
+	BOOL done;
+
+	va_start(arg_ptr, fmt);
+	done = ParserSinkTextV(ctx, varname, &varid, fmt, arg_ptr);
+	va_end(arg_ptr);
+	if (done)
+		return;
 
 	ParserOutBeforeId(ctx, varname, varid);
 
@@ -135,12 +267,32 @@ void ParserOut_Hex(CALYPSO_CTX_ST* ctx, const char* varname, const BYTE value[],
 {
 	DWORD i;
 
+	if (ctx->Parser.Sink != NULL)
+	{
+		ctx->Parser.Sink->Bytes(ctx, varname, value, size);
+		return;
+	}
+
 	ParserOutBefore(ctx, varname);
 
 	if ((ctx->Parser.OutputXml) || (ctx->Parser.OutputIni))
 	{
+		static const char hex[] = "0123456789ABCDEF";
+		char buffer[2 * 32];
+		DWORD j = 0;
+
 		for (i = 0; i < size; i++)
-			ParserPrint(ctx, "%02X", value[i]);
+		{
+			buffer[j++] = hex[value[i] >> 4];
+			buffer[j++] = hex[value[i] & 0x0F];
+			if (j == sizeof(buffer))
+			{
+				ParserWrite(ctx, buffer, j);
+				j = 0;
+			}
+		}
+		if (j)
+			ParserWrite(ctx, buffer, j);
 	}
 
 	ParserOutAfter(ctx, varname);
@@ -151,6 +303,9 @@ void ParserOut_Bin(CALYPSO_CTX_ST* ctx, const char* varname, DWORD value, BYTE b
 	BYTE i;
 	char t[32 + 1];
 
+	if (ParserSinkNumber(ctx, varname, NULL, value))
+		return;
+
 	if (bits > 32) bits = 32;
 	for (i = 0; i < bits; i++)
 	{
@@ -168,11 +323,15 @@ void ParserOut_Bin(CALYPSO_CTX_ST* ctx, const char* varname, DWORD value, BYTE b
 
 void ParserOut_Dec(CALYPSO_CTX_ST* ctx, const char* varname, DWORD value)
 {
+	if (ParserSinkNumber(ctx, varname, NULL, value))
+		return;
 	ParserOut_VarEx(ctx, varname, "%ld", value);
 }
 
 void ParserOut_DecId(CALYPSO_CTX_ST* ctx, const char* varname, DWORD varid, DWORD value)
 {
+	if (ParserSinkNumber(ctx, varname, &varid, value))
+		return;
 	ParserOutBeforeId(ctx, varname, varid);
 	ParserPrint(ctx, "%ld", value);
 	ParserOutAfter(ctx, varname);
@@ -180,31 +339,43 @@ void ParserOut_DecId(CALYPSO_CTX_ST* ctx, const char* varname, DWORD varid, DWOR
 
 void ParserOut_Hex4(CALYPSO_CTX_ST* ctx, const char* varname, DWORD value)
 {
+	if (ParserSinkNumber(ctx, varname, NULL, value & 0x0F))
+		return;
 	ParserOut_VarEx(ctx, varname, "%01X", value & 0x0F);
 }
 
 void ParserOut_Hex8(CALYPSO_CTX_ST* ctx, const char* varname, DWORD value)
 {
+	if (ParserSinkNumber(ctx, varname, NULL, value & 0x0FF))
+		return;
 	ParserOut_VarEx(ctx, varname, "%02X", value & 0x0FF);
 }
 
 void ParserOut_Hex12(CALYPSO_CTX_ST* ctx, const char* varname, DWORD value)
 {
+	if (ParserSinkNumber(ctx, varname, NULL, value & 0x0FFF))
+		return;
 	ParserOut_VarEx(ctx, varname, "%03X", value & 0x0FFF);
 }
 
 void ParserOut_Hex16(CALYPSO_CTX_ST* ctx, const char* varname, DWORD value)
 {
+	if (ParserSinkNumber(ctx, varname, NULL, value & 0x0FFFF))
+		return;
 	ParserOut_VarEx(ctx, varname, "%04X", value & 0x0FFFF);
 }
 
 void ParserOut_Hex24(CALYPSO_CTX_ST* ctx, const char* varname, DWORD value)
 {
+	if (ParserSinkNumber(ctx, varname, NULL, value & 0x0FFFFFF))
+		return;
 	ParserOut_VarEx(ctx, varname, "%06lX", value & 0x0FFFFFF);
 }
 
 void ParserOut_Hex32(CALYPSO_CTX_ST* ctx, const char* varname, DWORD value)
 {
+	if (ParserSinkNumber(ctx, varname, NULL, value))
+		return;
 	ParserOut_VarEx(ctx, varname, "%08lX", value);
 }
 
@@ -235,25 +406,56 @@ void ParserOut_IdfZones(CALYPSO_CTX_ST* ctx, const char* varname, DWORD value)
 	ParserOut_VarEx(ctx, varname, temp);
 }
 
+/* Characters that are written as %xx in XML text */
+static const BYTE xml_escape[256] =
+{
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, /* 0x00 */
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x20 : " & */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, /* 0x30 : < > */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x40 */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x60 */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, /* 0x80 */
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+};
+
 void ParserOut_Str(CALYPSO_CTX_ST* ctx, const char* varname, const char* value)
 {
+	if (ctx->Parser.Sink != NULL)
+	{
+		ctx->Parser.Sink->Text(ctx, varname, NULL, value);
+		return;
+	}
+
 	if (ctx->Parser.OutputXml)
 	{
 		const unsigned char* p = (unsigned char*)value;
+		const unsigned char* run;
 
 		ParserOutBefore(ctx, varname);
 
 		while (*p != '\0')
 		{
-			if ((*p >= ' ') && (*p <= 0x7F) && (*p != '"') && (*p != '<') && (*p != '>') && (*p != '&'))
-			{
-				ParserPrint(ctx, "%c", (char)*p);
-			}
-			else
+			/* Copy the characters that need no escape all at once */
+			run = p;
+			while ((*p != '\0') && !xml_escape[*p])
+				p++;
+			if (p != run)
+				ParserWrite(ctx, (const char*)run, (DWORD)(p - run));
+
+			if (*p != '\0')
 			{
 				ParserPrint(ctx, "%%%02x", *p);
+				p++;
 			}
-			p++;
 		}
 
 		ParserOutAfter(ctx, varname);
@@ -368,7 +570,7 @@ void ParserOut_Remark(CALYPSO_CTX_ST* ctx, const char* remark)
 
 	if ((ctx->Parser.OutputXml) || (ctx->Parser.OutputIni))
 	{
-		ParserPrint(ctx, remark);
+		ParserPuts(ctx, remark);
 	}
 
 	if (ctx->Parser.OutputXml)
@@ -383,12 +585,12 @@ void ParserOut_Remark(CALYPSO_CTX_ST* ctx, const char* remark)
 
 void ParserOut_SectionBegin(CALYPSO_CTX_ST* ctx, const char* sectionname)
 {
-	DWORD i;
+	if (ctx->Parser.Sink != NULL)
+		ctx->Parser.Sink->SectionBegin(ctx, sectionname, NULL);
 
 	if (ctx->Parser.OutputXml)
 	{
-		for (i = 0; i < ctx->Parser.SectionDepth; i++)
-			ParserPrint(ctx, "  ");
+		ParserIndent(ctx);
 		ParserPrint(ctx, "<%s>\n", sectionname);
 	}
 	if (ctx->Parser.OutputIni)
@@ -405,14 +607,26 @@ void ParserOut_SectionBegin(CALYPSO_CTX_ST* ctx, const char* sectionname)
 	ctx->Parser.SectionDepth++;
 }
 
+void ParserOut_RecordBegin(CALYPSO_CTX_ST* ctx)
+{
+	if ((ctx->Parser.Sink != NULL) && (ctx->Parser.Sink->RecordBegin != NULL))
+		ctx->Parser.Sink->RecordBegin(ctx);
+}
+
+void ParserOut_RecordEnd(CALYPSO_CTX_ST* ctx)
+{
+	if ((ctx->Parser.Sink != NULL) && (ctx->Parser.Sink->RecordEnd != NULL))
+		ctx->Parser.Sink->RecordEnd(ctx);
+}
+
 void ParserOut_SectionBeginId(CALYPSO_CTX_ST* ctx, const char* sectionname, DWORD sectionid)
 {
-	DWORD i;
+	if (ctx->Parser.Sink != NULL)
+		ctx->Parser.Sink->SectionBegin(ctx, sectionname, &sectionid);
 
 	if (ctx->Parser.OutputXml)
 	{
-		for (i = 0; i < ctx->Parser.SectionDepth; i++)
-			ParserPrint(ctx, "  ");
+		ParserIndent(ctx);
 		ParserPrint(ctx, "<%s id=\"%ld\">\n", sectionname, sectionid);
 	}
 	if (ctx->Parser.OutputIni)
@@ -431,15 +645,16 @@ void ParserOut_SectionBeginId(CALYPSO_CTX_ST* ctx, const char* sectionname, DWOR
 
 void ParserOut_SectionEnd(CALYPSO_CTX_ST* ctx, const char* sectionname)
 {
-	DWORD i;
-
 	if (ctx->Parser.SectionDepth)
+	{
 		ctx->Parser.SectionDepth--;
+		if (ctx->Parser.Sink != NULL)
+			ctx->Parser.Sink->SectionEnd(ctx);
+	}
 
 	if (ctx->Parser.OutputXml)
 	{
-		for (i = 0; i < ctx->Parser.SectionDepth; i++)
-			ParserPrint(ctx, "  ");
+		ParserIndent(ctx);
 		ParserPrint(ctx, "</%s>\n", sectionname);
 	}
 	if (ctx->Parser.OutputIni)
@@ -450,15 +665,16 @@ void ParserOut_SectionEnd(CALYPSO_CTX_ST* ctx, const char* sectionname)
 
 void ParserOut_SectionEndId(CALYPSO_CTX_ST* ctx, const char* sectionname, DWORD sectionid)
 {
-	DWORD i;
-
 	if (ctx->Parser.SectionDepth)
+	{
 		ctx->Parser.SectionDepth--;
+		if (ctx->Parser.Sink != NULL)
+			ctx->Parser.Sink->SectionEnd(ctx);
+	}
 
 	if (ctx->Parser.OutputXml)
 	{
-		for (i = 0; i < ctx->Parser.SectionDepth; i++)
-			ParserPrint(ctx, "  ");
+		ParserIndent(ctx);
 		ParserPrint(ctx, "</%s> <!-- id=\"%ld\" -->\n", sectionname, sectionid);
 	}
 	if (ctx->Parser.OutputIni)
@@ -467,6 +683,66 @@ void ParserOut_SectionEndId(CALYPSO_CTX_ST* ctx, const char* sectionname, DWORD
 	}
 }
 
+/*
+ * Common part of the CalypsoSetXxxOutput functions
+ */
+CALYPSO_RC ParserSetFile(CALYPSO_CTX_ST* ctx, const char* filename, const char* mode)
+{
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+
+	CalypsoClearOutput(ctx);
+
+	if (filename != NULL)
+	{
+#ifdef WIN32
+		int err = fopen_s(&ctx->Parser.TargetFile, filename, mode);
+		if (err)
+			return CALYPSO_ERR_INVALID_PARAM;
+#else
+		ctx->Parser.TargetFile = fopen(filename, mode);
+		if (ctx->Parser.TargetFile == NULL)
+			return CALYPSO_ERR_INVALID_PARAM;
+#endif
+	}
+
+	return 0;
+}
+
+CALYPSO_RC ParserSetString(CALYPSO_CTX_ST* ctx, char* target, CALYPSO_SZ length)
+{
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+
+	CalypsoClearOutput(ctx);
+
+	if (target == NULL) return CALYPSO_ERR_INVALID_PARAM;
+	if (length < 1) return CALYPSO_ERR_INVALID_PARAM;
+
+	/* The text is always terminated, don't clear the whole buffer */
+	target[0] = '\0';
+
+	ctx->Parser.TargetString = target;
+	ctx->Parser.TargetLength = length;
+
+	return 0;
+}
+
+CALYPSO_RC ParserSetBuilder(CALYPSO_CTX_ST* ctx)
+{
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+
+	CalypsoClearOutput(ctx);
+
+	ctx->Parser.TargetString = malloc(PARSER_BUILDER_MIN_SZ);
+	if (ctx->Parser.TargetString == NULL)
+		return CALYPSO_ERR_INTERNAL_ERROR;
+
+	ctx->Parser.TargetString[0] = '\0';
+	ctx->Parser.TargetLength = PARSER_BUILDER_MIN_SZ;
+	ctx->Parser.TargetOwned = TRUE;
+
+	return 0;
+}
+
 /**f* CSB6_Calypso/CalypsoSetXmlOutput
  *
  * NAME
@@ -489,22 +765,11 @@ void ParserOut_SectionEndId(CALYPSO_CTX_ST* ctx, const char* sectionname, DWORD
  **/
 CALYPSO_PROC CalypsoSetXmlOutput(CALYPSO_CTX_ST* ctx, const char* filename)
 {
-	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+	CALYPSO_RC rc = ParserSetFile(ctx, filename, "wt");
 
-	CalypsoClearOutput(ctx);
+	if (rc)
+		return rc;
 
-	if (filename != NULL)
-	{
-#ifdef WIN32
-		int err = fopen_s(&ctx->Parser.TargetFile, filename, "wt");
-		if (err)
-			return CALYPSO_ERR_INVALID_PARAM;
-#else
-		ctx->Parser.TargetFile = fopen(filename, "wt");
-		if (ctx->Parser.TargetFile == NULL)
-			return CALYPSO_ERR_INVALID_PARAM;
-#endif
-	}
 	ctx->Parser.OutputXml = TRUE;
 
 	ParserOut_SectionBegin(ctx, "calypso_card");
@@ -534,17 +799,11 @@ CALYPSO_PROC CalypsoSetXmlOutput(CALYPSO_CTX_ST* ctx, const char* filename)
  **/
 CALYPSO_PROC CalypsoSetXmlOutputStr(CALYPSO_CTX_ST* ctx, char* target, CALYPSO_SZ length)
 {
-	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+	CALYPSO_RC rc = ParserSetString(ctx, target, length);
 
-	CalypsoClearOutput(ctx);
+	if (rc)
+		return rc;
 
-	if (target == NULL) return CALYPSO_ERR_INVALID_PARAM;
-	if (length < 1) return CALYPSO_ERR_INVALID_PARAM;
-
-	memset(target, '\0', length);
-
-	ctx->Parser.TargetString = target;
-	ctx->Parser.TargetLength = length;
 	ctx->Parser.OutputXml = TRUE;
 
 	return 0;
@@ -573,22 +832,11 @@ CALYPSO_PROC CalypsoSetXmlOutputStr(CALYPSO_CTX_ST* ctx, char* target, CALYPSO_S
  **/
 CALYPSO_PROC CalypsoSetIniOutput(CALYPSO_CTX_ST* ctx, const char* filename)
 {
-	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+	CALYPSO_RC rc = ParserSetFile(ctx, filename, "wt");
 
-	CalypsoClearOutput(ctx);
+	if (rc)
+		return rc;
 
-	if (filename != NULL)
-	{
-#ifdef WIN32
-		int err = fopen_s(&ctx->Parser.TargetFile, filename, "wt");
-		if (err)
-			return CALYPSO_ERR_INVALID_PARAM;
-#else
-		ctx->Parser.TargetFile = fopen(filename, "wt");
-		if (ctx->Parser.TargetFile == NULL)
-			return CALYPSO_ERR_INVALID_PARAM;
-#endif
-	}
 	ctx->Parser.OutputIni = TRUE;
 
 	return 0;
@@ -618,22 +866,175 @@ CALYPSO_PROC CalypsoSetIniOutput(CALYPSO_CTX_ST* ctx, const char* filename)
 
 CALYPSO_PROC CalypsoSetIniOutputStr(CALYPSO_CTX_ST* ctx, char* target, CALYPSO_SZ length)
 {
-	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+	CALYPSO_RC rc = ParserSetString(ctx, target, length);
 
-	CalypsoClearOutput(ctx);
+	if (rc)
+		return rc;
 
-	if (target == NULL) return CALYPSO_ERR_INVALID_PARAM;
-	if (length < 1) return CALYPSO_ERR_INVALID_PARAM;
+	ctx->Parser.OutputIni = TRUE;
 
-	memset(target, '\0', length);
+	return 0;
+}
 
-	ctx->Parser.TargetString = target;
-	ctx->Parser.TargetLength = length;
-	ctx->Parser.OutputIni = TRUE;
+/**f* CSB6_Calypso/CalypsoSetXmlOutputBuilder
+ *
+ * NAME
+ *   CalypsoSetXmlOutputBuilder
+ *
+ * DESCRIPTION
+ *   Same as CalypsoSetXmlOutputStr, but the library allocates the text and
+ *   makes it grow as needed. Use CalypsoDetachOutput to retrieve the text.
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx      : library context
+ *
+ * RETURNS
+ *   DWORD                             : S_SUCCESS or an error code
+ *
+ * SEE ALSO
+ *   CalypsoDetachOutput
+ *   CalypsoClearOutput
+ *
+ **/
+CALYPSO_PROC CalypsoSetXmlOutputBuilder(CALYPSO_CTX_ST* ctx)
+{
+	CALYPSO_RC rc = ParserSetBuilder(ctx);
+
+	if (!rc)
+		ctx->Parser.OutputXml = TRUE;
+
+	return rc;
+}
+
+/**f* CSB6_Calypso/CalypsoSetIniOutputBuilder
+ *
+ * NAME
+ *   CalypsoSetIniOutputBuilder
+ *
+ * DESCRIPTION
+ *   Same as CalypsoSetIniOutputStr, but the library allocates the text and
+ *   makes it grow as needed. Use CalypsoDetachOutput to retrieve the text.
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx      : library context
+ *
+ * RETURNS
+ *   DWORD                             : S_SUCCESS or an error code
+ *
+ * SEE ALSO
+ *   CalypsoDetachOutput
+ *   CalypsoClearOutput
+ *
+ **/
+CALYPSO_PROC CalypsoSetIniOutputBuilder(CALYPSO_CTX_ST* ctx)
+{
+	CALYPSO_RC rc = ParserSetBuilder(ctx);
+
+	if (!rc)
+		ctx->Parser.OutputIni = TRUE;
+
+	return rc;
+}
+
+/**f* CSB6_Calypso/CalypsoGetOutputLength
+ *
+ * NAME
+ *   CalypsoGetOutputLength
+ *
+ * DESCRIPTION
+ *   Length of the text constructed in memory by the parser
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx      : library context
+ *   CALYPSO_SZ     *length   : length of the whole text (not including the terminating NUL)
+ *
+ * RETURNS
+ *   DWORD                             : S_SUCCESS or an error code
+ *   CALYPSO_ERR_BUFFER_TOO_SHORT      : the buffer given to CalypsoSetXmlOutputStr or
+ *                                       CalypsoSetIniOutputStr was too short, the text
+ *                                       has been cut. length tells the size needed.
+ *
+ **/
+CALYPSO_PROC CalypsoGetOutputLength(CALYPSO_CTX_ST* ctx, CALYPSO_SZ* length)
+{
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+	if (ctx->Parser.TargetString == NULL) return CALYPSO_ERR_INVALID_PARAM;
+
+	if (length != NULL)
+		*length = ctx->Parser.TargetNeeded;
+
+	if (ctx->Parser.TargetUsed != ctx->Parser.TargetNeeded)
+		return CALYPSO_ERR_BUFFER_TOO_SHORT;
 
 	return 0;
 }
 
+/**f* CSB6_Calypso/CalypsoDetachOutput
+ *
+ * NAME
+ *   CalypsoDetachOutput
+ *
+ * DESCRIPTION
+ *   Give the text constructed after CalypsoSetXmlOutputBuilder or CalypsoSetIniOutputBuilder
+ *   to the caller, and terminate the parser.
+ *   The caller must release the text with CalypsoFreeOutput.
+ *
+ * INPUTS
+ *   CALYPSO_CTX_ST *ctx      : library context
+ *   char          **text     : the text, NUL terminated
+ *   CALYPSO_SZ     *length   : length of the text (optional)
+ *
+ * RETURNS
+ *   DWORD                             : S_SUCCESS or an error code
+ *
+ * SEE ALSO
+ *   CalypsoFreeOutput
+ *
+ **/
+CALYPSO_PROC CalypsoDetachOutput(CALYPSO_CTX_ST* ctx, char** text, CALYPSO_SZ* length)
+{
+	CALYPSO_RC rc;
+
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+	if (text == NULL) return CALYPSO_ERR_INVALID_PARAM;
+	if (!ctx->Parser.TargetOwned) return CALYPSO_ERR_INVALID_PARAM;
+
+	/* Failed to grow ? */
+	rc = CalypsoGetOutputLength(ctx, length);
+	if (rc == CALYPSO_ERR_BUFFER_TOO_SHORT)
+		rc = CALYPSO_ERR_INTERNAL_OVERFLOW;
+	if (length != NULL)
+		*length = ctx->Parser.TargetUsed;
+
+	*text = ctx->Parser.TargetString;
+	ctx->Parser.TargetString = NULL;
+	ctx->Parser.TargetOwned = FALSE;
+
+	CalypsoClearOutput(ctx);
+	return rc;
+}
+
+/**f* CSB6_Calypso/CalypsoFreeOutput
+ *
+ * NAME
+ *   CalypsoFreeOutput
+ *
+ * DESCRIPTION
+ *   Release a text returned by CalypsoDetachOutput
+ *
+ * INPUTS
+ *   char           *text     : the text
+ *
+ * RETURNS
+ *   none
+ *
+ **/
+CALYPSO_LIB void CALYPSO_API CalypsoFreeOutput(char* text)
+{
+	if (text != NULL)
+		free(text);
+}
+
 /**f* CSB6_Calypso/CalypsoClearOutput
  *
  * NAME
@@ -658,10 +1059,21 @@ CALYPSO_PROC CalypsoClearOutput(CALYPSO_CTX_ST* ctx)
 		if (ctx->Parser.OutputXml)
 			ParserOut_SectionEnd(ctx, "calypso_card");
 
+		/* Terminate the JSON or binary document */
+		if (ctx->Parser.Sink != NULL)
+			while (ctx->Parser.SectionDepth)
+				ParserOut_SectionEnd(ctx, NULL);
+
 		fclose(ctx->Parser.TargetFile);
 		ctx->Parser.TargetFile = NULL;
 	}
 
+	if (ctx->Parser.TargetOwned && (ctx->Parser.TargetString != NULL))
+		free(ctx->Parser.TargetString);
+
+	if (ctx->Parser.SinkData != NULL)
+		free(ctx->Parser.SinkData);
+
 	memset(&ctx->Parser, 0, sizeof(ctx->Parser));
 	return 0;
 }
@@ -11,22 +11,104 @@
  *
  * HISTORY
  *   JDA 21/10/2008 : first public release
+ *   AGT 19/10/2026 : fields are accessed through a window instead of bit by bit
  *
  **/
 #include "../calypso_api_i.h"
 
-BOOL get_char5_bits(const BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, BYTE bit_count, char value[], BYTE length)
+/* The bit_count lowest bits set */
+#define BITS_MASK(n) (((n) < CALYPSO_BITS_WINDOW_SZ) ? ((((CALYPSO_BITS_WINDOW) 1) << (n)) - 1) : ~((CALYPSO_BITS_WINDOW) 0))
+
+/*
+ **********************************************************************************************************************
+ *
+ * SEQUENTIAL READER
+ *
+ **********************************************************************************************************************
+ */
+
+void bits_reader_init(CALYPSO_BITS_READER_ST* reader, const BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ bit_offset)
+{
+	reader->Data = data;
+	reader->Size = size;
+	reader->Next = bit_offset / 8;
+	reader->Window = 0;
+	reader->Avail = 0;
+
+	if (reader->Next < size)
+	{
+		reader->Window = data[reader->Next++];
+		reader->Avail = (BYTE)(8 - (bit_offset % 8));
+	}
+}
+
+BOOL bits_reader_get(CALYPSO_BITS_READER_ST* reader, BYTE bit_count, DWORD* value)
+{
+	if (bit_count > 32) return FALSE;
+
+	if (bit_count > (CALYPSO_BITS_WINDOW_SZ - 8))
+	{
+		/* Window too small for this field, take it in two parts */
+		DWORD hi, lo;
+		if (!bits_reader_get(reader, (BYTE)(bit_count - 16), &hi)) return FALSE;
+		if (!bits_reader_get(reader, 16, &lo)) return FALSE;
+		*value = (hi << 16) | lo;
+		return TRUE;
+	}
+
+	if (reader->Avail < bit_count)
+	{
+		/* Refill, bytewise */
+		while ((reader->Avail <= (CALYPSO_BITS_WINDOW_SZ - 8)) && (reader->Next < reader->Size))
+		{
+			reader->Window <<= 8;
+			reader->Window |= reader->Data[reader->Next++];
+			reader->Avail += 8;
+		}
+		if (reader->Avail < bit_count) return FALSE;
+	}
+
+	reader->Avail -= bit_count;
+	*value = (DWORD)((reader->Window >> reader->Avail) & BITS_MASK(bit_count));
+	return TRUE;
+}
+
+CALYPSO_BITS_SZ bits_reader_offset(const CALYPSO_BITS_READER_ST* reader)
+{
+	return (CALYPSO_BITS_SZ)reader->Next * 8 - reader->Avail;
+}
+
+/*
+ **********************************************************************************************************************
+ *
+ * RANDOM ACCESS
+ *
+ **********************************************************************************************************************
+ */
+
+static char char5_to_char(BYTE r)
+{
+	/* TODO : find a documentation ? This switch has been written only from reverse engineering */
+	switch (r)
+	{
+	case 0:
+		return '@';
+	case 27:
+		return ' ';
+	default:
+		return 'A' + (r - 1);
+	}
+}
+
+/*
+ * Bit by bit implementation, for the fields that go beyond the end of the data
+ */
+static BOOL get_char5_bits_slow(const BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, BYTE bit_count, char value[], BYTE length)
 {
 	CALYPSO_BITS_SZ  byte_offset;
 	BYTE pos_in_byte, byte_mask, i;
 	BYTE r = 0;
 
-	if (data == NULL)       return FALSE;
-	if (bit_offset == NULL) return FALSE;
-	if (value == NULL)      return FALSE;
-
-	memset(value, 0, length);
-
 	for (i = 0; i < bit_count; i++)
 	{
 		byte_offset = *bit_offset / 8;
@@ -47,18 +129,7 @@ BOOL get_char5_bits(const BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_off
 			if ((i / 5) >= length)
 				break;
 
-			/* TODO : find a documentation ? This switch has been written only from reverse engineering */
-			switch (r)
-			{
-			case 0:
-				value[i / 5] = '@';
-				break;
-			case 27:
-				value[i / 5] = ' ';
-				break;
-			default:
-				value[i / 5] = 'A' + (r - 1);
-			}
+			value[i / 5] = char5_to_char(r);
 			r = 0;
 		}
 
@@ -68,17 +139,37 @@ BOOL get_char5_bits(const BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_off
 	return TRUE;
 }
 
-BOOL get_dword_bits(const BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, BYTE bit_count, DWORD* value)
+BOOL get_char5_bits(const BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, BYTE bit_count, char value[], BYTE length)
 {
-	CALYPSO_BITS_SZ  byte_offset;
-	BYTE  pos_in_byte, byte_mask, i;
-	DWORD r = 0;
-
+	CALYPSO_BITS_READER_ST reader;
+	DWORD r;
+	BYTE i;
 
 	if (data == NULL)       return FALSE;
 	if (bit_offset == NULL) return FALSE;
 	if (value == NULL)      return FALSE;
-	if (bit_count > 32)     return FALSE;
+
+	memset(value, 0, length);
+
+	if ((*bit_offset + bit_count > (CALYPSO_BITS_SZ)size * 8) || (bit_count > 5 * (CALYPSO_BITS_SZ)length + 4))
+		return get_char5_bits_slow(data, size, bit_offset, bit_count, value, length);
+
+	bits_reader_init(&reader, data, size, *bit_offset);
+	for (i = 0; i < bit_count / 5; i++)
+	{
+		bits_reader_get(&reader, 5, &r);
+		value[i] = char5_to_char((BYTE)r);
+	}
+
+	*bit_offset += bit_count;
+	return TRUE;
+}
+
+static BOOL get_dword_bits_slow(const BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, BYTE bit_count, DWORD* value)
+{
+	CALYPSO_BITS_SZ  byte_offset;
+	BYTE  pos_in_byte, byte_mask, i;
+	DWORD r = 0;
 
 	for (i = 0; i < bit_count; i++)
 	{
@@ -102,6 +193,36 @@ BOOL get_dword_bits(const BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_off
 	return TRUE;
 }
 
+BOOL get_dword_bits(const BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, BYTE bit_count, DWORD* value)
+{
+	CALYPSO_BITS_SZ byte_offset;
+	CALYPSO_BITS_WINDOW w = 0;
+	BYTE shift, byte_count, i;
+
+	if (data == NULL)       return FALSE;
+	if (bit_offset == NULL) return FALSE;
+	if (value == NULL)      return FALSE;
+	if (bit_count > 32)     return FALSE;
+
+	byte_offset = *bit_offset / 8;
+	shift = (BYTE)(*bit_offset % 8);
+
+	if ((*bit_offset + bit_count > (CALYPSO_BITS_SZ)size * 8) || (shift + bit_count > CALYPSO_BITS_WINDOW_SZ))
+		return get_dword_bits_slow(data, size, bit_offset, bit_count, value);
+
+	/* Load all the bytes of the field at once, and keep the right bits */
+	byte_count = (BYTE)((shift + bit_count + 7) / 8);
+	for (i = 0; i < byte_count; i++)
+	{
+		w <<= 8;
+		w |= data[byte_offset + i];
+	}
+
+	*value = (DWORD)((w >> (8 * byte_count - shift - bit_count)) & BITS_MASK(bit_count));
+	*bit_offset += bit_count;
+	return TRUE;
+}
+
 CALYPSO_BITS_SZ count_zeros(const BYTE buffer[], CALYPSO_BITS_SZ bit_count)
 {
 	register CALYPSO_BITS_SZ i, r = 0;
@@ -125,7 +246,7 @@ CALYPSO_BITS_SZ count_zeros(const BYTE buffer[], CALYPSO_BITS_SZ bit_count)
 	return r;
 }
 
-BOOL set_dword_bits(BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, BYTE bit_count, DWORD value)
+static BOOL set_dword_bits_slow(BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, BYTE bit_count, DWORD value)
 {
 	CALYPSO_BITS_SZ byte_offset;
 	BYTE pos_in_byte, byte_mask, i;
@@ -162,6 +283,40 @@ BOOL set_dword_bits(BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, B
 	return TRUE;
 }
 
+BOOL set_dword_bits(BYTE data[], CALYPSO_SZ size, CALYPSO_BITS_SZ* bit_offset, BYTE bit_count, DWORD value)
+{
+	CALYPSO_BITS_SZ byte_offset;
+	CALYPSO_BITS_WINDOW w = 0, mask;
+	BYTE shift, byte_count, i;
+
+	byte_offset = *bit_offset / 8;
+	shift = (BYTE)(*bit_offset % 8);
+
+	if ((bit_count == 0) || (bit_count >= 32) || (*bit_offset + bit_count > (CALYPSO_BITS_SZ)size * 8) || (shift + bit_count > CALYPSO_BITS_WINDOW_SZ))
+		return set_dword_bits_slow(data, size, bit_offset, bit_count, value);
+
+	/* Read the bytes of the field, replace the field, write them back */
+	byte_count = (BYTE)((shift + bit_count + 7) / 8);
+	for (i = 0; i < byte_count; i++)
+	{
+		w <<= 8;
+		w |= data[byte_offset + i];
+	}
+
+	shift = (BYTE)(8 * byte_count - shift - bit_count);
+	mask = BITS_MASK(bit_count) << shift;
+	w = (w & ~mask) | (((CALYPSO_BITS_WINDOW)value << shift) & mask);
+
+	for (i = byte_count; i > 0; i--)
+	{
+		data[byte_offset + i - 1] = (BYTE)w;
+		w >>= 8;
+	}
+
+	*bit_offset += bit_count;
+	return TRUE;
+}
+
 CALYPSO_LIB BOOL CalypsoIsRecordEmpty(const BYTE data[], CALYPSO_SZ datasize)
 {
 	CALYPSO_SZ i;
@@ -29,8 +29,8 @@
   *   This function is used by the library, do not call it directly from your application.
   *
   * SIDE EFFECTS
-  *   When a session is active, the dialog between the application and the card is forwarded to the SAM
-  *   in two calls to CalypsoSamDigestUpdate
+  *   When a session is active, the dialog between the application and the card is recorded, to be
+  *   forwarded to the SAM by CalypsoSamDigestFlush before the next SAM command
   *
   **/
 CALYPSO_PROC CalypsoCardTransmit(CALYPSO_CTX_ST* ctx, const BYTE send_buffer[], CALYPSO_SZ send_length, BYTE recv_buffer[], CALYPSO_SZ* recv_length)
@@ -69,12 +69,21 @@ CALYPSO_PROC CalypsoCardTransmit(CALYPSO_CTX_ST* ctx, const BYTE send_buffer[],
 #if (CALYPSO_WITH_SAM)
 	if (ctx->CardApplication.SessionActive)
 	{
+#ifdef CALYPSO_HOST
+		/* Currently in transaction, the APDUs will be forwarded to the SAM later on */
+		rc = CalypsoSamDigestPush(ctx, send_buffer_copy, send_length);
+		if (rc) return rc;
+
+		rc = CalypsoSamDigestPush(ctx, recv_buffer, *recv_length);
+		if (rc) return rc;
+#else
 		/* Currently in transaction, forward the APDUs to the SAM */
 		rc = CalypsoSamDigestUpdate(ctx, send_buffer_copy, send_length);
 		if (rc) return rc;
 
 		rc = CalypsoSamDigestUpdate(ctx, recv_buffer, *recv_length);
 		if (rc) return rc;
+#endif
 	}
 #endif
 
@@ -97,6 +106,25 @@ CALYPSO_PROC CalypsoSamTransmit(CALYPSO_CTX_ST* ctx, const BYTE send_buffer[], C
 {
 	CALYPSO_RC rc;
 
+#ifdef CALYPSO_HOST
+	if (!CalypsoSamAsyncIsWorker(ctx))
+	{
+		/* The command running in background must terminate first */
+		rc = CalypsoSamAsyncWait(ctx);
+		if (rc) return rc;
+
+		if (ctx->Sam.DigestJournalLen && !ctx->Sam.DigestFlushing)
+		{
+			/* The SAM must receive the pending APDUs of the session first */
+			rc = CalypsoSamDigestFlush(ctx);
+			if (rc) return rc;
+		}
+	}
+
+	/* Whatever the command, the SAM forgets the challenge it has given */
+	ctx->Sam.ChallengeValid = FALSE;
+#endif
+
 	switch (ctx->Sam.Type)
 	{
 #ifdef _USE_PCSC
@@ -112,6 +140,10 @@ CALYPSO_PROC CalypsoSamTransmit(CALYPSO_CTX_ST* ctx, const BYTE send_buffer[], C
 
 	if (rc)
 	{
+#ifdef CALYPSO_HOST
+		/* SAM removed or reset, don't trust its state anymore */
+		ctx->Sam.DiversifierValid = FALSE;
+#endif
 		rc |= CALYPSO_ERR_SAM_;
 		return rc;
 	}
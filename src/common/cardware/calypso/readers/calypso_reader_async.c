@@ -0,0 +1,321 @@
+/**h* CalypsoAPI/calypso_reader_async.c
+ *
+ * NAME
+ *   calypso_reader_async.c
+ *
+ * DESCRIPTION
+ *   Background execution of SAM commands, so that the SAM may work while
+ *   the card is exchanging with the reader
+ *
+ * COPYRIGHT
+ *   (c) 2026 SpringCard - www.springcard.com
+ *
+ * HISTORY
+ *   AGT 19/10/2026 : created
+ *
+ **/
+#include "../calypso_api_i.h"
+
+#if (CALYPSO_WITH_SAM) && defined(CALYPSO_HOST)
+
+#ifndef WIN32
+#include <pthread.h>
+#endif
+
+/*
+ * The worker runs at most one job at a time. Every SAM command issued from
+ * the application's thread waits for the pending job first (before it
+ * touches ctx->Sam.Buffer), so the SAM always sees its commands in the order
+ * the library issued them ; only the card exchanges are actually overlapped.
+ * Pending, Result and Quit are only accessed with the lock held.
+ */
+typedef struct
+{
+#ifdef WIN32
+	HANDLE          hThread;
+	DWORD           dwThreadId;
+	HANDLE          hJobEvent;  /* Auto-reset, a job has been posted  */
+	HANDLE          hIdleEvent; /* Manual-reset, no job is pending    */
+	CRITICAL_SECTION Lock;
+#else
+	pthread_t       Thread;
+	pthread_mutex_t Mutex;
+	pthread_cond_t  Cond;
+#endif
+	BOOL            Pending;
+	BOOL            Quit;
+
+	CALYPSO_CTX_ST* Ctx;
+	CALYPSO_SAM_JOB Job;
+	BYTE            Param[CALYPSO_MAX_DATA_SZ + 4];
+	CALYPSO_SZ      ParamSize;
+	CALYPSO_RC      Result;
+
+} CALYPSO_SAM_ASYNC_ST;
+
+#ifdef WIN32
+static DWORD WINAPI CalypsoSamAsyncThread(LPVOID param)
+#else
+static void* CalypsoSamAsyncThread(void* param)
+#endif
+{
+	CALYPSO_SAM_ASYNC_ST* async = (CALYPSO_SAM_ASYNC_ST*)param;
+	CALYPSO_RC rc;
+	BOOL quit;
+
+	for (;;)
+	{
+#ifdef WIN32
+		WaitForSingleObject(async->hJobEvent, INFINITE);
+		EnterCriticalSection(&async->Lock);
+		quit = async->Quit;
+		LeaveCriticalSection(&async->Lock);
+#else
+		pthread_mutex_lock(&async->Mutex);
+		while (!async->Pending && !async->Quit)
+			pthread_cond_wait(&async->Cond, &async->Mutex);
+		quit = async->Quit;
+		pthread_mutex_unlock(&async->Mutex);
+#endif
+		if (quit)
+			break;
+
+		rc = async->Job(async->Ctx, async->Param, async->ParamSize);
+
+#ifdef WIN32
+		EnterCriticalSection(&async->Lock);
+		async->Result = rc;
+		async->Pending = FALSE;
+		SetEvent(async->hIdleEvent);
+		LeaveCriticalSection(&async->Lock);
+#else
+		pthread_mutex_lock(&async->Mutex);
+		async->Result = rc;
+		async->Pending = FALSE;
+		pthread_cond_broadcast(&async->Cond);
+		pthread_mutex_unlock(&async->Mutex);
+#endif
+	}
+
+#ifdef WIN32
+	return 0;
+#else
+	return NULL;
+#endif
+}
+
+/**f* CSB6_Calypso/CalypsoSamSetAsync
+ *
+ * NAME
+ *   CalypsoSamSetAsync
+ *
+ * DESCRIPTION
+ *   Let the library run some SAM commands (Digest Init) in a background
+ *   thread, while the card is already processing the next commands
+ *   of the session.
+ *   This is only possible when the SAM and the card are driven through
+ *   two independent channels (two PC/SC readers, or two SpringProx
+ *   instances when the library is built with SPROX_API_REENTRANT).
+ *   The application must not use the context from another thread.
+ *
+ * INPUTS
+ *   P_CALYPSO_CTX  ctx             : library context
+ *   BOOL           enable          : TRUE to start the worker, FALSE to stop it
+ *
+ * RETURNS
+ *   CALYPSO_SUCCESS
+ *   CALYPSO_ERR_INVALID_PARAM      : the SAM and the card share the same reader
+ *   CALYPSO_ERR_INTERNAL_ERROR     : failed to create the worker
+ *
+ **/
+CALYPSO_PROC CalypsoSamSetAsync(P_CALYPSO_CTX ctx, BOOL enable)
+{
+	CALYPSO_SAM_ASYNC_ST* async;
+
+	if (ctx == NULL) return CALYPSO_ERR_INVALID_CONTEXT;
+
+	if (!enable)
+	{
+		CalypsoSamAsyncDispose(ctx);
+		return CALYPSO_SUCCESS;
+	}
+
+	if (ctx->Sam.Async != NULL)
+		return CALYPSO_SUCCESS;
+
+#ifdef CALYPSO_LEGACY
+	if ((ctx->Sam.Type == CALYPSO_TYPE_LEGACY) && (ctx->Card.Type == CALYPSO_TYPE_LEGACY))
+	{
+#ifdef SPROX_API_REENTRANT
+		if (ctx->Sam.Legacy.rInst == ctx->Card.Legacy.rInst)
+#endif
+			return CALYPSO_ERR_INVALID_PARAM;
+	}
+#endif
+
+	async = malloc(sizeof(CALYPSO_SAM_ASYNC_ST));
+	if (async == NULL)
+		return CALYPSO_ERR_INTERNAL_ERROR;
+	memset(async, 0, sizeof(CALYPSO_SAM_ASYNC_ST));
+	async->Ctx = ctx;
+
+#ifdef WIN32
+	InitializeCriticalSection(&async->Lock);
+	async->hJobEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	async->hIdleEvent = CreateEvent(NULL, TRUE, TRUE, NULL);
+	if ((async->hJobEvent != NULL) && (async->hIdleEvent != NULL))
+		async->hThread = CreateThread(NULL, 0, CalypsoSamAsyncThread, async, 0, &async->dwThreadId);
+	if (async->hThread == NULL)
+	{
+		if (async->hJobEvent != NULL) CloseHandle(async->hJobEvent);
+		if (async->hIdleEvent != NULL) CloseHandle(async->hIdleEvent);
+		DeleteCriticalSection(&async->Lock);
+		free(async);
+		return CALYPSO_ERR_INTERNAL_ERROR;
+	}
+#else
+	pthread_mutex_init(&async->Mutex, NULL);
+	pthread_cond_init(&async->Cond, NULL);
+	if (pthread_create(&async->Thread, NULL, CalypsoSamAsyncThread, async))
+	{
+		pthread_cond_destroy(&async->Cond);
+		pthread_mutex_destroy(&async->Mutex);
+		free(async);
+		return CALYPSO_ERR_INTERNAL_ERROR;
+	}
+#endif
+
+	ctx->Sam.Async = async;
+	CalypsoTraceStr(TR_TRACE | TR_SAM, "SAM worker started");
+	return CALYPSO_SUCCESS;
+}
+
+/*
+ * Is the caller the worker thread ?
+ */
+BOOL CalypsoSamAsyncIsWorker(CALYPSO_CTX_ST* ctx)
+{
+	CALYPSO_SAM_ASYNC_ST* async = ctx->Sam.Async;
+
+	if (async == NULL)
+		return FALSE;
+
+#ifdef WIN32
+	return (GetCurrentThreadId() == async->dwThreadId) ? TRUE : FALSE;
+#else
+	return pthread_equal(pthread_self(), async->Thread) ? TRUE : FALSE;
+#endif
+}
+
+/*
+ * Wait until the pending job (if some) is terminated, and retrieve its result.
+ * The result is only returned once.
+ */
+CALYPSO_RC CalypsoSamAsyncWait(CALYPSO_CTX_ST* ctx)
+{
+	CALYPSO_SAM_ASYNC_ST* async = ctx->Sam.Async;
+	CALYPSO_RC rc;
+
+	if (async == NULL)
+		return CALYPSO_SUCCESS;
+	if (CalypsoSamAsyncIsWorker(ctx))
+		return CALYPSO_SUCCESS;
+
+#ifdef WIN32
+	WaitForSingleObject(async->hIdleEvent, INFINITE);
+	EnterCriticalSection(&async->Lock);
+	rc = async->Result;
+	async->Result = CALYPSO_SUCCESS;
+	LeaveCriticalSection(&async->Lock);
+#else
+	pthread_mutex_lock(&async->Mutex);
+	while (async->Pending)
+		pthread_cond_wait(&async->Cond, &async->Mutex);
+	rc = async->Result;
+	async->Result = CALYPSO_SUCCESS;
+	pthread_mutex_unlock(&async->Mutex);
+#endif
+
+	return rc;
+}
+
+/*
+ * Give a job to the worker. Without worker, the job is run at once and
+ * its result is returned. With a worker, the returned value is the result of
+ * the previous job, the result of this one will be returned by the next
+ * CalypsoSamAsyncWait (i.e. by the next access to the SAM).
+ */
+CALYPSO_RC CalypsoSamAsyncPost(CALYPSO_CTX_ST* ctx, CALYPSO_SAM_JOB job, const BYTE param[], CALYPSO_SZ paramsize)
+{
+	CALYPSO_SAM_ASYNC_ST* async = ctx->Sam.Async;
+	CALYPSO_RC rc;
+
+	if (paramsize > sizeof(async->Param))
+		return CALYPSO_ERR_INTERNAL_OVERFLOW;
+
+	if ((async == NULL) || CalypsoSamAsyncIsWorker(ctx))
+		return job(ctx, param, paramsize);
+
+	rc = CalypsoSamAsyncWait(ctx);
+	if (rc)
+		return rc;
+
+	async->Job = job;
+	if (paramsize)
+		memcpy(async->Param, param, paramsize);
+	async->ParamSize = paramsize;
+
+#ifdef WIN32
+	EnterCriticalSection(&async->Lock);
+	async->Pending = TRUE;
+	ResetEvent(async->hIdleEvent);
+	LeaveCriticalSection(&async->Lock);
+	SetEvent(async->hJobEvent);
+#else
+	pthread_mutex_lock(&async->Mutex);
+	async->Pending = TRUE;
+	pthread_cond_broadcast(&async->Cond);
+	pthread_mutex_unlock(&async->Mutex);
+#endif
+
+	return CALYPSO_SUCCESS;
+}
+
+/*
+ * Terminate the pending job, then stop the worker
+ */
+void CalypsoSamAsyncDispose(CALYPSO_CTX_ST* ctx)
+{
+	CALYPSO_SAM_ASYNC_ST* async = ctx->Sam.Async;
+
+	if (async == NULL)
+		return;
+
+	CalypsoSamAsyncWait(ctx);
+
+#ifdef WIN32
+	EnterCriticalSection(&async->Lock);
+	async->Quit = TRUE;
+	LeaveCriticalSection(&async->Lock);
+	SetEvent(async->hJobEvent);
+	WaitForSingleObject(async->hThread, INFINITE);
+	CloseHandle(async->hThread);
+	CloseHandle(async->hJobEvent);
+	CloseHandle(async->hIdleEvent);
+	DeleteCriticalSection(&async->Lock);
+#else
+	pthread_mutex_lock(&async->Mutex);
+	async->Quit = TRUE;
+	pthread_cond_broadcast(&async->Cond);
+	pthread_mutex_unlock(&async->Mutex);
+	pthread_join(async->Thread, NULL);
+	pthread_cond_destroy(&async->Cond);
+	pthread_mutex_destroy(&async->Mutex);
+#endif
+
+	free(async);
+	ctx->Sam.Async = NULL;
+	CalypsoTraceStr(TR_TRACE | TR_SAM, "SAM worker stopped");
+}
+
+#endif
@@ -177,6 +177,8 @@ CALYPSO_PROC CalypsoSamBindLegacy(P_CALYPSO_CTX ctx, BYTE slot)
 #endif
 
 	ctx->Sam.Type = CALYPSO_TYPE_LEGACY;
+	ctx->Sam.DiversifierValid = FALSE;
+	ctx->Sam.ChallengeValid = FALSE;
 	return 0;
 }
 #endif
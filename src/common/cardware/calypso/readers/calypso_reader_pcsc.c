@@ -170,6 +170,8 @@ CALYPSO_PROC CalypsoSamBindPcsc(CALYPSO_CTX_ST* ctx, SCARDHANDLE hCard)
 	memset(&ctx->Sam.Pcsc, 0, sizeof(ctx->Sam.Pcsc));
 
 	ctx->Sam.Type = CALYPSO_TYPE_PCSC;
+	ctx->Sam.DiversifierValid = FALSE;
+	ctx->Sam.ChallengeValid = FALSE;
 
 	ctx->Sam.Pcsc.hCard = hCard;
 	ctx->Sam.Pcsc.bTrace = TR_SAM;
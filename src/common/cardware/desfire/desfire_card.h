@@ -587,6 +587,22 @@ typedef union
 	} stRecordFileSettings;
 } DF_ADDITIONAL_FILE_SETTINGS;
 
+/*
+ * DF_READ_FILE_ST
+ * ---------------
+ * Structure describing one file to be read by SelectAuthenticateAesRead.
+ * The dwDoneCount member receives the actual data length read.
+ */
+typedef struct
+{
+	BYTE    bFileId;
+	BYTE    bCommMode;
+	DWORD   dwFromOffset;
+	DWORD   dwMaxCount;
+	BYTE*   pbData;
+	DWORD   dwDoneCount;
+} DF_READ_FILE_ST;
+
 /* Data item lengths for the GetFileSettings command */
 #define	DF_FILE_SETTINGS_COMMON_LENGTH	4
 #define	DF_DATA_FILE_SETTINGS_LENGTH	  3
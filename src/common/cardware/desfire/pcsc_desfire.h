@@ -34,6 +34,7 @@ extern  "C"
 	SPROX_DESFIRE_LIB LONG SPROX_DESFIRE_API SCardDesfire_AttachLibrary(SCARDHANDLE hCard);
 	SPROX_DESFIRE_LIB LONG SPROX_DESFIRE_API SCardDesfire_DetachLibrary(SCARDHANDLE hCard);
 	SPROX_DESFIRE_LIB LONG SPROX_DESFIRE_API SCardDesfire_IsoWrapping(SCARDHANDLE hCard, BYTE mode);
+	SPROX_DESFIRE_LIB LONG SPROX_DESFIRE_API SCardDesfire_SetMaxFrameSize(SCARDHANDLE hCard, WORD max_frame_size);
 
 	SPROX_DESFIRE_LIB const TCHAR* SPROX_DESFIRE_API SCardDesfire_GetLibraryVersion(void);
 
@@ -238,6 +239,12 @@ extern  "C"
 	SPROX_DESFIRE_LIB LONG SPROX_DESFIRE_API SCardDesfire_AuthenticateAes(SCARDHANDLE hCard,
 		BYTE bKeyNumber,
 		const BYTE pbAccessKey[16]);
+	SPROX_DESFIRE_LIB LONG SPROX_DESFIRE_API SCardDesfire_SelectAuthenticateAesRead(SCARDHANDLE hCard,
+		DWORD aid,
+		BYTE bKeyNumber,
+		const BYTE pbAccessKey[16],
+		DF_READ_FILE_ST files[],
+		BYTE file_count);
 	SPROX_DESFIRE_LIB LONG SPROX_DESFIRE_API SCardDesfire_ChangeKey24(SCARDHANDLE hCard,
 		BYTE key_number,
 		const BYTE new_key[24],
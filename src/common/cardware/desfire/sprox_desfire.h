@@ -50,6 +50,10 @@ extern  "C"
 
 	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROX_Desfire_SelectCid(BYTE cid);
 	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROX_Desfire_IsoWrapping(BYTE mode);
+	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROX_Desfire_SetMaxFrameSize(WORD max_frame_size);
+
+	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROX_Desfire_SwitchCid(BYTE cid);
+	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROX_Desfire_ReleaseCid(BYTE cid);
 
 	/*
 	 * Library helpers
@@ -220,6 +224,11 @@ extern  "C"
 		const BYTE pbAccessKey[24]);
 	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROX_Desfire_AuthenticateAes(BYTE bKeyNumber,
 		const BYTE pbAccessKey[16]);
+	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROX_Desfire_SelectAuthenticateAesRead(DWORD aid,
+		BYTE bKeyNumber,
+		const BYTE pbAccessKey[16],
+		DF_READ_FILE_ST files[],
+		BYTE file_count);
 	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROX_Desfire_ChangeKey24(BYTE key_number,
 		const BYTE new_key[24],
 		const BYTE old_key[24]);
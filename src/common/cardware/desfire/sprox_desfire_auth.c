@@ -634,9 +634,7 @@ SPROX_API_FUNC(Desfire_AuthenticateIso24) (SPROX_PARAM  BYTE bKeyNumber, const B
  **/
 SPROX_API_FUNC(Desfire_AuthenticateAes) (SPROX_PARAM  BYTE bKeyNumber, const BYTE pbAccessKey[16])
 {
-	SPROX_RC status;
-	DWORD t;
-	BYTE  abRndB[16], abRndA[16];
+	BYTE  abRndA[16];
 	SPROX_DESFIRE_GET_CTX();
 
 	if (pbAccessKey == NULL)
@@ -649,6 +647,27 @@ SPROX_API_FUNC(Desfire_AuthenticateAes) (SPROX_PARAM  BYTE bKeyNumber, const BYT
 	ctx->session_type = KEY_ISO_AES;
 	Desfire_InitCryptoAes(SPROX_PARAM_P  pbAccessKey);
 
+	/* Generate RndA now, so that nothing but the RndB processing remains between the frames */
+	GetRandomBytes(SPROX_PARAM_P  abRndA, 16);
+
+	return Desfire_AuthenticateAesRun(SPROX_PARAM_P  bKeyNumber, abRndA);
+}
+
+/*
+ * AuthenticateAesRun
+ * ------------------
+ * Protocol part of AuthenticateAes. The cipher unit must already be loaded with
+ * the access key, and RndA must already be generated.
+ */
+SPROX_RC Desfire_AuthenticateAesRun(SPROX_PARAM  BYTE bKeyNumber, const BYTE abRndA[16])
+{
+	SPROX_RC status;
+	DWORD t;
+	BYTE  abRndB[16];
+	SPROX_DESFIRE_GET_CTX();
+
+	ctx->session_type = KEY_ISO_AES;
+
 	/* Create the command string consisting of the command byte and the parameter byte. */
 	ctx->xfer_buffer[INF + 0] = DF_AUTHENTICATE_AES;
 	ctx->xfer_buffer[INF + 1] = bKeyNumber;
@@ -676,9 +695,6 @@ SPROX_API_FUNC(Desfire_AuthenticateAes) (SPROX_PARAM  BYTE bKeyNumber, const BYT
 	/* Store this RndB (is needed later on for generating the session key). */
 	memcpy(abRndB, &ctx->xfer_buffer[INF + 1], 16);
 
-	/* Now the PCD has to generate RndA. */
-	GetRandomBytes(SPROX_PARAM_P  abRndA, 16);
-
 	/* Start the second frame with a status byte indicating to the PICC that the Authenticate
 	   command is continued. */
 	ctx->xfer_buffer[INF + 0] = DF_ADDITIONAL_FRAME;
@@ -749,6 +765,102 @@ SPROX_API_FUNC(Desfire_AuthenticateAes) (SPROX_PARAM  BYTE bKeyNumber, const BYT
 	return DF_OPERATION_OK;
 }
 
+/**f* DesfireAPI/SelectAuthenticateAesRead
+ *
+ * NAME
+ *   SelectAuthenticateAesRead
+ *
+ * DESCRIPTION
+ *   Selects one application, performs authentication using the specified AES
+ *   key, and reads one or more Standard Data Files or Backup Data Files, all
+ *   in a single call.
+ *   The cryptographic preparation of the authentication (AES key schedule,
+ *   generation of RndA) is done before the first frame is sent to the card,
+ *   so only the processing of RndB remains between the RF exchanges.
+ *   This function is not available on DESFIRE EV0 cards.
+ *
+ * SYNOPSIS
+ *
+ *   [[sprox_desfire.dll]]
+ *   SWORD SPROX_Desfire_SelectAuthenticateAesRead(DWORD aid,
+ *                                                 BYTE bKeyNumber,
+ *                                                 const BYTE pbAccessKey[16],
+ *                                                 DF_READ_FILE_ST files[],
+ *                                                 BYTE file_count);
+ *
+ *   [[sprox_desfire_ex.dll]]
+ *   SWORD SPROXx_Desfire_SelectAuthenticateAesRead(SPROX_INSTANCE rInst,
+ *                                                  DWORD aid,
+ *                                                  BYTE bKeyNumber,
+ *                                                  const BYTE pbAccessKey[16],
+ *                                                  DF_READ_FILE_ST files[],
+ *                                                  BYTE file_count);
+ *
+ *   [[pcsc_desfire.dll]]
+ *   LONG  SCardDesfire_SelectAuthenticateAesRead(SCARDHANDLE hCard,
+ *                                                DWORD aid,
+ *                                                BYTE bKeyNumber,
+ *                                                const BYTE pbAccessKey[16],
+ *                                                DF_READ_FILE_ST files[],
+ *                                                BYTE file_count);
+ *
+ * INPUTS
+ *   DWORD aid                   : Application IDentifier
+ *   BYTE bKeyNumber             : number of the key (KeyNo)
+ *   const BYTE pbAccessKey[16]  : 16-byte Access Key (AES)
+ *   DF_READ_FILE_ST files[]     : list of the files to be read (may be NULL)
+ *   BYTE file_count             : number of entries in files[]
+ *
+ * RETURNS
+ *   DF_OPERATION_OK    : application selected, authentication succeed, all files read
+ *   Other code if internal or communication error has occured.
+ *
+ * NOTES
+ *   The files are read in the order of the list. The dwDoneCount member of
+ *   every entry that has been read is updated. The processing stops on the
+ *   first error; the entries after the one that failed are left untouched.
+ *
+ * SEE ALSO
+ *   SelectApplication
+ *   AuthenticateAes
+ *   ReadData
+ *
+ **/
+SPROX_API_FUNC(Desfire_SelectAuthenticateAesRead) (SPROX_PARAM  DWORD aid, BYTE bKeyNumber, const BYTE pbAccessKey[16], DF_READ_FILE_ST files[], BYTE file_count)
+{
+	SPROX_RC status;
+	BYTE  abRndA[16];
+	BYTE  i;
+	SPROX_DESFIRE_GET_CTX();
+
+	if (pbAccessKey == NULL)
+		return DFCARD_LIB_CALL_ERROR;
+	if ((files == NULL) && (file_count != 0))
+		return DFCARD_LIB_CALL_ERROR;
+
+	/* Prepare the authentication before talking to the card: the cipher unit is not  */
+	/* touched by SelectApplication, so it may already hold the access key            */
+	Desfire_InitCryptoAes(SPROX_PARAM_P  pbAccessKey);
+	GetRandomBytes(SPROX_PARAM_P  abRndA, 16);
+
+	status = SPROX_API_CALL(Desfire_SelectApplication) (SPROX_PARAM_P  aid);
+	if (status != DF_OPERATION_OK)
+		return status;
+
+	status = Desfire_AuthenticateAesRun(SPROX_PARAM_P  bKeyNumber, abRndA);
+	if (status != DF_OPERATION_OK)
+		return status;
+
+	for (i = 0; i < file_count; i++)
+	{
+		status = SPROX_API_CALL(Desfire_ReadDataEx) (SPROX_PARAM_P  DF_READ_DATA, files[i].bFileId, files[i].bCommMode, files[i].dwFromOffset, files[i].dwMaxCount, 1, files[i].pbData, &files[i].dwDoneCount);
+		if (status != DF_OPERATION_OK)
+			break;
+	}
+
+	return status;
+}
+
 void Desfire_CleanupAuthentication(SPROX_PARAM_V)
 {
 	SPROX_DESFIRE_GET_CTX_V();
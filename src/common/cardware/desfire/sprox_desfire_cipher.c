@@ -381,6 +381,56 @@ void Desfire_CipherSend(SPROX_PARAM  BYTE data[], DWORD* length, DWORD max_lengt
 #endif
 }
 
+/*
+ * CipherSendBlock
+ * ---------------
+ * Same as CipherSend, for a single block (8 bytes, or 16 bytes in AES),
+ * chained on the current init vector. This lets a message be ciphered
+ * block after block. In legacy mode, the caller must clear the init vector
+ * before the first block of the message.
+ */
+void Desfire_CipherSendBlock(SPROX_PARAM  BYTE block[])
+{
+	DWORD j;
+	SPROX_DESFIRE_GET_CTX_V();
+
+	switch (ctx->session_type)
+	{
+	case KEY_LEGACY_DES:
+	case KEY_LEGACY_3DES:
+	{
+		for (j = 0; j < 8; j++)
+			block[j] ^= ctx->init_vector[j];  /* P  <- P XOR IV  */
+		/* Legacy mode : PICC always encrypts, PCD always decrypts */
+		TDES_Decrypt2(&ctx->cipher_context.tdes, ctx->init_vector, block);  /* IV <- i3DES(P)   */
+		memcpy(block, ctx->init_vector, 8); /* P  <- IV        */
+	}
+	break;
+
+	case KEY_ISO_DES:
+	case KEY_ISO_3DES2K:
+	case KEY_ISO_3DES3K:
+	{
+		for (j = 0; j < 8; j++)
+			block[j] ^= ctx->init_vector[j];  /* P  <- P XOR IV  */
+		/* ISO mode : sending means encrypting */
+		TDES_Encrypt2(&ctx->cipher_context.tdes, ctx->init_vector, block);  /* IV <- 3DES(P)   */
+		memcpy(block, ctx->init_vector, 8); /* P  <- IV        */
+	}
+	break;
+
+	case KEY_ISO_AES:
+	{
+		for (j = 0; j < 16; j++)
+			block[j] ^= ctx->init_vector[j];  /* P  <- P XOR IV  */
+		/* ISO mode : sending means encrypting */
+		AES_Encrypt2(&ctx->cipher_context.aes, ctx->init_vector, block);  /* IV <- AES(P)   */
+		memcpy(block, ctx->init_vector, 16); /* P  <- IV        */
+	}
+	break;
+	}
+}
+
 void CipherSend_AES(BYTE data[], DWORD* length, DWORD max_length, BYTE Key[16], BYTE IV[16])
 {
 	AES_CTX_ST ctx;
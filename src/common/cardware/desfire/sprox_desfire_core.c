@@ -46,10 +46,10 @@ SPROX_API_FUNC(Desfire_Command) (SPROX_PARAM  WORD accept_len, BYTE flags)
 
 
 
-	if (ctx->xfer_length > DF_MAX_INFO_FRAME_SIZE)
+	if (ctx->xfer_length > DF_XFER_MAX_FRAME(ctx))
 	{
 #ifdef DEBUG_CORE
-		printf("INTERNAL OVERFLOW (%ld>%ld)\n", ctx->xfer_length, DF_MAX_INFO_FRAME_SIZE);
+		printf("INTERNAL OVERFLOW (%ld>%ld)\n", ctx->xfer_length, DF_XFER_MAX_FRAME(ctx));
 #endif
 		return DFCARD_LIB_CALL_ERROR;
 	}
@@ -148,3 +148,51 @@ SPROX_API_FUNC(Desfire_Command) (SPROX_PARAM  WORD accept_len, BYTE flags)
 	return DF_OPERATION_OK;
 }
 
+/**f* DesfireAPI/SetMaxFrameSize
+ *
+ * NAME
+ *   SetMaxFrameSize
+ *
+ * DESCRIPTION
+ *   Sets the maximum length of the frames sent to the card when a command
+ *   has to be split into ADDITIONAL_FRAME chunks (WriteData, WriteRecord).
+ *   The default, DF_MAX_INFO_FRAME_SIZE, suits every DESFire card. Cards
+ *   announcing a larger FSC in their ATS (DESFire EV2 and later) accept
+ *   longer frames, so large writes need fewer round trips.
+ *
+ * SYNOPSIS
+ *
+ *   [[sprox_desfire.dll]]
+ *   SWORD SPROX_Desfire_SetMaxFrameSize(WORD max_frame_size);
+ *
+ *   [[sprox_desfire_ex.dll]]
+ *   SWORD SPROXx_Desfire_SetMaxFrameSize(SPROX_INSTANCE rInst,
+ *                                        WORD max_frame_size);
+ *
+ *   [[pcsc_desfire.dll]]
+ *   LONG  SCardDesfire_SetMaxFrameSize(SCARDHANDLE hCard,
+ *                                      WORD max_frame_size);
+ *
+ * INPUTS
+ *   WORD max_frame_size : length of the native frame, command code included
+ *                         (from DF_MAX_INFO_FRAME_SIZE to 192, 0 to restore
+ *                         the default)
+ *
+ * RETURNS
+ *   DF_OPERATION_OK       : success
+ *   DFCARD_LIB_CALL_ERROR : invalid length
+ *
+ **/
+SPROX_API_FUNC(Desfire_SetMaxFrameSize) (SPROX_PARAM  WORD max_frame_size)
+{
+	SPROX_DESFIRE_GET_CTX();
+
+	if (max_frame_size == 0)
+		max_frame_size = DF_MAX_INFO_FRAME_SIZE;
+
+	if ((max_frame_size < DF_MAX_INFO_FRAME_SIZE) || (max_frame_size > DF_MAX_XFER_FRAME_SIZE))
+		return DFCARD_LIB_CALL_ERROR;
+
+	ctx->xfer_max_frame = max_frame_size;
+	return DF_OPERATION_OK;
+}
@@ -134,6 +134,30 @@ DWORD ComputeCrc32(const BYTE buffer[], DWORD size, BYTE crc[4])
 
 
 
+/*
+ * Incremental forms of ComputeCrc16 and ComputeCrc32, for data that is not available in one piece.
+ * Start with DF_CRC16_INIT / DF_CRC32_INIT and feed the chunks in order.
+ */
+WORD UpdateCrc16(WORD crc, const BYTE data[], DWORD length)
+{
+	DWORD i;
+
+	for (i = 0; i < length; i++)
+		UpdateDesfireCrc16(data[i], &crc);
+
+	return crc;
+}
+
+DWORD UpdateCrc32(DWORD crc, const BYTE data[], DWORD length)
+{
+	DWORD i;
+
+	for (i = 0; i < length; i++)
+		UpdateDesfireCrc32(data[i], &crc);
+
+	return crc;
+}
+
 void Desfire_XferAppendCrc(SPROX_PARAM  DWORD start_offset)
 {
 	SPROX_DESFIRE_GET_CTX_V();
@@ -21,6 +21,13 @@ extern  "C"
 		BYTE cid);
 	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROXx_Desfire_IsoWrapping(SPROX_INSTANCE rInst,
 		BYTE mode);
+	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROXx_Desfire_SetMaxFrameSize(SPROX_INSTANCE rInst,
+		WORD max_frame_size);
+
+	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROXx_Desfire_SwitchCid(SPROX_INSTANCE rInst,
+		BYTE cid);
+	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROXx_Desfire_ReleaseCid(SPROX_INSTANCE rInst,
+		BYTE cid);
 
 
 	/*
@@ -221,6 +228,12 @@ extern  "C"
 	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROXx_Desfire_AuthenticateAes(SPROX_INSTANCE rInst,
 		BYTE bKeyNumber,
 		const BYTE pbAccessKey[16]);
+	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROXx_Desfire_SelectAuthenticateAesRead(SPROX_INSTANCE rInst,
+		DWORD aid,
+		BYTE bKeyNumber,
+		const BYTE pbAccessKey[16],
+		DF_READ_FILE_ST files[],
+		BYTE file_count);
 	SPROX_DESFIRE_LIB SWORD SPROX_DESFIRE_API SPROXx_Desfire_ChangeKey24(SPROX_INSTANCE rInst,
 		BYTE key_number,
 		const BYTE new_key[24],
@@ -157,6 +157,11 @@ SPROX_API_FUNC(Desfire_ReadDataEx)     (SPROX_PARAM  BYTE read_command, BYTE fil
 SPROX_API_FUNC(Desfire_WriteDataEx)    (SPROX_PARAM  BYTE write_command, BYTE file_id, BYTE comm_mode, DWORD from_offset, DWORD size, const BYTE data[]);
 SPROX_API_FUNC(Desfire_ModifyValue)    (SPROX_PARAM  BYTE modify_command, BYTE file_id, BYTE comm_mode, LONG amount);
 
+/*
+ * Authentication
+ */
+SPROX_RC Desfire_AuthenticateAesRun(SPROX_PARAM  BYTE bKeyNumber, const BYTE abRndA[16]);
+
 /*
  * Ciphering
  */
@@ -165,6 +170,7 @@ void     Desfire_InitCrypto3Des(SPROX_PARAM  const BYTE des_key1[8], const BYTE
 void     Desfire_InitCryptoAes(SPROX_PARAM  const BYTE aes_key[16]);
 void     Desfire_XferCipherSend(SPROX_PARAM  DWORD start_offset);
 void     Desfire_CipherSend(SPROX_PARAM  BYTE data[], DWORD* length, DWORD max_length);
+void     Desfire_CipherSendBlock(SPROX_PARAM  BYTE block[]);
 void     Desfire_CipherRecv(SPROX_PARAM  BYTE data[], DWORD* length);
 
 void     Desfire_CleanupInitVector(SPROX_PARAM_V);
@@ -194,6 +200,12 @@ SPROX_RC Desfire_XferCmacRecv(SPROX_PARAM_V);
 WORD     ComputeCrc16(const BYTE data[], DWORD length, BYTE crc[2]);
 DWORD    ComputeCrc32(const BYTE data[], DWORD length, BYTE crc[4]);
 
+#define DF_CRC16_INIT 0x6363
+#define DF_CRC32_INIT 0xFFFFFFFF
+
+WORD     UpdateCrc16(WORD crc, const BYTE data[], DWORD length);
+DWORD    UpdateCrc32(DWORD crc, const BYTE data[], DWORD length);
+
 void     Desfire_XferAppendCrc(SPROX_PARAM  DWORD start_offset);
 
 void     Desfire_ComputeCrc16(SPROX_PARAM  const BYTE data[], DWORD length, BYTE crc[2]);
@@ -257,6 +269,37 @@ LONG SAM_DecipherData(SCARDHANDLE hSam, BYTE bCardStatus, DWORD dwResultLength,
 
 void dump_buffer(const BYTE* buffer, WORD len);
 
+/* Upper bound for SetMaxFrameSize, the default being DF_MAX_INFO_FRAME_SIZE */
+#define DF_MAX_XFER_FRAME_SIZE  192
+
+/* Number of card sessions that may be kept side by side, one per T=CL CID (0 to 14) */
+#define DF_MAX_CARD_SESSIONS    15
+
+/* Authentication state of one card, saved away while another CID is addressed */
+typedef struct
+{
+	BOOL  valid;
+
+	DWORD current_aid;
+
+	BYTE  session_type;
+	BYTE  session_key[24];
+	BYTE  session_key_id;
+
+	BYTE  init_vector[16];
+
+	BYTE  cmac_subkey_1[16];
+	BYTE  cmac_subkey_2[16];
+
+	union
+	{
+		DES_CTX_ST  des;
+		TDES_CTX_ST tdes;
+		AES_CTX_ST  aes;
+	} cipher_context;
+
+} SPROX_DESFIRE_CARD_ST;
+
 typedef struct
 {
 	BYTE  tcl_cid;
@@ -270,7 +313,8 @@ typedef struct
 
 	BOOL  xfer_fast;
 	DWORD xfer_length;
-	BYTE  xfer_buffer[64];
+	BYTE  xfer_buffer[DF_MAX_XFER_FRAME_SIZE + 8];
+	WORD  xfer_max_frame;
 
 	BYTE  init_vector[16];
 
@@ -284,6 +328,8 @@ typedef struct
 		AES_CTX_ST  aes;
 	} cipher_context;
 
+	SPROX_DESFIRE_CARD_ST card_sessions[DF_MAX_CARD_SESSIONS];
+
 #ifdef SPROX_DESFIRE_WITH_SAM
 	BOOL sam_session_active;
 	struct
@@ -296,6 +342,9 @@ typedef struct
 
 } SPROX_DESFIRE_CTX_ST;
 
+/* Maximum length of a frame sent to the card (see SetMaxFrameSize) */
+#define DF_XFER_MAX_FRAME(ctx) (((ctx)->xfer_max_frame != 0) ? (DWORD) (ctx)->xfer_max_frame : (DWORD) DF_MAX_INFO_FRAME_SIZE)
+
 #ifndef _USE_PCSC
 #ifndef SPROX_API_REENTRANT
 extern SPROX_DESFIRE_CTX_ST desfire_ctx;
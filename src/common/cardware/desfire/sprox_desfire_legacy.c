@@ -56,10 +56,167 @@ SPROX_API_FUNC(Desfire_SelectCid) (SPROX_PARAM  BYTE cid)
 	Desfire_CleanupAuthentication(SPROX_PARAM_PV);
 	ctx->tcl_cid = cid;
 
+	if (cid < DF_MAX_CARD_SESSIONS)
+		ctx->card_sessions[cid].valid = FALSE;
+
 	return DF_OPERATION_OK;
 }
 
 
+static void Desfire_SaveCardSession(SPROX_DESFIRE_CTX_ST* ctx)
+{
+	SPROX_DESFIRE_CARD_ST* card;
+
+	if (ctx->tcl_cid >= DF_MAX_CARD_SESSIONS)
+		return;
+
+	card = &ctx->card_sessions[ctx->tcl_cid];
+
+	card->current_aid = ctx->current_aid;
+	card->session_type = ctx->session_type;
+	memcpy(card->session_key, ctx->session_key, sizeof(card->session_key));
+	card->session_key_id = ctx->session_key_id;
+	memcpy(card->init_vector, ctx->init_vector, sizeof(card->init_vector));
+	memcpy(card->cmac_subkey_1, ctx->cmac_subkey_1, sizeof(card->cmac_subkey_1));
+	memcpy(card->cmac_subkey_2, ctx->cmac_subkey_2, sizeof(card->cmac_subkey_2));
+	memcpy(&card->cipher_context, &ctx->cipher_context, sizeof(card->cipher_context));
+	card->valid = TRUE;
+}
+
+static BOOL Desfire_LoadCardSession(SPROX_DESFIRE_CTX_ST* ctx, BYTE cid)
+{
+	SPROX_DESFIRE_CARD_ST* card;
+
+	if (cid >= DF_MAX_CARD_SESSIONS)
+		return FALSE;
+
+	card = &ctx->card_sessions[cid];
+	if (!card->valid)
+		return FALSE;
+
+	ctx->current_aid = card->current_aid;
+	ctx->session_type = card->session_type;
+	memcpy(ctx->session_key, card->session_key, sizeof(ctx->session_key));
+	ctx->session_key_id = card->session_key_id;
+	memcpy(ctx->init_vector, card->init_vector, sizeof(ctx->init_vector));
+	memcpy(ctx->cmac_subkey_1, card->cmac_subkey_1, sizeof(ctx->cmac_subkey_1));
+	memcpy(ctx->cmac_subkey_2, card->cmac_subkey_2, sizeof(ctx->cmac_subkey_2));
+	memcpy(&ctx->cipher_context, &card->cipher_context, sizeof(ctx->cipher_context));
+	return TRUE;
+}
+
+/**f* DesfireAPI/[Legacy]SwitchCid
+ *
+ * NAME
+ *   [Legacy]SwitchCid
+ *
+ * DESCRIPTION
+ *   Selects the logical number of the addressed DesFire card, keeping the
+ *   session (selected application, authentication, session key and IV) of
+ *   the card that was addressed so far.
+ *   When switching back to a CID that has already been used, its session is
+ *   restored, so several cards activated with different CIDs (see
+ *   SPROX_TclA_GetAts) can be authenticated and then used in any order.
+ *
+ * SYNOPSIS
+ *
+ *   [[sprox_desfire.dll]]
+ *   SWORD SPROX_Desfire_SwitchCid (BYTE cid);
+ *
+ *   [[sprox_desfire_ex.dll]]
+ *   SWORD SPROXx_Desfire_SwitchCid(SPROX_INSTANCE rInst, BYTE cid);
+ *
+ *   [[pcsc_desfire.dll]]
+ *   Not applicable.
+ *
+ * INPUTS
+ *   BYTE cid        : logical number of the addressed DesFire card (0 to 14)
+ *
+ * RETURNS
+ *   DF_OPERATION_OK       : CID selected
+ *   DFCARD_LIB_CALL_ERROR : invalid CID
+ *
+ * NOTES
+ *   The session of a card is kept until the card is addressed through
+ *   [Legacy]SelectCid, or released by [Legacy]ReleaseCid.
+ *
+ * SEE ALSO
+ *   [Legacy]SelectCid
+ *   [Legacy]ReleaseCid
+ *
+ **/
+SPROX_API_FUNC(Desfire_SwitchCid) (SPROX_PARAM  BYTE cid)
+{
+	SPROX_DESFIRE_GET_CTX();
+
+	if (cid >= DF_MAX_CARD_SESSIONS)
+		return DFCARD_LIB_CALL_ERROR;
+
+	if (cid == ctx->tcl_cid)
+		return DF_OPERATION_OK;
+
+	Desfire_SaveCardSession(ctx);
+
+	if (!Desfire_LoadCardSession(ctx, cid))
+	{
+		Desfire_CleanupAuthentication(SPROX_PARAM_PV);
+		ctx->current_aid = 0;
+	}
+
+	ctx->tcl_cid = cid;
+
+	return DF_OPERATION_OK;
+}
+
+/**f* DesfireAPI/[Legacy]ReleaseCid
+ *
+ * NAME
+ *   [Legacy]ReleaseCid
+ *
+ * DESCRIPTION
+ *   Forgets the session kept for the DesFire card at the given logical number.
+ *   Call this function once the card has been deselected or removed.
+ *
+ * SYNOPSIS
+ *
+ *   [[sprox_desfire.dll]]
+ *   SWORD SPROX_Desfire_ReleaseCid (BYTE cid);
+ *
+ *   [[sprox_desfire_ex.dll]]
+ *   SWORD SPROXx_Desfire_ReleaseCid(SPROX_INSTANCE rInst, BYTE cid);
+ *
+ *   [[pcsc_desfire.dll]]
+ *   Not applicable.
+ *
+ * INPUTS
+ *   BYTE cid        : logical number of the DesFire card (0 to 14)
+ *
+ * RETURNS
+ *   DF_OPERATION_OK       : session released
+ *   DFCARD_LIB_CALL_ERROR : invalid CID
+ *
+ * SEE ALSO
+ *   [Legacy]SwitchCid
+ *
+ **/
+SPROX_API_FUNC(Desfire_ReleaseCid) (SPROX_PARAM  BYTE cid)
+{
+	SPROX_DESFIRE_GET_CTX();
+
+	if (cid >= DF_MAX_CARD_SESSIONS)
+		return DFCARD_LIB_CALL_ERROR;
+
+	memset(&ctx->card_sessions[cid], 0, sizeof(ctx->card_sessions[cid]));
+
+	if (cid == ctx->tcl_cid)
+	{
+		Desfire_CleanupAuthentication(SPROX_PARAM_PV);
+		ctx->current_aid = 0;
+	}
+
+	return DF_OPERATION_OK;
+}
+
 /**f* DesfireAPI/[Legacy]IsoWrapping
  *
  * NAME
@@ -146,231 +146,308 @@ SPROX_API_FUNC(Desfire_WriteData2) (SPROX_PARAM  BYTE file_id, DWORD from_offset
 
 
 
-/* DesfireAPI/WriteDataEx
- *
- * NAME
- *   WriteDataEx
- *
- * DESCRIPTION
- *   Allows to write data from a Standard Data File, a Backup Data File, a Cyclic File or a Linear Record File
- *
- * INPUTS
- *   BYTE write_command : command to send, DF_WRITE_DATA or DF_WRITE_RECORD
- *   BYTE file_id       : ID of the file
- *   BYTE comm_mode     : communication mode
- *   DWORD from_offset  : starting position for the write operation
- *   DWORD size         : size of the buffer
- *   BYTE data[]        : buffer to write to the card
- *
- * RETURNS
- *   DF_OPERATION_OK    : success, data has been written
- *   Other code if internal or communication error has occured.
- *
- * SEE ALSO
- *   WriteData
- *   WriteData2
- *   WriteRecord
- *   WriteRecord2
- *
- **/
-SPROX_API_FUNC(Desfire_WriteDataEx) (SPROX_PARAM  BYTE write_command, BYTE file_id, BYTE comm_mode, DWORD from_offset, DWORD size, const BYTE data[])
+/*
+ * Write stream
+ * ------------
+ * The frames of a write command are produced on the fly from the caller's buffer:
+ * the 8-byte command header goes first, then the data, transformed according to
+ * the communication mode (ciphering, MAC, CMAC, CRC) block after block, and finally
+ * the trailing MAC, if any. This way there is no full-size copy of the payload.
+ */
+#define WRITE_STREAM_PLAIN   0  /* data sent as is                                   */
+#define WRITE_STREAM_CMAC    1  /* data sent as is, CMAC computed over header + data */
+#define WRITE_STREAM_MAC     2  /* data sent as is, legacy MAC computed over data    */
+#define WRITE_STREAM_CIPHER  3  /* data + CRC ciphered                               */
+
+typedef struct
 {
-	SPROX_RC status;
-	DWORD    buffer_size, max_frame_length, length, next_length, done_length = 0;
-	BYTE     comm_flags;
-	BYTE* buffer;
-	DWORD    temp;
-	SPROX_DESFIRE_GET_CTX();
+	BYTE        transform;
+	BOOL        append_mac;
+	DWORD       block_size;
 
-	if (ctx->iso_wrapping == DF_ISO_WRAPPING_CARD)
-	{
-		/* 5 bytes are used by the ISO APDU header */
-		max_frame_length = DF_MAX_INFO_FRAME_SIZE - 5;
-	}
-	else
-	{
-		max_frame_length = DF_MAX_INFO_FRAME_SIZE;
-	}
+	BYTE        header[8];
+	DWORD       header_length;
+	DWORD       header_pos;
 
-	buffer_size = size + 64; // TODO : confirmer la longueur
+	const BYTE* data;
+	DWORD       data_length;
+	DWORD       data_pos;
 
-	buffer = malloc(buffer_size);
-	if (buffer == NULL)
-		return DFCARD_OUT_OF_MEMORY;
+	/* Output that is ready to be sent (ciphered blocks, trailing MAC) */
+	BYTE        ready[32];
+	DWORD       ready_length;
+	DWORD       ready_pos;
 
-	memset(buffer, 0x00, buffer_size); // TODO
+	/* Input that is not yet processed (incomplete block) */
+	BYTE        block[32];
+	DWORD       block_length;
 
-	length = 0;
-	buffer[length++] = write_command;
-	buffer[length++] = file_id;
+	BYTE        mac_carry[8];
+	BOOL        use_crc32;
+	DWORD       crc32;
+	WORD        crc16;
 
-	temp = from_offset;
-	buffer[length++] = (BYTE)(temp & 0x000000FF); temp >>= 8;
-	buffer[length++] = (BYTE)(temp & 0x000000FF); temp >>= 8;
-	buffer[length++] = (BYTE)(temp & 0x000000FF);
+	BOOL        finished;
+} WRITE_STREAM_ST;
 
-	temp = size;
-	buffer[length++] = (BYTE)(temp & 0x000000FF); temp >>= 8;
-	buffer[length++] = (BYTE)(temp & 0x000000FF); temp >>= 8;
-	buffer[length++] = (BYTE)(temp & 0x000000FF);
+static DWORD WriteStream_TotalLength(WRITE_STREAM_ST* stream)
+{
+	DWORD length = stream->data_length;
 
-	memcpy(&buffer[length], data, size);
-	length += size;
+	switch (stream->transform)
+	{
+	case WRITE_STREAM_CMAC:
+		if (stream->append_mac)
+			length += 8;
+		break;
+
+	case WRITE_STREAM_MAC:
+		length += 4;
+		break;
+
+	case WRITE_STREAM_CIPHER:
+		length += stream->use_crc32 ? 4 : 2;
+		while (length % stream->block_size)
+			length++;
+		break;
+
+	default:
+		break;
+	}
 
-	/* decide upon the communications mode which cryptographic */
-	/* operation is to be applied on the data                  */
+	return stream->header_length + length;
+}
 
-	if (comm_mode == DF_COMM_MODE_ENCIPHERED)
+/* Feed the integrity check (CMAC, MAC or CRC) with bytes that are sent */
+static void WriteStream_Feed(SPROX_PARAM  WRITE_STREAM_ST* stream, const BYTE data[], DWORD length, BOOL is_header)
+{
+	DWORD i, n;
+	SPROX_DESFIRE_GET_CTX_V();
+
+	switch (stream->transform)
 	{
-		DWORD pos_data = length - size;
-		DWORD len_data = size;
-#ifdef SPROX_DESFIRE_WITH_SAM
-		if (ctx->sam_session_active)
+	case WRITE_STREAM_CMAC:
+		/* The last block must be kept until we know whether it is complete or not */
+		while (length)
 		{
-			BYTE pbOut[MAX_DATA_SIZE];
-			DWORD dwOutLength = sizeof(pbOut);
-
-			if (ctx->session_type & KEY_ISO_MODE)
+			if (stream->block_length == stream->block_size)
 			{
-				status = SAM_EncipherData(ctx->sam_context.hSam, buffer, length, (BYTE)pos_data, pbOut, &dwOutLength);
-				if (status == DF_OPERATION_OK)
-				{
-					memcpy(&buffer[pos_data], pbOut, dwOutLength);
-					length = pos_data + dwOutLength;
-				}
-				else
-				{
-					return status;
-				}
-
+				n = stream->block_size;
+				Desfire_CipherSend(SPROX_PARAM_P  stream->block, &n, n);
+				stream->block_length = 0;
 			}
-			else
-			{
-				/* Non-ISO authenticated: don't send command */
-				BYTE pbOut[MAX_DATA_SIZE];
-				DWORD dwOutLength = sizeof(pbOut);
-				status = SAM_EncipherData(ctx->sam_context.hSam, &buffer[pos_data], len_data, 0, pbOut, &dwOutLength);
-				if (status == DF_OPERATION_OK)
-				{
-					memcpy(&buffer[pos_data], pbOut, dwOutLength);
-					length = pos_data + dwOutLength;
-				}
-				else
-				{
-					return status;
-				}
+			n = stream->block_size - stream->block_length;
+			if (n > length)
+				n = length;
+			memcpy(&stream->block[stream->block_length], data, n);
+			stream->block_length += n;
+			data += n;
+			length -= n;
+		}
+		break;
 
+	case WRITE_STREAM_MAC:
+		if (is_header)
+			break;
+		while (length)
+		{
+			n = 8 - stream->block_length;
+			if (n > length)
+				n = length;
+			memcpy(&stream->block[stream->block_length], data, n);
+			stream->block_length += n;
+			data += n;
+			length -= n;
+			if (stream->block_length == 8)
+			{
+				for (i = 0; i < 8; i++)
+					stream->block[i] ^= stream->mac_carry[i];
+				TDES_Encrypt2(&ctx->cipher_context.tdes, stream->mac_carry, stream->block);
+				stream->block_length = 0;
 			}
+		}
+		break;
+
+	case WRITE_STREAM_CIPHER:
+		if (stream->use_crc32)
+			stream->crc32 = UpdateCrc32(stream->crc32, data, length);
+		else if (!is_header)
+			stream->crc16 = UpdateCrc16(stream->crc16, data, length);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/* Called once the header and the data have been fed; prepares the trailing bytes */
+static void WriteStream_Finish(SPROX_PARAM  WRITE_STREAM_ST* stream)
+{
+	DWORD i, n;
+	SPROX_DESFIRE_GET_CTX_V();
 
+	switch (stream->transform)
+	{
+	case WRITE_STREAM_CMAC:
+		/* Same as Desfire_ComputeCmac, on the last block */
+		if (stream->block_length < stream->block_size)
+		{
+			stream->block[stream->block_length] = 0x80;
+			memset(&stream->block[stream->block_length + 1], 0, stream->block_size - stream->block_length - 1);
+			for (i = 0; i < stream->block_size; i++)
+				stream->block[i] ^= ctx->cmac_subkey_2[i];
 		}
 		else
-#endif
 		{
-			if (ctx->session_type & KEY_ISO_MODE)
-			{
-				/* at first we have to append the CRC bytes, computed other the whole buffer */
-				Desfire_ComputeCrc32(SPROX_PARAM_P  buffer, length, &buffer[length]);
-				length += 4;
-				len_data += 4;
-			}
-			else
-			{
-				/* we compute the CRC other the data only */
-				Desfire_ComputeCrc16(SPROX_PARAM_P & buffer[pos_data], len_data, &buffer[pos_data + len_data]);
-				len_data += 2;
-				length += 2;
-			}
-
-			/* finally do the padding and the cipher operation on the data only */
-			Desfire_CipherSend(SPROX_PARAM_P & buffer[pos_data], &len_data, buffer_size - pos_data);
+			for (i = 0; i < stream->block_size; i++)
+				stream->block[i] ^= ctx->cmac_subkey_1[i];
+		}
+		n = stream->block_size;
+		Desfire_CipherSend(SPROX_PARAM_P  stream->block, &n, n);
+		memcpy(ctx->init_vector, stream->block, stream->block_size);
+		if (stream->append_mac)
+		{
+			memcpy(stream->ready, ctx->init_vector, 8);
+			stream->ready_length = 8;
+		}
+		break;
 
-			length = pos_data + len_data;
+	case WRITE_STREAM_MAC:
+		if (stream->block_length)
+		{
+			memset(&stream->block[stream->block_length], 0, 8 - stream->block_length);
+			for (i = 0; i < 8; i++)
+				stream->block[i] ^= stream->mac_carry[i];
+			TDES_Encrypt2(&ctx->cipher_context.tdes, stream->mac_carry, stream->block);
 		}
+		memcpy(stream->ready, stream->mac_carry, 4);
+		stream->ready_length = 4;
+		break;
 
+	case WRITE_STREAM_CIPHER:
+		/* Append the CRC to the remaining plain bytes, then pad and cipher */
+		if (stream->use_crc32)
+		{
+			stream->block[stream->block_length++] = (BYTE) (stream->crc32);
+			stream->block[stream->block_length++] = (BYTE) (stream->crc32 >> 8);
+			stream->block[stream->block_length++] = (BYTE) (stream->crc32 >> 16);
+			stream->block[stream->block_length++] = (BYTE) (stream->crc32 >> 24);
+		}
+		else
+		{
+			stream->block[stream->block_length++] = (BYTE) (stream->crc16);
+			stream->block[stream->block_length++] = (BYTE) (stream->crc16 >> 8);
+		}
+		while (stream->block_length % stream->block_size)
+			stream->block[stream->block_length++] = 0x00;
+		for (i = 0; i < stream->block_length; i += stream->block_size)
+			Desfire_CipherSendBlock(SPROX_PARAM_P  &stream->block[i]);
+		memcpy(stream->ready, stream->block, stream->block_length);
+		stream->ready_length = stream->block_length;
+		stream->block_length = 0;
+		break;
+
+	default:
+		break;
 	}
-	else
-		if (comm_mode == DF_COMM_MODE_MACED)
+
+	stream->ready_pos = 0;
+	stream->finished = TRUE;
+}
+
+/* Get the next bytes to be sent */
+static DWORD WriteStream_Read(SPROX_PARAM  WRITE_STREAM_ST* stream, BYTE buffer[], DWORD max_length)
+{
+	DWORD done = 0, n;
+
+	while (done < max_length)
+	{
+		if (stream->ready_pos < stream->ready_length)
 		{
-			if (ctx->session_type & KEY_ISO_MODE)
+			n = stream->ready_length - stream->ready_pos;
+			if (n > max_length - done)
+				n = max_length - done;
+			memcpy(&buffer[done], &stream->ready[stream->ready_pos], n);
+			stream->ready_pos += n;
+			done += n;
+		}
+		else if (stream->header_pos < stream->header_length)
+		{
+			n = stream->header_length - stream->header_pos;
+			if (n > max_length - done)
+				n = max_length - done;
+			memcpy(&buffer[done], &stream->header[stream->header_pos], n);
+			WriteStream_Feed(SPROX_PARAM_P  stream, &stream->header[stream->header_pos], n, TRUE);
+			stream->header_pos += n;
+			done += n;
+		}
+		else if (stream->data_pos < stream->data_length)
+		{
+			if (stream->transform == WRITE_STREAM_CIPHER)
 			{
-				/* append the 8 bytes CMAC (computed over the whole buffer) */
-#ifdef SPROX_DESFIRE_WITH_SAM
-				if (ctx->sam_session_active)
+				/* Take one block of plain data, and cipher it once it is complete */
+				n = stream->block_size - stream->block_length;
+				if (n > stream->data_length - stream->data_pos)
+					n = stream->data_length - stream->data_pos;
+				memcpy(&stream->block[stream->block_length], &stream->data[stream->data_pos], n);
+				WriteStream_Feed(SPROX_PARAM_P  stream, &stream->data[stream->data_pos], n, FALSE);
+				stream->block_length += n;
+				stream->data_pos += n;
+				if (stream->block_length == stream->block_size)
 				{
-					BYTE pbMac[8];
-					DWORD dwMacLength = sizeof(pbMac), k;
-
-					status = SAM_GenerateMAC(ctx->sam_context.hSam, buffer, length, pbMac, &dwMacLength);
-					if (status == DF_OPERATION_OK)
-					{
-						for (k = 0; k < dwMacLength; k++)
-							buffer[length++] = pbMac[k];
-					}
-					else
-					{
-						return status;
-					}
+					Desfire_CipherSendBlock(SPROX_PARAM_P  stream->block);
+					memcpy(stream->ready, stream->block, stream->block_size);
+					stream->ready_length = stream->block_size;
+					stream->ready_pos = 0;
+					stream->block_length = 0;
 				}
-				else
-#endif
-				{
-					Desfire_ComputeCmac(SPROX_PARAM_P  buffer, length, FALSE, &buffer[length]);
-					length += 8;
-				}
-
 			}
 			else
 			{
-				/* append the 4 bytes MAC (computed over the data only) */
-#ifdef SPROX_DESFIRE_WITH_SAM
-				if (ctx->sam_session_active)
-				{
-					BYTE pbMac[4];
-					DWORD dwMacLength = sizeof(pbMac), k;
-
-					status = SAM_GenerateMAC(ctx->sam_context.hSam, &buffer[length - size], size, pbMac, &dwMacLength);
-					if (status == DF_OPERATION_OK)
-					{
-						for (k = 0; k < dwMacLength; k++)
-							buffer[length++] = pbMac[k];
-					}
-					else
-					{
-						return status;
-					}
-				}
-				else
-#endif
-				{
-					Desfire_ComputeMac(SPROX_PARAM_P  data, size, &buffer[length]);
-					length += 4;
-				}
+				/* Send the data as is */
+				n = stream->data_length - stream->data_pos;
+				if (n > max_length - done)
+					n = max_length - done;
+				memcpy(&buffer[done], &stream->data[stream->data_pos], n);
+				WriteStream_Feed(SPROX_PARAM_P  stream, &stream->data[stream->data_pos], n, FALSE);
+				stream->data_pos += n;
+				done += n;
 			}
 		}
+		else if (!stream->finished)
+		{
+			WriteStream_Finish(SPROX_PARAM_P  stream);
+		}
 		else
 		{
-			/* if comm_mode is neither MACed nor ciphered we leave the data as it is */
-			/* this means a plain communication                                      */
-			if (ctx->session_type & KEY_ISO_MODE)
-			{
-				/* compute the 8 bytes CMAC, but do not send it */
-#ifdef SPROX_DESFIRE_WITH_SAM
-				if (ctx->sam_session_active)
-				{
-					BYTE pbMac[8];
-					DWORD dwMacLength = sizeof(pbMac);
-					SAM_GenerateMAC(ctx->sam_context.hSam, buffer, length, pbMac, &dwMacLength);
-				}
-				else
-#endif
-				{
-					Desfire_ComputeCmac(SPROX_PARAM_P  buffer, length, FALSE, NULL);
-				}
-			}
+			break;
 		}
+	}
 
+	/* The CMAC must be complete before the last frame is sent, even if it is not sent itself */
+	if ((!stream->finished) && (stream->header_pos >= stream->header_length) && (stream->data_pos >= stream->data_length) && (stream->ready_pos >= stream->ready_length))
+		WriteStream_Finish(SPROX_PARAM_P  stream);
 
-	/* Now our data is ready for being sent to the PICC */
+	return done;
+}
+
+/* Send the whole stream to the card, using ADDITIONAL_FRAME chaining */
+static SPROX_RC WriteStream_Send(SPROX_PARAM  WRITE_STREAM_ST* stream)
+{
+	SPROX_RC status = DF_OPERATION_OK;
+	DWORD    max_frame_length, length, next_length, done_length = 0;
+	BYTE     comm_flags;
+	SPROX_DESFIRE_GET_CTX();
+
+	max_frame_length = DF_XFER_MAX_FRAME(ctx);
+
+	if (ctx->iso_wrapping == DF_ISO_WRAPPING_CARD)
+	{
+		/* 5 bytes are used by the ISO APDU header */
+		max_frame_length -= 5;
+	}
+
+	length = WriteStream_TotalLength(stream);
 
 	do
 	{
@@ -407,15 +484,13 @@ SPROX_API_FUNC(Desfire_WriteDataEx) (SPROX_PARAM  BYTE write_command, BYTE file_
 		if (done_length == 0)
 		{
 			/* First frame */
-			memcpy(&ctx->xfer_buffer[INF + 0], &buffer[0], next_length);
-			ctx->xfer_length = (WORD)next_length;
+			ctx->xfer_length = WriteStream_Read(SPROX_PARAM_P  stream, &ctx->xfer_buffer[INF + 0], next_length);
 		}
 		else
 		{
 			/* Next frame */
 			ctx->xfer_buffer[INF + 0] = DF_ADDITIONAL_FRAME;
-			memcpy(&ctx->xfer_buffer[INF + 1], &buffer[done_length], next_length);
-			ctx->xfer_length = (WORD)(1 + next_length);
+			ctx->xfer_length = 1 + WriteStream_Read(SPROX_PARAM_P  stream, &ctx->xfer_buffer[INF + 1], next_length);
 		}
 
 		/* only one byte response is allowed                                */
@@ -434,8 +509,204 @@ SPROX_API_FUNC(Desfire_WriteDataEx) (SPROX_PARAM  BYTE write_command, BYTE file_
 	/* leaving the loop correctly an interrupted write operation is detected via */
 	/* a status code different from DF_OPERATION_OK                              */
 
-	free(buffer);
+	return status;
+}
+
+#ifdef SPROX_DESFIRE_WITH_SAM
+/*
+ * When the session is held by the SAM, the whole payload must be given to the SAM
+ * at once, so we have to work on a complete copy of the command
+ */
+static SPROX_RC WriteDataSam(SPROX_PARAM  const BYTE header[8], BYTE comm_mode, DWORD size, const BYTE data[])
+{
+	SPROX_RC status = DF_OPERATION_OK;
+	WRITE_STREAM_ST stream;
+	DWORD    buffer_size, length;
+	BYTE*    buffer;
+	BYTE     pbOut[MAX_DATA_SIZE];
+	DWORD    dwOutLength = sizeof(pbOut);
+	DWORD    k;
+	SPROX_DESFIRE_GET_CTX();
+
+	buffer_size = size + 64;
+
+	buffer = malloc(buffer_size);
+	if (buffer == NULL)
+		return DFCARD_OUT_OF_MEMORY;
+
+	memcpy(buffer, header, 8);
+	memcpy(&buffer[8], data, size);
+	length = 8 + size;
+
+	if (comm_mode == DF_COMM_MODE_ENCIPHERED)
+	{
+		if (ctx->session_type & KEY_ISO_MODE)
+			status = SAM_EncipherData(ctx->sam_context.hSam, buffer, length, 8, pbOut, &dwOutLength);
+		else
+			/* Non-ISO authenticated: don't send command */
+			status = SAM_EncipherData(ctx->sam_context.hSam, &buffer[8], size, 0, pbOut, &dwOutLength);
+
+		if ((status == DF_OPERATION_OK) && (8 + dwOutLength > buffer_size))
+			status = DFCARD_OVERFLOW;
+
+		if (status == DF_OPERATION_OK)
+		{
+			memcpy(&buffer[8], pbOut, dwOutLength);
+			length = 8 + dwOutLength;
+		}
+	}
+	else
+		if (comm_mode == DF_COMM_MODE_MACED)
+		{
+			/* append the 8 bytes CMAC (computed over the whole buffer), or the */
+			/* 4 bytes MAC (computed over the data only)                        */
+			if (ctx->session_type & KEY_ISO_MODE)
+				status = SAM_GenerateMAC(ctx->sam_context.hSam, buffer, length, pbOut, &dwOutLength);
+			else
+				status = SAM_GenerateMAC(ctx->sam_context.hSam, &buffer[8], size, pbOut, &dwOutLength);
+
+			if (status == DF_OPERATION_OK)
+			{
+				for (k = 0; (k < dwOutLength) && (k < 8); k++)
+					buffer[length++] = pbOut[k];
+			}
+		}
+		else
+		{
+			/* compute the 8 bytes CMAC, but do not send it */
+			if (ctx->session_type & KEY_ISO_MODE)
+				SAM_GenerateMAC(ctx->sam_context.hSam, buffer, length, pbOut, &dwOutLength);
+		}
+
+	if (status == DF_OPERATION_OK)
+	{
+		/* The buffer is now ready, send it as is */
+		memset(&stream, 0, sizeof(stream));
+		stream.transform = WRITE_STREAM_PLAIN;
+		stream.data = buffer;
+		stream.data_length = length;
 
+		status = WriteStream_Send(SPROX_PARAM_P  &stream);
+	}
+
+	free(buffer);
 	return status;
 }
+#endif
 
+/* DesfireAPI/WriteDataEx
+ *
+ * NAME
+ *   WriteDataEx
+ *
+ * DESCRIPTION
+ *   Allows to write data from a Standard Data File, a Backup Data File, a Cyclic File or a Linear Record File
+ *
+ * INPUTS
+ *   BYTE write_command : command to send, DF_WRITE_DATA or DF_WRITE_RECORD
+ *   BYTE file_id       : ID of the file
+ *   BYTE comm_mode     : communication mode
+ *   DWORD from_offset  : starting position for the write operation
+ *   DWORD size         : size of the buffer
+ *   BYTE data[]        : buffer to write to the card
+ *
+ * RETURNS
+ *   DF_OPERATION_OK    : success, data has been written
+ *   Other code if internal or communication error has occured.
+ *
+ * NOTES
+ *   The frames are built on the fly from data[] (see the write stream above),
+ *   so the length of the data is only limited by the card.
+ *
+ * SEE ALSO
+ *   WriteData
+ *   WriteData2
+ *   WriteRecord
+ *   WriteRecord2
+ *   SetMaxFrameSize
+ *
+ **/
+SPROX_API_FUNC(Desfire_WriteDataEx) (SPROX_PARAM  BYTE write_command, BYTE file_id, BYTE comm_mode, DWORD from_offset, DWORD size, const BYTE data[])
+{
+	WRITE_STREAM_ST stream;
+	DWORD    temp;
+	SPROX_DESFIRE_GET_CTX();
+
+	if ((data == NULL) && (size != 0))
+		return DFCARD_LIB_CALL_ERROR;
+
+	memset(&stream, 0, sizeof(stream));
+
+	stream.header[stream.header_length++] = write_command;
+	stream.header[stream.header_length++] = file_id;
+
+	temp = from_offset;
+	stream.header[stream.header_length++] = (BYTE)(temp & 0x000000FF); temp >>= 8;
+	stream.header[stream.header_length++] = (BYTE)(temp & 0x000000FF); temp >>= 8;
+	stream.header[stream.header_length++] = (BYTE)(temp & 0x000000FF);
+
+	temp = size;
+	stream.header[stream.header_length++] = (BYTE)(temp & 0x000000FF); temp >>= 8;
+	stream.header[stream.header_length++] = (BYTE)(temp & 0x000000FF); temp >>= 8;
+	stream.header[stream.header_length++] = (BYTE)(temp & 0x000000FF);
+
+#ifdef SPROX_DESFIRE_WITH_SAM
+	if (ctx->sam_session_active)
+		return WriteDataSam(SPROX_PARAM_P  stream.header, comm_mode, size, data);
+#endif
+
+	stream.data = data;
+	stream.data_length = size;
+	stream.block_size = (ctx->session_type == KEY_ISO_AES) ? 16 : 8;
+
+	/* decide upon the communications mode which cryptographic */
+	/* operation is to be applied on the data                  */
+
+	if (comm_mode == DF_COMM_MODE_ENCIPHERED)
+	{
+		stream.transform = WRITE_STREAM_CIPHER;
+		if (ctx->session_type & KEY_ISO_MODE)
+		{
+			/* CRC32 computed over the whole command */
+			stream.use_crc32 = TRUE;
+			stream.crc32 = DF_CRC32_INIT;
+		}
+		else
+		{
+			/* CRC16 computed over the data only, ciphering starts with a null IV */
+			stream.crc16 = DF_CRC16_INIT;
+			Desfire_CleanupInitVector(SPROX_PARAM_PV);
+		}
+	}
+	else
+		if (comm_mode == DF_COMM_MODE_MACED)
+		{
+			if (ctx->session_type & KEY_ISO_MODE)
+			{
+				/* append the 8 bytes CMAC (computed over the whole command) */
+				stream.transform = WRITE_STREAM_CMAC;
+				stream.append_mac = TRUE;
+			}
+			else
+			{
+				/* append the 4 bytes MAC (computed over the data only) */
+				stream.transform = WRITE_STREAM_MAC;
+			}
+		}
+		else
+		{
+			/* if comm_mode is neither MACed nor ciphered we leave the data as it is */
+			/* this means a plain communication                                      */
+			if (ctx->session_type & KEY_ISO_MODE)
+			{
+				/* compute the 8 bytes CMAC, but do not send it */
+				stream.transform = WRITE_STREAM_CMAC;
+			}
+			else
+			{
+				stream.transform = WRITE_STREAM_PLAIN;
+			}
+		}
+
+	return WriteStream_Send(SPROX_PARAM_P  &stream);
+}
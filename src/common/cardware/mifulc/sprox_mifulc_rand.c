@@ -48,6 +48,8 @@ void GetRandomBytes(SPROX_PARAM  BYTE rnd[], DWORD size)
 {
 	BYTE I[8], X[8];
 	DWORD i;
+	BYTE* rnd_out = rnd;
+	DWORD rnd_size = size;
 #if (defined(WIN32) && defined(WINCE))
 	SYSTEMTIME sys_time;
 #endif
@@ -103,6 +105,11 @@ void GetRandomBytes(SPROX_PARAM  BYTE rnd[], DWORD size)
 
 		TDES_Encrypt(&random_cipher_ctx, random_seed);
 	}
+
+#ifndef _USE_PCSC
+	/* Written to the recording of the traffic, or taken from the recording being replayed */
+	SPROX_API_CALL(RecordRandom) (SPROX_PARAM_P  rnd_out, rnd_size);
+#endif
 }
 
 
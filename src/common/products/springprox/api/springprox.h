@@ -276,6 +276,18 @@ extern  "C"
 	/* Resume the reader */
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_ReaderActivate(void);
 
+	/* How to open the device again when it fails (USB reader unplugged...) */
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_ReaderSetReconnect(BYTE tries, WORD delay_ms);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_ReaderSetBaudrate(DWORD baudrate);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_ReaderGetBaudrate(DWORD* baudrate);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_ReaderBaudrateHighEnable(BOOL enable);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_ReaderLock(DWORD wait_ms);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_ReaderUnlock(void);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_ReaderSetPipeline(BYTE depth);
+
+#define SPROX_LOCK_WAIT_FOREVER   0xFFFFFFFF  /* SPROX_ReaderLock waits until the reader is free */
+#define SPROX_LOCK_WAIT_MAX       86400000    /* Longer waits are shortened to one day           */
+
 	/* Discover the reader on a previously opened communication port */
 #ifdef WIN32
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_ReaderAttachSerial(HANDLE hComm);
@@ -287,6 +299,32 @@ extern  "C"
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_EnumUSBDevicesW(DWORD idx, wchar_t device[64], wchar_t description[64]);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_EnumUSBDevicesA(DWORD idx, char device[64], char description[64]);
 
+#ifndef WIN32
+	/* Enumerate the readers, and be told when a device is attached or detached (Linux only) */
+	typedef struct
+	{
+		char  device[64];     /* Name to give to SPROX_ReaderOpen                        */
+		char  stable_id[128]; /* Name that stays the same after a re-plug or a reboot    */
+		WORD  vid;            /* USB vendor and product, 0 if not an USB device          */
+		WORD  pid;
+		char  serial[32];     /* USB serial number, empty if none                        */
+		char  firmware[64];   /* As given by SPROX_ReaderGetFirmware                     */
+		SWORD rc;             /* MI_OK if a reader has answered                          */
+	} SPROX_READER_ENUM_ST;
+
+#define SPROX_ENUM_LEGACY_SERIAL  0x0001  /* Also probe the UARTs of the host (ttyS*)   */
+#define SPROX_ENUM_ALL_DEVICES    0x0002  /* Also list the devices where nothing answers */
+#define SPROX_ENUM_NO_PROBE       0x0004  /* List the devices, don't open them          */
+
+#define SPROX_HOTPLUG_ATTACH      0x01
+#define SPROX_HOTPLUG_DETACH      0x02
+
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_EnumReaders(SPROX_READER_ENUM_ST readers[], WORD max, WORD* count, DWORD flags);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_HotplugOpen(int* fd);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_HotplugRead(int fd, BYTE* event, char device[64]);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_HotplugClose(int fd);
+#endif
+
 	/* Select the address (RS-485 bus mode only) */
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_ReaderSelectAddress(BYTE address);
 
@@ -398,6 +436,25 @@ extern  "C"
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_Function(BYTE cmd, const BYTE send_buffer[], WORD send_bytelen, BYTE recv_buffer[], WORD* recv_bytelen);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_FunctionWaitResp(BYTE recv_buffer[], WORD* recv_bytelen, WORD timeout_s);
 
+	/* Send several raw commands to the reader, and receive their responses */
+	typedef struct
+	{
+		BYTE        cmd;
+		const BYTE* send_buffer;
+		WORD        send_bytelen;
+		BYTE*       recv_buffer;
+		WORD        recv_bytelen;   /* In: size of recv_buffer (0: large enough), out: length of the response */
+		SWORD       rc;             /* Status of this command                                                  */
+	} SPROX_FUNCTION_ST;
+
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_FunctionBatch(SPROX_FUNCTION_ST functions[], WORD count);
+
+	/* Record the traffic with the reader, to replay it with SPROX_ReaderOpen("REPLAY:<file>") */
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_RecordStart(const TCHAR filename[]);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_RecordStop(void);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_RecordRandom(BYTE rnd[], DWORD size);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_RecordGetStats(DWORD* exchanges, DWORD* reader_ms, DWORD* host_ms);
+
 	/* Test communication with the reader */
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_Echo(WORD len);
 
@@ -501,6 +558,8 @@ extern  "C"
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_Iso15693_Exchange(const BYTE send_buffer[], WORD send_len, BYTE recv_buffer[], WORD* recv_len, WORD timeout);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_Iso15693_ExchangeStdCommand(BOOL opt_flag, BYTE snr[8], BYTE cmd_opcode, const BYTE cmd_params[], WORD cmd_params_len, BYTE recv_buffer[], WORD* recv_len, WORD timeout);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_Iso15693_ExchangeCustomCommand(BOOL opt_flag, BYTE mfg_id, BYTE snr[8], BYTE cmd_opcode, const BYTE cmd_params[], WORD cmd_params_len, BYTE recv_buffer[], WORD* recv_len, WORD timeout);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_Iso15693_Inventory(BYTE afi, BYTE snr_list[][8], WORD max_count, WORD* count);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_Iso15693_ReadMultipleTags(BYTE snr_list[][8], WORD tag_count, WORD addr, WORD count, BYTE data[], WORD tag_data_size, WORD datalen[], SWORD status[]);
 
 	/* ICODE1 functions */
 	/* ---------------- */
@@ -520,6 +579,8 @@ extern  "C"
 
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_Find(WORD want_protos, WORD* got_proto, BYTE uid[], BYTE* uidlen);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_FindEx(WORD want_protos, WORD* got_proto, BYTE uid[], BYTE* uidlen, BYTE info[], BYTE* infolen);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_FindIdent(WORD want_protos, WORD* got_proto, BYTE uid[], BYTE* uidlen, BYTE info[], BYTE* infolen, BYTE ats[], BYTE* atslen, DWORD* time_us);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_FindIdentEnable(BOOL enable);
 
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_FindWait(WORD want_protos, WORD* got_proto, BYTE uid[], BYTE* uidlen, WORD timeout_s, WORD interval_ms);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_FindWaitEx(WORD want_protos, WORD* got_proto, BYTE uid[], BYTE* uidlen, BYTE info[], BYTE* infolen, WORD timeout_s, WORD interval_ms);
@@ -528,6 +589,63 @@ extern  "C"
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_FindLpcd(WORD want_protos, WORD* got_proto, BYTE uid[], BYTE* uidlen, WORD timeout_s);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_FindLpcdEx(WORD want_protos, WORD* got_proto, BYTE uid[], BYTE* uidlen, BYTE info[], BYTE* infolen, WORD timeout_s, BOOL forced_pulses);
 
+	/* Card presence events */
+	/* -------------------- */
+
+#define SPROX_WATCH_ARRIVAL        0x01
+#define SPROX_WATCH_REMOVAL        0x02
+#define SPROX_WATCH_ERROR          0x80
+
+	typedef struct
+	{
+		BYTE  event;        /* SPROX_WATCH_ARRIVAL, SPROX_WATCH_REMOVAL or SPROX_WATCH_ERROR */
+		WORD  proto;        /* Same as SPROX_FindEx                                          */
+		BYTE  uid[32];
+		BYTE  uidlen;
+		BYTE  info[32];
+		BYTE  infolen;
+		SWORD rc;           /* Error code, for SPROX_WATCH_ERROR                             */
+		DWORD time_s;       /* When the event has been seen, on a monotonic clock            */
+		DWORD time_us;
+	} SPROX_WATCH_EVENT_ST;
+
+	typedef void (SPRINGPROX_API* SPROX_WATCH_CALLBACK) (void* param, const SPROX_WATCH_EVENT_ST* event);
+
+	typedef struct
+	{
+		WORD  lpcd_timeout_s;       /* Low-power card detection when idle, for that long (0: no LPCD)  */
+		BOOL  lpcd_forced_pulses;   /* See SPROX_FindLpcdEx                                             */
+		WORD  burst_interval_ms;    /* Time between two polls after a wake-up or a removal              */
+		WORD  burst_polls;          /* Back to idle after that many empty polls                         */
+		WORD  present_interval_ms;  /* Time between two polls while a card is there                     */
+	} SPROX_WATCH_PROFILE_ST;
+
+	typedef struct
+	{
+		DWORD arrivals;             /* Cards detected                                                   */
+		DWORD detect_ms_total;      /* Time to detect them, summed up                                   */
+		DWORD detect_ms_max;
+		DWORD polls;                /* Discoveries at full power from the host                          */
+		DWORD lpcd_wakeups;         /* Returns from low-power card detection                            */
+		DWORD rf_on_ms;             /* Time spent looking for the cards at full power                   */
+		DWORD lpcd_ms;              /* Time spent in low-power card detection                           */
+		DWORD elapsed_ms;           /* Since the profile has been set                                   */
+	} SPROX_WATCH_STATS_ST;
+
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_WatchStart(WORD want_protos, WORD interval_ms, SPROX_WATCH_CALLBACK callback, void* param);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_WatchStartEx(WORD want_protos, const SPROX_WATCH_PROFILE_ST* profile, SPROX_WATCH_CALLBACK callback, void* param);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_WatchSetProfile(const SPROX_WATCH_PROFILE_ST* profile);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_WatchGetStats(SPROX_WATCH_STATS_ST* stats);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_WatchStop(void);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_WatchRead(SPROX_WATCH_EVENT_ST* event);
+#ifdef WIN32
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_WatchGetHandle(HANDLE* handle);
+#else
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_WatchGetFd(int* fd);
+#endif
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_WatchLock(void);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_WatchUnlock(void);
+
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_NfcI_Exchange(BYTE did, const BYTE send_buffer[], WORD send_len, BYTE recv_buffer[], WORD* recv_len);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_NfcI_Atr(BYTE did, const BYTE gi[], WORD gi_len, BYTE nfcid3t[10], BYTE gt[], WORD* gt_len);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_NfcI_Dsl(BYTE did);
@@ -577,6 +695,7 @@ extern  "C"
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_MifStReadSector(const BYTE snr[4], BYTE sector, BYTE data[], const BYTE key_val[6]);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_MifStReadSector2(const BYTE snr[4], BYTE sector, BYTE data[], BYTE key_idx);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_MifStReadTag768(const BYTE snr[4], WORD* sectors, BYTE data[]);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_MifStReadTag(const BYTE snr[4], BYTE sector_count, const BYTE* key_map[], BYTE sectors[], BYTE data[]);
 
 	/* Mifare standard authenticate and write */
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_MifStWriteBlock(const BYTE snr[4], BYTE block, const BYTE data[16], const BYTE key_val[6]);
@@ -584,6 +703,7 @@ extern  "C"
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_MifStWriteSector(const BYTE snr[4], BYTE sector, const BYTE data[], const BYTE key_val[6]);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_MifStWriteSector2(const BYTE snr[4], BYTE sector, const BYTE data[], BYTE key_idx);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_MifStWriteTag768(const BYTE snr[4], WORD* sectors, const BYTE data[]);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_MifStWriteTag(const BYTE snr[4], BYTE sector_count, const BYTE* key_map[], BYTE sectors[], const BYTE data[]);
 
 	/* Mifare standard counter manipulation */
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROX_MifStReadCounter(const BYTE snr[4], BYTE block, SDWORD* value, const BYTE key_val[6]);
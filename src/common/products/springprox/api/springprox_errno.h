@@ -95,6 +95,7 @@
 #define MI_READER_CONNECT_FAILED       (-251)      /* Library: Failed to connect to a remote reader */
 #define MI_INVALID_READER_CONTEXT      (-252)      /* Library: The sprox_ctx parameter is invalid */
 #define MI_LIB_INTERNAL_ERROR          (-253)      /* Library: An internal error has occured */
+#define MI_READER_BUSY                 (-254)      /* Library: The shared reader is locked by another application */
 
 
 #endif
@@ -75,6 +75,15 @@ extern  "C"
 	/* Resume the reader */
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_ReaderActivate(SPROX_INSTANCE rInst);
 
+	/* How to open the device again when it fails (USB reader unplugged...) */
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_ReaderSetReconnect(SPROX_INSTANCE rInst, BYTE tries, WORD delay_ms);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_ReaderSetBaudrate(SPROX_INSTANCE rInst, DWORD baudrate);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_ReaderGetBaudrate(SPROX_INSTANCE rInst, DWORD* baudrate);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_ReaderBaudrateHighEnable(SPROX_INSTANCE rInst, BOOL enable);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_ReaderLock(SPROX_INSTANCE rInst, DWORD wait_ms);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_ReaderUnlock(SPROX_INSTANCE rInst);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_ReaderSetPipeline(SPROX_INSTANCE rInst, BYTE depth);
+
 	/* Discover the reader on a previously opened communication port */
 #ifdef WIN32
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_ReaderAttachSerial(SPROX_INSTANCE rInst, HANDLE hComm);
@@ -86,6 +95,13 @@ extern  "C"
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_EnumUSBDevicesW(DWORD idx, wchar_t device[64], wchar_t description[64]);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_EnumUSBDevicesA(DWORD idx, char device[64], char description[64]);
 
+#ifndef WIN32
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_EnumReaders(SPROX_READER_ENUM_ST readers[], WORD max, WORD* count, DWORD flags);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_HotplugOpen(int* fd);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_HotplugRead(int fd, BYTE* event, char device[64]);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_HotplugClose(int fd);
+#endif
+
 	/* Select the address (RS-485 bus mode only) */
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_ReaderSelectAddress(SPROX_INSTANCE rInst, BYTE address);
 
@@ -152,6 +168,13 @@ extern  "C"
 	/* Send a raw command to the reader */
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_Function(SPROX_INSTANCE rInst, BYTE cmd, const BYTE send_buffer[], WORD send_bytelen, BYTE recv_buffer[], WORD* recv_bytelen);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_FunctionWaitResp(SPROX_INSTANCE rInst, BYTE recv_buffer[], WORD* recv_bytelen, WORD timeout_s);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_FunctionBatch(SPROX_INSTANCE rInst, SPROX_FUNCTION_ST functions[], WORD count);
+
+	/* Record the traffic with the reader, to replay it with SPROXx_ReaderOpen("REPLAY:<file>") */
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_RecordStart(SPROX_INSTANCE rInst, const TCHAR filename[]);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_RecordStop(SPROX_INSTANCE rInst);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_RecordRandom(SPROX_INSTANCE rInst, BYTE rnd[], DWORD size);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_RecordGetStats(SPROX_INSTANCE rInst, DWORD* exchanges, DWORD* reader_ms, DWORD* host_ms);
 
 	/* Test communication with the reader */
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_Echo(SPROX_INSTANCE rInst, WORD len);
@@ -253,6 +276,8 @@ extern  "C"
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_Iso15693_Exchange(SPROX_INSTANCE rInst, const BYTE send_buffer[], WORD send_len, BYTE recv_buffer[], WORD* recv_len, WORD timeout);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_Iso15693_ExchangeStdCommand(SPROX_INSTANCE rInst, BOOL opt_flag, BYTE snr[8], BYTE cmd_opcode, const BYTE cmd_params[], WORD cmd_params_len, BYTE recv_buffer[], WORD* recv_len, WORD timeout);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_Iso15693_ExchangeCustomCommand(SPROX_INSTANCE rInst, BOOL opt_flag, BYTE mfg_id, BYTE snr[8], BYTE cmd_opcode, const BYTE cmd_params[], WORD cmd_params_len, BYTE recv_buffer[], WORD* recv_len, WORD timeout);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_Iso15693_Inventory(SPROX_INSTANCE rInst, BYTE afi, BYTE snr_list[][8], WORD max_count, WORD* count);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_Iso15693_ReadMultipleTags(SPROX_INSTANCE rInst, BYTE snr_list[][8], WORD tag_count, WORD addr, WORD count, BYTE data[], WORD tag_data_size, WORD datalen[], SWORD status[]);
 
 	/* ICODE1 functions */
 	/* ---------------- */
@@ -272,10 +297,29 @@ extern  "C"
 
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_Find(SPROX_INSTANCE rInst, WORD want_protos, WORD* got_proto, BYTE uid[10], BYTE* uidlen);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_FindEx(SPROX_INSTANCE rInst, WORD want_protos, WORD* got_proto, BYTE uid[10], BYTE* uidlen, BYTE info[32], BYTE* infolen);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_FindIdent(SPROX_INSTANCE rInst, WORD want_protos, WORD* got_proto, BYTE uid[], BYTE* uidlen, BYTE info[], BYTE* infolen, BYTE ats[], BYTE* atslen, DWORD* time_us);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_FindIdentEnable(SPROX_INSTANCE rInst, BOOL enable);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_FindWait(SPROX_INSTANCE rInst, WORD want_protos, WORD* got_proto, BYTE uid[10], BYTE* uidlen, WORD timeout_s, WORD interval_ms);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_FindWaitEx(SPROX_INSTANCE rInst, WORD want_protos, WORD* got_proto, BYTE uid[10], BYTE* uidlen, BYTE info[32], BYTE* infolen, WORD timeout_s, WORD interval_ms);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_FindWaitCancel(SPROX_INSTANCE rInst);
 
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_FindLpcd(SPROX_INSTANCE rInst, WORD want_protos, WORD* got_proto, BYTE uid[], BYTE* uidlen, WORD timeout_s);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_FindLpcdEx(SPROX_INSTANCE rInst, WORD want_protos, WORD* got_proto, BYTE uid[], BYTE* uidlen, BYTE info[], BYTE* infolen, WORD timeout_s, BOOL forced_pulses);
+
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_WatchStart(SPROX_INSTANCE rInst, WORD want_protos, WORD interval_ms, SPROX_WATCH_CALLBACK callback, void* param);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_WatchStartEx(SPROX_INSTANCE rInst, WORD want_protos, const SPROX_WATCH_PROFILE_ST* profile, SPROX_WATCH_CALLBACK callback, void* param);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_WatchSetProfile(SPROX_INSTANCE rInst, const SPROX_WATCH_PROFILE_ST* profile);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_WatchGetStats(SPROX_INSTANCE rInst, SPROX_WATCH_STATS_ST* stats);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_WatchStop(SPROX_INSTANCE rInst);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_WatchRead(SPROX_INSTANCE rInst, SPROX_WATCH_EVENT_ST* event);
+#ifdef WIN32
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_WatchGetHandle(SPROX_INSTANCE rInst, HANDLE* handle);
+#else
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_WatchGetFd(SPROX_INSTANCE rInst, int* fd);
+#endif
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_WatchLock(SPROX_INSTANCE rInst);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_WatchUnlock(SPROX_INSTANCE rInst);
+
 
 	/* Legacy Mifare functions */
 	/* ----------------------- */
@@ -301,6 +345,7 @@ extern  "C"
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_MifStReadSector(SPROX_INSTANCE rInst, const BYTE snr[4], BYTE sect, BYTE data[], const BYTE key_val[6]);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_MifStReadSector2(SPROX_INSTANCE rInst, const BYTE snr[4], BYTE sect, BYTE data[], BYTE key_idx);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_MifStReadTag768(SPROX_INSTANCE rInst, const BYTE snr[4], WORD* sectors, BYTE data[]);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_MifStReadTag(SPROX_INSTANCE rInst, const BYTE snr[4], BYTE sector_count, const BYTE* key_map[], BYTE sectors[], BYTE data[]);
 
 	/* Mifare standard authenticate and write */
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_MifStWriteBlock(SPROX_INSTANCE rInst, const BYTE snr[4], BYTE bloc, const BYTE data[16], const BYTE key_val[6]);
@@ -308,6 +353,7 @@ extern  "C"
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_MifStWriteSector(SPROX_INSTANCE rInst, const BYTE snr[4], BYTE sect, const BYTE data[], const BYTE key[6]);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_MifStWriteSector2(SPROX_INSTANCE rInst, const BYTE snr[4], BYTE sect, const BYTE data[], BYTE key_idx);
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_MifStWriteTag768(SPROX_INSTANCE rInst, const BYTE snr[4], WORD* sectors, const BYTE data[]);
+	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_MifStWriteTag(SPROX_INSTANCE rInst, const BYTE snr[4], BYTE sector_count, const BYTE* key_map[], BYTE sectors[], const BYTE data[]);
 
 	/* Mifare standard counter manipulation */
 	SPRINGPROX_LIB SWORD SPRINGPROX_API SPROXx_MifStReadCounter(SPROX_INSTANCE rInst, const BYTE snr[4], BYTE bloc, SDWORD* value, const BYTE key_val[6]);
@@ -818,6 +818,351 @@ SPROX_API_FUNC(Iso15693_ExchangeCustomCommand) (SPROX_PARAM  BOOL opt_flag, BYTE
 	return SPROX_API_CALL(Iso15693_Exchange) (SPROX_PARAM_P  send_buffer, send_len, recv_buffer, recv_len, timeout);
 }
 
+/*
+ *****************************************************************************
+ *
+ *   INVENTORY AND MULTI-TAG FUNCTIONS
+ *
+ *****************************************************************************
+ */
+
+#define ISO15693_INVENTORY_TIMEOUT 1000
+#define ISO15693_INVENTORY_SLOTS   16
+#define ISO15693_MAX_MASK_NIBBLES  16
+
+/*
+ * Send one single-slot INVENTORY request, with the given mask (LSB first, as in
+ * the tags' UID), and tell whether no tag, exactly one tag, or more than one tag
+ * has answered
+ */
+static SWORD Iso15693_InventorySlot(SPROX_PARAM  BYTE afi, const BYTE mask[8], BYTE mask_nibbles, BYTE snr[8])
+{
+	BYTE send_buffer[16];
+	BYTE recv_buffer[32];
+	WORD send_len = 0;
+	WORD recv_len = sizeof(recv_buffer);
+	BYTE i;
+	SWORD rc;
+
+	/* High data rate, inventory, 1 slot */
+	send_buffer[send_len++] = (afi != 0) ? 0x36 : 0x26;
+	send_buffer[send_len++] = 0x01;
+	if (afi != 0)
+		send_buffer[send_len++] = afi;
+	send_buffer[send_len++] = (BYTE)(4 * mask_nibbles);
+	for (i = 0; i < (mask_nibbles + 1) / 2; i++)
+		send_buffer[send_len++] = mask[i];
+
+	rc = SPROX_API_CALL(Iso15693_Exchange) (SPROX_PARAM_P  send_buffer, send_len, recv_buffer, &recv_len, ISO15693_INVENTORY_TIMEOUT);
+
+	switch (rc)
+	{
+	case MI_OK:
+		/* Flags, DSFID, then the UID (LSB first) */
+		if ((recv_len < 10) || (recv_buffer[0] & 0x01))
+			return MI_COLLERR;
+		for (i = 0; i < 8; i++)
+			snr[i] = recv_buffer[9 - i];
+		return MI_OK;
+
+	case MI_CRCERR:
+	case MI_PARITYERR:
+	case MI_BITCOUNTERR:
+	case MI_BYTECOUNTERR:
+	case MI_FRAMINGERR:
+	case MI_CODINGERR:
+	case MI_COLLERR:
+		/* Several tags answered at the same time */
+		return MI_COLLERR;
+
+	default:
+		return rc;
+	}
+}
+
+/**f* SpringProx.API/SPROX_Iso15693_Inventory
+ *
+ * NAME
+ *   SPROX_Iso15693_Inventory
+ *
+ * DESCRIPTION
+ *   Retrieve the UIDs of all the ISO 15693 tags available in the RF field
+ *
+ * INPUTS
+ *   BYTE afi           : application family identifier. Set to 0 for all tags.
+ *   BYTE snr_list[][8] : buffer to receive the 8-byte UIDs of the tags
+ *   WORD max_count     : number of entries in snr_list
+ *   WORD *count        : number of tags that have been found
+ *
+ * RETURNS
+ *   MI_OK              : success, *count tags have been found
+ *   MI_NOTAGERR        : no tag available in the RF field
+ *   MI_RESPONSE_OVERFLOW : more than max_count tags are available in the field,
+ *                        the max_count first ones are returned in snr_list
+ *   Other code if internal or communication error has occured.
+ *
+ * NOTES
+ *   The anticollision walks the UIDs 4 bits at a time, each node being split
+ *   into 16 slots. Since the reader is not able to send the end-of-slot markers,
+ *   every slot is a single-slot request with the matching mask.
+ *   When only one tag is in the field, a single request is needed.
+ *
+ * SEE ALSO
+ *   SPROX_Iso15693_SelectAny
+ *   SPROX_Iso15693_ReadMultipleTags
+ *
+ **/
+SPROX_API_FUNC(Iso15693_Inventory) (SPROX_PARAM  BYTE afi, BYTE snr_list[][8], WORD max_count, WORD* count)
+{
+	/* Pending nodes of the anticollision tree: mask and depth (in nibbles) */
+	BYTE  stack_mask[ISO15693_MAX_MASK_NIBBLES * (ISO15693_INVENTORY_SLOTS - 1) + 1][8];
+	BYTE  stack_depth[ISO15693_MAX_MASK_NIBBLES * (ISO15693_INVENTORY_SLOTS - 1) + 1];
+	WORD  stack_size = 0;
+	WORD  found = 0;
+	BYTE  snr[8];
+	SWORD rc;
+
+	if ((snr_list == NULL) || (count == NULL) || (max_count == 0))
+		return MI_LIB_CALL_ERROR;
+
+	*count = 0;
+
+	rc = SPROX_API_CALL(SetConfig) (SPROX_PARAM_P  CFG_MODE_ISO_15693);
+	if (rc != MI_OK) return rc;
+
+	/* Root node: no mask at all */
+	memset(stack_mask[0], 0, 8);
+	stack_depth[0] = 0;
+	stack_size = 1;
+
+	while (stack_size > 0)
+	{
+		BYTE mask[8];
+		BYTE depth;
+		BYTE slot;
+
+		stack_size--;
+		memcpy(mask, stack_mask[stack_size], 8);
+		depth = stack_depth[stack_size];
+
+		if (depth == 0)
+		{
+			/* First of all, try without any mask - this is enough if only one tag is there */
+			rc = Iso15693_InventorySlot(SPROX_PARAM_P  afi, mask, 0, snr);
+			if (rc == MI_NOTAGERR)
+				break;
+			if (rc == MI_OK)
+			{
+				memcpy(snr_list[found++], snr, 8);
+				break;
+			}
+			if (rc != MI_COLLERR)
+				goto exit_proc;
+		}
+
+		if (depth >= ISO15693_MAX_MASK_NIBBLES)
+		{
+			/* Two tags can't share the same UID... */
+			rc = MI_COLLERR;
+			goto exit_proc;
+		}
+
+		for (slot = 0; slot < ISO15693_INVENTORY_SLOTS; slot++)
+		{
+			if (depth % 2)
+				mask[depth / 2] = (BYTE)((mask[depth / 2] & 0x0F) | (slot << 4));
+			else
+				mask[depth / 2] = (BYTE)((mask[depth / 2] & 0xF0) | slot);
+
+			rc = Iso15693_InventorySlot(SPROX_PARAM_P  afi, mask, (BYTE)(depth + 1), snr);
+			if (rc == MI_NOTAGERR)
+				continue;
+
+			if (rc == MI_OK)
+			{
+				if (found >= max_count)
+				{
+					rc = MI_RESPONSE_OVERFLOW;
+					goto exit_proc;
+				}
+				memcpy(snr_list[found++], snr, 8);
+				continue;
+			}
+
+			if (rc != MI_COLLERR)
+				goto exit_proc;
+
+			/* Collision in this slot, go deeper later */
+			memcpy(stack_mask[stack_size], mask, 8);
+			stack_depth[stack_size] = (BYTE)(depth + 1);
+			stack_size++;
+		}
+	}
+
+	rc = (found > 0) ? MI_OK : MI_NOTAGERR;
+
+exit_proc:
+	*count = found;
+	if ((rc == MI_OK) && (found == 1))
+		Save15693Snr(SPROX_PARAM_P  snr_list[0]);
+
+	SPROX_Trace(TRACE_DEBUG, "15693_Inventory %d -> %d", found, rc);
+	return rc;
+}
+
+/*
+ * Retrieve the size and the number of blocks of the currently selected tag,
+ * 0 if they are unknown
+ */
+static void Iso15693_GetMemorySize(SPROX_PARAM  WORD* block_size, WORD* block_count)
+{
+	BYTE buffer[32];
+	WORD length = sizeof(buffer);
+	WORD i = 9;
+
+	*block_size = 0;
+	*block_count = 0;
+
+	if (SPROX_API_CALL(Iso15693_GetSystemInformation) (SPROX_PARAM_P  NULL, buffer, &length) != MI_OK)
+		return;
+
+	/* Info flags, UID, then optional fields */
+	if (buffer[0] & 0x01)
+		i++; /* DSFID */
+	if (buffer[0] & 0x02)
+		i++; /* AFI */
+	if ((buffer[0] & 0x04) && (length >= i + 2))
+	{
+		*block_count = buffer[i] + 1;
+		*block_size = (buffer[i + 1] & 0x1F) + 1;
+	}
+}
+
+/**f* SpringProx.API/SPROX_Iso15693_ReadMultipleTags
+ *
+ * NAME
+ *   SPROX_Iso15693_ReadMultipleTags
+ *
+ * DESCRIPTION
+ *   Read the same range of blocks from a list of ISO 15693 tags
+ *
+ * INPUTS
+ *   BYTE snr_list[][8] : 8-byte UIDs of the tags, as returned by SPROX_Iso15693_Inventory
+ *   WORD tag_count     : number of tags in snr_list
+ *   WORD addr          : address of the first block to read
+ *   WORD count         : number of blocks to read
+ *   BYTE data[]        : buffer to receive the data, tag_count * tag_data_size bytes
+ *                        Data of tag i are stored at data[i * tag_data_size]
+ *   WORD tag_data_size : room for each tag in data[]
+ *   WORD datalen[]     : number of bytes actually read from each tag
+ *   SWORD status[]     : result of the read operation for each tag
+ *
+ * RETURNS
+ *   MI_OK              : success, check status[] to know which tags have been read
+ *   Other code if internal or communication error has occured.
+ *
+ * NOTES
+ *   The memory layout of each tag is retrieved through GetSystemInformation, so
+ *   every tag is read using as many blocks per command as it (and the reader's
+ *   buffer) is able to handle. Extended commands are used only when needed.
+ *   If a tag doesn't support GetSystemInformation or ReadMultipleBlocks, it is
+ *   read one block at a time.
+ *
+ * SEE ALSO
+ *   SPROX_Iso15693_Inventory
+ *   SPROX_Iso15693_ReadMultipleBlocks
+ *   SPROX_Iso15693_GetSystemInformation
+ *
+ **/
+SPROX_API_FUNC(Iso15693_ReadMultipleTags) (SPROX_PARAM  BYTE snr_list[][8], WORD tag_count, WORD addr, WORD count, BYTE data[], WORD tag_data_size, WORD datalen[], SWORD status[])
+{
+	WORD tag;
+	SWORD rc;
+
+	if ((snr_list == NULL) || (data == NULL) || (datalen == NULL) || (status == NULL))
+		return MI_LIB_CALL_ERROR;
+
+	rc = SPROX_API_CALL(SetConfig) (SPROX_PARAM_P  CFG_MODE_ISO_15693);
+	if (rc != MI_OK) return rc;
+
+	for (tag = 0; tag < tag_count; tag++)
+	{
+		BYTE* ptr = &data[(DWORD)tag * tag_data_size];
+		WORD  block_size, block_count;
+		WORD  chunk, done = 0, offset = 0;
+		WORD  tag_count_blocks = count;
+
+		datalen[tag] = 0;
+
+		rc = SPROX_API_CALL(Iso15693_SelectAgain) (SPROX_PARAM_P  snr_list[tag]);
+		if (rc != MI_OK)
+		{
+			status[tag] = rc;
+			continue;
+		}
+
+		Iso15693_GetMemorySize(SPROX_PARAM_P  &block_size, &block_count);
+
+		if (block_size != 0)
+		{
+			/* Largest number of blocks in one response (ReadMultipleBlocks is limited to 256) */
+			chunk = (WORD)((SPROX_FRAME_CONTENT_SIZE - 20) / block_size);
+			if (chunk > 255)
+				chunk = 255;
+			if (chunk == 0)
+				chunk = 1;
+		}
+		else
+		{
+			/* Unknown layout */
+			chunk = 1;
+		}
+
+		if ((block_count != 0) && (addr + count > block_count))
+		{
+			/* Don't try to read past the end of the tag */
+			tag_count_blocks = (addr < block_count) ? (WORD)(block_count - addr) : 0;
+		}
+
+		rc = MI_OK;
+		while (done < tag_count_blocks)
+		{
+			WORD n = (WORD)(tag_count_blocks - done);
+			WORD len = (WORD)(tag_data_size - offset);
+			WORD a = (WORD)(addr + done);
+
+			if (n > chunk)
+				n = chunk;
+			if ((block_size != 0) && (len < n * block_size))
+			{
+				rc = MI_RESPONSE_OVERFLOW;
+				break;
+			}
+
+			/* Same count convention as Iso15693_ReadSingleBlock / Iso15693_ReadMultipleBlocks */
+			rc = Iso15693_ReadProc(SPROX_PARAM_P  (a + n > 256) ? TRUE : FALSE, NULL, a, (WORD)((n > 1) ? n : 0), ptr + offset, &len);
+
+			if ((rc != MI_OK) && (n > 1))
+			{
+				/* ReadMultipleBlocks not supported? Go on one block at a time */
+				chunk = 1;
+				continue;
+			}
+			if (rc != MI_OK)
+				break;
+
+			offset = (WORD)(offset + len);
+			done = (WORD)(done + n);
+		}
+
+		datalen[tag] = offset;
+		status[tag] = rc;
+	}
+
+	SPROX_Trace(TRACE_DEBUG, "15693_ReadMultipleTags %d -> %d", tag_count, MI_OK);
+	return MI_OK;
+}
+
 /*
  *
  * ICODE1
@@ -104,6 +104,7 @@
 
 #include <termios.h>
 #include <unistd.h>  
+#include <strings.h>
 
 #ifndef MAX_PATH
 #define MAX_PATH 256
@@ -113,6 +114,7 @@
 #define _tcscat strcat
 #define _tcsicmp strcmp
 #define _tcsncmp strncmp
+#define _tcsncicmp strncasecmp
 #define _tcsncpy strncpy
 #define _tcscpy strcpy
 #define _tcslen strlen
@@ -123,6 +125,17 @@
 
 #define Sleep(x) usleep(1000*x)
 
+/* Network readers, see sprox_dlg_tcp.c */
+#ifndef SPROX_API_NO_TCP
+#define SPROX_API_WITH_TCP
+typedef int SOCKET;
+#endif
+
+/* Readers shared through the ref_share daemon, see sprox_dlg_share.c */
+#ifndef SPROX_API_NO_SHARE
+#define SPROX_API_WITH_SHARE
+#endif
+
 #endif
 
 #define UNUSED_PARAMETER(x) (void) x
@@ -162,6 +175,8 @@
 #define COM_INTERFACE_SERIAL            0x01000000
 #define COM_INTERFACE_FTDI              0x03000000
 #define COM_INTERFACE_TCP               0x10000000
+#define COM_INTERFACE_SHARE             0x20000000
+#define COM_INTERFACE_REPLAY            0x30000000
 #define COM_INTERFACE_MASK              0xFF000000
 #define COM_INTERFACE_SHIFT             24
 
@@ -182,6 +197,7 @@ struct _SPROX_CTX_ST
 	BYTE    com_sequence;
 
 	BYTE    com_status;
+	BOOL    com_lost;      /* The device has failed (unplugged...), see SPROX_ReaderReconnect */
 
 #ifdef WIN32
 	HANDLE  com_handle;
@@ -192,10 +208,23 @@ struct _SPROX_CTX_ST
 #ifdef SPROX_API_WITH_TCP
 	SOCKET  com_socket;
 #endif
+	BYTE    com_pipeline;  /* Requests in flight in SPROX_FunctionBatch, see SPROX_ReaderSetPipeline */
+
+#ifdef SPROX_API_WITH_SHARE
+	int     com_share;     /* Socket to the ref_share daemon */
+#endif
+
+#if (defined(LINUX) && !defined(SPROX_API_NO_FTDI))
+	struct ftdi_context* com_ftdi; /* Not NULL when the device is a FTDI chip, opened through libftdi */
+#endif
 
 
 	TCHAR   com_name[48 + 1];
 
+	DWORD   com_baudrate;   /* Current baudrate of the serial link, set by SerialSetBaudrate */
+	BYTE    com_crc_errors; /* Consecutive functions with CRC errors, see SPROX_ReaderBaudrateFallback */
+	BOOL    com_baudrate_high_enable; /* Rates above 115200bps allowed, see SPROX_ReaderBaudrateHighEnable */
+
 	//  BOOL    com_reset_ctrl :1;
 	//  BOOL    com_power_ctrl :1;
 	//  BOOL    com_power_auto :1;
@@ -222,9 +251,41 @@ struct _SPROX_CTX_ST
 	DWORD   sprox_version;
 	DWORD   sprox_capabilities;
 
+	/* What SPROX_ReaderConnect has found, to open the same device again with one exchange */
+	struct
+	{
+		BOOL    valid;
+		TCHAR   com_name[48 + 1];
+		DWORD   com_settings;
+		DWORD   com_baudrate;
+		BYTE    sprox_info[16];
+		DWORD   sprox_version;
+		DWORD   sprox_capabilities;
+	} com_profile;
+
+	/* Transparent reconnect (see SPROX_ReaderSetReconnect) */
+	BOOL    reconnect_set;
+	BYTE    reconnect_tries;
+	WORD    reconnect_delay_ms;
+
 	/* Current RF operating mode */
 	BYTE    pcd_current_rf_protocol;
 
+	/* Does the reader answer SPROX_FIND_IDENT (see sprox_find.c) */
+	BYTE    pcd_find_ident;
+	BOOL    pcd_find_ident_enable;
+
+	/* SPROX_FIND waits for a card : SPROX_FindWaitCancel only sends its command */
+	volatile BOOL find_wait_pending;
+	volatile BOOL find_wait_broken;
+
+	/* Card presence events (see sprox_watch.c) */
+	void*   watch;
+
+	/* Record and replay of the traffic (see sprox_record.c) */
+	void*   record;
+	void*   replay;
+
 	/* For Mifare functions */
 	BYTE    mif_auth_ok;
 	BYTE    mif_auth_info;
@@ -284,6 +345,16 @@ BOOL SerialControl_Power(SPROX_CTX_ST* sprox_ctx, BOOL power_up);
 SWORD SPROX_ReaderConnect(SPROX_CTX_ST* sprox_ctx);
 SWORD SPROX_ReaderConnectAt(SPROX_CTX_ST* sprox_ctx, DWORD baudrate);
 SWORD SPROX_ReaderConnectTCP(SPROX_CTX_ST* sprox_ctx, const TCHAR* conn_string);
+SWORD SPROX_ReaderProbe(SPROX_CTX_ST* sprox_ctx, DWORD baudrate);
+SWORD SPROX_ReaderReconnect(SPROX_CTX_ST* sprox_ctx);
+SWORD SPROX_Function_SendOnly(SPROX_CTX_ST* sprox_ctx, BYTE command);
+void  SPROX_Function_Drain(SPROX_CTX_ST* sprox_ctx);
+
+void SPROX_ReaderSetInfo(SPROX_CTX_ST* sprox_ctx, WORD infolen);
+void SPROX_ReaderInfoToString(SPROX_CTX_ST* sprox_ctx, char* buffer, size_t size);
+
+void SPROX_GetMonotonicTime(DWORD* sec, DWORD* usec);
+DWORD SPROX_GetMonotonicMs(void);
 
 void LoadSettings(void);
 BOOL LoadDefaultDevice(void);
@@ -304,6 +375,26 @@ SWORD SPROX_Brcd_ReaderOpen(const TCHAR device[], BOOL direct);
 SWORD SPROX_TCP_Function(SPROX_CTX_ST* sprox_ctx, BYTE cmd, const BYTE send_buffer[], WORD send_bytelen, BYTE recv_buffer[], WORD* recv_bytelen);
 SWORD SPROX_TCP_ReaderOpen(SPROX_CTX_ST* sprox_ctx, const TCHAR device[]);
 SWORD SPROX_TCP_ReaderClose(SPROX_CTX_ST* sprox_ctx);
+SWORD SPROX_TCP_FunctionBatch(SPROX_CTX_ST* sprox_ctx, SPROX_FUNCTION_ST functions[], WORD count);
+
+SWORD SPROX_Share_Function(SPROX_CTX_ST* sprox_ctx, BYTE cmd, const BYTE send_buffer[], WORD send_bytelen, BYTE recv_buffer[], WORD* recv_bytelen);
+SWORD SPROX_Share_ReaderOpen(SPROX_CTX_ST* sprox_ctx, const TCHAR socket_path[]);
+SWORD SPROX_Share_ReaderClose(SPROX_CTX_ST* sprox_ctx);
+SWORD SPROX_Share_Lock(SPROX_CTX_ST* sprox_ctx, DWORD wait_ms);
+SWORD SPROX_Share_Unlock(SPROX_CTX_ST* sprox_ctx);
+
+#define SPROX_RECORD_FUNCTION   'F'  /* SPROX_Function           */
+#define SPROX_RECORD_WAIT_RESP  'W'  /* SPROX_FunctionWaitResp   */
+#define SPROX_RECORD_RANDOM     'R'  /* SPROX_RecordRandom       */
+
+SWORD SPROX_Record_Start(SPROX_CTX_ST* sprox_ctx, const char filename[], BOOL whole_process);
+void  SPROX_Record_Stop(SPROX_CTX_ST* sprox_ctx, BOOL forced);
+void  SPROX_Record_Begin(SPROX_CTX_ST* sprox_ctx);
+void  SPROX_Record_End(SPROX_CTX_ST* sprox_ctx, BYTE type, BYTE cmd, const BYTE send_data[], WORD send_len, SWORD rc, const BYTE recv_data[], const WORD* recv_len);
+void  SPROX_Record_EndBatch(SPROX_CTX_ST* sprox_ctx, const SPROX_FUNCTION_ST functions[], WORD count);
+SWORD SPROX_Replay_Function(SPROX_CTX_ST* sprox_ctx, BYTE type, BYTE cmd, const BYTE send_data[], WORD send_len, BYTE recv_data[], WORD* recv_len);
+SWORD SPROX_Replay_ReaderOpen(SPROX_CTX_ST* sprox_ctx, const char filename[], BOOL whole_process);
+SWORD SPROX_Replay_ReaderClose(SPROX_CTX_ST* sprox_ctx);
 
 #ifdef UNICODE
 const char* _ST(const TCHAR* s);
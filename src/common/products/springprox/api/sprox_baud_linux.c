@@ -0,0 +1,81 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  SpringProx API
+  --------------
+
+  sprox_baud_linux.c
+  ------------------
+  Serial baudrates that have no Bxxx constant, under Linux
+
+  The kernel takes them as is (BOTHER), through its own struct termios2 and
+  the TCGETS2/TCSETS2 ioctls. Their definitions come from <asm/termbits.h>,
+  that can't be included together with the <termios.h> of the C library
+  (sprox_api_i.h) : this is why this code lives in a file of its own, and
+  takes only plain C types.
+  Some architectures (powerpc) have no termios2 : their struct termios carries
+  the speeds already, and TCGETS/TCSETS take BOTHER.
+
+  revision :
+  ----------
+
+  AGT 19/10/2026 : created, out of sprox_comm_linux.c
+
+*/
+
+#ifdef __linux__
+
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+#include <string.h>
+
+#include "sprox_baud_linux.h"
+
+/*
+ * SerialSetCustomBaudrate
+ * -----------------------
+ * Same settings as SerialSetBaudrate (8 data bits, 1 stop bit, no parity,
+ * no flow control, raw), at any rate the driver accepts
+ * Returns :
+ * - 0 on success
+ * - -1 if the driver refuses the rate, or if the kernel headers don't offer
+ *   BOTHER (the port is left unchanged)
+ */
+int SerialSetCustomBaudrate(int fd, unsigned long baudrate)
+{
+#if defined(BOTHER) && defined(TCSETS2)
+	struct termios2 tio;
+#define SERIAL_SET_CUSTOM TCSETS2
+#elif defined(BOTHER)
+	struct termios tio;
+#define SERIAL_SET_CUSTOM TCSETS
+#endif
+
+#ifdef SERIAL_SET_CUSTOM
+	memset(&tio, 0, sizeof(tio));
+	tio.c_cflag = CS8 | CLOCAL | CREAD | BOTHER;
+#ifdef IBSHIFT
+	tio.c_cflag |= BOTHER << IBSHIFT;
+#endif
+	tio.c_iflag = IGNPAR | IGNBRK;
+	tio.c_oflag = 0;
+	tio.c_lflag = 0;
+	tio.c_cc[VTIME] = 0;
+	tio.c_cc[VMIN] = 1;
+	tio.c_ispeed = baudrate;
+	tio.c_ospeed = baudrate;
+
+	if (ioctl(fd, SERIAL_SET_CUSTOM, &tio))
+		return -1;
+	return 0;
+#else
+	(void) fd;
+	(void) baudrate;
+	return -1;
+#endif
+}
+
+#endif
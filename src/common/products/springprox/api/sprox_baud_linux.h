@@ -0,0 +1,18 @@
+/*
+  SpringProx API
+  --------------
+
+  sprox_baud_linux.h
+  ------------------
+  Serial baudrates that have no Bxxx constant, under Linux (see sprox_baud_linux.c)
+  This header must not depend on <termios.h> nor on <asm/termbits.h>
+
+  AGT 19/10/2026 : created
+
+*/
+#ifndef SPROX_BAUD_LINUX_H
+#define SPROX_BAUD_LINUX_H
+
+int SerialSetCustomBaudrate(int fd, unsigned long baudrate);
+
+#endif
@@ -18,6 +18,14 @@
 
 	JDA 03/02/2004 : created from SpringCard's serial_linux.c
   JDA 27/01/2012 : better handling of timeout in RecvBurst
+  AGT 19/10/2026 : SerialLookup probes all the serial devices at once, through SPROX_EnumReaders
+  AGT 19/10/2026 : SerialLookup gives the complete connection sequence to the devices that fail the probe
+  AGT 19/10/2026 : ...only to /dev/ttyUSB0, /dev/ttyS0 and /dev/ttyS1, as before the probe
+  AGT 19/10/2026 : remember in com_lost that the device has failed, for the reconnect
+  AGT 19/10/2026 : a signal during select, read or write is not a failure of the device
+  AGT 19/10/2026 : baudrates above 115200bps, including non-standard ones through termios2
+  AGT 19/10/2026 : termios2 comes from the kernel headers, see sprox_baud_linux.c
+  AGT 19/10/2026 : FTDI devices are told by their own libftdi context (com_ftdi)
 
 */
 
@@ -29,18 +37,26 @@
 //#define D(x) x
 
 #include <unistd.h>
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <sys/ioctl.h>
+
+#include "sprox_baud_linux.h"
 
 static BOOL SerialOpen_COM(SPROX_CTX_ST* sprox_ctx, const TCHAR* device);
 static BOOL SerialSetRs485Mode(SPROX_CTX_ST* sprox_ctx, BOOL rs485_output);
 
+/* Devices that get the complete connection sequence when the probe finds nothing */
+static const char* SERIAL_LOOKUP_DEVICES[] = { "/dev/ttyUSB0", "/dev/ttyS0", "/dev/ttyS1" };
+
 /*
  * SerialLookup
  * ------------
  * Lookup for the SpringProx device trying every available serial devices
- * one after the other.
+ * (the serial devices are probed in parallel, see SPROX_EnumReaders ; if
+ * none answers, the usual devices below get SPROX_ReaderConnect afterwards).
  * If host has only one serial device, or if the SpringProx is always bound
  * to the same serial device, this function can be only an alias to
  * SerialOpen + SPROX_ReaderConnect
@@ -61,7 +77,6 @@ BOOL SerialLookup(SPROX_CTX_ST* sprox_ctx)
 			return TRUE;
 		SerialClose(sprox_ctx);
 	}
-	memset(&sprox_ctx->settings, 0, sizeof(sprox_ctx->settings));
 	if (SerialOpen(sprox_ctx, _T("FTDI:0403:6001"))) /* FTDI default ID */
 	{
 		if (SPROX_ReaderConnect(sprox_ctx) == MI_OK)
@@ -70,27 +85,47 @@ BOOL SerialLookup(SPROX_CTX_ST* sprox_ctx)
 	}
 #endif
 
-	/* Sample sequence can be something like that : */
-	if (SerialOpen(sprox_ctx, "/dev/ttyUSB0"))
-	{
-		if (SPROX_ReaderConnect(sprox_ctx) == MI_OK)
-			return TRUE;
-		SerialClose(sprox_ctx);
-	}
-	/* ... */
-	if (SerialOpen(sprox_ctx, "/dev/ttyS0"))
-	{
-		if (SPROX_ReaderConnect(sprox_ctx) == MI_OK)
-			return TRUE;
-		SerialClose(sprox_ctx);
-	}
-	if (SerialOpen(sprox_ctx, "/dev/ttyS1"))
+	/* Probe all the serial devices at once (see sprox_enum_linux.c), and */
+	/* connect to the first one where a reader has answered                */
 	{
-		if (SPROX_ReaderConnect(sprox_ctx) == MI_OK)
-			return TRUE;
-		SerialClose(sprox_ctx);
+		SPROX_READER_ENUM_ST readers[32];
+		WORD count = 0, i;
+		size_t j;
+
+		SPROX_API_CALL(EnumReaders) (readers, sizeof(readers) / sizeof(readers[0]), &count, SPROX_ENUM_LEGACY_SERIAL | SPROX_ENUM_ALL_DEVICES);
+
+		for (i = 0; i < count; i++)
+		{
+			if ((readers[i].rc != MI_OK) && (readers[i].rc != MI_POLLING))
+				continue;
+			if (SerialOpen(sprox_ctx, readers[i].device))
+			{
+				if (SPROX_ReaderConnect(sprox_ctx) == MI_OK)
+					return TRUE;
+				SerialClose(sprox_ctx);
+			}
+		}
+
+		/* The probe only speaks binary protocol, once, without resetting the */
+		/* reader : give the complete connection sequence (DTR/RTS reset, OSI */
+		/* and ASCII protocols) to the devices SerialLookup has always tried, */
+		/* not to every device of the host (2s or more each)                  */
+		for (j = 0; j < sizeof(SERIAL_LOOKUP_DEVICES) / sizeof(SERIAL_LOOKUP_DEVICES[0]); j++)
+		{
+			for (i = 0; i < count; i++)
+				if (!strcmp(readers[i].device, SERIAL_LOOKUP_DEVICES[j]))
+					break;
+			if ((i < count) && ((readers[i].rc == MI_OK) || (readers[i].rc == MI_POLLING) || (readers[i].rc == MI_SER_ACCESS_ERR)))
+				continue;
+			if (SerialOpen(sprox_ctx, SERIAL_LOOKUP_DEVICES[j]))
+			{
+				if (SPROX_ReaderConnect(sprox_ctx) == MI_OK)
+					return TRUE;
+				SerialClose(sprox_ctx);
+			}
+		}
 	}
-	/* ... */
+
 	return FALSE;
 }
 
@@ -108,6 +143,7 @@ BOOL SerialOpen(SPROX_CTX_ST* sprox_ctx, const TCHAR* device)
 		return FALSE;
 
 	sprox_ctx->com_options = 0;
+	sprox_ctx->com_lost = FALSE;
 
 	if (device == NULL)
 	{
@@ -191,7 +227,7 @@ void SerialClose(SPROX_CTX_ST* sprox_ctx)
 	if (sprox_ctx->com_handle >= 0)
 	{
 #ifndef SPROX_API_NO_FTDI
-		if (sprox_ctx->com_type == DEVICE_IS_USB)
+		if (sprox_ctx->com_ftdi != NULL)
 		{
 			FTDI_Close(sprox_ctx);
 		}
@@ -208,7 +244,8 @@ void SerialClose(SPROX_CTX_ST* sprox_ctx)
  * SerialSetBaudrate
  * -----------------
  * Configure the baudrate for the serial device
- * (UART shoul'd accept 38400bps or 115200bps, other baudrates not used)
+ * (UART shoul'd accept 38400bps or 115200bps ; up to 921600bps and more
+ * with recent readers, see SPROX_ReaderSetBaudrate)
  * Params :
  * - baudrate (38400bps or 115200bps or ...)
  * Returns :
@@ -218,35 +255,71 @@ void SerialClose(SPROX_CTX_ST* sprox_ctx)
  * - whatever the baudrate, the communication settings are 8 data bits, 1 stop bit,
  *   no parity, no flow control/
  * - if the UART doesn't support 115200bps, the SPROX_HIGH_BAUDRATE must be #undef
+ * - a baudrate that has no Bxxx constant is given to the driver as is (BOTHER) ;
+ *   if the driver refuses it, the port is left unchanged
  */
 BOOL SerialSetBaudrate(SPROX_CTX_ST* sprox_ctx, DWORD baudrate)
 {
 	struct termios newtio;
+	speed_t speed;
 
 	if (sprox_ctx == NULL)
 		return FALSE;
 
 #ifndef SPROX_API_NO_FTDI
-	if (sprox_ctx->com_type == DEVICE_IS_USB)
-		return FTDI_SetBaudrate(sprox_ctx, baudrate);
+	if (sprox_ctx->com_ftdi != NULL)
+	{
+		if (!FTDI_SetBaudrate(sprox_ctx, baudrate))
+			return FALSE;
+		sprox_ctx->com_baudrate = baudrate;
+		return TRUE;
+	}
 #endif
 
+	switch (baudrate)
+	{
+#ifdef B4000000
+	case 4000000: speed = B4000000; break;
+#endif
+#ifdef B3000000
+	case 3000000: speed = B3000000; break;
+#endif
+#ifdef B2000000
+	case 2000000: speed = B2000000; break;
+#endif
+#ifdef B1000000
+	case 1000000: speed = B1000000; break;
+#endif
+#ifdef B921600
+	case  921600: speed = B921600; break;
+#endif
+#ifdef B576000
+	case  576000: speed = B576000; break;
+#endif
+#ifdef B500000
+	case  500000: speed = B500000; break;
+#endif
+#ifdef B460800
+	case  460800: speed = B460800; break;
+#endif
+#ifdef B230400
+	case  230400: speed = B230400; break;
+#endif
+	case  115200: speed = B115200; break;
+	case   38400: speed = B38400; break;
+	case   19200: speed = B19200; break;
+	case    9600: speed = B9600; break;
+	case    4800: speed = B4800; break;
+	case    2400: speed = B2400; break;
+	case    1200: speed = B1200; break;
+	default: speed = 0; break;
+	}
+
 	bzero(&newtio, sizeof(newtio));
 	// CS8  = 8n1 (8bit,no parity,1 stopbit
 	// CLOCAL= local connection, no modem control
 	// CREAD  = enable receiving characters
-	newtio.c_cflag = CS8 | CLOCAL | CREAD;
-	switch (baudrate)
-	{
-	case 115200: newtio.c_cflag |= B115200; break;
-	case  38400: newtio.c_cflag |= B38400; break;
-	case  19200: newtio.c_cflag |= B19200; break;
-	case   9600: newtio.c_cflag |= B9600; break;
-	case   4800: newtio.c_cflag |= B4800; break;
-	case   2400: newtio.c_cflag |= B2400; break;
-	case   1200: newtio.c_cflag |= B1200; break;
-	default: return FALSE;
-	}
+	newtio.c_cflag = CS8 | CLOCAL | CREAD | speed;
 	newtio.c_iflag = IGNPAR | IGNBRK;
 	newtio.c_oflag = 0;
 
@@ -256,6 +329,21 @@ BOOL SerialSetBaudrate(SPROX_CTX_ST* sprox_ctx, DWORD baudrate)
 	newtio.c_cc[VTIME] = 0;       // inter-character timer unused
 	newtio.c_cc[VMIN] = 1;        // blocking read until 1 chars received
 
+	if (speed == 0)
+	{
+		/* Same settings, the rate is given as is (see sprox_baud_linux.c) */
+		tcflush(sprox_ctx->com_handle, TCIFLUSH);
+
+		if (SerialSetCustomBaudrate(sprox_ctx->com_handle, baudrate))
+		{
+			SPROX_Trace(TRACE_DLG_HI, "SetBaudrate: %d refused by the driver", baudrate);
+			return FALSE;
+		}
+
+		sprox_ctx->com_baudrate = baudrate;
+		return TRUE;
+	}
+
 	tcflush(sprox_ctx->com_handle, TCIFLUSH);
 
 	if (tcsetattr(sprox_ctx->com_handle, TCSANOW, &newtio))
@@ -265,6 +353,7 @@ BOOL SerialSetBaudrate(SPROX_CTX_ST* sprox_ctx, DWORD baudrate)
 		return FALSE;
 	}
 
+	sprox_ctx->com_baudrate = baudrate;
 	return TRUE;
 }
 
@@ -302,14 +391,18 @@ BOOL SendByte(SPROX_CTX_ST* sprox_ctx, BYTE b)
 	int done;
 
 #ifndef SPROX_API_NO_FTDI
-	if (sprox_ctx->com_type == DEVICE_IS_USB)
+	if (sprox_ctx->com_ftdi != NULL)
 		return FTDI_SendBurst(sprox_ctx, &b, 1);
 #endif
 
-	done = write(sprox_ctx->com_handle, &b, 1);
+	do
+	{
+		done = write(sprox_ctx->com_handle, &b, 1);
+	} while ((done < 0) && (errno == EINTR));
 	if (done <= 0)
 	{
 		perror("write");
+		sprox_ctx->com_lost = TRUE;
 		return FALSE;
 	}
 	D(printf("-%02X", b));
@@ -332,7 +425,7 @@ BOOL RecvByte(SPROX_CTX_ST* sprox_ctx, BYTE* b)
 	int     res, done;
 
 #ifndef SPROX_API_NO_FTDI
-	if (sprox_ctx->com_type == DEVICE_IS_USB)
+	if (sprox_ctx->com_ftdi != NULL)
 		return FTDI_RecvBurst(sprox_ctx, b, 1);
 #endif
 
@@ -342,14 +435,23 @@ BOOL RecvByte(SPROX_CTX_ST* sprox_ctx, BYTE* b)
 	FD_ZERO(&fdset);
 	FD_SET(sprox_ctx->com_handle, &fdset);
 
-	res = select(sprox_ctx->com_handle + 1, &fdset, NULL, NULL, &timeout);
+	/* Interrupted by a signal : wait again (Linux leaves the time remaining in timeout) */
+	do
+	{
+		res = select(sprox_ctx->com_handle + 1, &fdset, NULL, NULL, &timeout);
+	} while ((res < 0) && (errno == EINTR));
 
 	if (res > 0)
 	{
-		done = read(sprox_ctx->com_handle, b, 1);
+		do
+		{
+			done = read(sprox_ctx->com_handle, b, 1);
+		} while ((done < 0) && (errno == EINTR));
 		if (done < 1)
 		{
+			/* Readable but nothing to read : the device has been hung up */
 			perror("read");
+			sprox_ctx->com_lost = TRUE;
 			return FALSE;
 		}
 		D(printf("+%02X", *b);
@@ -364,6 +466,7 @@ BOOL RecvByte(SPROX_CTX_ST* sprox_ctx, BYTE* b)
 	else
 	{
 		perror("select");
+		sprox_ctx->com_lost = TRUE;
 		return FALSE;
 	}
 }
@@ -384,7 +487,7 @@ BOOL SendBurst(SPROX_CTX_ST* sprox_ctx, const BYTE* b, WORD len)
 	int offset;
 
 #ifndef SPROX_API_NO_FTDI
-	if (sprox_ctx->com_type == DEVICE_IS_USB)
+	if (sprox_ctx->com_ftdi != NULL)
 		return FTDI_SendBurst(sprox_ctx, b, len);
 #endif
 
@@ -393,9 +496,12 @@ BOOL SendBurst(SPROX_CTX_ST* sprox_ctx, const BYTE* b, WORD len)
 	while (tosend)
 	{
 		done = write(sprox_ctx->com_handle, &b[offset], tosend);
+		if ((done < 0) && (errno == EINTR))
+			continue;
 		if (done <= 0)
 		{
 			perror("write");
+			sprox_ctx->com_lost = TRUE;
 			return FALSE;
 		}
 		tosend -= done;
@@ -430,7 +536,7 @@ BOOL RecvBurst(SPROX_CTX_ST* sprox_ctx, BYTE* b, WORD len)
 	int offset;
 
 #ifndef SPROX_API_NO_FTDI
-	if (sprox_ctx->com_type == DEVICE_IS_USB)
+	if (sprox_ctx->com_ftdi != NULL)
 		return FTDI_RecvBurst(sprox_ctx, b, len);
 #endif
 
@@ -455,16 +561,24 @@ BOOL RecvBurst(SPROX_CTX_ST* sprox_ctx, BYTE* b, WORD len)
 			timeout.tv_usec = (sprox_ctx->sprox_timeout.byte_tmo % 1000) * 1000;
 		}
 
-		/* Wait */
-		res = select(sprox_ctx->com_handle + 1, &fdset, NULL, NULL, &timeout);
+		/* Wait (interrupted by a signal : wait again, for the time remaining) */
+		do
+		{
+			res = select(sprox_ctx->com_handle + 1, &fdset, NULL, NULL, &timeout);
+		} while ((res < 0) && (errno == EINTR));
 
 		if (res > 0)
 		{
 			/* Data available */
-			done = read(sprox_ctx->com_handle, &b[offset], torecv);
+			do
+			{
+				done = read(sprox_ctx->com_handle, &b[offset], torecv);
+			} while ((done < 0) && (errno == EINTR));
 			if (done <= 0)
 			{
+				/* Readable but nothing to read : the device has been hung up */
 				perror("read");
+				sprox_ctx->com_lost = TRUE;
 				return FALSE;
 			}
 			torecv -= done;
@@ -479,6 +593,7 @@ BOOL RecvBurst(SPROX_CTX_ST* sprox_ctx, BYTE* b, WORD len)
 		{
 			/* Select error */
 			perror("select");
+			sprox_ctx->com_lost = TRUE;
 			return FALSE;
 		}
 	}
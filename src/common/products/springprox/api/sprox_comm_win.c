@@ -36,6 +36,8 @@
    JDA 05/07/2005 : added SPROX_ReaderAttachHandle
    JDA 24/05/2006 : added support of multiple USB devices
    JDA 01/08/2007 : added a call to ResetUart after CreateFile and before CloseHandle
+   AGT 19/10/2026 : remember in com_lost that the device has failed, for the reconnect
+   AGT 19/10/2026 : remember the baudrate in com_baudrate
 
  */
 #include "sprox_api_i.h"
@@ -139,6 +141,7 @@ BOOL SerialOpen(SPROX_CTX_ST* sprox_ctx, const TCHAR* device)
 		return FALSE;
 
 	sprox_ctx->com_options = 0;
+	sprox_ctx->com_lost = FALSE;
 
 	if (device == NULL)
 	{
@@ -426,7 +429,8 @@ void SerialClose(SPROX_CTX_ST* sprox_ctx)
  * SerialSetBaudrate
  * -----------------
  * Configure the baudrate for the serial device
- * (UART shoul'd accept 38400bps or 115200bps, other baudrates not used)
+ * (UART shoul'd accept 38400bps or 115200bps ; up to 921600bps and more
+ * with recent readers, see SPROX_ReaderSetBaudrate)
  * Params :
  * - baudrate (38400bps or 115200bps or ...)
  * Returns :
@@ -521,6 +525,7 @@ BOOL SerialSetBaudrate(SPROX_CTX_ST* sprox_ctx, DWORD baudrate)
 	}
 
 	SPROX_Trace(TRACE_ACCESS, "Serial device configured at %ldbps", baudrate);
+	sprox_ctx->com_baudrate = baudrate;
 	return TRUE;
 }
 
@@ -610,6 +615,7 @@ BOOL SendByte(SPROX_CTX_ST* sprox_ctx, BYTE b)
 		if (!FT_W32_WriteFile(sprox_ctx->com_handle, &b, 1, &dwWritten, 0))
 		{
 			SPROX_Trace(TRACE_ACCESS, "FT_W32_WriteFile error (%d)", FT_W32_GetLastError(sprox_ctx->com_handle));
+			sprox_ctx->com_lost = TRUE;
 			return FALSE;
 		}
 
@@ -625,6 +631,7 @@ BOOL SendByte(SPROX_CTX_ST* sprox_ctx, BYTE b)
 			if (!WriteFile(sprox_ctx->com_handle, &b, 1, &dwWritten, 0))
 			{
 				SPROX_Trace(TRACE_ACCESS, "WriteFile(%d) error (%d)", 1, GetLastError());
+				sprox_ctx->com_lost = TRUE;
 				goto failed;
 			}
 
@@ -677,6 +684,7 @@ BOOL RecvByte(SPROX_CTX_ST* sprox_ctx, BYTE* b)
 		if (!FT_W32_ReadFile(sprox_ctx->com_handle, b, 1, &dwRead, 0))
 		{
 			SPROX_Trace(TRACE_ACCESS, "FT_W32_ReadFile failed (%d)", FT_W32_GetLastError(sprox_ctx->com_handle));
+			sprox_ctx->com_lost = TRUE;
 			return FALSE;
 		}
 #endif
@@ -687,6 +695,7 @@ BOOL RecvByte(SPROX_CTX_ST* sprox_ctx, BYTE* b)
 			if (!ReadFile(sprox_ctx->com_handle, b, 1, &dwRead, 0))
 			{
 				SPROX_Trace(TRACE_ACCESS, "ReadFile failed (%d)", GetLastError());
+				sprox_ctx->com_lost = TRUE;
 				return FALSE;
 			}
 		}
@@ -742,6 +751,7 @@ BOOL SendBurst(SPROX_CTX_ST* sprox_ctx, const BYTE* b, WORD len)
 			if (!FT_W32_WriteFile(sprox_ctx->com_handle, (void*)pSendBuffer, dwWriteLen, &dwWritten, 0))
 			{
 				SPROX_Trace(TRACE_ACCESS, "FT_W32_WriteFile failed (%d)", FT_W32_GetLastError(sprox_ctx->com_handle));
+				sprox_ctx->com_lost = TRUE;
 				return FALSE;
 			}
 
@@ -784,6 +794,7 @@ BOOL SendBurst(SPROX_CTX_ST* sprox_ctx, const BYTE* b, WORD len)
 				if (!WriteFile(sprox_ctx->com_handle, pSendBuffer, dwWriteLen, &dwWritten, 0))
 				{
 					SPROX_Trace(TRACE_ACCESS, "WriteFile(%d) error (%d)", dwWriteLen, GetLastError());
+					sprox_ctx->com_lost = TRUE;
 					goto failed;
 				}
 
@@ -862,6 +873,7 @@ BOOL RecvBurst(SPROX_CTX_ST* sprox_ctx, BYTE* b, WORD len)
 			if (!FT_W32_ReadFile(sprox_ctx->com_handle, pRecvBuffer, dwWantLen, &dwGotLen, 0))
 			{
 				SPROX_Trace(TRACE_ACCESS, "FT_W32_ReadFile failed (%d)", FT_W32_GetLastError(sprox_ctx->com_handle));
+				sprox_ctx->com_lost = TRUE;
 				return FALSE;
 			}
 
@@ -892,6 +904,7 @@ BOOL RecvBurst(SPROX_CTX_ST* sprox_ctx, BYTE* b, WORD len)
 				if (!ReadFile(sprox_ctx->com_handle, pRecvBuffer, dwWantLen, &dwGotLen, 0))
 				{
 					SPROX_Trace(TRACE_ACCESS, "ReadFile failed (%d)", GetLastError());
+					sprox_ctx->com_lost = TRUE;
 					return FALSE;
 				}
 
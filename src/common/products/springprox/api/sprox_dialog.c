@@ -33,6 +33,17 @@
    JDA 28/02/2012 : improved timeout handling
 					forget current protocol every time the reader is likely to have resetted
    JDA 16/07/2014 : added support for TCP C/S protocol
+   AGT 19/10/2026 : FunctionWaitResp counts its timeout on the monotonic clock, in ms
+   AGT 19/10/2026 : added SPROX_ReaderProbe for the enumeration
+   AGT 19/10/2026 : connection profile, fast re-open and transparent reconnect
+   AGT 19/10/2026 : added SPROX_ReaderSetBaudrate (above 115200bps), fallback on CRC errors
+   AGT 19/10/2026 : readers shared through the ref_share daemon, SPROX_ReaderLock and SPROX_ReaderUnlock
+   AGT 19/10/2026 : SPROX_ReaderLock waits up to SPROX_LOCK_WAIT_MAX, or SPROX_LOCK_WAIT_FOREVER
+   AGT 19/10/2026 : added SPROX_FunctionBatch and SPROX_ReaderSetPipeline, TCP on Linux
+   AGT 19/10/2026 : record of the traffic, and replay of a recording as a reader ("REPLAY:<file>")
+   AGT 19/10/2026 : a command is sent once more only when its sending has failed
+   AGT 19/10/2026 : rates above 115200bps only after SPROX_ReaderBaudrateHighEnable
+   AGT 19/10/2026 : the batches sent to a network reader are recorded, "REPLAY:" in any case
 
  */
 
@@ -55,6 +66,13 @@ DWORD DefaultSettingsAllowed = COM_BAUDRATE_38400 | COM_BAUDRATE_115200 | COM_PR
 
 #define SPROX_API_CAN_REPEAT
 
+/* Transparent reconnect, unless changed by SPROX_ReaderSetReconnect */
+#define SPROX_RECONNECT_TRIES     4    /* Attempts to open the device again            */
+#define SPROX_RECONNECT_DELAY_MS  100  /* Before the 2nd attempt, doubled at each one  */
+
+static SWORD SPROX_Function_Send(SPROX_CTX_ST* sprox_ctx, BYTE command, const BYTE* send_data, WORD send_len);
+static SWORD SPROX_Function_Recv(SPROX_CTX_ST* sprox_ctx, BYTE* sequence, BYTE* recv_data, WORD* recv_len);
+
 /*
  * Low layer protocol
  * ------------------
@@ -66,7 +84,7 @@ void RecvFlush(SPROX_CTX_ST* sprox_ctx)
 
 	SPROX_Trace(TRACE_DLG_HI, "<flush>");
 
-	SerialSetTimeouts(sprox_ctx, 0, INTER_BYTE_TMO);
+	SerialSetTimeouts(sprox_ctx, 0, SPROX_INTER_BYTE_TMO(sprox_ctx));
 	retry = 250;
 	while ((retry--) && (RecvByte(sprox_ctx, &b)));
 
@@ -355,6 +373,256 @@ SWORD SPROX_ReaderConnectAt(SPROX_CTX_ST* sprox_ctx, DWORD baudrate)
 	return rc;
 }
 
+/*
+ * Connection profile
+ * ------------------
+ * Once the reader has been found on a device, remember how to talk to it :
+ * opening the same device again is then only one Echo exchange.
+ */
+static void SPROX_ReaderSaveProfile(SPROX_CTX_ST* sprox_ctx)
+{
+	_tcsncpy(sprox_ctx->com_profile.com_name, sprox_ctx->com_name, sizeof(sprox_ctx->com_profile.com_name) / sizeof(TCHAR) - 1);
+	sprox_ctx->com_profile.com_name[sizeof(sprox_ctx->com_profile.com_name) / sizeof(TCHAR) - 1] = '\0';
+	sprox_ctx->com_profile.com_settings = sprox_ctx->com_settings;
+	sprox_ctx->com_profile.com_baudrate = sprox_ctx->com_baudrate;
+	memcpy(sprox_ctx->com_profile.sprox_info, &sprox_ctx->sprox_info, sizeof(sprox_ctx->com_profile.sprox_info));
+	sprox_ctx->com_profile.sprox_version = sprox_ctx->sprox_version;
+	sprox_ctx->com_profile.sprox_capabilities = sprox_ctx->sprox_capabilities;
+	sprox_ctx->com_profile.valid = TRUE;
+}
+
+/*
+ * Check the link with one Echo exchange
+ * -------------------------------------
+ */
+static SWORD SPROX_ReaderEchoCheck(SPROX_CTX_ST* sprox_ctx)
+{
+	BYTE  send_buffer[8];
+	BYTE  recv_buffer[8];
+	BYTE  recv_sequence;
+	WORD  l;
+	SWORD rc;
+	BYTE  i;
+
+	/* A pattern of our own, so an old answer can't be taken for the good one */
+	for (i = 0; i < sizeof(send_buffer); i++)
+		send_buffer[i] = (BYTE)(0xA5 ^ sprox_ctx->com_sequence ^ (i << 4));
+
+	rc = SPROX_Function_Send(sprox_ctx, SPROX_ECHO, send_buffer, sizeof(send_buffer));
+	if (rc != MI_OK)
+		return rc;
+
+	l = sizeof(recv_buffer);
+	rc = SPROX_Function_Recv(sprox_ctx, &recv_sequence, recv_buffer, &l);
+	if (rc != MI_OK)
+		return rc;
+	if ((recv_sequence != sprox_ctx->com_sequence) || (l != sizeof(send_buffer)) || memcmp(recv_buffer, send_buffer, l))
+		return MI_RESPONSE_INVALID;
+	sprox_ctx->com_sequence++;
+
+	return MI_OK;
+}
+
+/*
+ * Talk again to the reader known on the (just opened) device
+ * ----------------------------------------------------------
+ */
+static SWORD SPROX_ReaderResume(SPROX_CTX_ST* sprox_ctx)
+{
+	DWORD baudrate;
+	SWORD rc;
+
+	if (!sprox_ctx->com_profile.valid || _tcsicmp(sprox_ctx->com_profile.com_name, sprox_ctx->com_name))
+		return MI_SER_ACCESS_ERR;
+
+	sprox_ctx->com_settings = sprox_ctx->com_profile.com_settings;
+	baudrate = sprox_ctx->com_profile.com_baudrate;
+	if (!baudrate)
+		baudrate = (sprox_ctx->com_settings & COM_BAUDRATE_115200) ? 115200 : 38400;
+	if (!SerialSetBaudrate(sprox_ctx, baudrate))
+		return MI_SER_ACCESS_ERR;
+	RecvFlush(sprox_ctx);
+
+	rc = SPROX_ReaderEchoCheck(sprox_ctx);
+	if (rc != MI_OK)
+		return rc;
+
+	memcpy(&sprox_ctx->sprox_info, sprox_ctx->com_profile.sprox_info, sizeof(sprox_ctx->com_profile.sprox_info));
+	sprox_ctx->sprox_version = sprox_ctx->com_profile.sprox_version;
+	sprox_ctx->sprox_capabilities = sprox_ctx->com_profile.sprox_capabilities;
+
+	/* The reader may have resetted meanwhile */
+	sprox_ctx->pcd_current_rf_protocol = 0;
+	sprox_ctx->com_status = COM_STATUS_OPEN_ACTIVE;
+	return MI_OK;
+}
+
+/*
+ * Change the baudrate of the reader, then ours
+ * --------------------------------------------
+ * Up to 115200bps, SPROX_CONTROL_BAUDRATE takes the rate in kbit/s on one byte
+ * (38 or 115). Above, we send a 0 and the rate on 4 bytes, MSB first : this
+ * form is not documented, it is used only after SPROX_ReaderBaudrateHighEnable.
+ * The new rate is checked with one Echo exchange ; if the link doesn't work,
+ * we go back to the previous rate, where the reader shall be after its own
+ * timeout.
+ */
+static SWORD SPROX_ReaderSwitchBaudrate(SPROX_CTX_ST* sprox_ctx, DWORD baudrate)
+{
+	DWORD previous = sprox_ctx->com_baudrate;
+	BYTE  buffer[6];
+	WORD  length;
+	BYTE  recv_sequence;
+	SWORD rc;
+
+	/* Does our UART take this rate at all? */
+	if (!SerialSetBaudrate(sprox_ctx, baudrate))
+	{
+		SPROX_Trace(TRACE_DLG_HI, "Baudrate %lu not supported by the UART", baudrate);
+		if (!SerialSetBaudrate(sprox_ctx, previous))
+			return MI_SER_ACCESS_ERR;
+		return MI_FUNCTION_NOT_AVAILABLE;
+	}
+	if (!SerialSetBaudrate(sprox_ctx, previous))
+		return MI_SER_ACCESS_ERR;
+
+	buffer[0] = SPROX_CONTROL_BAUDRATE;
+	if ((baudrate == 38400) || (baudrate == 115200))
+	{
+		buffer[1] = (BYTE)(baudrate / 1000);
+		length = 2;
+	}
+	else
+	{
+		buffer[1] = 0;
+		buffer[2] = (BYTE)(baudrate >> 24);
+		buffer[3] = (BYTE)(baudrate >> 16);
+		buffer[4] = (BYTE)(baudrate >> 8);
+		buffer[5] = (BYTE)baudrate;
+		length = 6;
+	}
+
+	rc = SPROX_Function_Send(sprox_ctx, SPROX_CONTROL, buffer, length);
+	if (rc != MI_OK)
+		return rc;
+	rc = SPROX_Function_Recv(sprox_ctx, &recv_sequence, NULL, NULL);
+	sprox_ctx->com_sequence++;
+
+	/* The reader may answer already at the new rate */
+	if ((rc != MI_OK) && (rc != MI_SER_CHECKSUM_ERR) && (rc != MI_SER_PROTO_ERR) && (rc != MI_SER_TIMEOUT_ERR))
+	{
+		SPROX_Trace(TRACE_DLG_HI, "Reader refused %lubps (%d)", baudrate, rc);
+		return rc;
+	}
+
+	/* Give reader at least 25ms for UART reset */
+	Sleep(25);
+
+	if (SerialSetBaudrate(sprox_ctx, baudrate))
+	{
+		RecvFlush(sprox_ctx);
+		rc = SPROX_ReaderEchoCheck(sprox_ctx);
+		if (rc == MI_OK)
+		{
+			sprox_ctx->com_settings &= ~COM_BAUDRATE_MASK;
+			sprox_ctx->com_settings |= (baudrate == 38400) ? COM_BAUDRATE_38400 : COM_BAUDRATE_115200;
+			sprox_ctx->com_crc_errors = 0;
+			if (sprox_ctx->com_profile.valid)
+				SPROX_ReaderSaveProfile(sprox_ctx);
+			SPROX_Trace(TRACE_DLG_HI, "Reader now at %lubps", baudrate);
+			return MI_OK;
+		}
+	}
+	else
+		rc = MI_SER_ACCESS_ERR;
+
+	SPROX_Trace(TRACE_DLG_HI, "No link at %lubps (%d), back to %lubps", baudrate, rc, previous);
+
+	Sleep(RESPONSE_TMO);
+	if (!SerialSetBaudrate(sprox_ctx, previous))
+		return MI_SER_ACCESS_ERR;
+	RecvFlush(sprox_ctx);
+	if (SPROX_ReaderEchoCheck(sprox_ctx) != MI_OK)
+		sprox_ctx->com_lost = TRUE; /* Let SPROX_ReaderReconnect find it again */
+
+	return rc;
+}
+
+/*
+ * Too many CRC errors : go down one step
+ * --------------------------------------
+ */
+#define SPROX_BAUDRATE_CRC_ERRORS 3
+
+static void SPROX_ReaderBaudrateFallback(SPROX_CTX_ST* sprox_ctx)
+{
+	static const DWORD steps[] = { 921600, 460800, 230400, 115200 };
+	DWORD current = sprox_ctx->com_baudrate;
+	BYTE  i;
+
+	sprox_ctx->com_crc_errors = 0;
+
+	for (i = 0; i < sizeof(steps) / sizeof(steps[0]); i++)
+	{
+		if (steps[i] < current)
+		{
+			SPROX_Trace(TRACE_ACCESS, "Too many CRC errors at %lubps, going down to %lubps", current, steps[i]);
+			if (SPROX_ReaderSwitchBaudrate(sprox_ctx, steps[i]) == MI_OK)
+				return;
+			current = sprox_ctx->com_baudrate;
+		}
+	}
+}
+
+/*
+ * Open the device again after it has failed, and talk again to the reader
+ * -----------------------------------------------------------------------
+ * Bounded number of attempts, with a growing delay between them
+ */
+SWORD SPROX_ReaderReconnect(SPROX_CTX_ST* sprox_ctx)
+{
+	BYTE  tries = SPROX_RECONNECT_TRIES;
+	WORD  delay_ms = SPROX_RECONNECT_DELAY_MS;
+	DWORD started_ms = SPROX_GetMonotonicMs();
+	SWORD rc = MI_SER_ACCESS_ERR;
+	BYTE  i;
+
+	if (sprox_ctx->reconnect_set)
+	{
+		tries = sprox_ctx->reconnect_tries;
+		delay_ms = sprox_ctx->reconnect_delay_ms;
+	}
+
+	if (!sprox_ctx->com_profile.valid)
+		return MI_SER_ACCESS_ERR;
+
+	for (i = 0; i < tries; i++)
+	{
+		if (i)
+		{
+			Sleep(delay_ms);
+			if (delay_ms < 1000)
+				delay_ms *= 2;
+		}
+
+		SerialClose(sprox_ctx);
+		if (!SerialOpen(sprox_ctx, sprox_ctx->com_profile.com_name))
+			continue;
+
+		rc = SPROX_ReaderResume(sprox_ctx);
+		if (rc == MI_OK)
+		{
+			SPROX_Trace(TRACE_ACCESS, "Reconnected to %s in %lums (%d attempt(s))", _ST(sprox_ctx->com_name), SPROX_GetMonotonicMs() - started_ms, i + 1);
+			return MI_OK;
+		}
+	}
+
+	SPROX_Trace(TRACE_ACCESS, "Reconnect to %s failed after %lums, rc=%d", _ST(sprox_ctx->com_profile.com_name), SPROX_GetMonotonicMs() - started_ms, rc);
+	SerialClose(sprox_ctx);
+	sprox_ctx->com_status = COM_STATUS_CLOSED_BUT_SEEN;
+	return MI_SER_ACCESS_ERR;
+}
+
 /*
  * Try to establish dialog with the reader, trying both baudrates
  * --------------------------------------------------------------
@@ -549,6 +817,7 @@ SWORD SPROX_ReaderConnect(SPROX_CTX_ST* sprox_ctx)
 
 success:
 	sprox_ctx->com_status = COM_STATUS_OPEN_ACTIVE;
+	SPROX_ReaderSaveProfile(sprox_ctx);
 	return MI_OK;
 }
 
@@ -685,14 +954,19 @@ time_extension:
 }
 
 
-SPROX_API_FUNC(Function) (SPROX_PARAM  BYTE command, const BYTE* send_data, WORD send_len, BYTE* recv_data, WORD* recv_len)
+static SWORD SPROX_Function_Exchange(SPROX_CTX_ST* sprox_ctx, BYTE command, const BYTE* send_data, WORD send_len, BYTE* recv_data, WORD* recv_len)
 {
 	SWORD rc, first_rc = MI_OK;
 	BYTE  recv_sequence;
 	BYTE  retry = 3;
 	WORD  first_recv_len = 0;
+	BOOL  reconnected = FALSE;
+	BOOL  crc_error = FALSE;
 
-	SPROX_PARAM_TO_CTX;
+	if ((sprox_ctx->com_settings & COM_INTERFACE_MASK) == COM_INTERFACE_REPLAY)
+	{
+		return SPROX_Replay_Function(sprox_ctx, SPROX_RECORD_FUNCTION, command, send_data, send_len, recv_data, recv_len);
+	}
 
 #ifdef SPROX_API_WITH_TCP
 	if ((sprox_ctx->com_settings & COM_INTERFACE_MASK) == COM_INTERFACE_TCP)
@@ -701,6 +975,13 @@ SPROX_API_FUNC(Function) (SPROX_PARAM  BYTE command, const BYTE* send_data, WORD
 	}
 #endif
 
+#ifdef SPROX_API_WITH_SHARE
+	if ((sprox_ctx->com_settings & COM_INTERFACE_MASK) == COM_INTERFACE_SHARE)
+	{
+		return SPROX_Share_Function(sprox_ctx, command, send_data, send_len, recv_data, recv_len);
+	}
+#endif
+
 #ifdef SPROX_API_WITH_BRCD
 	if (sprox_ctx->settings.brcd)
 	{
@@ -713,7 +994,17 @@ SPROX_API_FUNC(Function) (SPROX_PARAM  BYTE command, const BYTE* send_data, WORD
 	/* Send the command */
 send_command:
 	rc = SPROX_Function_Send(sprox_ctx, command, send_data, send_len);
-	if (rc != MI_OK) return rc;
+	if (rc != MI_OK)
+	{
+		/* The device has gone away (USB unplugged...) : open it again, and send once more */
+		if (sprox_ctx->com_lost && (sprox_ctx->com_status >= COM_STATUS_OPEN_ACTIVE) && !reconnected)
+		{
+			reconnected = TRUE;
+			if (SPROX_ReaderReconnect(sprox_ctx) == MI_OK)
+				goto send_command;
+		}
+		return rc;
+	}
 
 	/* Retrieve the answer */
 recv_answer:
@@ -721,6 +1012,20 @@ recv_answer:
 
 	if (rc != MI_OK)
 	{
+		/* The device has gone away while we were waiting for the answer : the  */
+		/* command may have been executed already, so it is not sent once more */
+		/* (the reader is opened again for the next one)                      */
+		if (sprox_ctx->com_lost && (sprox_ctx->com_status >= COM_STATUS_OPEN_ACTIVE))
+		{
+			if (recv_len != NULL) *recv_len = 0;
+			if (SPROX_ReaderReconnect(sprox_ctx) != MI_OK)
+				return MI_SER_ACCESS_ERR;
+			return MI_SER_NORESP_ERR;
+		}
+
+		if (rc == MI_SER_CHECKSUM_ERR)
+			crc_error = TRUE;
+
 		/* Error in receive function */
 		if (first_rc == MI_OK)
 			first_rc = rc; /* Remember first error code */
@@ -775,34 +1080,128 @@ recv_answer:
 				if (recv_len != NULL) *recv_len = first_recv_len;
 				goto send_command;
 			}
-			return MI_SER_PROTO_ERR;
+			rc = MI_SER_PROTO_ERR;
+			goto check_link;
 		}
 	}
 
 	/* Next sequence */
 	sprox_ctx->com_sequence++;
 
+check_link:
+	/* Link too noisy for the high baudrate? */
+	if (sprox_ctx->com_baudrate > 115200)
+	{
+		if (!crc_error)
+			sprox_ctx->com_crc_errors = 0;
+		else if (++sprox_ctx->com_crc_errors >= SPROX_BAUDRATE_CRC_ERRORS)
+			SPROX_ReaderBaudrateFallback(sprox_ctx);
+	}
+
 	/* Return the status code */
 	return rc;
 }
 
+/*
+ * Send a command whose answer is for the thread that is already waiting
+ * for an answer (SPROX_FunctionWaitResp), see SPROX_FindWaitCancel
+ * ----------------------------------------------------------------------
+ */
+SWORD SPROX_Function_SendOnly(SPROX_CTX_ST* sprox_ctx, BYTE command)
+{
+	SWORD rc;
+
+	assert(sprox_ctx != NULL);
+
+	rc = SPROX_Function_Send(sprox_ctx, command, NULL, 0);
+	sprox_ctx->com_sequence++;
+	return rc;
+}
+
+/*
+ * Drop the late answer to a command sent by SPROX_Function_SendOnly
+ * -----------------------------------------------------------------
+ */
+void SPROX_Function_Drain(SPROX_CTX_ST* sprox_ctx)
+{
+	BYTE b;
+
+	assert(sprox_ctx != NULL);
+
+	SerialSetTimeouts(sprox_ctx, 100, SPROX_INTER_BYTE_TMO(sprox_ctx));
+	if (RecvByte(sprox_ctx, &b))
+		RecvFlush(sprox_ctx);
+}
+
+SPROX_API_FUNC(Function) (SPROX_PARAM  BYTE command, const BYTE* send_data, WORD send_len, BYTE* recv_data, WORD* recv_len)
+{
+	SWORD rc;
+	SPROX_PARAM_TO_CTX;
+
+	if (sprox_ctx->record == NULL)
+		return SPROX_Function_Exchange(sprox_ctx, command, send_data, send_len, recv_data, recv_len);
+
+	/* Write the exchange to the recording, see sprox_record.c */
+	SPROX_Record_Begin(sprox_ctx);
+	rc = SPROX_Function_Exchange(sprox_ctx, command, send_data, send_len, recv_data, recv_len);
+	SPROX_Record_End(sprox_ctx, SPROX_RECORD_FUNCTION, command, send_data, send_len, rc, recv_data, recv_len);
+	return rc;
+}
+
+/*
+ * Ask a reader for its version, at the specified baudrate
+ * -------------------------------------------------------
+ * Only the context given as parameter is used (never the global one), and
+ * only the binary protocol is tried, once : this is how the enumeration
+ * looks for the readers on many devices at the same time.
+ */
+SWORD SPROX_ReaderProbe(SPROX_CTX_ST* sprox_ctx, DWORD baudrate)
+{
+	BYTE  recv_sequence;
+	WORD  l;
+	SWORD rc;
+
+	assert(sprox_ctx != NULL);
+
+	sprox_ctx->com_settings &= ~COM_PROTO_MASK;
+	sprox_ctx->com_settings |= COM_PROTO_BIN;
+
+	if (!SerialSetBaudrate(sprox_ctx, baudrate))
+		return MI_SER_ACCESS_ERR;
+
+	rc = SPROX_Function_Send(sprox_ctx, SPROX_CSB_GET_INFOS, NULL, 0);
+	if (rc != MI_OK)
+		return rc;
+
+	l = sizeof(sprox_ctx->sprox_info);
+	rc = SPROX_Function_Recv(sprox_ctx, &recv_sequence, (BYTE*)&sprox_ctx->sprox_info, &l);
+	if (rc == MI_UNKNOWN_FUNCTION)
+	{
+		l = 0;
+		rc = MI_OK;
+	}
+	if ((rc == MI_OK) && (recv_sequence != sprox_ctx->com_sequence))
+		rc = MI_SER_PROTO_ERR;
+	if (rc != MI_OK)
+		return rc;
+
+	sprox_ctx->com_sequence++;
+	SPROX_ReaderSetInfo(sprox_ctx, l);
+	return MI_OK;
+}
+
 /* New 1.54 */
 SPROX_API_FUNC(FunctionWaitResp) (SPROX_PARAM  BYTE* recv_data, WORD* recv_len, WORD timeout_s)
 {
 	SWORD rc;
 	BYTE recv_sequence;
-	time_t wait_until = 0;
+	DWORD started_ms = SPROX_GetMonotonicMs();
 	SPROX_PARAM_TO_CTX;
 
-	if (timeout_s != 0xFFFF)
-	{
-#ifndef UNDER_CE	
-		wait_until = time(NULL);
-		wait_until += timeout_s + 1;
-#else
-		return MI_LIB_CALL_ERROR;
-#endif
-	}
+	if ((sprox_ctx->com_settings & COM_INTERFACE_MASK) == COM_INTERFACE_REPLAY)
+		return SPROX_Replay_Function(sprox_ctx, SPROX_RECORD_WAIT_RESP, 0, NULL, 0, recv_data, recv_len);
+
+	SPROX_Record_Begin(sprox_ctx);
 
 	for (;;)
 	{
@@ -811,15 +1210,91 @@ SPROX_API_FUNC(FunctionWaitResp) (SPROX_PARAM  BYTE* recv_data, WORD* recv_len,
 		if (rc != MI_SER_NORESP_ERR)
 			break;
 
-#ifndef UNDER_CE	
-		if ((wait_until != 0) && (wait_until < time(NULL)))
+		/* Give the reader one more second to answer after its own timeout */
+		if ((timeout_s != 0xFFFF) && ((SPROX_GetMonotonicMs() - started_ms) > (timeout_s + 1) * 1000UL))
 			break;
-#endif
 	}
 
+	SPROX_Record_End(sprox_ctx, SPROX_RECORD_WAIT_RESP, 0, NULL, 0, rc, recv_data, recv_len);
 	return rc;
 }
 
+/**f* SpringProx.API/SPROX_FunctionBatch
+ *
+ * NAME
+ *   SPROX_FunctionBatch
+ *
+ * DESCRIPTION
+ *   Send several raw commands to the reader, and receive their responses
+ *
+ * INPUTS
+ *   SPROX_FUNCTION_ST functions[] : the commands, with room for their responses
+ *   WORD count         : number of commands
+ *
+ * RETURNS
+ *   MI_OK              : every command has been exchanged with the reader, its
+ *                        own status is in functions[i].rc
+ *   Other code if internal or communication error has occured ; the commands
+ *   that have not been exchanged get this code as status.
+ *
+ * NOTES
+ *   Every command is sent, even if an earlier one has failed : only put in a
+ *   batch commands that don't depend on each other (reading a list of blocks
+ *   on a card that is already selected...).
+ *   With a network reader ("TCP:host") and SPROX_ReaderSetPipeline, the next
+ *   commands are sent before the answers to the first ones have come back.
+ *
+ * SEE ALSO
+ *   SPROX_Function
+ *   SPROX_ReaderSetPipeline
+ *
+ **/
+SPROX_API_FUNC(FunctionBatch) (SPROX_PARAM  SPROX_FUNCTION_ST functions[], WORD count)
+{
+	SWORD rc;
+	WORD i;
+	SPROX_PARAM_TO_CTX;
+
+	if ((functions == NULL) && count)
+		return MI_LIB_CALL_ERROR;
+
+#ifdef SPROX_API_WITH_TCP
+	if ((sprox_ctx->com_settings & COM_INTERFACE_MASK) == COM_INTERFACE_TCP)
+	{
+		if (sprox_ctx->record == NULL)
+			return SPROX_TCP_FunctionBatch(sprox_ctx, functions, count);
+
+		/* Write the functions to the recording, up to the one the link has failed on (see sprox_record.c) */
+		SPROX_Record_Begin(sprox_ctx);
+		rc = SPROX_TCP_FunctionBatch(sprox_ctx, functions, count);
+		for (i = 0; i < count; i++)
+			if ((rc != MI_OK) && (functions[i].rc == rc))
+			{
+				i++;
+				break;
+			}
+		SPROX_Record_EndBatch(sprox_ctx, functions, i);
+		return rc;
+	}
+#endif
+
+	for (i = 0; i < count; i++)
+	{
+		rc = SPROX_API_CALL(Function) (SPROX_PARAM_P  functions[i].cmd, functions[i].send_buffer, functions[i].send_bytelen, functions[i].recv_buffer, &functions[i].recv_bytelen);
+		functions[i].rc = rc;
+
+		/* No use to go on if the link with the reader has failed */
+		if ((rc <= MI_SER_LENGTH_ERR) && (rc >= MI_SER_NORESP_ERR) && (rc != MI_SER_PROTO_NAK))
+		{
+			for (i++; i < count; i++)
+				functions[i].rc = rc;
+			return rc;
+		}
+	}
+
+	return MI_OK;
+}
+
 SPROX_API_FUNC(ReaderOpenAuto) (SPROX_PARAM_V)
 {
 	SPROX_PARAM_TO_CTX;
@@ -874,9 +1349,41 @@ SPROX_API_FUNC(ReaderOpenAuto) (SPROX_PARAM_V)
  *
  *   For Pocket PC, device must remain NULL. The CF module is implicitly powered up.
  *
+ *   "REPLAY:<file>" replays a recording made with SPROX_RecordStart. When
+ *   SPROX_REPLAY=<file> is set in the environment, the recording is replayed
+ *   whatever the device ; when SPROX_RECORD=<file> is set, the traffic with
+ *   the reader is recorded (see sprox_record.c).
+ *
  **/
 
+static SWORD SPROX_ReaderOpenDevice(SPROX_PARAM  const TCHAR device[]);
+
 SPROX_API_FUNC(ReaderOpen) (SPROX_PARAM  const TCHAR device[])
+{
+	const char* filename;
+	SWORD rc;
+	SPROX_PARAM_TO_CTX;
+
+	/* Replay instead of the reader, whatever the application opens */
+	filename = getenv("SPROX_REPLAY");
+	if ((filename != NULL) && (filename[0] != '\0'))
+	{
+		if (sprox_ctx->com_status > COM_STATUS_CLOSED_BUT_SEEN)
+			SPROX_API_CALL(ReaderClose) (SPROX_PARAM_PV);
+		return SPROX_Replay_ReaderOpen(sprox_ctx, filename, TRUE);
+	}
+
+	rc = SPROX_ReaderOpenDevice(SPROX_PARAM_P  device);
+
+	/* Record what the application does with the reader */
+	filename = getenv("SPROX_RECORD");
+	if ((rc == MI_OK) && (sprox_ctx->record == NULL) && (filename != NULL) && (filename[0] != '\0'))
+		SPROX_Record_Start(sprox_ctx, filename, TRUE);
+
+	return rc;
+}
+
+static SWORD SPROX_ReaderOpenDevice(SPROX_PARAM  const TCHAR device[])
 {
 	SPROX_PARAM_TO_CTX;
 
@@ -913,11 +1420,19 @@ SPROX_API_FUNC(ReaderOpen) (SPROX_PARAM  const TCHAR device[])
 	SPROX_Trace(TRACE_DLG_HI, "Set settings to %08lX, allowed=%08lX", sprox_ctx->com_settings, sprox_ctx->com_settings_allowed);
 
 	/* Non-serial devices */
+	if (!_tcsncicmp(device, _T("REPLAY:"), 7))
+		return SPROX_Replay_ReaderOpen(sprox_ctx, _ST(&device[7]), FALSE);
+
 #ifdef SPROX_API_WITH_TCP
 	if (!_tcsncicmp(device, _T("TCP:"), 4))
 		return SPROX_TCP_ReaderOpen(sprox_ctx, &device[4]);
 #endif
 
+#ifdef SPROX_API_WITH_SHARE
+	if (!_tcsncmp(device, _T("SHARE"), 5) && ((device[5] == '\0') || (device[5] == ':')))
+		return SPROX_Share_ReaderOpen(sprox_ctx, (device[5] == ':') ? &device[6] : NULL);
+#endif
+
 #ifdef SPROX_API_WITH_BRCD
 	if (!_tcsncicmp(device, _T("BARACODA"), 8))
 	{
@@ -935,6 +1450,14 @@ SPROX_API_FUNC(ReaderOpen) (SPROX_PARAM  const TCHAR device[])
 		return MI_SER_ACCESS_ERR;
 	}
 
+	/* Reader already seen on this device? One exchange is enough to be sure it's still there */
+	if (SPROX_ReaderResume(sprox_ctx) == MI_OK)
+	{
+		SPROX_Trace(TRACE_ACCESS, "ReaderOpen OK (known reader)");
+		return MI_OK;
+	}
+	sprox_ctx->com_settings = DefaultSettingsForced;
+
 	/* Try to connect to the specified device */
 	if (SPROX_ReaderConnect(sprox_ctx) != MI_OK)
 	{
@@ -1019,15 +1542,312 @@ SPROX_API_FUNC(ReaderClose) (SPROX_PARAM_V)
 		}
 		else
 #endif  
+#ifdef SPROX_API_WITH_SHARE
+		if ((sprox_ctx->com_settings & COM_INTERFACE_MASK) == COM_INTERFACE_SHARE)
+		{
+			SPROX_Share_ReaderClose(sprox_ctx);
+		}
+		else
+#endif
+		if ((sprox_ctx->com_settings & COM_INTERFACE_MASK) == COM_INTERFACE_REPLAY)
+		{
+			SPROX_Replay_ReaderClose(sprox_ctx);
+		}
+		else
 		{
 			SerialClose(sprox_ctx);
 		}
 	}
 
+	SPROX_Record_Stop(sprox_ctx, FALSE);
+
 	sprox_ctx->com_status = COM_STATUS_CLOSED_BUT_SEEN;
 	return MI_OK;
 }
 
+/**f* SpringProx.API/SPROX_ReaderSetReconnect
+ *
+ * NAME
+ *   SPROX_ReaderSetReconnect
+ *
+ * DESCRIPTION
+ *   Tell how the library opens the device again when it fails during an
+ *   exchange (USB reader unplugged and plugged again...)
+ *
+ * INPUTS
+ *   BYTE tries         : attempts to open the device again (0 to disable the reconnect)
+ *   WORD delay_ms      : delay before the second attempt, doubled at each attempt
+ *                        (up to 1s)
+ *
+ * RETURNS
+ *   MI_OK              : success
+ *
+ * NOTES
+ *   By default the library makes 4 attempts, in about 0.7s, the first one at once.
+ *   When the device has failed while the command was being sent, the command
+ *   is sent again (once) after the reconnect. When it has failed while the
+ *   library was waiting for the answer, the command may have run already : it
+ *   is not sent again, the function returns MI_SER_NORESP_ERR once the reader
+ *   is back (MI_SER_ACCESS_ERR if it is not). The reader has usually been
+ *   resetted anyway, so the card has to be selected again.
+ *   The reader is checked with one Echo exchange, using the protocol and the
+ *   baudrate that SPROX_ReaderOpen has found the first time. Calling
+ *   SPROX_ReaderOpen again on the same device takes the same fast path.
+ *
+ **/
+SPROX_API_FUNC(ReaderSetReconnect) (SPROX_PARAM  BYTE tries, WORD delay_ms)
+{
+	SPROX_PARAM_TO_CTX;
+
+	sprox_ctx->reconnect_tries = tries;
+	sprox_ctx->reconnect_delay_ms = delay_ms;
+	sprox_ctx->reconnect_set = TRUE;
+	return MI_OK;
+}
+
+/**f* SpringProx.API/SPROX_ReaderSetBaudrate
+ *
+ * NAME
+ *   SPROX_ReaderSetBaudrate
+ *
+ * DESCRIPTION
+ *   Change the baudrate of the serial link with the reader
+ *
+ * INPUTS
+ *   DWORD baudrate     : 38400, 115200, 230400, 460800, 921600, or any other
+ *                        rate that both the reader and the UART take
+ *
+ * RETURNS
+ *   MI_OK                     : success, the link works at the new baudrate
+ *   MI_FUNCTION_NOT_AVAILABLE : the reader or the UART doesn't support this baudrate
+ *   Other code if internal or communication error has occured.
+ *
+ * NOTES
+ *   Only with the binary protocol, on a serial or USB (FTDI) device.
+ *   Above 115200bps, the application must have called
+ *   SPROX_ReaderBaudrateHighEnable first.
+ *   The new baudrate is checked with one Echo exchange ; on failure, the library
+ *   goes back to the previous one.
+ *   Above 115200bps, after 3 functions in a row with CRC errors the library
+ *   goes down one step (921600, 460800, 230400, 115200bps) by itself : use
+ *   SPROX_ReaderGetBaudrate to know the current baudrate.
+ *
+ * SEE ALSO
+ *   SPROX_ReaderGetBaudrate
+ *   SPROX_ReaderBaudrateHighEnable
+ *
+ **/
+SPROX_API_FUNC(ReaderSetBaudrate) (SPROX_PARAM  DWORD baudrate)
+{
+	SPROX_PARAM_TO_CTX;
+
+	if (sprox_ctx->com_status < COM_STATUS_OPEN_ACTIVE)
+		return MI_SER_ACCESS_ERR;
+
+#ifdef SPROX_API_WITH_TCP
+	if ((sprox_ctx->com_settings & COM_INTERFACE_MASK) == COM_INTERFACE_TCP)
+		return MI_FUNCTION_NOT_AVAILABLE;
+#endif
+#ifdef SPROX_API_WITH_SHARE
+	if ((sprox_ctx->com_settings & COM_INTERFACE_MASK) == COM_INTERFACE_SHARE)
+		return MI_FUNCTION_NOT_AVAILABLE;
+#endif
+	if ((sprox_ctx->com_settings & COM_INTERFACE_MASK) == COM_INTERFACE_REPLAY)
+		return MI_FUNCTION_NOT_AVAILABLE;
+	if (!(sprox_ctx->com_settings & COM_PROTO_BIN))
+		return MI_FUNCTION_NOT_AVAILABLE;
+
+	if (baudrate == sprox_ctx->com_baudrate)
+		return MI_OK;
+
+	if ((baudrate > 115200) && !sprox_ctx->com_baudrate_high_enable)
+		return MI_FUNCTION_NOT_AVAILABLE;
+	if ((baudrate >= 115200) && !(sprox_ctx->sprox_capabilities & SPROX_WITH_BAUDRATE_115200))
+		return MI_FUNCTION_NOT_AVAILABLE;
+	if ((baudrate < 115200) && (baudrate != 38400))
+		return MI_FUNCTION_NOT_AVAILABLE;
+
+	return SPROX_ReaderSwitchBaudrate(sprox_ctx, baudrate);
+}
+
+/**f* SpringProx.API/SPROX_ReaderGetBaudrate
+ *
+ * NAME
+ *   SPROX_ReaderGetBaudrate
+ *
+ * DESCRIPTION
+ *   Current baudrate of the serial link with the reader
+ *
+ * INPUTS
+ *   DWORD *baudrate    : current baudrate (0 if not a serial link)
+ *
+ * RETURNS
+ *   MI_OK              : success
+ *
+ * SEE ALSO
+ *   SPROX_ReaderSetBaudrate
+ *
+ **/
+SPROX_API_FUNC(ReaderGetBaudrate) (SPROX_PARAM  DWORD* baudrate)
+{
+	SPROX_PARAM_TO_CTX;
+
+	if (baudrate == NULL)
+		return MI_LIB_CALL_ERROR;
+
+	*baudrate = sprox_ctx->com_baudrate;
+	return MI_OK;
+}
+
+/**f* SpringProx.API/SPROX_ReaderBaudrateHighEnable
+ *
+ * NAME
+ *   SPROX_ReaderBaudrateHighEnable
+ *
+ * DESCRIPTION
+ *   Let SPROX_ReaderSetBaudrate go above 115200bps
+ *
+ * INPUTS
+ *   BOOL enable        : TRUE to allow the rates above 115200bps, FALSE to
+ *                        stay at 38400 or 115200bps (default)
+ *
+ * RETURNS
+ *   MI_OK              : success
+ *
+ * NOTES
+ *   Above 115200bps, SPROX_CONTROL_BAUDRATE is sent with a 0 and the rate on
+ *   4 bytes. This form is not part of the documented command set of the
+ *   readers, and no capability bit tells which firmware takes it : enable it
+ *   only for a firmware known to implement it. A reader that doesn't is left
+ *   at its current rate (MI_UNKNOWN_FUNCTION, or no link at the new rate and
+ *   back to the previous one).
+ *
+ * SEE ALSO
+ *   SPROX_ReaderSetBaudrate
+ *
+ **/
+SPROX_API_FUNC(ReaderBaudrateHighEnable) (SPROX_PARAM  BOOL enable)
+{
+	SPROX_PARAM_TO_CTX;
+
+	sprox_ctx->com_baudrate_high_enable = enable;
+	return MI_OK;
+}
+
+/**f* SpringProx.API/SPROX_ReaderLock
+ *
+ * NAME
+ *   SPROX_ReaderLock
+ *
+ * DESCRIPTION
+ *   Take the shared reader for this application only, for a whole card
+ *   transaction
+ *
+ * INPUTS
+ *   DWORD wait_ms      : how long to wait for the applications that hold the
+ *                        reader already (ms), up to SPROX_LOCK_WAIT_MAX (one
+ *                        day, longer waits are shortened), or
+ *                        SPROX_LOCK_WAIT_FOREVER
+ *
+ * RETURNS
+ *   MI_OK              : success, the other applications have to wait
+ *   MI_READER_BUSY     : another application has kept the reader for wait_ms
+ *   Other code if internal or communication error has occured.
+ *
+ * NOTES
+ *   Only matters with a reader opened through the ref_share daemon
+ *   (SPROX_ReaderOpen("SHARE") or SPROX_ReaderOpen("SHARE:<socket>")) ; with
+ *   any other reader the function does nothing.
+ *   The daemon serves the applications that wait for the lock in order. It
+ *   takes the lock back (and resets the RF field) when the application closes
+ *   its connection, or stays more than 5s without any command.
+ *
+ * SEE ALSO
+ *   SPROX_ReaderUnlock
+ *
+ **/
+SPROX_API_FUNC(ReaderLock) (SPROX_PARAM  DWORD wait_ms)
+{
+	SPROX_PARAM_TO_CTX;
+
+#ifdef SPROX_API_WITH_SHARE
+	if ((sprox_ctx->com_settings & COM_INTERFACE_MASK) == COM_INTERFACE_SHARE)
+		return SPROX_Share_Lock(sprox_ctx, wait_ms);
+#endif
+
+	UNUSED_PARAMETER(sprox_ctx);
+	UNUSED_PARAMETER(wait_ms);
+	return MI_OK;
+}
+
+/**f* SpringProx.API/SPROX_ReaderUnlock
+ *
+ * NAME
+ *   SPROX_ReaderUnlock
+ *
+ * DESCRIPTION
+ *   Give the shared reader back to the other applications
+ *
+ * RETURNS
+ *   MI_OK              : success
+ *
+ * SEE ALSO
+ *   SPROX_ReaderLock
+ *
+ **/
+SPROX_API_FUNC(ReaderUnlock) (SPROX_PARAM_V)
+{
+	SPROX_PARAM_TO_CTX;
+
+#ifdef SPROX_API_WITH_SHARE
+	if ((sprox_ctx->com_settings & COM_INTERFACE_MASK) == COM_INTERFACE_SHARE)
+		return SPROX_Share_Unlock(sprox_ctx);
+#endif
+
+	UNUSED_PARAMETER(sprox_ctx);
+	return MI_OK;
+}
+
+/**f* SpringProx.API/SPROX_ReaderSetPipeline
+ *
+ * NAME
+ *   SPROX_ReaderSetPipeline
+ *
+ * DESCRIPTION
+ *   Tell how many commands of a SPROX_FunctionBatch may be sent to a network
+ *   reader before its first answer has come back
+ *
+ * INPUTS
+ *   BYTE depth         : commands in flight (0 or 1: one command at once, the
+ *                        default ; up to 32)
+ *
+ * RETURNS
+ *   MI_OK              : success
+ *   MI_LIB_CALL_ERROR  : depth is over 32
+ *
+ * NOTES
+ *   Every command has its own sequence number, so the answers are matched
+ *   to the commands whatever the depth. The reader must accept a new request
+ *   before it has sent the answer to the previous one ; check this before
+ *   going over 1.
+ *   Only matters with a reader opened as "TCP:host" or "TCP:host:port" ;
+ *   SPROX_FunctionBatch sends the commands one at once to the other readers.
+ *
+ * SEE ALSO
+ *   SPROX_FunctionBatch
+ *
+ **/
+SPROX_API_FUNC(ReaderSetPipeline) (SPROX_PARAM  BYTE depth)
+{
+	SPROX_PARAM_TO_CTX;
+
+	if (depth > 32)
+		return MI_LIB_CALL_ERROR;
+
+	sprox_ctx->com_pipeline = depth;
+	return MI_OK;
+}
+
 /**f* SpringProx.API/SPROX_ReaderActivate
  *
  * NAME
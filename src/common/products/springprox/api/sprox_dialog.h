@@ -105,6 +105,8 @@
 
 #define SPROX_LPCD                      0x63
 
+#define SPROX_FIND_IDENT                0x64
+
 
   /*
    * Echo and repeat please
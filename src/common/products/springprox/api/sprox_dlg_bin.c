@@ -18,6 +18,7 @@
 
   JDA 07/04/2004 : created
   JDA 28/02/2012 : improved timeout handling
+  AGT 19/10/2026 : inter-byte timeout depends on the baudrate
 
 */
 
@@ -95,7 +96,7 @@ SWORD RecvFrameBIN(SPROX_CTX_ST* sprox_ctx, BYTE* buffer, WORD* buflen)
 	}
 
 	/* Shorten timeouts, remaining part of buffer must come immediatly */
-	if (!SerialSetTimeouts(sprox_ctx, INTER_BYTE_TMO, INTER_BYTE_TMO))
+	if (!SerialSetTimeouts(sprox_ctx, SPROX_INTER_BYTE_TMO(sprox_ctx), SPROX_INTER_BYTE_TMO(sprox_ctx)))
 	{
 		SPROX_Trace(TRACE_DLG_HI, "SerialSetTimeouts failed");
 		return MI_SER_ACCESS_ERR;
@@ -224,7 +225,7 @@ SWORD RecvFrameBIN(SPROX_CTX_ST* sprox_ctx, BYTE* buffer, WORD* buflen)
 		return MI_SER_NORESP_ERR;
 	}
 
-	if (!SerialSetTimeouts(sprox_ctx, INTER_BYTE_TMO, INTER_BYTE_TMO))
+	if (!SerialSetTimeouts(sprox_ctx, SPROX_INTER_BYTE_TMO(sprox_ctx), SPROX_INTER_BYTE_TMO(sprox_ctx)))
 	{
 		SPROX_Trace(TRACE_DLG_HI, "SerialSetTimeouts failed");
 		return MI_SER_ACCESS_ERR;
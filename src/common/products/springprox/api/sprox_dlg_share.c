@@ -0,0 +1,309 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  SpringProx API
+  --------------
+
+  Copyright (c) 2026 SpringCard SAS, FRANCE - www.springcard.com
+
+  sprox_dlg_share.c
+  -----------------
+  Implementation of the dialog with a reader owned by the ref_share daemon,
+  over a local (Unix) socket. See sprox_share.h for the protocol.
+
+  revision :
+  ----------
+
+  AGT 19/10/2026 : created from sprox_dlg_tcp.c
+  AGT 19/10/2026 : SPROX_Share_Lock may wait for ever, no overflow of its timeout
+
+*/
+
+#include "sprox_api_i.h"
+
+#ifdef SPROX_API_WITH_SHARE
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "sprox_share.h"
+
+/* The daemon may have to serve the other applications first */
+#define SHARE_ANSWER_TMO  30000
+/* Share_Exchange timeout : no deadline */
+#define SHARE_WAIT_FOREVER  0xFFFFFFFF
+
+static SWORD Share_Send(int sk, const BYTE buffer[], DWORD length)
+{
+	ssize_t done;
+
+	while (length)
+	{
+		done = send(sk, buffer, length, MSG_NOSIGNAL);
+		if (done < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			SPROX_Trace(TRACE_DLG_HI, "SHARE:send error");
+			return MI_SER_ACCESS_ERR;
+		}
+		buffer += done;
+		length -= (DWORD)done;
+	}
+
+	return MI_OK;
+}
+
+static SWORD Share_Recv(int sk, BYTE buffer[], DWORD length, BOOL forever, DWORD deadline_ms)
+{
+	struct pollfd pfd;
+	ssize_t done;
+	DWORD now_ms;
+	int ret;
+
+	while (length)
+	{
+		now_ms = SPROX_GetMonotonicMs();
+		if (!forever && ((SDWORD)(deadline_ms - now_ms) <= 0))
+		{
+			SPROX_Trace(TRACE_DLG_HI, "SHARE:no response");
+			return MI_SER_NORESP_ERR;
+		}
+
+		pfd.fd = sk;
+		pfd.events = POLLIN;
+		ret = poll(&pfd, 1, forever ? -1 : (int)(deadline_ms - now_ms));
+		if (ret < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			SPROX_Trace(TRACE_DLG_HI, "SHARE:wait error");
+			return MI_SER_ACCESS_ERR;
+		}
+		if (ret == 0)
+			continue;
+
+		done = recv(sk, buffer, length, 0);
+		if (done <= 0)
+		{
+			if ((done < 0) && (errno == EINTR))
+				continue;
+			/* The daemon has gone away */
+			SPROX_Trace(TRACE_DLG_HI, "SHARE:recv error");
+			return MI_SER_ACCESS_ERR;
+		}
+		buffer += done;
+		length -= (DWORD)done;
+	}
+
+	return MI_OK;
+}
+
+/*
+ * One frame to the daemon, one frame back
+ */
+static SWORD Share_Exchange(SPROX_CTX_ST* sprox_ctx, BYTE type, BYTE cmd, const BYTE send_buffer[], WORD send_bytelen, BYTE recv_buffer[], WORD* recv_bytelen, DWORD timeout_ms)
+{
+	BYTE header[SPROX_SHARE_HEADER_SIZE];
+	BYTE trash[64];
+	DWORD deadline_ms;
+	BOOL forever = (timeout_ms == SHARE_WAIT_FOREVER);
+	WORD length, t;
+	SWORD rc;
+
+	if (send_bytelen > SPROX_SHARE_MAX_DATA)
+		return MI_COMMAND_OVERFLOW;
+
+	header[0] = type;
+	header[1] = sprox_ctx->com_sequence;
+	header[2] = cmd;
+	header[3] = (BYTE)(send_bytelen / 0x0100);
+	header[4] = (BYTE)(send_bytelen % 0x0100);
+
+	rc = Share_Send(sprox_ctx->com_share, header, sizeof(header));
+	if ((rc == MI_OK) && (send_buffer != NULL) && send_bytelen)
+		rc = Share_Send(sprox_ctx->com_share, send_buffer, send_bytelen);
+	if (rc != MI_OK)
+		goto failed;
+
+	deadline_ms = SPROX_GetMonotonicMs() + timeout_ms;
+
+	rc = Share_Recv(sprox_ctx->com_share, header, sizeof(header), forever, deadline_ms);
+	if (rc != MI_OK)
+		goto failed;
+
+	if ((header[0] != SPROX_SHARE_TO_CLIENT) || (header[1] != sprox_ctx->com_sequence))
+	{
+		rc = MI_SER_PROTO_ERR;
+		goto failed;
+	}
+	sprox_ctx->com_sequence++;
+
+	t = header[3];
+	t *= 0x0100;
+	t += header[4];
+
+	/* Always read the whole answer, to stay in sync with the daemon */
+	if ((recv_buffer != NULL) && ((recv_bytelen == NULL) || (*recv_bytelen == 0) || (*recv_bytelen >= t)))
+	{
+		rc = Share_Recv(sprox_ctx->com_share, recv_buffer, t, forever, deadline_ms);
+		if (rc != MI_OK)
+			goto failed;
+		rc = (0 - header[2]);
+	}
+	else
+	{
+		rc = ((recv_buffer != NULL) && t) ? MI_RESPONSE_OVERFLOW : (0 - header[2]);
+		while (t)
+		{
+			length = (t < sizeof(trash)) ? t : sizeof(trash);
+			if (Share_Recv(sprox_ctx->com_share, trash, length, forever, deadline_ms) != MI_OK)
+			{
+				rc = MI_SER_ACCESS_ERR;
+				goto failed;
+			}
+			t -= length;
+		}
+		t = header[3];
+		t *= 0x0100;
+		t += header[4];
+	}
+
+	if (recv_bytelen != NULL)
+		*recv_bytelen = t;
+
+	return rc;
+
+failed:
+	SPROX_Share_ReaderClose(sprox_ctx);
+	return rc;
+}
+
+SWORD SPROX_Share_Function(SPROX_CTX_ST* sprox_ctx, BYTE cmd, const BYTE send_buffer[], WORD send_bytelen, BYTE recv_buffer[], WORD* recv_bytelen)
+{
+	if (sprox_ctx->com_status < COM_STATUS_OPEN_IDLE)
+		return MI_SER_ACCESS_ERR;
+
+	return Share_Exchange(sprox_ctx, SPROX_SHARE_TO_READER, cmd, send_buffer, send_bytelen, recv_buffer, recv_bytelen, SHARE_ANSWER_TMO);
+}
+
+SWORD SPROX_Share_Lock(SPROX_CTX_ST* sprox_ctx, DWORD wait_ms)
+{
+	BYTE buffer[4];
+	DWORD timeout_ms;
+
+	if (sprox_ctx->com_status < COM_STATUS_OPEN_IDLE)
+		return MI_SER_ACCESS_ERR;
+
+	/* The daemon counts the wait on 31 bits ; one day is long enough */
+	if ((wait_ms != SPROX_LOCK_WAIT_FOREVER) && (wait_ms > SPROX_LOCK_WAIT_MAX))
+		wait_ms = SPROX_LOCK_WAIT_MAX;
+
+	buffer[0] = (BYTE)(wait_ms >> 24);
+	buffer[1] = (BYTE)(wait_ms >> 16);
+	buffer[2] = (BYTE)(wait_ms >> 8);
+	buffer[3] = (BYTE)wait_ms;
+
+	/* Wait for the daemon a bit longer than it waits for the lock (no overflow, wait_ms is bounded) */
+	timeout_ms = (wait_ms == SPROX_LOCK_WAIT_FOREVER) ? SHARE_WAIT_FOREVER : (wait_ms + SHARE_ANSWER_TMO);
+
+	return Share_Exchange(sprox_ctx, SPROX_SHARE_TO_DAEMON, SPROX_SHARE_LOCK, buffer, sizeof(buffer), NULL, NULL, timeout_ms);
+}
+
+SWORD SPROX_Share_Unlock(SPROX_CTX_ST* sprox_ctx)
+{
+	if (sprox_ctx->com_status < COM_STATUS_OPEN_IDLE)
+		return MI_SER_ACCESS_ERR;
+
+	return Share_Exchange(sprox_ctx, SPROX_SHARE_TO_DAEMON, SPROX_SHARE_UNLOCK, NULL, 0, NULL, NULL, SHARE_ANSWER_TMO);
+}
+
+SWORD SPROX_Share_ReaderOpen(SPROX_CTX_ST* sprox_ctx, const TCHAR socket_path[])
+{
+	struct sockaddr_un sa;
+	SWORD rc;
+	int sk;
+
+	if ((socket_path == NULL) || (socket_path[0] == '\0'))
+		socket_path = getenv("SPROX_SHARE_SOCKET");
+	if ((socket_path == NULL) || (socket_path[0] == '\0'))
+		socket_path = SPROX_SHARE_SOCKET;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family = AF_UNIX;
+	if (strlen(socket_path) >= sizeof(sa.sun_path))
+	{
+		SPROX_Trace(TRACE_DLG_HI, "SHARE:socket path too long");
+		return MI_READER_NAME_INVALID;
+	}
+	strcpy(sa.sun_path, socket_path);
+
+	sk = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (sk < 0)
+	{
+		SPROX_Trace(TRACE_DLG_HI, "SHARE:socket error");
+		return MI_READER_CONNECT_FAILED;
+	}
+
+	if (connect(sk, (struct sockaddr*)&sa, sizeof(sa)) < 0)
+	{
+		SPROX_Trace(TRACE_DLG_HI, "SHARE:connect to %s failed", socket_path);
+		close(sk);
+		return MI_READER_CONNECT_FAILED;
+	}
+
+	sprox_ctx->com_share = sk;
+	sprox_ctx->com_settings &= ~COM_INTERFACE_MASK;
+	sprox_ctx->com_settings |= COM_INTERFACE_SHARE;
+	sprox_ctx->com_status = COM_STATUS_OPEN_ACTIVE;
+	_tcsncpy(sprox_ctx->com_name, socket_path, sizeof(sprox_ctx->com_name) / sizeof(TCHAR) - 1);
+	sprox_ctx->com_name[sizeof(sprox_ctx->com_name) / sizeof(TCHAR) - 1] = '\0';
+
+#ifdef SPROX_API_REENTRANT
+	rc = SPROXx_ReaderGetFirmware(sprox_ctx, NULL, 0);
+#else
+	rc = SPROX_ReaderGetFirmware(NULL, 0);
+#endif
+	if (rc != MI_OK)
+	{
+		SPROX_Trace(TRACE_DLG_HI, "SHARE:GetFirmware failed");
+		goto failed;
+	}
+
+#ifdef SPROX_API_REENTRANT
+	rc = SPROXx_ReaderGetFeatures(sprox_ctx, NULL);
+#else
+	rc = SPROX_ReaderGetFeatures(NULL);
+#endif
+	if (rc != MI_OK)
+	{
+		SPROX_Trace(TRACE_DLG_HI, "SHARE:GetFeatures failed");
+		goto failed;
+	}
+
+	SPROX_Trace(TRACE_ACCESS, "SHARE:ReaderOpen OK");
+	return MI_OK;
+
+failed:
+	SPROX_Share_ReaderClose(sprox_ctx);
+	return rc;
+}
+
+SWORD SPROX_Share_ReaderClose(SPROX_CTX_ST* sprox_ctx)
+{
+	if (((sprox_ctx->com_settings & COM_INTERFACE_MASK) == COM_INTERFACE_SHARE) && (sprox_ctx->com_status > COM_STATUS_CLOSED_BUT_SEEN))
+	{
+		SPROX_Trace(TRACE_ACCESS, "SHARE:ReaderClose");
+		close(sprox_ctx->com_share);
+		sprox_ctx->com_status = COM_STATUS_CLOSED_BUT_SEEN;
+	}
+
+	return MI_OK;
+}
+
+#endif
@@ -17,6 +17,11 @@
   ----------
 
   JDA 16/07/2014 : created
+  AGT 19/10/2026 : the connection stays open and is re-established with a backoff when lost,
+                   TCP_NODELAY and keepalive, frames of any length,
+                   pipelined requests in SPROX_TCP_FunctionBatch,
+                   available on Linux, optional port in "TCP:host:port",
+                   connect bounded by TCP_CONNECT_TMO
 
 */
 
@@ -27,11 +32,36 @@
 #ifdef WIN32
 #pragma comment(lib, "WS2_32")
 #pragma warning( disable : 4996 )
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#endif
+
+#ifndef INVALID_SOCKET
+#define INVALID_SOCKET (-1)
+#endif
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
 #endif
 
 #define RDR_TO_PC_LEGACY 0x28
 #define PC_TO_RDR_LEGACY 0x29
 
+#define TCP_PORT_LEGACY    3999
+#define TCP_HEADER_SIZE    5
+#define TCP_ANSWER_TMO     30000  /* ms */
+#define TCP_CONNECT_TMO    3000   /* ms, an unreachable reader must not block for the system's timeout */
+#define TCP_STALE_ANSWERS  8      /* Late answers to skip, to commands that have timed out */
+
+/* Same defaults as SPROX_ReaderReconnect */
+#define TCP_RECONNECT_TRIES     4
+#define TCP_RECONNECT_DELAY_MS  100
+
 #ifdef WIN32
 static BOOL WinsockStarted = FALSE;
 static BOOL WinsockStartup(void)
@@ -65,174 +95,540 @@ static void WinsockCleanup(void)
 }
 #endif
 
-static SWORD TCP_Wait(SOCKET sk, DWORD wait_sec)
+static SWORD TCP_Wait(SOCKET sk, DWORD deadline_ms)
 {
 	fd_set rdfdset;
 	int selret;
 	struct timeval timeout;
+	DWORD now_ms;
+
+	for (;;)
+	{
+		now_ms = SPROX_GetMonotonicMs();
+		if ((SDWORD)(deadline_ms - now_ms) <= 0)
+		{
+			/* Timeout */
+			SPROX_Trace(TRACE_DLG_HI, "TCP:no response");
+			return MI_SER_NORESP_ERR;
+		}
 
-	timeout.tv_sec = wait_sec;
-	timeout.tv_usec = 0;
+		timeout.tv_sec = (deadline_ms - now_ms) / 1000;
+		timeout.tv_usec = ((deadline_ms - now_ms) % 1000) * 1000;
 
-	FD_ZERO(&rdfdset);
-	FD_SET(sk, &rdfdset);
+		FD_ZERO(&rdfdset);
+		FD_SET(sk, &rdfdset);
 
-	selret = select(sk + 1, &rdfdset, 0, 0, &timeout);
-	if (selret < 0)
-	{
-		/* Disconnected? */
-		SPROX_Trace(TRACE_DLG_HI, "TCP:wait error");
-		return MI_SER_ACCESS_ERR;
+		selret = select((int)sk + 1, &rdfdset, 0, 0, &timeout);
+		if (selret > 0)
+			return MI_OK;
+
+		if (selret < 0)
+		{
+#ifndef WIN32
+			if (errno == EINTR)
+				continue;
+#endif
+			/* Disconnected? */
+			SPROX_Trace(TRACE_DLG_HI, "TCP:wait error");
+			return MI_SER_ACCESS_ERR;
+		}
 	}
+}
+
+static SWORD TCP_Send(SOCKET sk, const BYTE buffer[], DWORD length, int flags)
+{
+	int done;
 
-	if (selret == 0)
+	while (length)
 	{
-		/* Timeout */
-		SPROX_Trace(TRACE_DLG_HI, "TCP:no response");
-		return MI_SER_NORESP_ERR;
+		done = send(sk, (const char*)buffer, length, flags | MSG_NOSIGNAL);
+		if (done < 0)
+		{
+#ifndef WIN32
+			if (errno == EINTR)
+				continue;
+#endif
+			SPROX_Trace(TRACE_DLG_HI, "TCP:send error");
+			return MI_SER_ACCESS_ERR;
+		}
+		buffer += done;
+		length -= done;
 	}
 
 	return MI_OK;
 }
 
-static SWORD TCP_Send(SOCKET sk, BYTE buffer[], WORD length)
+static SWORD TCP_Recv(SOCKET sk, BYTE buffer[], DWORD length, DWORD deadline_ms)
 {
 	int done;
+	SWORD rc;
 
-	done = send(sk, buffer, length, 0);
+	while (length)
+	{
+		rc = TCP_Wait(sk, deadline_ms);
+		if (rc != MI_OK)
+			return rc;
+
+		done = recv(sk, (char*)buffer, length, 0);
+		if (done <= 0)
+		{
+#ifndef WIN32
+			if ((done < 0) && (errno == EINTR))
+				continue;
+#endif
+			/* The reader has closed the connection */
+			SPROX_Trace(TRACE_DLG_HI, "TCP:recv error");
+			return MI_SER_ACCESS_ERR;
+		}
+		buffer += done;
+		length -= done;
+	}
 
-	if (done < 0)
+	return MI_OK;
+}
+
+static void TCP_Close(SOCKET sk)
+{
+#ifdef WIN32
+	closesocket(sk);
+#else
+	close(sk);
+#endif
+}
+
+/*
+ * The requests are small : send them at once, and detect a dead reader (or a dead network)
+ * even when the application only waits for a card
+ */
+static void TCP_SetOptions(SOCKET sk)
+{
+	int one = 1;
+#ifdef TCP_KEEPIDLE
+	int idle_s = 10, interval_s = 2, count = 3;
+#endif
+
+	setsockopt(sk, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+	setsockopt(sk, SOL_SOCKET, SO_KEEPALIVE, (const char*)&one, sizeof(one));
+#ifdef TCP_KEEPIDLE
+	setsockopt(sk, IPPROTO_TCP, TCP_KEEPIDLE, (const char*)&idle_s, sizeof(idle_s));
+	setsockopt(sk, IPPROTO_TCP, TCP_KEEPINTVL, (const char*)&interval_s, sizeof(interval_s));
+	setsockopt(sk, IPPROTO_TCP, TCP_KEEPCNT, (const char*)&count, sizeof(count));
+#endif
+}
+
+/*
+ * Connect without blocking for longer than TCP_CONNECT_TMO
+ */
+static BOOL TCP_Connect(SOCKET sk, const struct sockaddr_in* sa)
+{
+	DWORD deadline_ms = SPROX_GetMonotonicMs() + TCP_CONNECT_TMO;
+	fd_set wrfdset, exfdset;
+	struct timeval timeout;
+	DWORD now_ms;
+	int selret, err;
+#ifdef WIN32
+	int err_len = sizeof(err);
+	u_long mode = 1;
+
+	ioctlsocket(sk, FIONBIO, &mode);
+	if ((connect(sk, (const struct sockaddr*)sa, sizeof(struct sockaddr_in)) < 0) && (WSAGetLastError() != WSAEWOULDBLOCK))
+		return FALSE;
+#else
+	socklen_t err_len = sizeof(err);
+	int flags = fcntl(sk, F_GETFL, 0);
+
+	fcntl(sk, F_SETFL, flags | O_NONBLOCK);
+	if ((connect(sk, (const struct sockaddr*)sa, sizeof(struct sockaddr_in)) < 0) && (errno != EINPROGRESS))
+		return FALSE;
+#endif
+
+	for (;;)
 	{
-		SPROX_Trace(TRACE_DLG_HI, "TCP:send error");
-		return MI_SER_ACCESS_ERR;
+		now_ms = SPROX_GetMonotonicMs();
+		if ((SDWORD)(deadline_ms - now_ms) <= 0)
+		{
+			SPROX_Trace(TRACE_DLG_HI, "TCP:connect timeout");
+			return FALSE;
+		}
+
+		timeout.tv_sec = (deadline_ms - now_ms) / 1000;
+		timeout.tv_usec = ((deadline_ms - now_ms) % 1000) * 1000;
+
+		/* Windows tells a failed connect in the exception set */
+		FD_ZERO(&wrfdset);
+		FD_SET(sk, &wrfdset);
+		FD_ZERO(&exfdset);
+		FD_SET(sk, &exfdset);
+
+		selret = select((int)sk + 1, 0, &wrfdset, &exfdset, &timeout);
+		if (selret > 0)
+			break;
+#ifndef WIN32
+		if ((selret < 0) && (errno == EINTR))
+			continue;
+#endif
+		if (selret < 0)
+			return FALSE;
+	}
+
+	err = 0;
+	if ((getsockopt(sk, SOL_SOCKET, SO_ERROR, (char*)&err, &err_len) < 0) || (err != 0))
+		return FALSE;
+
+	/* The dialog itself waits with select */
+#ifdef WIN32
+	mode = 0;
+	ioctlsocket(sk, FIONBIO, &mode);
+#else
+	fcntl(sk, F_SETFL, flags);
+#endif
+	return TRUE;
+}
+
+/*
+ * "host" or "host:port"
+ */
+static SWORD TCP_Open(const TCHAR conn_string[], SOCKET* sk)
+{
+	struct sockaddr_in sa;
+	struct hostent* hp;
+	char host[64];
+	WORD port = TCP_PORT_LEGACY;
+	SOCKET new_sk;
+	char* p;
+
+	strlcpy(host, _ST(conn_string), sizeof(host));
+	p = strchr(host, ':');
+	if (p != NULL)
+	{
+		*p++ = '\0';
+		port = (WORD)atoi(p);
+		if (port == 0)
+		{
+			SPROX_Trace(TRACE_DLG_HI, "TCP:invalid port");
+			return MI_READER_NAME_INVALID;
+		}
 	}
-	if (done < length)
+
+	hp = gethostbyname(host);
+	if (hp == NULL)
 	{
-		SPROX_Trace(TRACE_DLG_HI, "TCP:send too short");
-		return MI_SER_ACCESS_ERR;
+		SPROX_Trace(TRACE_DLG_HI, "TCP:host not found or invalid");
+		return MI_READER_NAME_INVALID;
 	}
 
+	memset(&sa, 0, sizeof(struct sockaddr_in));
+
+	if (hp->h_addrtype == AF_INET)
+	{
+		sa.sin_family = AF_INET;
+		memcpy(&sa.sin_addr, hp->h_addr_list[0], 4);
+		sa.sin_port = htons(port);
+	}
+	else
+	{
+		SPROX_Trace(TRACE_DLG_HI, "TCP:invalid address type");
+		return MI_READER_NAME_INVALID;
+	}
+
+	new_sk = socket(AF_INET, SOCK_STREAM, 0);
+	if (new_sk == INVALID_SOCKET)
+	{
+		SPROX_Trace(TRACE_DLG_HI, "TCP:socket error");
+		return MI_READER_CONNECT_FAILED;
+	}
+
+	TCP_SetOptions(new_sk);
+
+	if (!TCP_Connect(new_sk, &sa))
+	{
+		SPROX_Trace(TRACE_DLG_HI, "TCP:connect error");
+		TCP_Close(new_sk); /* Oups ca manquait ! */
+		return MI_READER_CONNECT_FAILED;
+	}
+
+	*sk = new_sk;
+
 	return MI_OK;
 }
 
-static SWORD TCP_Recv(SOCKET sk, BYTE buffer[], WORD max_len, WORD* got_len)
+/*
+ * The connection has failed : open it again, a bounded number of times with a growing delay
+ * (the settings of SPROX_ReaderSetReconnect apply here as well)
+ */
+static SWORD TCP_Reconnect(SPROX_CTX_ST* sprox_ctx)
 {
-	int done;
+	BYTE  tries = TCP_RECONNECT_TRIES;
+	WORD  delay_ms = TCP_RECONNECT_DELAY_MS;
+	DWORD started_ms = SPROX_GetMonotonicMs();
+	SWORD rc = MI_SER_ACCESS_ERR;
+	BYTE  i;
 
-	done = recv(sk, buffer, max_len, 0);
-	if (done < 0)
+	if (sprox_ctx->reconnect_set)
 	{
-		SPROX_Trace(TRACE_DLG_HI, "TCP:recv error");
-		return MI_SER_ACCESS_ERR;
+		tries = sprox_ctx->reconnect_tries;
+		delay_ms = sprox_ctx->reconnect_delay_ms;
 	}
 
-	*got_len = done;
-	return MI_OK;
+	if (sprox_ctx->com_socket != INVALID_SOCKET)
+	{
+		TCP_Close(sprox_ctx->com_socket);
+		sprox_ctx->com_socket = INVALID_SOCKET;
+	}
+
+	for (i = 0; i < tries; i++)
+	{
+		if (i)
+		{
+			Sleep(delay_ms);
+			if (delay_ms < 1000)
+				delay_ms *= 2;
+		}
+
+		rc = TCP_Open(sprox_ctx->com_name, &sprox_ctx->com_socket);
+		if (rc == MI_OK)
+		{
+			SPROX_Trace(TRACE_ACCESS, "TCP:reconnected to %s in %lums (%d attempt(s))", _ST(sprox_ctx->com_name), SPROX_GetMonotonicMs() - started_ms, i + 1);
+			sprox_ctx->com_lost = FALSE;
+			return MI_OK;
+		}
+	}
+
+	SPROX_Trace(TRACE_ACCESS, "TCP:reconnect to %s failed after %lums, rc=%d", _ST(sprox_ctx->com_name), SPROX_GetMonotonicMs() - started_ms, rc);
+	return MI_SER_ACCESS_ERR;
 }
 
-SWORD SPROX_TCP_Function(SPROX_CTX_ST* sprox_ctx, BYTE cmd, const BYTE send_buffer[], WORD send_bytelen, BYTE recv_buffer[], WORD* recv_bytelen)
+/*
+ * The stream can't be trusted anymore : drop the connection, the next function will open it again
+ */
+static void TCP_Lost(SPROX_CTX_ST* sprox_ctx)
+{
+	if (sprox_ctx->com_socket != INVALID_SOCKET)
+	{
+		TCP_Close(sprox_ctx->com_socket);
+		sprox_ctx->com_socket = INVALID_SOCKET;
+	}
+	sprox_ctx->com_lost = TRUE;
+}
+
+static SWORD TCP_SendRequest(SPROX_CTX_ST* sprox_ctx, BYTE sequence, BYTE cmd, const BYTE send_buffer[], WORD send_bytelen)
 {
 	BYTE buffer[512];
-	WORD length, t;
+	int flags = 0;
 	SWORD rc;
 
-	length = 0;
-	buffer[length++] = PC_TO_RDR_LEGACY;
-	buffer[length++] = sprox_ctx->com_sequence;
-	buffer[length++] = cmd;
-	buffer[length++] = (BYTE)(send_bytelen / 0x0100);
-	buffer[length++] = (BYTE)(send_bytelen % 0x0100);
-	if (send_buffer != NULL)
-		memcpy(&buffer[length], send_buffer, send_bytelen);
-	length += send_bytelen;
-
-	rc = TCP_Send(sprox_ctx->com_socket, buffer, length);
-	if (rc != MI_OK)
-		goto failed;
-
-	rc = TCP_Wait(sprox_ctx->com_socket, 30000);
-	if (rc != MI_OK)
-		goto failed;
+	buffer[0] = PC_TO_RDR_LEGACY;
+	buffer[1] = sequence;
+	buffer[2] = cmd;
+	buffer[3] = (BYTE)(send_bytelen / 0x0100);
+	buffer[4] = (BYTE)(send_bytelen % 0x0100);
 
-	length = 0;
-	rc = TCP_Recv(sprox_ctx->com_socket, buffer, sizeof(buffer), &length);
-	if (rc != MI_OK)
-		goto failed;
+	if (send_buffer == NULL)
+		send_bytelen = 0;
 
-	if (buffer[0] != RDR_TO_PC_LEGACY)
+	/* Short frames in one segment */
+	if (send_bytelen <= (sizeof(buffer) - TCP_HEADER_SIZE))
 	{
-		rc = MI_SER_PROTO_ERR;
-		goto failed;
+		if (send_bytelen)
+			memcpy(&buffer[TCP_HEADER_SIZE], send_buffer, send_bytelen);
+		return TCP_Send(sprox_ctx->com_socket, buffer, TCP_HEADER_SIZE + send_bytelen, 0);
 	}
-	if (buffer[1] != sprox_ctx->com_sequence)
+
+#ifdef MSG_MORE
+	flags = MSG_MORE;
+#endif
+	rc = TCP_Send(sprox_ctx->com_socket, buffer, TCP_HEADER_SIZE, flags);
+	if (rc == MI_OK)
+		rc = TCP_Send(sprox_ctx->com_socket, send_buffer, send_bytelen, 0);
+	return rc;
+}
+
+static SWORD TCP_Drain(SOCKET sk, WORD length, DWORD deadline_ms)
+{
+	BYTE trash[64];
+	WORD t;
+	SWORD rc;
+
+	while (length)
 	{
-		rc = MI_SER_PROTO_ERR;
-		goto failed;
+		t = (length < sizeof(trash)) ? length : sizeof(trash);
+		rc = TCP_Recv(sk, trash, t, deadline_ms);
+		if (rc != MI_OK)
+			return rc;
+		length -= t;
 	}
-	sprox_ctx->com_sequence++;
 
-	rc = (0 - buffer[2]);
+	return MI_OK;
+}
 
-	t = buffer[3];
-	t *= 0x0100;
-	t += buffer[4];
+/*
+ * Receive the answer to the request with this sequence number. The return value tells
+ * whether the link is OK, *status is the reader's status
+ */
+static SWORD TCP_RecvAnswer(SPROX_CTX_ST* sprox_ctx, BYTE sequence, BYTE recv_buffer[], WORD* recv_bytelen, SWORD* status)
+{
+	BYTE header[TCP_HEADER_SIZE];
+	DWORD deadline_ms = SPROX_GetMonotonicMs() + TCP_ANSWER_TMO;
+	BYTE stale = TCP_STALE_ANSWERS;
+	WORD t;
+	SWORD rc;
 
-	if (recv_bytelen != NULL)
+	for (;;)
 	{
-		if ((*recv_bytelen != 0) && (*recv_bytelen < t))
+		rc = TCP_Recv(sprox_ctx->com_socket, header, sizeof(header), deadline_ms);
+		if (rc != MI_OK)
+			return rc;
+
+		if (header[0] != RDR_TO_PC_LEGACY)
+			return MI_SER_PROTO_ERR;
+
+		t = header[3];
+		t *= 0x0100;
+		t += header[4];
+
+		if (header[1] == sequence)
+			break;
+
+		/* Answer to an earlier request, that we have stopped waiting for */
+		if (((BYTE)(sequence - header[1]) < 0x80) && stale--)
 		{
-			rc = MI_RESPONSE_OVERFLOW;
-			goto failed;
+			SPROX_Trace(TRACE_DLG_HI, "TCP:late answer %02X skipped", header[1]);
+			rc = TCP_Drain(sprox_ctx->com_socket, t, deadline_ms);
+			if (rc != MI_OK)
+				return rc;
+			continue;
 		}
-		*recv_bytelen = t;
+
+		return MI_SER_PROTO_ERR;
 	}
 
-	if (recv_buffer != NULL)
-		memcpy(recv_buffer, &buffer[5], t);
+	*status = (0 - header[2]);
 
-	return rc;
+	/* Always read the whole answer, to stay in sync with the reader */
+	if ((recv_bytelen != NULL) && (*recv_bytelen != 0) && (*recv_bytelen < t))
+	{
+		*status = MI_RESPONSE_OVERFLOW;
+		return TCP_Drain(sprox_ctx->com_socket, t, deadline_ms);
+	}
 
-failed:
-	SPROX_TCP_ReaderClose(sprox_ctx);
-	return rc;
+	if (recv_bytelen != NULL)
+		*recv_bytelen = t;
+
+	if (recv_buffer != NULL)
+		return TCP_Recv(sprox_ctx->com_socket, recv_buffer, t, deadline_ms);
+
+	return TCP_Drain(sprox_ctx->com_socket, t, deadline_ms);
 }
 
-static void TCP_Close(SOCKET sk)
+SWORD SPROX_TCP_Function(SPROX_CTX_ST* sprox_ctx, BYTE cmd, const BYTE send_buffer[], WORD send_bytelen, BYTE recv_buffer[], WORD* recv_bytelen)
 {
-#ifdef WIN32
-	closesocket(sk);
-#else
-	close(sk);
-#endif  
+	BOOL reconnected = FALSE;
+	BOOL sent;
+	WORD first_recv_bytelen = 0;
+	SWORD rc, status = MI_LIB_INTERNAL_ERROR;
+
+	if (sprox_ctx->com_status < COM_STATUS_OPEN_IDLE)
+		return MI_SER_ACCESS_ERR;
+
+	if (recv_bytelen != NULL)
+		first_recv_bytelen = *recv_bytelen;
+
+	if (sprox_ctx->com_lost)
+	{
+		reconnected = TRUE;
+		rc = TCP_Reconnect(sprox_ctx);
+		if (rc != MI_OK)
+			return rc;
+	}
+
+again:
+	rc = TCP_SendRequest(sprox_ctx, sprox_ctx->com_sequence, cmd, send_buffer, send_bytelen);
+	sent = (rc == MI_OK);
+	if (sent)
+		rc = TCP_RecvAnswer(sprox_ctx, sprox_ctx->com_sequence, recv_buffer, recv_bytelen, &status);
+	sprox_ctx->com_sequence++;
+
+	if (rc == MI_OK)
+		return status;
+
+	if (rc == MI_SER_NORESP_ERR)
+	{
+		/* The connection is still there, a late answer will be skipped */
+		return rc;
+	}
+
+	TCP_Lost(sprox_ctx);
+
+	/*
+	 * Connection reset (reader restarted, network failure...) before the request has gone : open it again,
+	 * and send once more. Once the request has gone, the reader may have run it : never send it twice
+	 */
+	if (!sent && (rc == MI_SER_ACCESS_ERR) && !reconnected)
+	{
+		reconnected = TRUE;
+		if (TCP_Reconnect(sprox_ctx) == MI_OK)
+		{
+			if (recv_bytelen != NULL)
+				*recv_bytelen = first_recv_bytelen;
+			goto again;
+		}
+	}
+
+	return rc;
 }
 
-static SWORD TCP_Open(struct sockaddr_in* sa, SOCKET* sk)
+/*
+ * Up to com_pipeline requests in flight, each one with its own sequence number : the batch
+ * takes about one round-trip time instead of one per command
+ */
+SWORD SPROX_TCP_FunctionBatch(SPROX_CTX_ST* sprox_ctx, SPROX_FUNCTION_ST functions[], WORD count)
 {
-	SOCKET new_sk;
+	BYTE  depth = sprox_ctx->com_pipeline ? sprox_ctx->com_pipeline : 1;
+	BYTE  first_sequence;
+	WORD  sent = 0, done = 0;
+	SWORD rc = MI_OK;
 
-	new_sk = socket(AF_INET, SOCK_STREAM, 0);
-	if (new_sk < 0)
+	if (sprox_ctx->com_status < COM_STATUS_OPEN_IDLE)
+		return MI_SER_ACCESS_ERR;
+
+	if (sprox_ctx->com_lost)
 	{
-		SPROX_Trace(TRACE_DLG_HI, "TCP:socket error");
-		return MI_READER_CONNECT_FAILED;
+		rc = TCP_Reconnect(sprox_ctx);
+		if (rc != MI_OK)
+			goto failed;
 	}
 
-	if (connect(new_sk, (struct sockaddr*)sa, sizeof(struct sockaddr_in)) < 0)
+	first_sequence = sprox_ctx->com_sequence;
+
+	while (done < count)
 	{
-		SPROX_Trace(TRACE_DLG_HI, "TCP:connect error");
-		TCP_Close(new_sk); /* Oups ca manquait ! */
-		return MI_READER_CONNECT_FAILED;
-	}
+		while ((sent < count) && ((sent - done) < depth))
+		{
+			rc = TCP_SendRequest(sprox_ctx, (BYTE)(first_sequence + sent), functions[sent].cmd, functions[sent].send_buffer, functions[sent].send_bytelen);
+			if (rc != MI_OK)
+				goto failed;
+			sent++;
+		}
 
-	*sk = new_sk;
+		rc = TCP_RecvAnswer(sprox_ctx, (BYTE)(first_sequence + done), functions[done].recv_buffer, &functions[done].recv_bytelen, &functions[done].rc);
+		if (rc != MI_OK)
+			goto failed;
+		done++;
+	}
 
+	sprox_ctx->com_sequence = (BYTE)(first_sequence + count);
 	return MI_OK;
+
+failed:
+	/* We don't know which commands the reader has run : don't send them again */
+	for (; done < count; done++)
+		functions[done].rc = rc;
+	TCP_Lost(sprox_ctx);
+	return rc;
 }
 
 SWORD SPROX_TCP_ReaderOpen(SPROX_CTX_ST* sprox_ctx, const TCHAR conn_string[])
 {
-	struct sockaddr_in sa;
-	struct hostent* hp;
 	SWORD rc;
 
 #ifdef WIN32
@@ -243,33 +639,21 @@ SWORD SPROX_TCP_ReaderOpen(SPROX_CTX_ST* sprox_ctx, const TCHAR conn_string[])
 	}
 #endif
 
-	hp = gethostbyname(conn_string);
-	if (hp == NULL)
+	if (_tcslen(conn_string) >= sizeof(sprox_ctx->com_name) / sizeof(TCHAR))
 	{
-		SPROX_Trace(TRACE_DLG_HI, "TCP:host not found or invalid");
+		SPROX_Trace(TRACE_DLG_HI, "TCP:host name too long");
 		return MI_READER_NAME_INVALID;
 	}
 
-	memset(&sa, 0, sizeof(struct sockaddr_in));
-
-	if (hp->h_addrtype == AF_INET)
-	{
-		sa.sin_family = AF_INET;
-		memcpy(&sa.sin_addr, hp->h_addr_list[0], 4);
-		sa.sin_port = htons(3999);
-	}
-	else
-	{
-		SPROX_Trace(TRACE_DLG_HI, "TCP:invalid address type");
-		return MI_READER_NAME_INVALID;
-	}
-
-	rc = TCP_Open(&sa, &sprox_ctx->com_socket);
+	rc = TCP_Open(conn_string, &sprox_ctx->com_socket);
 	if (rc != MI_OK)
 		return rc;
 
 	sprox_ctx->com_settings &= ~COM_INTERFACE_MASK;
 	sprox_ctx->com_settings |= COM_INTERFACE_TCP;
+	sprox_ctx->com_status = COM_STATUS_OPEN_ACTIVE;
+	sprox_ctx->com_lost = FALSE;
+	_tcscpy(sprox_ctx->com_name, conn_string);
 
 #ifdef SPROX_API_REENTRANT
 	rc = SPROXx_ReaderGetFirmware(sprox_ctx, NULL, 0);
@@ -306,7 +690,11 @@ SWORD SPROX_TCP_ReaderClose(SPROX_CTX_ST* sprox_ctx)
 	if ((sprox_ctx->com_settings & COM_INTERFACE_MASK) == COM_INTERFACE_TCP)
 	{
 		SPROX_Trace(TRACE_ACCESS, "TCP:ReaderClose");
-		TCP_Close(sprox_ctx->com_socket);
+		if (sprox_ctx->com_socket != INVALID_SOCKET)
+			TCP_Close(sprox_ctx->com_socket);
+		sprox_ctx->com_socket = INVALID_SOCKET;
+		sprox_ctx->com_lost = FALSE;
+		sprox_ctx->com_status = COM_STATUS_CLOSED_BUT_SEEN;
 #ifdef WIN32
 		WinsockCleanup();
 #endif
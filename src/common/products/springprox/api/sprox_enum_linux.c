@@ -0,0 +1,525 @@
+/**h* SpringProx.API/Enum
+ *
+ * NAME
+ *   SpringProx.API :: Reader enumeration (Linux)
+ *
+ * DESCRIPTION
+ *   The candidate devices are listed from sysfs (/sys/class/tty) : the USB
+ *   serial ports (ttyUSB*, ttyACM*) and, on request, the UARTs actually
+ *   present on the host (ttyS*). Vendor, product and serial number come from
+ *   the USB device, the stable identifier from the links udev maintains in
+ *   /dev/serial/by-id (or by-path).
+ *   Every candidate is probed by a thread of its own, with a context of its
+ *   own, so the time to enumerate is the time to probe one device.
+ *   The arrival and the removal of the devices are read from the kernel's
+ *   uevent socket, so neither libudev nor a daemon is needed.
+ *
+ * PORTABILITY
+ *   Linux (pthread)
+ *
+ **/
+
+ /*
+
+   SpringProx API
+   --------------
+
+   Copyright (c) 2026 SpringCard SAS, FRANCE - www.springcard.com
+
+   THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+   ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+   TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+   PARTICULAR PURPOSE.
+
+   History
+   -------
+
+   AGT 19/10/2026 : created
+
+ */
+
+#include "sprox_api_i.h"
+
+#ifdef LINUX
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
+#define ENUM_CANDIDATES_MAX  64
+#define ENUM_SYSFS_TTY       "/sys/class/tty"
+
+typedef struct
+{
+	SPROX_READER_ENUM_ST Info;
+	pthread_t            Thread;
+	BOOL                 Started;
+} SPROX_ENUM_CANDIDATE_ST;
+
+/*
+ * Which tty devices are worth probing
+ * -----------------------------------
+ */
+static BOOL EnumIsCandidate(const char* name, DWORD flags)
+{
+	char path[PATH_MAX];
+	char buffer[16];
+	FILE* fp;
+	BOOL rc = FALSE;
+
+	if (!strncmp(name, "ttyUSB", 6) || !strncmp(name, "ttyACM", 6))
+		return TRUE;
+
+	if (!(flags & SPROX_ENUM_LEGACY_SERIAL) || strncmp(name, "ttyS", 4))
+		return FALSE;
+
+	/* The 8250 driver creates all its ports, type is 0 when there's no UART behind */
+	snprintf(path, sizeof(path), "%s/%s/type", ENUM_SYSFS_TTY, name);
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return FALSE;
+	if (fgets(buffer, sizeof(buffer), fp) != NULL)
+		rc = (atoi(buffer) != 0);
+	fclose(fp);
+
+	return rc;
+}
+
+static BOOL EnumReadAttr(const char* dir, const char* attr, char* value, size_t size)
+{
+	char path[PATH_MAX];
+	FILE* fp;
+	size_t l;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, attr);
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return FALSE;
+
+	if (fgets(value, (int)size, fp) == NULL)
+		value[0] = '\0';
+	fclose(fp);
+
+	l = strlen(value);
+	while ((l > 0) && ((value[l - 1] == '\n') || (value[l - 1] == '\r')))
+		value[--l] = '\0';
+
+	return TRUE;
+}
+
+/*
+ * Vendor, product and serial number of the USB device behind a tty
+ * ----------------------------------------------------------------
+ * The tty is an interface of the USB device : walk up from the interface
+ * until the directory that has the idVendor attribute.
+ */
+static void EnumReadUsb(SPROX_READER_ENUM_ST* info, const char* name)
+{
+	char path[PATH_MAX];
+	char dir[PATH_MAX];
+	char value[64];
+	char* p;
+	int i;
+
+	snprintf(path, sizeof(path), "%s/%s/device", ENUM_SYSFS_TTY, name);
+	if (realpath(path, dir) == NULL)
+		return;
+
+	for (i = 0; i < 4; i++)
+	{
+		if (EnumReadAttr(dir, "idVendor", value, sizeof(value)))
+		{
+			info->vid = (WORD)strtoul(value, NULL, 16);
+			if (EnumReadAttr(dir, "idProduct", value, sizeof(value)))
+				info->pid = (WORD)strtoul(value, NULL, 16);
+			if (EnumReadAttr(dir, "serial", value, sizeof(value)))
+				strlcpy(info->serial, value, sizeof(info->serial));
+			return;
+		}
+
+		p = strrchr(dir, '/');
+		if ((p == NULL) || (p == dir))
+			return;
+		*p = '\0';
+	}
+}
+
+/*
+ * Name of the device that survives a re-plug or a reboot
+ * ------------------------------------------------------
+ */
+static BOOL EnumFindLink(SPROX_READER_ENUM_ST* info, const char* links)
+{
+	char path[PATH_MAX];
+	char target[PATH_MAX];
+	struct dirent* entry;
+	DIR* dir;
+	BOOL found = FALSE;
+
+	dir = opendir(links);
+	if (dir == NULL)
+		return FALSE;
+
+	while ((entry = readdir(dir)) != NULL)
+	{
+		if (entry->d_name[0] == '.')
+			continue;
+
+		snprintf(path, sizeof(path), "%s/%s", links, entry->d_name);
+		if (realpath(path, target) == NULL)
+			continue;
+
+		if (!strcmp(target, info->device))
+		{
+			strlcpy(info->stable_id, path, sizeof(info->stable_id));
+			found = TRUE;
+			break;
+		}
+	}
+
+	closedir(dir);
+	return found;
+}
+
+static void EnumStableId(SPROX_READER_ENUM_ST* info)
+{
+	if (EnumFindLink(info, "/dev/serial/by-id"))
+		return;
+
+	/* No udev : build an equivalent from the USB descriptors */
+	if (info->vid && info->serial[0])
+	{
+		snprintf(info->stable_id, sizeof(info->stable_id), "usb-%04x:%04x-%s", info->vid, info->pid, info->serial);
+		return;
+	}
+
+	if (EnumFindLink(info, "/dev/serial/by-path"))
+		return;
+
+	strlcpy(info->stable_id, info->device, sizeof(info->stable_id));
+}
+
+static WORD EnumListCandidates(SPROX_ENUM_CANDIDATE_ST candidates[], WORD max, DWORD flags)
+{
+	struct dirent* entry;
+	DIR* dir;
+	WORD count = 0;
+
+	dir = opendir(ENUM_SYSFS_TTY);
+	if (dir == NULL)
+		return 0;
+
+	while (((entry = readdir(dir)) != NULL) && (count < max))
+	{
+		SPROX_READER_ENUM_ST* info;
+
+		if (!EnumIsCandidate(entry->d_name, flags))
+			continue;
+
+		info = &candidates[count].Info;
+		memset(&candidates[count], 0, sizeof(candidates[count]));
+		snprintf(info->device, sizeof(info->device), "/dev/%s", entry->d_name);
+		info->rc = MI_SER_NORESP_ERR;
+
+		EnumReadUsb(info, entry->d_name);
+		EnumStableId(info);
+		count++;
+	}
+
+	closedir(dir);
+	return count;
+}
+
+/*
+ * Probe one device
+ * ----------------
+ * 38400bps first : this is the speed of a reader that has just been powered
+ */
+static void* EnumProbeThread(void* param)
+{
+	SPROX_READER_ENUM_ST* info = param;
+	SPROX_CTX_ST* sprox_ctx;
+	static const DWORD baudrates[] = { 38400, 115200 };
+	int i;
+
+	sprox_ctx = calloc(1, sizeof(SPROX_CTX_ST));
+	if (sprox_ctx == NULL)
+	{
+		info->rc = MI_OUT_OF_MEMORY_ERROR;
+		return NULL;
+	}
+	sprox_ctx->com_handle = -1;
+
+	if (!SerialOpen(sprox_ctx, info->device))
+	{
+		info->rc = MI_SER_ACCESS_ERR;
+		free(sprox_ctx);
+		return NULL;
+	}
+
+	for (i = 0; i < (int)(sizeof(baudrates) / sizeof(baudrates[0])); i++)
+	{
+		info->rc = SPROX_ReaderProbe(sprox_ctx, baudrates[i]);
+
+		if (info->rc == MI_OK)
+		{
+			SPROX_ReaderInfoToString(sprox_ctx, info->firmware, sizeof(info->firmware));
+			break;
+		}
+
+		/* The reader is there, but busy waiting for a card : its owner will cancel */
+		if (info->rc == MI_POLLING)
+			break;
+
+		if (info->rc == MI_SER_ACCESS_ERR)
+			break;
+	}
+
+	SerialClose(sprox_ctx);
+	free(sprox_ctx);
+	return NULL;
+}
+
+/**f* SpringProx.API/SPROX_EnumReaders
+ *
+ * NAME
+ *   SPROX_EnumReaders
+ *
+ * DESCRIPTION
+ *   List the readers connected to the host, probing all the candidate
+ *   devices at the same time (Linux only)
+ *
+ * INPUTS
+ *   SPROX_READER_ENUM_ST readers[] : buffer to receive the readers
+ *   WORD  max          : number of entries in readers
+ *   WORD *count        : number of readers found
+ *   DWORD flags        : SPROX_ENUM_LEGACY_SERIAL to look at the UARTs of the
+ *                        host too, SPROX_ENUM_ALL_DEVICES to list the devices
+ *                        where no reader has answered, SPROX_ENUM_NO_PROBE to
+ *                        list the candidate devices without opening them
+ *
+ * RETURNS
+ *   MI_OK                : success
+ *   MI_RESPONSE_OVERFLOW : more than max readers, the first max ones have been given
+ *   MI_LIB_CALL_ERROR    : invalid parameter
+ *
+ * NOTES
+ *   The device field is the name to give to SPROX_ReaderOpen. The stable_id
+ *   field stays the same when the reader is plugged again or the host reboots
+ *   (path in /dev/serial/by-id when udev is running).
+ *   rc tells MI_OK when the reader has answered, MI_POLLING when it is
+ *   waiting for a card on behalf of another program (firmware is empty then).
+ *   Don't call this function while the library is talking to a reader at
+ *   38400 or 115200bps on one of those devices : the probe would disturb it.
+ *
+ * SEE ALSO
+ *   SPROX_HotplugOpen
+ *
+ **/
+SPROX_API_FUNC(EnumReaders) (SPROX_READER_ENUM_ST readers[], WORD max, WORD* count, DWORD flags)
+{
+	SPROX_ENUM_CANDIDATE_ST* candidates;
+	WORD candidates_count, i, found;
+	SWORD rc = MI_OK;
+
+	if ((count == NULL) || ((readers == NULL) && (max != 0)))
+		return MI_LIB_CALL_ERROR;
+
+	candidates = calloc(ENUM_CANDIDATES_MAX, sizeof(SPROX_ENUM_CANDIDATE_ST));
+	if (candidates == NULL)
+		return MI_OUT_OF_MEMORY_ERROR;
+
+	candidates_count = EnumListCandidates(candidates, ENUM_CANDIDATES_MAX, flags);
+	SPROX_Trace(TRACE_ACCESS, "EnumReaders : %d candidate(s)", candidates_count);
+
+	if (!(flags & SPROX_ENUM_NO_PROBE))
+	{
+		for (i = 0; i < candidates_count; i++)
+			candidates[i].Started = !pthread_create(&candidates[i].Thread, NULL, EnumProbeThread, &candidates[i].Info);
+
+		/* Not enough threads ? Probe the remaining ones from here */
+		for (i = 0; i < candidates_count; i++)
+		{
+			if (candidates[i].Started)
+				pthread_join(candidates[i].Thread, NULL);
+			else
+				EnumProbeThread(&candidates[i].Info);
+		}
+	}
+
+	found = 0;
+	for (i = 0; i < candidates_count; i++)
+	{
+		if (!(flags & (SPROX_ENUM_ALL_DEVICES | SPROX_ENUM_NO_PROBE)) && (candidates[i].Info.rc != MI_OK) && (candidates[i].Info.rc != MI_POLLING))
+			continue;
+
+		SPROX_Trace(TRACE_ACCESS, "EnumReaders : %s (%s) rc=%d %s", candidates[i].Info.device, candidates[i].Info.stable_id, candidates[i].Info.rc, candidates[i].Info.firmware);
+
+		if (found < max)
+			readers[found] = candidates[i].Info;
+		else
+			rc = MI_RESPONSE_OVERFLOW;
+		found++;
+	}
+
+	free(candidates);
+
+	*count = (found < max) ? found : max;
+	return rc;
+}
+
+/**f* SpringProx.API/SPROX_HotplugOpen
+ *
+ * NAME
+ *   SPROX_HotplugOpen
+ *
+ * DESCRIPTION
+ *   Get a file descriptor that becomes readable when a serial device is
+ *   attached to or detached from the host (Linux only)
+ *
+ * INPUTS
+ *   int *fd            : the file descriptor, to be used with select/poll
+ *                        and SPROX_HotplugRead
+ *
+ * RETURNS
+ *   MI_OK              : success
+ *   MI_SER_ACCESS_ERR  : the kernel's uevent socket is not available
+ *
+ * SEE ALSO
+ *   SPROX_HotplugRead
+ *   SPROX_HotplugClose
+ *
+ **/
+SPROX_API_FUNC(HotplugOpen) (int* fd)
+{
+	struct sockaddr_nl addr;
+	int s;
+
+	if (fd == NULL)
+		return MI_LIB_CALL_ERROR;
+
+	s = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+	if (s < 0)
+		return MI_SER_ACCESS_ERR;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+	addr.nl_groups = 1; /* Kernel events */
+
+	if (bind(s, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+	{
+		close(s);
+		return MI_SER_ACCESS_ERR;
+	}
+
+	*fd = s;
+	return MI_OK;
+}
+
+/**f* SpringProx.API/SPROX_HotplugRead
+ *
+ * NAME
+ *   SPROX_HotplugRead
+ *
+ * DESCRIPTION
+ *   Retrieve the next attach or detach event
+ *
+ * INPUTS
+ *   int   fd           : the file descriptor from SPROX_HotplugOpen
+ *   BYTE *event        : SPROX_HOTPLUG_ATTACH or SPROX_HOTPLUG_DETACH
+ *   char  device[64]   : name of the device (/dev/ttyUSB0...)
+ *
+ * RETURNS
+ *   MI_OK              : an event has been retrieved
+ *   MI_POLLING         : no event pending
+ *
+ * NOTES
+ *   Only the devices SPROX_EnumReaders would probe are reported (without
+ *   SPROX_ENUM_LEGACY_SERIAL). On attach, udev may need a little time to
+ *   give the access rights on the device : retry SPROX_ReaderOpen or
+ *   SPROX_EnumReaders when they fail with MI_SER_ACCESS_ERR.
+ *
+ **/
+SPROX_API_FUNC(HotplugRead) (int fd, BYTE* event, char device[64])
+{
+	char buffer[4096];
+	const char* action;
+	const char* subsystem;
+	const char* devname;
+	const char* p;
+	ssize_t l;
+
+	if ((event == NULL) || (device == NULL))
+		return MI_LIB_CALL_ERROR;
+
+	for (;;)
+	{
+		l = recv(fd, buffer, sizeof(buffer) - 1, MSG_DONTWAIT);
+		if (l < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return MI_POLLING;
+		}
+		buffer[l] = '\0';
+
+		/* Message is "action@devpath", followed by "KEY=value" strings */
+		action = subsystem = devname = NULL;
+		for (p = buffer; p < buffer + l; p += strlen(p) + 1)
+		{
+			if (!strncmp(p, "ACTION=", 7))
+				action = p + 7;
+			else if (!strncmp(p, "SUBSYSTEM=", 10))
+				subsystem = p + 10;
+			else if (!strncmp(p, "DEVNAME=", 8))
+				devname = p + 8;
+		}
+
+		if ((action == NULL) || (subsystem == NULL) || (devname == NULL))
+			continue;
+		if (strcmp(subsystem, "tty"))
+			continue;
+		if (!strncmp(devname, "/dev/", 5))
+			devname += 5;
+		if (!EnumIsCandidate(devname, 0))
+			continue;
+
+		if (!strcmp(action, "add"))
+			*event = SPROX_HOTPLUG_ATTACH;
+		else if (!strcmp(action, "remove"))
+			*event = SPROX_HOTPLUG_DETACH;
+		else
+			continue;
+
+		snprintf(device, 64, "/dev/%s", devname);
+		SPROX_Trace(TRACE_ACCESS, "Hotplug : %s %s", action, device);
+		return MI_OK;
+	}
+}
+
+/**f* SpringProx.API/SPROX_HotplugClose
+ *
+ * NAME
+ *   SPROX_HotplugClose
+ *
+ * DESCRIPTION
+ *   Stop receiving the attach and detach events
+ *
+ * INPUTS
+ *   int   fd           : the file descriptor from SPROX_HotplugOpen
+ *
+ **/
+SPROX_API_FUNC(HotplugClose) (int fd)
+{
+	if (fd < 0)
+		return MI_LIB_CALL_ERROR;
+
+	close(fd);
+	return MI_OK;
+}
+
+#endif
@@ -33,6 +33,9 @@
    JDA 04/11/2011 : UserIO is deprecated, replaced by ModeIO
    JDA 21/11/2011 : added SPROX_ReaderRestart
    JDA 30/01/2012 : forget pcd_current_rf_protocol after ControlRF
+   AGT 19/10/2026 : forget whether the reader knows SPROX_FIND_IDENT in ReaderGetFeatures
+   AGT 19/10/2026 : reader version and firmware string moved to SPROX_ReaderSetInfo and
+                    SPROX_ReaderInfoToString, to be shared with the enumeration
 
  */
 #include "sprox_api_i.h"
@@ -648,6 +651,54 @@ SPROX_API_FUNC(Echo) (SPROX_PARAM  WORD len)
 	return rc;
 }
 
+/*
+ * Version of the reader, from the answer to SPROX_CSB_GET_INFOS
+ * -------------------------------------------------------------
+ * infolen is 0 when the reader doesn't know the command (CSB 3 or prior)
+ */
+void SPROX_ReaderSetInfo(SPROX_CTX_ST* sprox_ctx, WORD infolen)
+{
+	if (infolen == 0)
+	{
+		/* CSB 3 or prior */
+		sprox_ctx->sprox_version = 0x00000000;
+		memset(&sprox_ctx->sprox_info, 0x00, sizeof(sprox_ctx->sprox_info));
+		SPROX_Trace(TRACE_ALL, "Sprox version : old");
+	}
+	else
+	{
+		/* CSB 4 or SpringProx or... */
+		sprox_ctx->sprox_version = sprox_ctx->sprox_info.ver[0];  /* Major */
+		sprox_ctx->sprox_version *= 0x00000100;
+		sprox_ctx->sprox_version += sprox_ctx->sprox_info.ver[1]; /* Minor */
+		sprox_ctx->sprox_version *= 0x00000100;
+		sprox_ctx->sprox_version += sprox_ctx->sprox_info.ver[2];
+		SPROX_Trace(TRACE_ALL, "Sprox version : %08lX", sprox_ctx->sprox_version);
+	}
+}
+
+/*
+ * Firmware string, as returned by SPROX_ReaderGetFirmware
+ * -------------------------------------------------------
+ */
+void SPROX_ReaderInfoToString(SPROX_CTX_ST* sprox_ctx, char* buffer, size_t size)
+{
+	char    temp[20];
+
+	if (!sprox_ctx->sprox_version)
+	{
+		snprintf(buffer, size, "SPRINGCARD CSB3");
+	}
+	else
+	{
+		snprintf(buffer, size,
+			"SPRINGCARD %c%c%c%c", sprox_ctx->sprox_info.prd[0], sprox_ctx->sprox_info.prd[1], sprox_ctx->sprox_info.prd[2], sprox_ctx->sprox_info.prd[3]);
+		snprintf(temp, sizeof(temp),
+			" %X.%02X [%d]", sprox_ctx->sprox_info.ver[0], sprox_ctx->sprox_info.ver[1], sprox_ctx->sprox_info.ver[2]);
+		strlcat(buffer, temp, size);
+	}
+}
+
 /**f* SpringProx.API/SPROX_ReaderGetFirmware
  *
  * NAME
@@ -681,7 +732,6 @@ SPROX_API_FUNC(Echo) (SPROX_PARAM  WORD len)
 SPROX_API_FUNC(ReaderGetFirmware) (SPROX_PARAM  TCHAR firmware[], WORD len)
 {
 	char    buffer[64];
-	char    temp[20];
 	int     i;
 	WORD    l;
 	SWORD   rc;
@@ -698,42 +748,12 @@ SPROX_API_FUNC(ReaderGetFirmware) (SPROX_PARAM  TCHAR firmware[], WORD len)
 	if (rc != MI_OK)
 		return rc;
 
-	if (rc == MI_OK)
-	{
-		if (l == 0)
-		{
-			/* CSB 3 or prior */
-			sprox_ctx->sprox_version = 0x00000000;
-			memset(&sprox_ctx->sprox_info, 0x00, sizeof(sprox_ctx->sprox_info));
-			SPROX_Trace(TRACE_ALL, "Sprox version : old");
-		}
-		else
-		{
-			/* CSB 4 or SpringProx or... */
-			sprox_ctx->sprox_version = sprox_ctx->sprox_info.ver[0];  /* Major */
-			sprox_ctx->sprox_version *= 0x00000100;
-			sprox_ctx->sprox_version += sprox_ctx->sprox_info.ver[1]; /* Minor */
-			sprox_ctx->sprox_version *= 0x00000100;
-			sprox_ctx->sprox_version += sprox_ctx->sprox_info.ver[2];
-			SPROX_Trace(TRACE_ALL, "Sprox version : %08lX", sprox_ctx->sprox_version);
-		}
-	}
+	SPROX_ReaderSetInfo(sprox_ctx, l);
 
 	if ((firmware == NULL) || (len == 0))
 		return rc;
 
-	if (!sprox_ctx->sprox_version)
-	{
-		snprintf(buffer, sizeof(buffer), "SPRINGCARD CSB3");
-	}
-	else
-	{
-		snprintf(buffer, sizeof(buffer),
-			"SPRINGCARD %c%c%c%c", sprox_ctx->sprox_info.prd[0], sprox_ctx->sprox_info.prd[1], sprox_ctx->sprox_info.prd[2], sprox_ctx->sprox_info.prd[3]);
-		snprintf(temp, sizeof(temp),
-			" %X.%02X [%d]", sprox_ctx->sprox_info.ver[0], sprox_ctx->sprox_info.ver[1], sprox_ctx->sprox_info.ver[2]);
-		strlcat(buffer, temp, sizeof(buffer));
-	}
+	SPROX_ReaderInfoToString(sprox_ctx, buffer, sizeof(buffer));
 	l = (WORD)strlen(buffer);
 
 	if (l < len) l = len - 1;
@@ -833,6 +853,7 @@ SPROX_API_FUNC(ReaderGetFeatures) (SPROX_PARAM  DWORD* features)
 	SPROX_PARAM_TO_CTX;
 
 	sprox_ctx->sprox_capabilities = 0x00000000;
+	sprox_ctx->pcd_find_ident = 0;
 
 	/* Retrieve capabilities */
 	len = sizeof(buffer);
@@ -30,6 +30,10 @@
    JDA 28/02/2008 : created
    JDA 30/01/2012 : forget pcd_current_rf_protocol after ControlRF
    JDA 04/12/2013 : added SPROX_FindLpcd and SPROX_FindLpcdEx
+   AGT 19/10/2026 : added SPROX_FindIdent, SPROX_FindEx gets everything in one exchange when possible
+   AGT 19/10/2026 : SPROX_FIND_IDENT is sent only after SPROX_FindIdentEnable
+   AGT 19/10/2026 : SPROX_FindWaitCancel from another thread only sends its command
+   AGT 19/10/2026 : the UID SPROX_FIND_IDENT returns is checked against the size of uid
 
  */
 
@@ -81,9 +85,6 @@ SPROX_API_FUNC(FindEx) (SPROX_PARAM  WORD want_protos, WORD* got_proto, BYTE uid
 	SWORD rc;
 	SPROX_PARAM_TO_CTX;
 
-	/* Forget current mode so that later SetConfig will actually reconfigure the reader */
-	sprox_ctx->pcd_current_rf_protocol = 0;
-
 	if (infolen != NULL)
 	{
 		l_infolen = *infolen;
@@ -92,6 +93,9 @@ SPROX_API_FUNC(FindEx) (SPROX_PARAM  WORD want_protos, WORD* got_proto, BYTE uid
 
 	if (sprox_ctx->sprox_version < 0x00014600)
 	{
+		/* Forget current mode so that later SetConfig will actually reconfigure the reader */
+		sprox_ctx->pcd_current_rf_protocol = 0;
+
 		if (want_protos & 0x0002)
 		{
 			/* 14443-B */
@@ -167,104 +171,407 @@ SPROX_API_FUNC(FindEx) (SPROX_PARAM  WORD want_protos, WORD* got_proto, BYTE uid
 	}
 	else
 	{
-		BYTE buffer[64];
-		WORD buflen;
+		/* FIND then FIND_INFO, or one exchange after SPROX_FindIdentEnable */
+		if (infolen != NULL)
+			*infolen = l_infolen;
+
+		rc = SPROX_API_CALL(FindIdent) (SPROX_PARAM_P  want_protos, got_proto, uid, uidlen, info, infolen, NULL, NULL, NULL);
+	}
+
+	return rc;
+}
+
+/**f* SpringProx.API/SPROX_Find
+ *
+ * NAME
+ *   SPROX_Find
+ *
+ * DESCRIPTION
+ *   Automatic discovery of any contactless card in the field
+ *
+ * NOTES
+ *   This function is only avalaible for readers having version >= 1.44
+ *
+ * INPUTS
+ *   WORD want_protos   : bit-map of contactless family to look for
+ *   WORD *got_proto    : on exit, found contactless family
+ *                        (one bit only is set, or none)
+ *   BYTE uid[10]       : Unique IDentifier of the found card
+ *   BYTE *uidlen       : on input, size of UID
+ *                        on output, actual length of UID
+ *
+ * RETURNS
+ *   MI_OK              : success, one card selected
+ *   MI_NOTAGERR        : no card available in the RF field
+ *   Other code if internal or communication error has occured.
+ *
+ **/
+SPROX_API_FUNC(Find) (SPROX_PARAM  WORD want_protos, WORD* got_proto, BYTE uid[], BYTE* uidlen)
+{
+	SPROX_PARAM_TO_CTX;
+
+	return SPROX_API_CALL(FindEx) (SPROX_PARAM_P  want_protos, got_proto, uid, uidlen, NULL, NULL);
+}
+
+/* Value of pcd_find_ident */
+#define FIND_IDENT_UNKNOWN 0
+#define FIND_IDENT_YES     1
+#define FIND_IDENT_NO      2
+
+/* Size of the UID when the caller doesn't give it (BYTE uid[10]) */
+#define FIND_IDENT_UID_MAX 10
+
+/*
+ * RF configuration the reader is left in once it has found a card of this family
+ */
+static BYTE FindProtoToConfig(WORD proto)
+{
+	switch (proto)
+	{
+	case PROTO_14443_A: return CFG_MODE_ISO_14443_A;
+	case PROTO_14443_B: return CFG_MODE_ISO_14443_B;
+	case PROTO_INNOVATRON: return CFG_MODE_ISO_14443_Bi;
+	case PROTO_15693: return CFG_MODE_ISO_15693;
+	case PROTO_ICODE1: return CFG_MODE_ICODE1;
+	case PROTO_INSIDE_PICO_14443: return CFG_MODE_INSIDE_PICO_14443;
+	case PROTO_INSIDE_PICO_15693: return CFG_MODE_INSIDE_PICO_15693;
+	default: return 0;
+	}
+}
+
+/*
+ * Take one length-prefixed field out of the answer to SPROX_FIND_IDENT
+ */
+static BOOL FindIdentField(const BYTE buffer[], WORD buflen, WORD* offset, const BYTE** field, BYTE* fieldlen)
+{
+	if (*offset >= buflen)
+		return FALSE;
+
+	*fieldlen = buffer[(*offset)++];
+	if ((DWORD)*offset + *fieldlen > buflen)
+		return FALSE;
+
+	*field = &buffer[*offset];
+	*offset += *fieldlen;
+	return TRUE;
+}
+
+/**f* SpringProx.API/SPROX_FindIdent
+ *
+ * NAME
+ *   SPROX_FindIdent
+ *
+ * DESCRIPTION
+ *   Same as SPROX_FindEx, also returning the ATS (or any other protocol
+ *   data the reader got while activating the card) and the time the
+ *   reader spent in the discovery
+ *
+ * NOTES
+ *   By default the function sends SPROX_FIND then SPROX_FIND_INFO, as
+ *   SPROX_FindEx does ; ats and time_us are then always empty.
+ *   Once SPROX_FindIdentEnable has been called, the function tries
+ *   SPROX_FIND_IDENT first : a reader that knows it returns everything in
+ *   one exchange, and stays configured for the protocol of the card. The
+ *   library remembers when the reader doesn't.
+ *
+ * INPUTS
+ *   WORD want_protos   : bit-map of contactless family to look for
+ *   WORD *got_proto    : on exit, found contactless family
+ *                        (one bit only is set, or none)
+ *   BYTE uid[10]       : Unique IDentifier of the found card
+ *   BYTE *uidlen       : on input, size of UID (10 bytes if 0)
+ *                        on output, actual length of UID
+ *   BYTE info[32]      : Protocol-related information (see SPROX_FindEx)
+ *   BYTE *infolen      : on input, size of info
+ *                        on output, actual length of info
+ *   BYTE ats[32]       : ATS of an ISO 14443-A card the reader has already
+ *                        activated, empty otherwise
+ *   BYTE *atslen       : on input, size of ats
+ *                        on output, actual length of ats
+ *   DWORD *time_us     : time spent by the reader, in microseconds (0 if unknown)
+ *
+ * RETURNS
+ *   MI_OK              : success, one card selected
+ *   MI_NOTAGERR        : no card available in the RF field
+ *   MI_RESPONSE_OVERFLOW : uid is too small, *uidlen is the length of the UID
+ *   Other code if internal or communication error has occured.
+ *
+ * DETAILS
+ *   The answer to SPROX_FIND_IDENT is
+ *     got_proto (2 bytes, MSB first)
+ *     uidlen (1 byte), uid
+ *     infolen (1 byte), info
+ *     atslen (1 byte), ats
+ *     time_us (4 bytes, MSB first)
+ *
+ **/
+SPROX_API_FUNC(FindIdent) (SPROX_PARAM  WORD want_protos, WORD* got_proto, BYTE uid[], BYTE* uidlen, BYTE info[], BYTE* infolen, BYTE ats[], BYTE* atslen, DWORD* time_us)
+{
+	BYTE buffer[128];
+	WORD buflen;
+	BYTE l_uidlen = 0;
+	BYTE l_infolen = 0;
+	BYTE l_atslen = 0;
+	SWORD rc;
+	SPROX_PARAM_TO_CTX;
+
+	if (uidlen != NULL)
+		l_uidlen = *uidlen;
+	if (infolen != NULL)
+	{
+		l_infolen = *infolen;
+		*infolen = 0;
+	}
+	if (atslen != NULL)
+	{
+		l_atslen = *atslen;
+		*atslen = 0;
+	}
+	if (time_us != NULL)
+		*time_us = 0;
 
+	if (sprox_ctx->sprox_version < 0x00014600)
+	{
+		if (infolen != NULL)
+			*infolen = l_infolen;
+		return SPROX_API_CALL(FindEx) (SPROX_PARAM_P  want_protos, got_proto, uid, uidlen, info, infolen);
+	}
+
+	if (sprox_ctx->pcd_find_ident_enable && (sprox_ctx->pcd_find_ident != FIND_IDENT_NO))
+	{
 		buffer[0] = (BYTE)(want_protos / 0x0100);
 		buffer[1] = (BYTE)(want_protos % 0x0100);
 
 		buflen = sizeof(buffer);
-		rc = SPROX_DLG_FUNC(SPROX_PARAM_P  SPROX_FIND, buffer, 2, buffer, &buflen);
+		rc = SPROX_DLG_FUNC(SPROX_PARAM_P  SPROX_FIND_IDENT, buffer, 2, buffer, &buflen);
 
-		if (rc == MI_OK)
+		if (rc == MI_UNKNOWN_FUNCTION)
 		{
+			/* Don't ask again, go on with FIND and FIND_INFO */
+			sprox_ctx->pcd_find_ident = FIND_IDENT_NO;
+		}
+		else
+		{
+			const BYTE* field;
+			BYTE fieldlen;
+			WORD offset = 2;
+			WORD proto;
+
+			sprox_ctx->pcd_find_ident = FIND_IDENT_YES;
+
+			/* The reader has been reconfigured, whatever the result */
+			sprox_ctx->pcd_current_rf_protocol = 0;
+
+			if (rc != MI_OK)
+				return rc;
+
 			if (buflen < 2)
+				return MI_SER_LENGTH_ERR;
+
+			proto = buffer[0];
+			proto *= 0x0100;
+			proto += buffer[1];
+			if (got_proto != NULL)
+				*got_proto = proto;
+
+			if (!FindIdentField(buffer, buflen, &offset, &field, &fieldlen))
+				return MI_SER_LENGTH_ERR;
+			if (l_uidlen == 0)
 			{
-				rc = MI_SER_LENGTH_ERR;
+				/* No size given : a longer UID is not a UID */
+				if (fieldlen > FIND_IDENT_UID_MAX)
+					return MI_SER_LENGTH_ERR;
 			}
-			else
+			else if (fieldlen > l_uidlen)
 			{
-				if (got_proto != NULL)
-				{
-					*got_proto = buffer[0];
-					*got_proto *= 0x0100;
-					*got_proto += buffer[1];
-				}
+				*uidlen = fieldlen;
+				return MI_RESPONSE_OVERFLOW;
+			}
+			if (uid != NULL)
+				memcpy(uid, field, fieldlen);
+			if (uidlen != NULL)
+				*uidlen = fieldlen;
+
+			if (!FindIdentField(buffer, buflen, &offset, &field, &fieldlen))
+				return MI_SER_LENGTH_ERR;
+			if ((info != NULL) && (infolen != NULL) && (fieldlen <= l_infolen))
+			{
+				memcpy(info, field, fieldlen);
+				*infolen = fieldlen;
+			}
 
-				if (uid != NULL)
-					memcpy(uid, &buffer[2], buflen - 2);
+			if (!FindIdentField(buffer, buflen, &offset, &field, &fieldlen))
+				return MI_SER_LENGTH_ERR;
+			if ((ats != NULL) && (atslen != NULL) && (fieldlen <= l_atslen))
+			{
+				memcpy(ats, field, fieldlen);
+				*atslen = fieldlen;
+			}
 
-				if (uidlen != NULL)
-					*uidlen = (BYTE)(buflen - 2);
+			if ((offset + 4 <= buflen) && (time_us != NULL))
+			{
+				*time_us = buffer[offset++];
+				*time_us *= 0x00000100;
+				*time_us += buffer[offset++];
+				*time_us *= 0x00000100;
+				*time_us += buffer[offset++];
+				*time_us *= 0x00000100;
+				*time_us += buffer[offset++];
 			}
+
+			/* The card is selected, no need to configure the reader again to talk to it */
+			sprox_ctx->pcd_current_rf_protocol = FindProtoToConfig(proto);
+
+			return MI_OK;
 		}
+	}
 
-		if ((rc == MI_OK) && (info != NULL))
-		{
-			buffer[0] = SPROX_FIND_INFO_PROT_BYTES;
-			buflen = sizeof(buffer);
+	/* Forget current mode so that later SetConfig will actually reconfigure the reader */
+	sprox_ctx->pcd_current_rf_protocol = 0;
 
-			rc = SPROX_DLG_FUNC(SPROX_PARAM_P  SPROX_FIND_INFO, buffer, 1, buffer, &buflen);
+	buffer[0] = (BYTE)(want_protos / 0x0100);
+	buffer[1] = (BYTE)(want_protos % 0x0100);
 
-			if (rc == MI_OK)
+	buflen = sizeof(buffer);
+	rc = SPROX_DLG_FUNC(SPROX_PARAM_P  SPROX_FIND, buffer, 2, buffer, &buflen);
+
+	if (rc == MI_OK)
+	{
+		if (buflen < 2)
+		{
+			rc = MI_SER_LENGTH_ERR;
+		}
+		else
+		{
+			if (got_proto != NULL)
 			{
-				if (buflen <= l_infolen)
-				{
-					memcpy(info, buffer, buflen);
-					if (infolen != NULL)
-						*infolen = (BYTE)buflen;
-				}
+				*got_proto = buffer[0];
+				*got_proto *= 0x0100;
+				*got_proto += buffer[1];
 			}
-			else
+
+			if (uid != NULL)
+				memcpy(uid, &buffer[2], buflen - 2);
+
+			if (uidlen != NULL)
+				*uidlen = (BYTE)(buflen - 2);
+		}
+	}
+
+	if ((rc == MI_OK) && (info != NULL))
+	{
+		buffer[0] = SPROX_FIND_INFO_PROT_BYTES;
+		buflen = sizeof(buffer);
+
+		rc = SPROX_DLG_FUNC(SPROX_PARAM_P  SPROX_FIND_INFO, buffer, 1, buffer, &buflen);
+
+		if (rc == MI_OK)
+		{
+			if (buflen <= l_infolen)
 			{
-				rc = MI_OK;
+				memcpy(info, buffer, buflen);
+				if (infolen != NULL)
+					*infolen = (BYTE)buflen;
 			}
 		}
+		else
+		{
+			rc = MI_OK;
+		}
 	}
 
-
 	return rc;
 }
 
-/**f* SpringProx.API/SPROX_Find
+/**f* SpringProx.API/SPROX_FindIdentEnable
  *
  * NAME
- *   SPROX_Find
+ *   SPROX_FindIdentEnable
  *
  * DESCRIPTION
- *   Automatic discovery of any contactless card in the field
- *
- * NOTES
- *   This function is only avalaible for readers having version >= 1.44
+ *   Let SPROX_FindIdent and SPROX_FindEx try the single-exchange
+ *   SPROX_FIND_IDENT command first
  *
  * INPUTS
- *   WORD want_protos   : bit-map of contactless family to look for
- *   WORD *got_proto    : on exit, found contactless family
- *                        (one bit only is set, or none)
- *   BYTE uid[10]       : Unique IDentifier of the found card
- *   BYTE *uidlen       : on input, size of UID
- *                        on output, actual length of UID
+ *   BOOL enable        : TRUE to try SPROX_FIND_IDENT, FALSE to go back to
+ *                        SPROX_FIND then SPROX_FIND_INFO (default)
  *
  * RETURNS
- *   MI_OK              : success, one card selected
- *   MI_NOTAGERR        : no card available in the RF field
- *   Other code if internal or communication error has occured.
+ *   MI_OK              : success
+ *
+ * NOTES
+ *   SPROX_FIND_IDENT (0x64) is not part of the documented command set of
+ *   the readers. Enable it only for a firmware known to implement it ; a
+ *   reader that answers MI_UNKNOWN_FUNCTION is not asked again until the
+ *   next SPROX_ReaderGetFeatures.
  *
  **/
-SPROX_API_FUNC(Find) (SPROX_PARAM  WORD want_protos, WORD* got_proto, BYTE uid[], BYTE* uidlen)
+SPROX_API_FUNC(FindIdentEnable) (SPROX_PARAM  BOOL enable)
 {
 	SPROX_PARAM_TO_CTX;
 
-	return SPROX_API_CALL(FindEx) (SPROX_PARAM_P  want_protos, got_proto, uid, uidlen, NULL, NULL);
+	sprox_ctx->pcd_find_ident_enable = enable;
+	return MI_OK;
 }
 
+/**f* SpringProx.API/SPROX_FindWaitCancel
+ *
+ * NAME
+ *   SPROX_FindWaitCancel
+ *
+ * DESCRIPTION
+ *   Stop the reader waiting for a card (SPROX_FindWait, SPROX_FindLpcd)
+ *
+ * NOTES
+ *   May be called from another thread while SPROX_FindWait or SPROX_FindLpcd
+ *   waits for the answer of the reader : the command is only sent, and the
+ *   waiting function returns MI_QUIT (or the card, if it came at the same
+ *   time).
+ *
+ **/
 SPROX_API_FUNC(FindWaitCancel) (SPROX_PARAM_V)
 {
 	SPROX_PARAM_TO_CTX;
 
+	if (sprox_ctx->find_wait_pending)
+	{
+		/* Another thread is waiting for the answer, it will get it */
+		sprox_ctx->find_wait_broken = TRUE;
+		return SPROX_Function_SendOnly(sprox_ctx, SPROX_FIND_INFO);
+	}
+
 	return SPROX_DLG_FUNC(SPROX_PARAM_P  SPROX_FIND_INFO, NULL, 0, NULL, NULL);
 }
 
+/*
+ * The reader has accepted to wait for a card (MI_POLLING), now wait for the card
+ * The wait may be broken by SPROX_FindWaitCancel, from another thread
+ */
+static SWORD FindWaitAnswer(SPROX_PARAM  BYTE buffer[], WORD* buflen, WORD timeout_s)
+{
+	SWORD rc;
+	SPROX_PARAM_TO_CTX;
+
+	sprox_ctx->find_wait_broken = FALSE;
+	sprox_ctx->find_wait_pending = TRUE;
+
+	rc = SPROX_WRS_FUNC(SPROX_PARAM_P  buffer, buflen, timeout_s);
+
+	sprox_ctx->find_wait_pending = FALSE;
+
+	if (sprox_ctx->find_wait_broken)
+	{
+		/* The reader may answer both the wait and the cancel */
+		SPROX_Function_Drain(sprox_ctx);
+		sprox_ctx->find_wait_broken = FALSE;
+
+		if ((rc != MI_OK) || (*buflen < 2))
+			rc = MI_QUIT;
+	}
+
+	return rc;
+}
+
 
 
 SPROX_API_FUNC(FindWaitEx) (SPROX_PARAM  WORD want_protos, WORD* got_proto, BYTE uid[], BYTE* uidlen, BYTE info[], BYTE* infolen, WORD timeout_s, WORD interval_ms)
@@ -308,7 +615,7 @@ SPROX_API_FUNC(FindWaitEx) (SPROX_PARAM  WORD want_protos, WORD* got_proto, BYTE
 	{
 		/* Wait for the answer */
 		buflen = sizeof(buffer);
-		rc = SPROX_WRS_FUNC(SPROX_PARAM_P  buffer, &buflen, timeout_s);
+		rc = FindWaitAnswer(SPROX_PARAM_P  buffer, &buflen, timeout_s);
 	}
 
 	if (rc == MI_OK)
@@ -409,7 +716,7 @@ SPROX_API_FUNC(FindLpcdEx) (SPROX_PARAM  WORD want_protos, WORD* got_proto, BYTE
 	{
 		/* Wait for the answer */
 		buflen = sizeof(buffer);
-		rc = SPROX_WRS_FUNC(SPROX_PARAM_P  buffer, &buflen, timeout_s);
+		rc = FindWaitAnswer(SPROX_PARAM_P  buffer, &buflen, timeout_s);
 	}
 
 	if (rc == MI_OK)
@@ -18,6 +18,8 @@
 
 	JDA 17/12/2006 : creation
 	JDA 19/02/2007 : major improvements, first really working release
+	AGT 19/10/2026 : one libftdi context per reader, asynchronous transfers with
+	                 a deadline instead of the SIGALRM timer (libftdi >= 1.5)
 
 
 	note :
@@ -29,6 +31,12 @@
 	If you do not want to (or do not need to) link against libftdi and libusb,
 	define SPROX_API_NO_FTDI to disable this module.
 
+	The FTDI chip sends its modem status every latency period, so a read
+	returns (empty) long before its timeout : the timeout of ftdi_read_data
+	never fires. Instead, we submit the transfer and run the events of the
+	reader's own libusb context until it completes or its deadline is over.
+	Nothing is shared between the readers, so a process may open many of them.
+
 */
 
 #include "sprox_api_i.h"
@@ -36,44 +44,48 @@
 #if (defined (LINUX) && !defined(SPROX_API_NO_FTDI))
 
 #include <sys/time.h>
-#include <signal.h>
 
 //#undef D
 //#define D(x) x
 
-static struct ftdi_context ftdi_ctx;
-
 /*
  * Try to open the FTDI USB port as specified in device.
- * Format for device string is "FTDI:XXXX:YYYY" where
+ * Format for device string is "FTDI:XXXX:YYYY" or "FTDI:XXXX:YYYY:SERIAL" where
  * - XXXX is the Vendor ID
  * - YYYY is the Product ID
+ * - SERIAL is the serial number of the chip (to tell many readers apart)
  */
 BOOL FTDI_Open(SPROX_CTX_ST* sprox_ctx, const TCHAR* device)
 {
+	struct ftdi_context* ftdi;
+	const char* serial = NULL;
 	int ret;
 	int vid, pid;
 
 	if (sprox_ctx == NULL) return FALSE;
 	if ((device == NULL) || (!strlen(device))) return FALSE;
 	if (sscanf(device, "FTDI:%04X:%04X", &vid, &pid) != 2) return FALSE;
+	if ((strlen(device) > 15) && (device[14] == ':'))
+		serial = &device[15];
 
 	D(printf("Opening FTDI:%04X:%04X\n", vid, pid));
 
-	if (ftdi_init(&ftdi_ctx) < 0)
+	ftdi = ftdi_new();
+	if (ftdi == NULL)
 	{
-		fprintf(stderr, "ftdi_init: %s\n", ftdi_get_error_string(&ftdi_ctx));
+		fprintf(stderr, "ftdi_new failed\n");
 		return FALSE;
 	}
 
-	ret = ftdi_usb_open(&ftdi_ctx, vid, pid);
+	ret = ftdi_usb_open_desc(ftdi, vid, pid, NULL, serial);
 	if (ret < 0)
 	{
-		D(fprintf(stderr, "ftdi_usb_open: %s\n", ftdi_get_error_string(&ftdi_ctx)));
-		ftdi_deinit(&ftdi_ctx);
+		D(fprintf(stderr, "ftdi_usb_open: %s\n", ftdi_get_error_string(ftdi)));
+		ftdi_free(ftdi);
 		return FALSE;
 	}
 
+	sprox_ctx->com_ftdi = ftdi;
 	sprox_ctx->com_handle = ret; /* Don't really know what to do with this */
 	return TRUE;
 }
@@ -82,148 +94,123 @@ BOOL FTDI_Open(SPROX_CTX_ST* sprox_ctx, const TCHAR* device)
 void FTDI_Close(SPROX_CTX_ST* sprox_ctx)
 {
 	if (sprox_ctx == NULL) return;
-	if (sprox_ctx->com_handle != -1)
+	if (sprox_ctx->com_ftdi != NULL)
 	{
-		if (ftdi_usb_close(&ftdi_ctx) < 0)
-			fprintf(stderr, "ftdi_usb_close: %s\n", ftdi_get_error_string(&ftdi_ctx));
-		ftdi_deinit(&ftdi_ctx);
+		if (ftdi_usb_close(sprox_ctx->com_ftdi) < 0)
+			fprintf(stderr, "ftdi_usb_close: %s\n", ftdi_get_error_string(sprox_ctx->com_ftdi));
+		ftdi_free(sprox_ctx->com_ftdi);
+		sprox_ctx->com_ftdi = NULL;
 		sprox_ctx->com_handle = -1;
 	}
 }
 
 BOOL FTDI_SetBaudrate(SPROX_CTX_ST* sprox_ctx, DWORD baudrate)
 {
-	if (ftdi_set_baudrate(&ftdi_ctx, (int)baudrate) < 0)
+	struct ftdi_context* ftdi = sprox_ctx->com_ftdi;
+
+	if (ftdi_set_baudrate(ftdi, (int)baudrate) < 0)
 	{
-		fprintf(stderr, "ftdi_set_baudrate: %s\n", ftdi_get_error_string(&ftdi_ctx));
+		fprintf(stderr, "ftdi_set_baudrate: %s\n", ftdi_get_error_string(ftdi));
 		return FALSE;
 	}
 
-	if (ftdi_set_line_property(&ftdi_ctx, BITS_8, STOP_BIT_1, NONE) < 0)
+	if (ftdi_set_line_property(ftdi, BITS_8, STOP_BIT_1, NONE) < 0)
 	{
-		fprintf(stderr, "ftdi_set_line_property: %s\n", ftdi_get_error_string(&ftdi_ctx));
+		fprintf(stderr, "ftdi_set_line_property: %s\n", ftdi_get_error_string(ftdi));
 		return FALSE;
 	}
 
-	if (ftdi_setflowctrl(&ftdi_ctx, SIO_DISABLE_FLOW_CTRL) < 0)
+	if (ftdi_setflowctrl(ftdi, SIO_DISABLE_FLOW_CTRL) < 0)
 	{
-		fprintf(stderr, "ftdi_set_flowctrl: %s\n", ftdi_get_error_string(&ftdi_ctx));
+		fprintf(stderr, "ftdi_set_flowctrl: %s\n", ftdi_get_error_string(ftdi));
 		return FALSE;
 	}
 
 	return TRUE;
 }
 
-BOOL FTDI_SendBurst(SPROX_CTX_ST* sprox_ctx, BYTE* b, WORD len)
+/*
+ * Run the events of the reader's libusb context until the transfer completes,
+ * or until the deadline. The thread sleeps in libusb meanwhile.
+ * Returns the number of bytes transfered, or -1 (error or timeout)
+ */
+static int FTDI_WaitTransfer(SPROX_CTX_ST* sprox_ctx, struct ftdi_transfer_control* tc, DWORD deadline_ms)
 {
-	D(DWORD i);
-	int done;
-	int tosend;
-	int offset;
-
-	/* Set timeouts */
-	ftdi_ctx.usb_write_timeout = 1000;
+	struct timeval tv;
+	DWORD now_ms;
+	int ret;
 
-	tosend = len;
-	offset = 0;
+	if (tc == NULL)
+		return -1;
 
-	/* Loop until we've send the expected amount of data */
-	while (tosend)
+	while (!tc->completed)
 	{
-		done = ftdi_write_data(&ftdi_ctx, &b[offset], tosend);
-		if (done <= 0)
+		now_ms = SPROX_GetMonotonicMs();
+		if ((SDWORD)(deadline_ms - now_ms) <= 0)
 		{
-			fprintf(stderr, "ftdi_write_data: %s\n", ftdi_get_error_string(&ftdi_ctx));
-			return FALSE;
+			D(fprintf(stderr, "ftdi transfer: timeout\n"));
+			tv.tv_sec = 0;
+			tv.tv_usec = 100000;
+			ftdi_transfer_data_cancel(tc, &tv);
+			return -1;
 		}
-		tosend -= done;
-		offset += done;
-	}
-	if (done < len)
-	{
-		return FALSE;
-	}
 
-	D(for (i = 0; i < len; i++) printf("-%02X", b[i]););
-	D(printf("\n"));
-	return TRUE;
-}
+		tv.tv_sec = (deadline_ms - now_ms) / 1000;
+		tv.tv_usec = ((deadline_ms - now_ms) % 1000) * 1000;
 
-static volatile BOOL timer_overflow;
+		ret = libusb_handle_events_timeout_completed(sprox_ctx->com_ftdi->usb_ctx, &tv, &tc->completed);
+		if ((ret < 0) && (ret != LIBUSB_ERROR_INTERRUPTED))
+		{
+			fprintf(stderr, "libusb_handle_events: %s\n", libusb_error_name(ret));
+			tv.tv_sec = 0;
+			tv.tv_usec = 100000;
+			ftdi_transfer_data_cancel(tc, &tv);
+			return -1;
+		}
+	}
 
-static void timer_handler(int unused)
-{
-	timer_overflow = TRUE;
+	if ((tc->transfer != NULL) && (tc->transfer->status == LIBUSB_TRANSFER_NO_DEVICE))
+		sprox_ctx->com_lost = TRUE;
+
+	return ftdi_transfer_data_done(tc);
 }
 
-static void timer_start(DWORD ms_timeout)
+BOOL FTDI_SendBurst(SPROX_CTX_ST* sprox_ctx, const BYTE* b, WORD len)
 {
-	struct itimerval val;
+	struct ftdi_context* ftdi = sprox_ctx->com_ftdi;
+	D(DWORD i);
+	int done;
 
-	val.it_interval.tv_sec = 0;
-	val.it_interval.tv_usec = 0;
-	val.it_value.tv_sec = ms_timeout / 1000;
-	val.it_value.tv_usec = (ms_timeout % 1000) * 1000;
+	ftdi->usb_write_timeout = 1000;
 
-	timer_overflow = FALSE;
-	signal(SIGALRM, timer_handler);
-	if (setitimer(ITIMER_REAL, &val, NULL))
+	done = FTDI_WaitTransfer(sprox_ctx, ftdi_write_data_submit(ftdi, (unsigned char*)b, len), SPROX_GetMonotonicMs() + ftdi->usb_write_timeout);
+	if (done < len)
 	{
-		perror("setitimer");
+		fprintf(stderr, "ftdi_write_data: %s\n", (done < 0) ? "failed" : "short write");
+		return FALSE;
 	}
-}
 
+	D(for (i = 0; i < len; i++) printf("-%02X", b[i]););
+	D(printf("\n"));
+	return TRUE;
+}
 
 BOOL FTDI_RecvBurst(SPROX_CTX_ST* sprox_ctx, BYTE* b, WORD len)
 {
+	struct ftdi_context* ftdi = sprox_ctx->com_ftdi;
 	D(DWORD i);
+	DWORD timeout_ms;
 	int done;
-	int torecv;
-	int offset;
-
-	/* Set timeouts */
-	ftdi_ctx.usb_read_timeout = sprox_ctx->sprox_timeout.resp_tmo + len * sprox_ctx->sprox_timeout.byte_tmo;
 
-	torecv = len;
-	offset = 0;
+	/* Same timeout as before : the reader's answer, then each byte */
+	timeout_ms = sprox_ctx->sprox_timeout.resp_tmo + len * sprox_ctx->sprox_timeout.byte_tmo;
+	ftdi->usb_read_timeout = timeout_ms;
 
-	/* Loop until we've received the expected amount of data */
-	while (torecv)
+	done = FTDI_WaitTransfer(sprox_ctx, ftdi_read_data_submit(ftdi, b, len), SPROX_GetMonotonicMs() + timeout_ms);
+	if (done < len)
 	{
-		/*
-		 * TRICKY TRICKY TRICKY TRICKY // TODO TODO TODO TODO
-		 *
-		 * It seems that the usb_read_timeout has no effect at all (or really really little effect)
-		 * on actual timeouts in our test environment (Linux Kernel 2.4.27-2-386, Debian 3.3.6-8).
-		 *
-		 * To overcome this we use an infinite loop + an interval timer
-		 *
-		 */
-		timer_start(ftdi_ctx.usb_read_timeout);
-		while (!timer_overflow)
-		{
-			done = ftdi_read_data(&ftdi_ctx, &b[offset], torecv);
-			if (done != 0)
-				break;
-		}
-
-		if (done == 0)
-		{
-			D(fprintf(stderr, "ftdi_read_data: timeout\n"));
-			D(for (i = 0; i < offset; i++) printf("+%02X", b[i]););
-			D(printf("\n"));
-			return FALSE;
-		}
-
-		if (done < 0)
-		{
-			fprintf(stderr, "ftdi_read_data: %s\n", ftdi_get_error_string(&ftdi_ctx));
-			return FALSE;
-		}
-		torecv -= done;
-		offset += done;
-
-		ftdi_ctx.usb_read_timeout = torecv * sprox_ctx->sprox_timeout.byte_tmo;
+		D(fprintf(stderr, "ftdi_read_data: %s\n", (done < 0) ? "failed or timeout" : "short read"));
+		return FALSE;
 	}
 
 	D(for (i = 0; i < len; i++) printf("+%02X", b[i]););
@@ -17,6 +17,8 @@
   JDA 16/05/2003 : added some strings
 				   added helpers functions for Delphi and VB users
   LTC 26/02/2008 : added some strings for ISO 15693 and ICODE1
+  AGT 19/10/2026 : added SPROX_GetMonotonicTime
+  AGT 19/10/2026 : added MI_READER_BUSY
 
 */
 
@@ -28,6 +30,10 @@
  **/
 #include "sprox_api_i.h"
 
+#ifndef WIN32
+#include <time.h>
+#endif
+
 #ifndef SPROX_API_NO_MSG
 
  /**f* SpringProx.API/SPROX_GetErrorMessage
@@ -196,6 +202,8 @@ SPROX_API_FUNC_T(const TCHAR*, GetErrorMessage) (SWORD status)
 		return _T("Library: An internal error has occured");
 	case MI_INVALID_READER_CONTEXT:
 		return _T("Library: the sprox_ctx parameter is invalid");
+	case MI_READER_BUSY:
+		return _T("Library: The shared reader is locked by another application");
 	}
 
 #ifdef WIN32
@@ -493,3 +501,36 @@ SPROX_API_FUNC(Free) (BYTE* buffer)
 
 #endif
 
+
+/*
+ * Monotonic clock, for the timeouts and the timestamps of the library
+ * (unlike time(NULL), it doesn't jump when the wall clock is adjusted)
+ */
+void SPROX_GetMonotonicTime(DWORD* sec, DWORD* usec)
+{
+#if defined(UNDER_CE)
+	DWORD t = GetTickCount();
+	*sec = t / 1000;
+	*usec = (t % 1000) * 1000;
+#elif defined(WIN32)
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER t;
+	if (!freq.QuadPart)
+		QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&t);
+	*sec = (DWORD)(t.QuadPart / freq.QuadPart);
+	*usec = (DWORD)(((t.QuadPart % freq.QuadPart) * 1000000) / freq.QuadPart);
+#else
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	*sec = (DWORD)t.tv_sec;
+	*usec = (DWORD)(t.tv_nsec / 1000);
+#endif
+}
+
+DWORD SPROX_GetMonotonicMs(void)
+{
+	DWORD sec, usec;
+	SPROX_GetMonotonicTime(&sec, &usec);
+	return sec * 1000 + usec / 1000;
+}
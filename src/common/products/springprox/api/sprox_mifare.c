@@ -1537,6 +1537,240 @@ SPROX_API_FUNC(MifStWriteTag768) (SPROX_PARAM  const BYTE snr[4], WORD* sectors,
 
 }
 
+/*
+ * Internal function to read or write a whole Mifare classic tag (1k, 2k or 4k)
+ * ----------------------------------------------------------------------------
+ */
+static SWORD MifStRWTag(SPROX_PARAM  BOOL w, const BYTE* snr, BYTE sector_count, const BYTE* key_map[], BYTE sectors[], BYTE* data)
+{
+	SWORD   rc;
+	BYTE    sectors_ok[5];
+	BYTE    sect;
+	WORD    bulk_mask = 0x0000;
+	DWORD   offset;
+	BOOL    need_select = FALSE;
+	SPROX_PARAM_TO_CTX;
+
+	if (!sprox_ctx->sprox_version)
+		return MI_FUNCTION_NOT_AVAILABLE;
+	if ((sector_count == 0) || (sector_count > 40))
+		return MI_LIB_CALL_ERROR;
+	if (sectors == NULL)
+		return MI_LIB_CALL_ERROR;
+	if (data == NULL)
+		return MI_LIB_CALL_ERROR;
+
+	/* The tag is selected only once, sectors are then chained without re-selecting it */
+	rc = SPROX_API_CALL(MifStSelectAgain) (SPROX_PARAM_P  snr);
+	if (rc != MI_OK)
+		return rc;
+
+	memset(sectors_ok, 0, sizeof(sectors_ok));
+
+	if ((sprox_ctx->sprox_capabilities & SPROX_WITH_XXL_BUFFERS) && (sector_count >= 16))
+	{
+		/* The CSB is able to process the 16 first sectors in a single exchange, */
+		/* but only using its own keys                                           */
+		WORD    mask = 0x0000;
+
+		for (sect = 0; sect < 16; sect++)
+		{
+			if ((sectors[sect / 8] & (1 << (sect % 8))) && ((key_map == NULL) || (key_map[sect] == NULL)))
+				mask |= (1 << sect);
+		}
+
+		if (mask != 0x0000)
+		{
+			BYTE    buffer[770];
+			WORD    length;
+
+			if (w)
+			{
+				buffer[0] = (BYTE)(mask / 0x0100);
+				buffer[1] = (BYTE)(mask % 0x0100);
+				memcpy(&buffer[2], data, 768);
+				length = 2;
+
+				rc = SPROX_DLG_FUNC(SPROX_PARAM_P  SPROX_CSB_WRITE_SECT, buffer, sizeof(buffer), buffer, &length);
+				if ((rc == MI_OK) && (length != 2))
+					rc = MI_WRONG_LENGTH;
+			}
+			else
+			{
+				buffer[0] = 0xFF;
+				buffer[1] = (BYTE)(mask / 0x0100);
+				buffer[2] = (BYTE)(mask % 0x0100);
+				length = sizeof(buffer);
+
+				rc = SPROX_DLG_FUNC(SPROX_PARAM_P  SPROX_CSB_READ_SECT, buffer, 3, buffer, &length);
+				if ((rc == MI_OK) && (length != 770))
+					rc = MI_WRONG_LENGTH;
+				if (rc == MI_OK)
+				{
+					for (sect = 0; sect < 16; sect++)
+						if (mask & (1 << sect))
+							memcpy(&data[48 * sect], &buffer[2 + 48 * sect], 48);
+				}
+			}
+
+			if (rc != MI_OK)
+				goto exit_proc;
+
+			sectors_ok[0] = buffer[1];
+			sectors_ok[1] = buffer[0];
+			bulk_mask = mask;
+
+			/* The CSB leaves the tag in an unknown state */
+			need_select = TRUE;
+		}
+	}
+
+	for (sect = 0; sect < sector_count; sect++)
+	{
+		if ((sect < 16) && (bulk_mask & (1 << sect)))
+			continue; /* Already processed by the CSB */
+
+		if (sect < 32)
+			offset = 48 * (DWORD) sect;
+		else
+			offset = 48 * 32 + 240 * (DWORD) (sect - 32);
+
+		if (!(sectors[sect / 8] & (1 << (sect % 8))))
+			continue;
+
+		if (need_select)
+		{
+			/* A previous authentication has failed, the tag must be woken-up again */
+			rc = SPROX_API_CALL(MifStSelectAgain) (SPROX_PARAM_P  snr);
+			if (rc != MI_OK)
+				break;
+			need_select = FALSE;
+		}
+
+		if ((key_map != NULL) && (key_map[sect] != NULL))
+			rc = MifStRWSectorKey(SPROX_PARAM_P  w, NULL, sect, &data[offset], key_map[sect]);
+		else
+			rc = MifStRWSector(SPROX_PARAM_P  w, NULL, sect, &data[offset]);
+
+		if (rc == MI_OK)
+		{
+			/* Success with this sector */
+			sectors_ok[sect / 8] |= (1 << (sect % 8));
+		}
+		else if ((rc != MI_AUTHERR) && (rc != MI_NOTAUTHERR))
+		{
+			/* Fatal (?) error */
+			break;
+		}
+		else
+		{
+			/* Dummy OK for this one */
+			need_select = TRUE;
+			rc = MI_OK;
+		}
+	}
+
+exit_proc:
+	memcpy(sectors, sectors_ok, (sector_count + 7) / 8);
+
+	SPROX_Trace(TRACE_DEBUG, "MifSt%sTag %d -> %d", w ? "Write" : "Read", sector_count, rc);
+	return rc;
+}
+
+/**f* SpringProx.API/SPROX_MifStReadTag
+ *
+ * NAME
+ *   SPROX_MifStReadTag
+ *
+ * DESCRIPTION
+ *   Read a whole Mifare classic tag (1k, 2k or 4k), using a key per sector or
+ *   internally available keys for authentication.
+ *
+ * INPUTS
+ *   const BYTE snr[4]      : 4-byte UID of the Mifare card to read
+ *                            If NULL, the reader will work with currently selected tag
+ *   BYTE sector_count      : number of sectors of the tag (16 for a 1k, 32 for a
+ *                            2k, 40 for a 4k)
+ *   const BYTE *key_map[]  : array of sector_count pointers to the 6-byte key of
+ *                            each sector (either A or B)
+ *                            A NULL entry (or a NULL key_map) means that the reader
+ *                            will try all the preloaded keys for this sector
+ *   BYTE sectors[5]        : bit-array, bit b(i%8) of sectors[i/8] standing for sector i
+ *                            - in input, bit set means that sector i must be read
+ *                            - in output, bit set means that sector i has been
+ *                              successfully read
+ *   BYTE data[]            : buffer to receive the data. Sector trailers are not
+ *                            included, so its size is 768 bytes for a 1k, 1536 bytes
+ *                            for a 2k, and 3456 bytes for a 4k
+ *
+ * RETURNS
+ *   MI_OK              : success, some data have been read. Check the sectors bit-
+ *                        array to see which sectors have been read
+ *   MI_NOTAGERR        : the required tag is not available in the RF field,
+ *                        or the supplied key has been denied
+ *   Other code if internal or communication error has occured.
+ *
+ * NOTES
+ *   The tag is selected only once. It is selected again only after a sector has
+ *   been denied.
+ *
+ *   When the reader has XXL buffers, all the sectors among the 16 first ones
+ *   that are to be read using the preloaded keys are read in a single exchange,
+ *   as in SPROX_MifStReadTag768.
+ *
+ * SEE ALSO
+ *   SPROX_MifStReadSector
+ *   SPROX_MifStReadTag768
+ *   SPROX_MifStWriteTag
+ *
+ **/
+SPROX_API_FUNC(MifStReadTag) (SPROX_PARAM  const BYTE snr[4], BYTE sector_count, const BYTE* key_map[], BYTE sectors[], BYTE data[])
+{
+	return MifStRWTag(SPROX_PARAM_P  FALSE, snr, sector_count, key_map, sectors, data);
+}
+
+/**f* SpringProx.API/SPROX_MifStWriteTag
+ *
+ * NAME
+ *   SPROX_MifStWriteTag
+ *
+ * DESCRIPTION
+ *   Write a whole Mifare classic tag (1k, 2k or 4k), using a key per sector or
+ *   internally available keys for authentication.
+ *
+ * INPUTS
+ *   const BYTE snr[4]      : 4-byte UID of the Mifare card to write
+ *                            If NULL, the reader will work with currently selected tag
+ *   BYTE sector_count      : number of sectors of the tag (16 for a 1k, 32 for a
+ *                            2k, 40 for a 4k)
+ *   const BYTE *key_map[]  : array of sector_count pointers to the 6-byte key of
+ *                            each sector (either A or B)
+ *                            A NULL entry (or a NULL key_map) means that the reader
+ *                            will try all the preloaded keys for this sector
+ *   BYTE sectors[5]        : bit-array, bit b(i%8) of sectors[i/8] standing for sector i
+ *                            - in input, bit set means that sector i must be written
+ *                            - in output, bit set means that sector i has been
+ *                              successfully written
+ *   const BYTE data[]      : buffer of data, laid out as in SPROX_MifStReadTag
+ *
+ * RETURNS
+ *   MI_OK              : success, some data have been written. Check the sectors bit-
+ *                        array to see which sectors have been written
+ *   MI_NOTAGERR        : the required tag is not available in the RF field,
+ *                        or the supplied key has been denied
+ *   Other code if internal or communication error has occured.
+ *
+ * SEE ALSO
+ *   SPROX_MifStWriteSector
+ *   SPROX_MifStWriteTag768
+ *   SPROX_MifStReadTag
+ *
+ **/
+SPROX_API_FUNC(MifStWriteTag) (SPROX_PARAM  const BYTE snr[4], BYTE sector_count, const BYTE* key_map[], BYTE sectors[], const BYTE data[])
+{
+	return MifStRWTag(SPROX_PARAM_P  TRUE, snr, sector_count, key_map, sectors, (BYTE*)data);
+}
+
 
 /*
  * Internal functions to encode / decode a counter
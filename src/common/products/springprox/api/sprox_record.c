@@ -0,0 +1,631 @@
+/**h* SpringProx.API/Record
+ *
+ * NAME
+ *   SpringProx.API :: Record and replay of the traffic with the reader
+ *
+ * DESCRIPTION
+ *   Record : every SPROX_Function (and SPROX_FunctionWaitResp, and each
+ *   function of a SPROX_FunctionBatch) is written to a file, with the
+ *   command, the response, the status, and when it has started and how
+ *   long it has taken. The random numbers the card
+ *   libraries draw for their authentications are written as well (see
+ *   SPROX_RecordRandom).
+ *   Replay : SPROX_ReaderOpen("REPLAY:<file>") opens a recording instead of
+ *   a reader. The commands must come in the same order, with the same data ;
+ *   the recorded responses are served without any delay, or after the time
+ *   they have taken when recorded.
+ *   Without changing the application :
+ *   - SPROX_RECORD=<file> records from the first SPROX_ReaderOpen,
+ *   - SPROX_REPLAY=<file> makes every SPROX_ReaderOpen replay the file,
+ *   - SPROX_REPLAY_TIMED=1 replays with the original timing.
+ *
+ *   File format (the integers are MSB first) :
+ *   - "SPROXREC", format version (1 byte), the reader's identity (GET_INFOS
+ *     response, 16 bytes), firmware version (4 bytes), capabilities (4 bytes)
+ *   - then one entry per exchange : type (1 byte), start time in ms since the
+ *     start of the recording (4 bytes), duration in us (4 bytes), command
+ *     (1 byte), status as -rc (1 byte), command length (2 bytes), response
+ *     length (2 bytes), command data, response data.
+ *
+ * PORTABILITY
+ *   Win32 and Linux
+ *
+ **/
+
+ /*
+
+   SpringProx API
+   --------------
+
+   Copyright (c) 2026 SpringCard SAS, FRANCE - www.springcard.com
+
+   THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+   ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+   TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+   PARTICULAR PURPOSE.
+
+   History
+   -------
+
+   AGT 19/10/2026 : created
+
+ */
+
+#include "sprox_api_i.h"
+
+#define RECORD_MAGIC        "SPROXREC"
+#define RECORD_VERSION      2
+#define RECORD_HEADER_SIZE  (8 + 1 + 16 + 4 + 4)
+#define RECORD_ENTRY_SIZE   15
+
+/* Times in us, on 64 bits : a recording (or a process) may well last more than 71 minutes */
+#ifdef WIN32
+typedef unsigned __int64 RECORD_US;
+#else
+typedef uint64_t RECORD_US;
+#endif
+
+typedef struct
+{
+	FILE* fp;
+	RECORD_US started_us;       /* Start of the recording */
+	RECORD_US exchange_us;      /* Start of the current exchange */
+	DWORD exchanges;
+	RECORD_US reader_us;        /* Time spent in the exchanges */
+	BOOL  whole_process;    /* Set from the environment : goes on after SPROX_ReaderClose */
+} SPROX_RECORD_ST;
+
+typedef struct
+{
+	BYTE* data;
+	DWORD size;
+	DWORD offset;
+	DWORD entry;            /* Index of the next entry, for the traces */
+	BOOL  timed;
+	RECORD_US started_us;       /* When the recording has been opened */
+	DWORD exchanges;
+	RECORD_US reader_us;        /* Time the exchanges have taken when recorded */
+	RECORD_US inside_us;        /* Time spent in the exchanges now */
+	BOOL  whole_process;    /* Set from the environment : goes on after SPROX_ReaderClose */
+} SPROX_REPLAY_ST;
+
+typedef struct
+{
+	BYTE  type;
+	DWORD at_ms;
+	DWORD duration_us;
+	BYTE  cmd;
+	BYTE  status;
+	WORD  send_len;
+	WORD  recv_len;
+	const BYTE* send_data;
+	const BYTE* recv_data;
+} RECORD_ENTRY_ST;
+
+static RECORD_US Record_Now(void)
+{
+	DWORD sec, usec;
+	SPROX_GetMonotonicTime(&sec, &usec);
+	return (RECORD_US)sec * 1000000 + usec;
+}
+
+static void Record_PutDword(BYTE buffer[], DWORD value)
+{
+	buffer[0] = (BYTE)(value >> 24);
+	buffer[1] = (BYTE)(value >> 16);
+	buffer[2] = (BYTE)(value >> 8);
+	buffer[3] = (BYTE)value;
+}
+
+static DWORD Record_GetDword(const BYTE buffer[])
+{
+	return ((DWORD)buffer[0] << 24) | ((DWORD)buffer[1] << 16) | ((DWORD)buffer[2] << 8) | buffer[3];
+}
+
+/*
+ * Recording
+ * ---------
+ */
+SWORD SPROX_Record_Start(SPROX_CTX_ST* sprox_ctx, const char filename[], BOOL whole_process)
+{
+	SPROX_RECORD_ST* record;
+	BYTE header[RECORD_HEADER_SIZE];
+
+	SPROX_Record_Stop(sprox_ctx, TRUE);
+
+	record = calloc(1, sizeof(SPROX_RECORD_ST));
+	if (record == NULL)
+		return MI_OUT_OF_MEMORY_ERROR;
+
+	record->fp = fopen(filename, "wb");
+	if (record->fp == NULL)
+	{
+		SPROX_Trace(TRACE_ACCESS, "Record:failed to create %s", filename);
+		free(record);
+		return MI_LIB_CALL_ERROR;
+	}
+
+	memcpy(&header[0], RECORD_MAGIC, 8);
+	header[8] = RECORD_VERSION;
+	memcpy(&header[9], &sprox_ctx->sprox_info, 16);
+	Record_PutDword(&header[25], sprox_ctx->sprox_version);
+	Record_PutDword(&header[29], sprox_ctx->sprox_capabilities);
+	fwrite(header, sizeof(header), 1, record->fp);
+	fflush(record->fp);
+
+	record->started_us = Record_Now();
+	record->whole_process = whole_process;
+	sprox_ctx->record = record;
+
+	SPROX_Trace(TRACE_ACCESS, "Record:recording to %s", filename);
+	return MI_OK;
+}
+
+void SPROX_Record_Stop(SPROX_CTX_ST* sprox_ctx, BOOL forced)
+{
+	SPROX_RECORD_ST* record = sprox_ctx->record;
+
+	if (record == NULL)
+		return;
+
+	/* The application may open the reader again */
+	if (record->whole_process && !forced)
+		return;
+
+	SPROX_Trace(TRACE_ACCESS, "Record:%lu exchange(s), %lums in the reader, %lums in the host", record->exchanges, (DWORD)(record->reader_us / 1000), (DWORD)((Record_Now() - record->started_us - record->reader_us) / 1000));
+
+	fclose(record->fp);
+	free(record);
+	sprox_ctx->record = NULL;
+}
+
+static void Record_Write(SPROX_RECORD_ST* record, BYTE type, RECORD_US at_us, DWORD duration_us, BYTE cmd, SWORD rc, const BYTE send_data[], WORD send_len, const BYTE recv_data[], WORD recv_len)
+{
+	BYTE entry[RECORD_ENTRY_SIZE];
+
+	if (send_data == NULL)
+		send_len = 0;
+	if (recv_data == NULL)
+		recv_len = 0;
+
+	entry[0] = type;
+	Record_PutDword(&entry[1], (DWORD)((at_us - record->started_us) / 1000));
+	Record_PutDword(&entry[5], duration_us);
+	entry[9] = cmd;
+	entry[10] = (BYTE)(0 - rc);
+	entry[11] = (BYTE)(send_len >> 8);
+	entry[12] = (BYTE)send_len;
+	entry[13] = (BYTE)(recv_len >> 8);
+	entry[14] = (BYTE)recv_len;
+
+	fwrite(entry, sizeof(entry), 1, record->fp);
+	if (send_len)
+		fwrite(send_data, send_len, 1, record->fp);
+	if (recv_len)
+		fwrite(recv_data, recv_len, 1, record->fp);
+
+	/* A field problem may well end with a crash : keep what we have */
+	fflush(record->fp);
+}
+
+void SPROX_Record_Begin(SPROX_CTX_ST* sprox_ctx)
+{
+	SPROX_RECORD_ST* record = sprox_ctx->record;
+
+	if (record != NULL)
+		record->exchange_us = Record_Now();
+}
+
+void SPROX_Record_End(SPROX_CTX_ST* sprox_ctx, BYTE type, BYTE cmd, const BYTE send_data[], WORD send_len, SWORD rc, const BYTE recv_data[], const WORD* recv_len)
+{
+	SPROX_RECORD_ST* record = sprox_ctx->record;
+	DWORD duration_us;
+
+	if (record == NULL)
+		return;
+
+	duration_us = (DWORD)(Record_Now() - record->exchange_us);
+	record->exchanges++;
+	record->reader_us += duration_us;
+
+	/* The response is only meaningful on success */
+	if ((rc != MI_OK) || (recv_len == NULL))
+		recv_data = NULL;
+
+	Record_Write(record, type, record->exchange_us, duration_us, cmd, rc, send_data, send_len, recv_data, (recv_data != NULL) ? *recv_len : 0);
+}
+
+/*
+ * A batch sent at once (see SPROX_TCP_FunctionBatch) : written as the functions
+ * it is made of, so it is replayed as SPROX_FunctionBatch does without a network
+ * reader. The time of the batch is shared among them
+ */
+void SPROX_Record_EndBatch(SPROX_CTX_ST* sprox_ctx, const SPROX_FUNCTION_ST functions[], WORD count)
+{
+	SPROX_RECORD_ST* record = sprox_ctx->record;
+	DWORD duration_us;
+	WORD i;
+
+	if ((record == NULL) || (count == 0))
+		return;
+
+	duration_us = (DWORD)((Record_Now() - record->exchange_us) / count);
+
+	for (i = 0; i < count; i++)
+	{
+		record->exchanges++;
+		record->reader_us += duration_us;
+
+		Record_Write(record, SPROX_RECORD_FUNCTION, record->exchange_us + (RECORD_US)i * duration_us, duration_us, functions[i].cmd, functions[i].rc, functions[i].send_buffer, functions[i].send_bytelen,
+		             (functions[i].rc == MI_OK) ? functions[i].recv_buffer : NULL, functions[i].recv_bytelen);
+	}
+}
+
+/*
+ * Replay
+ * ------
+ */
+static BOOL Replay_Peek(SPROX_REPLAY_ST* replay, RECORD_ENTRY_ST* entry)
+{
+	const BYTE* p = &replay->data[replay->offset];
+
+	if ((replay->size - replay->offset) < RECORD_ENTRY_SIZE)
+		return FALSE;
+
+	entry->type = p[0];
+	entry->at_ms = Record_GetDword(&p[1]);
+	entry->duration_us = Record_GetDword(&p[5]);
+	entry->cmd = p[9];
+	entry->status = p[10];
+	entry->send_len = (p[11] << 8) | p[12];
+	entry->recv_len = (p[13] << 8) | p[14];
+
+	if ((replay->size - replay->offset - RECORD_ENTRY_SIZE) < ((DWORD)entry->send_len + entry->recv_len))
+		return FALSE;
+
+	entry->send_data = &p[RECORD_ENTRY_SIZE];
+	entry->recv_data = &p[RECORD_ENTRY_SIZE + entry->send_len];
+	return TRUE;
+}
+
+static void Replay_Skip(SPROX_REPLAY_ST* replay, const RECORD_ENTRY_ST* entry)
+{
+	replay->offset += RECORD_ENTRY_SIZE + entry->send_len + entry->recv_len;
+	replay->entry++;
+}
+
+static void Replay_Wait(RECORD_US until_us)
+{
+	RECORD_US now_us = Record_Now();
+
+	if (until_us <= now_us)
+		return;
+
+#ifdef WIN32
+	Sleep((DWORD)((until_us - now_us) / 1000));
+#else
+	usleep((useconds_t)(until_us - now_us));
+#endif
+}
+
+SWORD SPROX_Replay_Function(SPROX_CTX_ST* sprox_ctx, BYTE type, BYTE cmd, const BYTE send_data[], WORD send_len, BYTE recv_data[], WORD* recv_len)
+{
+	SPROX_REPLAY_ST* replay = sprox_ctx->replay;
+	RECORD_ENTRY_ST entry;
+	RECORD_US started_us = Record_Now();
+	SWORD rc;
+
+	if ((replay == NULL) || (sprox_ctx->com_status < COM_STATUS_OPEN_IDLE))
+		return MI_SER_ACCESS_ERR;
+
+	if (send_data == NULL)
+		send_len = 0;
+
+	if (!Replay_Peek(replay, &entry))
+	{
+		SPROX_Trace(TRACE_DLG_HI, "Replay:end of the recording");
+		return MI_SER_NORESP_ERR;
+	}
+
+	if ((entry.type != type) || (entry.cmd != cmd) || (entry.send_len != send_len) || (send_len && memcmp(entry.send_data, send_data, send_len)))
+	{
+		/* The application doesn't do what it has done when recorded : stay there */
+		SPROX_Trace(TRACE_DLG_HI, "Replay:entry %lu is %c %02X (%d bytes), not %c %02X (%d bytes)", replay->entry, entry.type, entry.cmd, entry.send_len, type, cmd, send_len);
+		return MI_SER_PROTO_ERR;
+	}
+	Replay_Skip(replay, &entry);
+
+	rc = (0 - entry.status);
+
+	if (rc == MI_OK)
+	{
+		if ((recv_len != NULL) && (*recv_len != 0) && (*recv_len < entry.recv_len))
+		{
+			rc = MI_RESPONSE_OVERFLOW;
+		}
+		else
+		{
+			if ((recv_data != NULL) && entry.recv_len)
+				memcpy(recv_data, entry.recv_data, entry.recv_len);
+			if (recv_len != NULL)
+				*recv_len = entry.recv_len;
+		}
+	}
+
+	if (replay->timed)
+		Replay_Wait(started_us + entry.duration_us);
+
+	replay->exchanges++;
+	replay->reader_us += entry.duration_us;
+	replay->inside_us += Record_Now() - started_us;
+
+	return rc;
+}
+
+SWORD SPROX_Replay_ReaderOpen(SPROX_CTX_ST* sprox_ctx, const char filename[], BOOL whole_process)
+{
+	SPROX_REPLAY_ST* replay;
+	FILE* fp;
+	long size;
+	const char* timed;
+
+	/* The application opens the reader again : go on from where it has stopped */
+	replay = sprox_ctx->replay;
+	if (replay != NULL)
+	{
+		if (replay->whole_process && whole_process)
+			goto opened;
+		free(replay->data);
+		free(replay);
+		sprox_ctx->replay = NULL;
+	}
+
+	fp = fopen(filename, "rb");
+	if (fp == NULL)
+	{
+		SPROX_Trace(TRACE_ACCESS, "Replay:failed to open %s", filename);
+		return MI_READER_NAME_INVALID;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	replay = calloc(1, sizeof(SPROX_REPLAY_ST));
+	if ((replay == NULL) || (size < RECORD_HEADER_SIZE) || ((replay->data = malloc(size)) == NULL) || (fread(replay->data, size, 1, fp) != 1))
+	{
+		SPROX_Trace(TRACE_ACCESS, "Replay:failed to load %s", filename);
+		fclose(fp);
+		if (replay != NULL)
+			free(replay->data);
+		free(replay);
+		return (size < RECORD_HEADER_SIZE) ? MI_READER_NAME_INVALID : MI_OUT_OF_MEMORY_ERROR;
+	}
+	fclose(fp);
+
+	if (memcmp(replay->data, RECORD_MAGIC, 8) || (replay->data[8] != RECORD_VERSION))
+	{
+		SPROX_Trace(TRACE_ACCESS, "Replay:%s is not a recording", filename);
+		free(replay->data);
+		free(replay);
+		return MI_READER_NAME_INVALID;
+	}
+
+	replay->size = (DWORD)size;
+	replay->offset = RECORD_HEADER_SIZE;
+	timed = getenv("SPROX_REPLAY_TIMED");
+	replay->timed = ((timed != NULL) && (timed[0] != '\0') && (timed[0] != '0'));
+	replay->started_us = Record_Now();
+	replay->whole_process = whole_process;
+	sprox_ctx->replay = replay;
+
+opened:
+	/* The reader that has been recorded */
+	memcpy(&sprox_ctx->sprox_info, &replay->data[9], 16);
+	sprox_ctx->sprox_version = Record_GetDword(&replay->data[25]);
+	sprox_ctx->sprox_capabilities = Record_GetDword(&replay->data[29]);
+
+	sprox_ctx->com_settings &= ~COM_INTERFACE_MASK;
+	sprox_ctx->com_settings |= COM_INTERFACE_REPLAY;
+	sprox_ctx->com_status = COM_STATUS_OPEN_ACTIVE;
+	sprox_ctx->com_lost = FALSE;
+	_tcscpy(sprox_ctx->com_name, _T("REPLAY"));
+
+	SPROX_Trace(TRACE_ACCESS, "Replay:ReaderOpen(%s) OK%s", filename, replay->timed ? ", with the original timing" : "");
+	return MI_OK;
+}
+
+SWORD SPROX_Replay_ReaderClose(SPROX_CTX_ST* sprox_ctx)
+{
+	SPROX_REPLAY_ST* replay = sprox_ctx->replay;
+
+	if (replay == NULL)
+		return MI_OK;
+
+	SPROX_Trace(TRACE_ACCESS, "Replay:ReaderClose after %lu exchange(s), %s", replay->exchanges, (replay->offset < replay->size) ? "recording not finished" : "recording finished");
+
+	sprox_ctx->com_status = COM_STATUS_CLOSED_BUT_SEEN;
+
+	/* The application may open the reader again */
+	if (replay->whole_process)
+		return MI_OK;
+
+	free(replay->data);
+	free(replay);
+	sprox_ctx->replay = NULL;
+	return MI_OK;
+}
+
+/**f* SpringProx.API/SPROX_RecordStart
+ *
+ * NAME
+ *   SPROX_RecordStart
+ *
+ * DESCRIPTION
+ *   Write the traffic with the reader to a file, to replay it later without
+ *   the reader (and without the card)
+ *
+ * INPUTS
+ *   const TCHAR filename[] : the file to create
+ *
+ * RETURNS
+ *   MI_OK              : success
+ *   MI_SER_ACCESS_ERR  : the reader is not open
+ *   MI_LIB_CALL_ERROR  : failed to create the file
+ *
+ * NOTES
+ *   The recording goes on until SPROX_RecordStop or SPROX_ReaderClose.
+ *   Set SPROX_RECORD=<file> in the environment to record an application
+ *   without changing it, and open "REPLAY:<file>" (or set SPROX_REPLAY=<file>)
+ *   to replay it. See sprox_record.c for the details.
+ *
+ * SEE ALSO
+ *   SPROX_RecordStop
+ *   SPROX_RecordGetStats
+ *
+ **/
+SPROX_API_FUNC(RecordStart) (SPROX_PARAM  const TCHAR filename[])
+{
+	SPROX_PARAM_TO_CTX;
+
+	if (filename == NULL)
+		return MI_LIB_CALL_ERROR;
+
+	if (sprox_ctx->com_status < COM_STATUS_OPEN_ACTIVE)
+		return MI_SER_ACCESS_ERR;
+
+	return SPROX_Record_Start(sprox_ctx, _ST(filename), FALSE);
+}
+
+/**f* SpringProx.API/SPROX_RecordStop
+ *
+ * NAME
+ *   SPROX_RecordStop
+ *
+ * DESCRIPTION
+ *   Stop writing the traffic with the reader, and close the file
+ *
+ * RETURNS
+ *   MI_OK              : success
+ *
+ * SEE ALSO
+ *   SPROX_RecordStart
+ *
+ **/
+SPROX_API_FUNC(RecordStop) (SPROX_PARAM_V)
+{
+	SPROX_PARAM_TO_CTX;
+
+	SPROX_Record_Stop(sprox_ctx, TRUE);
+	return MI_OK;
+}
+
+/**f* SpringProx.API/SPROX_RecordRandom
+ *
+ * NAME
+ *   SPROX_RecordRandom
+ *
+ * DESCRIPTION
+ *   Random numbers drawn by the host for the card, to be recorded or
+ *   replayed with the traffic of the reader
+ *
+ * INPUTS
+ *   BYTE rnd[]         : the random bytes
+ *   DWORD size         : their number
+ *
+ * OUTPUTS
+ *   BYTE rnd[]         : when replaying, the random bytes drawn when recorded
+ *
+ * RETURNS
+ *   MI_OK              : success
+ *
+ * NOTES
+ *   The card libraries (Desfire, Mifare Plus, Mifare UltraLight C) call this
+ *   function, so their authentications can be replayed.
+ *
+ **/
+SPROX_API_FUNC(RecordRandom) (SPROX_PARAM  BYTE rnd[], DWORD size)
+{
+	SPROX_REPLAY_ST* replay;
+	RECORD_ENTRY_ST entry;
+	SPROX_PARAM_TO_CTX;
+
+	if ((rnd == NULL) || (size == 0) || (size > 0xFFFF))
+		return MI_OK;
+
+	if (sprox_ctx->record != NULL)
+		Record_Write(sprox_ctx->record, SPROX_RECORD_RANDOM, Record_Now(), 0, 0, MI_OK, NULL, 0, rnd, (WORD)size);
+
+	replay = sprox_ctx->replay;
+	if (replay != NULL)
+	{
+		if (Replay_Peek(replay, &entry) && (entry.type == SPROX_RECORD_RANDOM) && (entry.recv_len == size))
+		{
+			memcpy(rnd, entry.recv_data, size);
+			Replay_Skip(replay, &entry);
+		}
+		else
+		{
+			SPROX_Trace(TRACE_DLG_HI, "Replay:entry %lu is not %lu random bytes", replay->entry, size);
+		}
+	}
+
+	return MI_OK;
+}
+
+/**f* SpringProx.API/SPROX_RecordGetStats
+ *
+ * NAME
+ *   SPROX_RecordGetStats
+ *
+ * DESCRIPTION
+ *   Time spent in the reader (RF, link) and time spent in the host, since
+ *   the recording or the replay has started
+ *
+ * OUTPUTS
+ *   DWORD *exchanges   : number of exchanges with the reader
+ *   DWORD *reader_ms   : time taken by the exchanges ; when replaying, the time
+ *                        they had taken when recorded
+ *   DWORD *host_ms     : the rest of the elapsed time
+ *
+ * RETURNS
+ *   MI_OK              : success
+ *   MI_FUNCTION_NOT_AVAILABLE : neither recording nor replaying
+ *
+ * NOTES
+ *   Replaying without the original timing gives the host's own overhead,
+ *   without waiting for the reader.
+ *
+ **/
+SPROX_API_FUNC(RecordGetStats) (SPROX_PARAM  DWORD* exchanges, DWORD* reader_ms, DWORD* host_ms)
+{
+	RECORD_US r, h;
+	DWORD e;
+	SPROX_PARAM_TO_CTX;
+
+	if (sprox_ctx->replay != NULL)
+	{
+		SPROX_REPLAY_ST* replay = sprox_ctx->replay;
+		e = replay->exchanges;
+		r = replay->reader_us;
+		h = Record_Now() - replay->started_us - replay->inside_us;
+	}
+	else if (sprox_ctx->record != NULL)
+	{
+		SPROX_RECORD_ST* record = sprox_ctx->record;
+		e = record->exchanges;
+		r = record->reader_us;
+		h = Record_Now() - record->started_us - record->reader_us;
+	}
+	else
+		return MI_FUNCTION_NOT_AVAILABLE;
+
+	if (exchanges != NULL)
+		*exchanges = e;
+	if (reader_ms != NULL)
+		*reader_ms = (DWORD)(r / 1000);
+	if (host_ms != NULL)
+		*host_ms = (DWORD)(h / 1000);
+
+	return MI_OK;
+}
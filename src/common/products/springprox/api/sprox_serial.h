@@ -13,6 +13,12 @@
   --------------
   Serial communication prototypes
 
+  revision :
+  ----------
+
+  AGT 19/10/2026 : shorter inter-byte timeout above 115200bps
+  AGT 19/10/2026 : one libftdi context per reader
+
 */
 #ifndef SPROX_SERIAL_H
 #define SPROX_SERIAL_H
@@ -53,7 +59,7 @@ BOOL FTDI_Open(SPROX_CTX_ST* sprox_ctx, const TCHAR* device);
 void FTDI_Close(SPROX_CTX_ST* sprox_ctx);
 BOOL FTDI_SetBaudrate(SPROX_CTX_ST* sprox_ctx, DWORD baudrate);
 BOOL FTDI_SendBurst(SPROX_CTX_ST* sprox_ctx, const BYTE* b, WORD len);
-BOOL FTDI_RecvBurst(SPROX_CTX_ST* sprox_ctx, const BYTE* b, WORD len);
+BOOL FTDI_RecvBurst(SPROX_CTX_ST* sprox_ctx, BYTE* b, WORD len);
 #endif
 #endif
 
@@ -61,5 +67,9 @@ BOOL FTDI_RecvBurst(SPROX_CTX_ST* sprox_ctx, const BYTE* b, WORD len);
 #define OSI_PROTOCOL_TMO   500  /* Timeout for the OSI flow control (ms) */
 #define ASCII_TMO         5000  /* Timeout for the ASCII protocol   (ms) */
 #define RESPONSE_TMO      1200  /* Timeout between send and receive (ms) */
+#define INTER_BYTE_TMO_HS   50  /* Timeout between each byte, above 115200bps (ms) */
+
+/* At high speed a whole frame takes a few ms : a long silence is a lost byte, not a slow reader */
+#define SPROX_INTER_BYTE_TMO(ctx) (((ctx)->com_baudrate > 115200) ? INTER_BYTE_TMO_HS : INTER_BYTE_TMO)
 
 #endif
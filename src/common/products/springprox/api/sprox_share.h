@@ -0,0 +1,40 @@
+/**h* SpringProx.API/sprox_share.h
+ *
+ * NAME
+ *   sprox_share.h
+ *
+ * DESCRIPTION
+ *   Protocol between the library and the reader-sharing daemon (ref_share),
+ *   over a local (Unix) socket.
+ *   The daemon owns the reader ; the applications open it with
+ *   SPROX_ReaderOpen("SHARE") (default socket) or SPROX_ReaderOpen("SHARE:<socket>").
+ *
+ *   Every frame is : type, sequence, command or status, length (2 bytes, MSB first),
+ *   then the data. The frames for the reader are the same as in the TCP C/S protocol.
+ *   The daemon answers each frame once, in order.
+ *
+ * HISTORY
+ *   AGT 19/10/2026 : created
+ *   AGT 19/10/2026 : the wait of SPROX_SHARE_LOCK is bounded, or for ever
+ *
+ **/
+#ifndef __SPROX_SHARE_H__
+#define __SPROX_SHARE_H__
+
+/* Default path of the socket, overriden by the SPROX_SHARE_SOCKET environment variable */
+#define SPROX_SHARE_SOCKET        "/tmp/springprox.sock"
+
+#define SPROX_SHARE_HEADER_SIZE   5
+#define SPROX_SHARE_MAX_DATA      2048
+
+/* Frame types */
+#define SPROX_SHARE_TO_CLIENT     0x28  /* Answer : the status is the opposite of the rc */
+#define SPROX_SHARE_TO_READER     0x29  /* Command for the reader, as given to SPROX_Function */
+#define SPROX_SHARE_TO_DAEMON     0x2A  /* Command for the daemon itself, see below */
+
+/* Commands for the daemon */
+#define SPROX_SHARE_LOCK          0x01  /* Data : how long to wait for the lock, in ms (4 bytes, MSB first) */
+                                        /* ...SPROX_LOCK_WAIT_FOREVER or up to SPROX_LOCK_WAIT_MAX           */
+#define SPROX_SHARE_UNLOCK        0x02  /* No data */
+
+#endif
@@ -0,0 +1,1111 @@
+/**h* SpringProx.API/Watch
+ *
+ * NAME
+ *   SpringProx.API :: Card presence events
+ *
+ * DESCRIPTION
+ *   A thread polls the reader on behalf of the application, and reports
+ *   the arrival and the removal of the cards, either through a callback
+ *   or through a queue the application waits on (a file descriptor under
+ *   Linux, an event HANDLE under Windows).
+ *   The thread follows a profile (SPROX_WATCH_PROFILE_ST) :
+ *   - idle : no card for a while, the reader looks for a card by itself,
+ *     in low-power card detection (SPROX_FindLpcdEx) or with its own
+ *     polling (SPROX_FindWaitEx),
+ *   - burst : after a wake-up or a removal, the host polls (SPROX_FindEx)
+ *     every burst_interval_ms, and goes back to idle after burst_polls
+ *     empty polls,
+ *   - present : a card is there, the host polls every present_interval_ms
+ *     to see when it leaves.
+ *   The time spent in each and the time to detect the cards are counted,
+ *   see SPROX_WatchGetStats.
+ *
+ * PORTABILITY
+ *   Win32 and Linux (pthread)
+ *
+ **/
+
+ /*
+
+   SpringProx API
+   --------------
+
+   Copyright (c) 2026 SpringCard SAS, FRANCE - www.springcard.com
+
+   THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+   ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+   TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+   PARTICULAR PURPOSE.
+
+   History
+   -------
+
+   AGT 19/10/2026 : created
+   AGT 19/10/2026 : polling profiles with low-power card detection, statistics
+   AGT 19/10/2026 : the reader is free while it waits for a card, Stop and Lock break the wait
+   AGT 19/10/2026 : same for low-power card detection, in slices of WATCH_LPCD_SLICE_S
+
+ */
+
+#include "sprox_api_i.h"
+
+#if (defined(WIN32) && !defined(UNDER_CE)) || defined(LINUX)
+
+#ifndef WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#define WATCH_QUEUE_SZ  32  /* Events waiting for SPROX_WatchRead, the oldest are lost */
+#define WATCH_MISSES     2  /* The card is gone once the reader has missed it that many times in a row */
+#define WATCH_WAIT_S     1  /* Time given to the reader to find a card by itself */
+#define WATCH_LPCD_SLICE_S 2  /* Longest low-power detection in one command, a stop is honoured by then anyway */
+
+#define WATCH_STATE_IDLE     0
+#define WATCH_STATE_BURST    1
+#define WATCH_STATE_PRESENT  2
+
+typedef struct
+{
+	SPROX_CTX_ST*         Ctx;
+#ifdef SPROX_API_REENTRANT
+	SPROX_INSTANCE        rInst;
+#endif
+	WORD                  WantProtos;
+	SPROX_WATCH_PROFILE_ST Profile;   /* Under QueueLock                       */
+	SPROX_WATCH_STATS_ST  Stats;      /* Under QueueLock                       */
+	DWORD                 StatsSince;
+	SPROX_WATCH_CALLBACK  Callback;
+	void*                 Param;
+
+#ifdef WIN32
+	HANDLE                hThread;
+	CRITICAL_SECTION      Lock;       /* Access to the reader                  */
+	CRITICAL_SECTION      QueueLock;  /* Queue, Quit and Waiting               */
+	HANDLE                hQuitEvent; /* Manual-reset, wakes the thread up     */
+	HANDLE                hReadyEvent;/* Manual-reset, the queue is not empty  */
+	HANDLE                hFreeEvent; /* Manual-reset, the thread is not waiting */
+#else
+	pthread_t             Thread;
+	pthread_mutex_t       Lock;
+	pthread_mutex_t       QueueLock;
+	pthread_cond_t        QuitCond;
+	pthread_cond_t        FreeCond;   /* Waiting has been cleared              */
+	int                   Pipe[2];    /* One byte per event in the queue       */
+#endif
+	BOOL                  Quit;
+	BOOL                  Waiting;    /* The reader waits for a card, Lock is not held */
+	BOOL                  Cancelled;  /* SPROX_FindWaitCancel has been sent     */
+	WORD                  Wanted;     /* Callers of SPROX_WatchLock, no new wait meanwhile */
+
+	SPROX_WATCH_EVENT_ST  Queue[WATCH_QUEUE_SZ];
+	WORD                  QueueFirst;
+	WORD                  QueueCount;
+
+} SPROX_WATCH_ST;
+
+#ifdef SPROX_API_REENTRANT
+#define WATCH_PARAM_P  watch->rInst,
+#define WATCH_PARAM_PV watch->rInst
+#else
+#define WATCH_PARAM_P
+#define WATCH_PARAM_PV
+#endif
+
+static void WatchLockQueue(SPROX_WATCH_ST* watch)
+{
+#ifdef WIN32
+	EnterCriticalSection(&watch->QueueLock);
+#else
+	pthread_mutex_lock(&watch->QueueLock);
+#endif
+}
+
+static void WatchUnlockQueue(SPROX_WATCH_ST* watch)
+{
+#ifdef WIN32
+	LeaveCriticalSection(&watch->QueueLock);
+#else
+	pthread_mutex_unlock(&watch->QueueLock);
+#endif
+}
+
+static void WatchPost(SPROX_WATCH_ST* watch, SPROX_WATCH_EVENT_ST* event)
+{
+	SPROX_GetMonotonicTime(&event->time_s, &event->time_us);
+
+	if (watch->Callback != NULL)
+	{
+		/* Called with the reader locked, so the callback may talk to the card */
+		watch->Callback(watch->Param, event);
+		return;
+	}
+
+	WatchLockQueue(watch);
+
+	if (watch->QueueCount < WATCH_QUEUE_SZ)
+	{
+		watch->Queue[(watch->QueueFirst + watch->QueueCount) % WATCH_QUEUE_SZ] = *event;
+		watch->QueueCount++;
+#ifdef WIN32
+		SetEvent(watch->hReadyEvent);
+#else
+		if (write(watch->Pipe[1], "E", 1) != 1)
+			SPROX_Trace(TRACE_ALL, "Watch: failed to signal the event");
+#endif
+	}
+	else
+	{
+		/* Full, drop the oldest one (the count, and so the pipe, doesn't change) */
+		watch->Queue[watch->QueueFirst] = *event;
+		watch->QueueFirst = (watch->QueueFirst + 1) % WATCH_QUEUE_SZ;
+	}
+
+	WatchUnlockQueue(watch);
+}
+
+/*
+ * Is an application thread waiting in SPROX_WatchLock
+ */
+static BOOL WatchWanted(SPROX_WATCH_ST* watch)
+{
+	BOOL wanted;
+
+	WatchLockQueue(watch);
+	wanted = (watch->Wanted != 0) ? TRUE : FALSE;
+	WatchUnlockQueue(watch);
+
+	return wanted;
+}
+
+/*
+ * Break the wait of the reader, if the watch thread is waiting for its answer
+ * (the thread gets MI_QUIT, or the card if it came at the same time)
+ */
+static void WatchCancelWait(SPROX_WATCH_ST* watch)
+{
+	/* Under QueueLock, the thread doesn't stop waiting before the command is sent */
+	WatchLockQueue(watch);
+	if (watch->Waiting && !watch->Cancelled)
+	{
+		watch->Cancelled = TRUE;
+		SPROX_API_CALL(FindWaitCancel) (WATCH_PARAM_PV);
+	}
+	WatchUnlockQueue(watch);
+}
+
+/*
+ * Wait until the watch thread has stopped talking to the reader out of the Lock
+ */
+static void WatchWaitFree(SPROX_WATCH_ST* watch)
+{
+#ifdef WIN32
+	WaitForSingleObject(watch->hFreeEvent, INFINITE);
+#else
+	pthread_mutex_lock(&watch->QueueLock);
+	while (watch->Waiting)
+		pthread_cond_wait(&watch->FreeCond, &watch->QueueLock);
+	pthread_mutex_unlock(&watch->QueueLock);
+#endif
+}
+
+/*
+ * Sleep for the given time, unless SPROX_WatchStop wakes us up
+ * Returns TRUE if the thread must leave
+ */
+static BOOL WatchSleep(SPROX_WATCH_ST* watch, DWORD ms)
+{
+#ifdef WIN32
+	return (WaitForSingleObject(watch->hQuitEvent, ms) == WAIT_OBJECT_0) ? TRUE : FALSE;
+#else
+	struct timespec t;
+	BOOL quit;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	t.tv_sec += ms / 1000;
+	t.tv_nsec += (long)(ms % 1000) * 1000000;
+	if (t.tv_nsec >= 1000000000)
+	{
+		t.tv_sec++;
+		t.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&watch->QueueLock);
+	while (!watch->Quit)
+		if (pthread_cond_timedwait(&watch->QuitCond, &watch->QueueLock, &t) == ETIMEDOUT)
+			break;
+	quit = watch->Quit;
+	pthread_mutex_unlock(&watch->QueueLock);
+
+	return quit;
+#endif
+}
+
+/*
+ * Let the reader look for a card by itself : it answers SPROX_FIND when a
+ * card arrives, or at its timeout. Meanwhile the Lock is free, and
+ * SPROX_WatchLock or SPROX_WatchStop break the wait.
+ * Called, and returns, with the Lock held
+ */
+static SWORD WatchWaitCard(SPROX_WATCH_ST* watch, const BYTE command[], WORD length, WORD timeout_s, SPROX_WATCH_EVENT_ST* found, BOOL* cancelled)
+{
+	SPROX_CTX_ST* sprox_ctx = watch->Ctx;
+	BYTE buffer[64];
+	WORD buflen;
+	BOOL drained = FALSE;
+	SWORD rc;
+
+	*cancelled = FALSE;
+
+	/* Forget current mode so that later SetConfig will actually reconfigure the reader */
+	sprox_ctx->pcd_current_rf_protocol = 0;
+
+	buflen = sizeof(buffer);
+	rc = SPROX_DLG_FUNC(WATCH_PARAM_P  SPROX_FIND, command, length, buffer, &buflen);
+
+	if (rc == MI_POLLING)
+	{
+		WatchLockQueue(watch);
+		if (watch->Wanted || watch->Quit)
+		{
+			/* The reader is wanted already, don't leave it waiting */
+			WatchUnlockQueue(watch);
+			SPROX_API_CALL(FindWaitCancel) (WATCH_PARAM_PV);
+			SPROX_Function_Drain(sprox_ctx);
+			*cancelled = TRUE;
+			return MI_QUIT;
+		}
+		watch->Waiting = TRUE;
+		watch->Cancelled = FALSE;
+		sprox_ctx->find_wait_pending = TRUE;
+#ifdef WIN32
+		ResetEvent(watch->hFreeEvent);
+#endif
+		WatchUnlockQueue(watch);
+
+#ifdef WIN32
+		LeaveCriticalSection(&watch->Lock);
+#else
+		pthread_mutex_unlock(&watch->Lock);
+#endif
+
+		buflen = sizeof(buffer);
+		rc = SPROX_WRS_FUNC(WATCH_PARAM_P  buffer, &buflen, timeout_s);
+
+		for (;;)
+		{
+			WatchLockQueue(watch);
+			*cancelled = watch->Cancelled;
+			if (*cancelled == drained)
+			{
+				watch->Waiting = FALSE;
+				sprox_ctx->find_wait_pending = FALSE;
+				sprox_ctx->find_wait_broken = FALSE;
+#ifdef WIN32
+				SetEvent(watch->hFreeEvent);
+#else
+				pthread_cond_broadcast(&watch->FreeCond);
+#endif
+				WatchUnlockQueue(watch);
+				break;
+			}
+			WatchUnlockQueue(watch);
+
+			/* The reader may answer both the wait and the cancel */
+			SPROX_Function_Drain(sprox_ctx);
+			drained = TRUE;
+		}
+
+#ifdef WIN32
+		EnterCriticalSection(&watch->Lock);
+#else
+		pthread_mutex_lock(&watch->Lock);
+#endif
+
+		if (*cancelled && ((rc != MI_OK) || (buflen < 2)))
+			return MI_QUIT;
+	}
+
+	if (rc != MI_OK)
+		return rc;
+	if ((buflen < 2) || (buflen > sizeof(found->uid) + 2))
+		return MI_SER_LENGTH_ERR;
+
+	found->proto = buffer[0];
+	found->proto *= 0x0100;
+	found->proto += buffer[1];
+	found->uidlen = (BYTE)(buflen - 2);
+	memcpy(found->uid, &buffer[2], found->uidlen);
+
+	/* Same as SPROX_FindEx */
+	buffer[0] = SPROX_FIND_INFO_PROT_BYTES;
+	buflen = sizeof(buffer);
+	if ((SPROX_DLG_FUNC(WATCH_PARAM_P  SPROX_FIND_INFO, buffer, 1, buffer, &buflen) == MI_OK) && (buflen <= sizeof(found->info)))
+	{
+		memcpy(found->info, buffer, buflen);
+		found->infolen = (BYTE)buflen;
+	}
+	else
+	{
+		found->infolen = 0;
+	}
+
+	return MI_OK;
+}
+
+#ifdef WIN32
+static DWORD WINAPI WatchThread(LPVOID param)
+#else
+static void* WatchThread(void* param)
+#endif
+{
+	SPROX_WATCH_ST* watch = (SPROX_WATCH_ST*)param;
+	SPROX_WATCH_PROFILE_ST profile;
+	SPROX_WATCH_EVENT_ST found, current;
+	BYTE state = WATCH_STATE_BURST;
+	BOOL failed = FALSE;
+	BOOL reader_waits = (watch->Ctx->sprox_version >= 0x00015400) ? TRUE : FALSE;
+	BOOL reader_lpcd = reader_waits;
+	WORD empty = 0;
+	WORD lpcd_spent_s = 0;
+	BYTE misses = 0;
+	DWORD seen_empty = SPROX_GetMonotonicMs();
+	SWORD rc;
+
+	memset(&current, 0, sizeof(current));
+
+	for (;;)
+	{
+		BOOL lpcd = FALSE;
+		BOOL lpcd_again = FALSE;
+		BOOL waited = FALSE;
+		BOOL cancelled = FALSE;
+		WORD slice_s = 0;
+		DWORD t0, t1, sleep_ms;
+
+		WatchLockQueue(watch);
+		profile = watch->Profile;
+		WatchUnlockQueue(watch);
+
+		/* Nothing to wait on, the host polls forever */
+		if ((state == WATCH_STATE_IDLE) && !(profile.lpcd_timeout_s && reader_lpcd) && !reader_waits)
+			state = WATCH_STATE_BURST;
+
+		memset(&found, 0, sizeof(found));
+		found.uidlen = sizeof(found.uid);
+		found.infolen = sizeof(found.info);
+
+#ifdef WIN32
+		EnterCriticalSection(&watch->Lock);
+#else
+		pthread_mutex_lock(&watch->Lock);
+#endif
+
+		t0 = SPROX_GetMonotonicMs();
+
+		if ((state == WATCH_STATE_IDLE) && profile.lpcd_timeout_s && reader_lpcd && !WatchWanted(watch))
+		{
+			/* Low-power card detection, the reader wakes up and looks for the card when the field changes */
+			BYTE command[5];
+
+			slice_s = profile.lpcd_timeout_s - lpcd_spent_s;
+			if (slice_s > WATCH_LPCD_SLICE_S)
+				slice_s = WATCH_LPCD_SLICE_S;
+
+			command[0] = (BYTE)(watch->WantProtos / 0x0100);
+			command[1] = (BYTE)(watch->WantProtos % 0x0100);
+			command[2] = (BYTE)(slice_s / 0x0100);
+			command[3] = (BYTE)(slice_s % 0x0100);
+			command[4] = 0x01;
+			if (profile.lpcd_forced_pulses)
+				command[4] |= 0x02;
+
+			rc = WatchWaitCard(watch, command, sizeof(command), slice_s, &found, &cancelled);
+			if (WatchSleep(watch, 0))
+			{
+#ifdef WIN32
+				LeaveCriticalSection(&watch->Lock);
+#else
+				pthread_mutex_unlock(&watch->Lock);
+#endif
+				break;
+			}
+			if ((rc == MI_UNKNOWN_FUNCTION) || (rc == MI_FUNCTION_NOT_AVAILABLE))
+			{
+				reader_lpcd = FALSE;
+				rc = MI_NOTAGERR;
+			}
+			else
+			{
+				lpcd = TRUE;
+			}
+		}
+		else
+			if ((state == WATCH_STATE_IDLE) && !WatchWanted(watch))
+			{
+				/* The reader polls by itself and answers as soon as a card arrives */
+				BYTE command[7];
+
+				command[0] = (BYTE)(watch->WantProtos / 0x0100);
+				command[1] = (BYTE)(watch->WantProtos % 0x0100);
+				command[2] = 0x00;
+				command[3] = WATCH_WAIT_S;
+				command[4] = 0x00;
+				command[5] = (BYTE)(profile.burst_interval_ms / 0x0100);
+				command[6] = (BYTE)(profile.burst_interval_ms % 0x0100);
+
+				rc = WatchWaitCard(watch, command, sizeof(command), WATCH_WAIT_S, &found, &cancelled);
+				if (WatchSleep(watch, 0))
+				{
+#ifdef WIN32
+					LeaveCriticalSection(&watch->Lock);
+#else
+					pthread_mutex_unlock(&watch->Lock);
+#endif
+					break;
+				}
+				if ((rc == MI_UNKNOWN_FUNCTION) || (rc == MI_FUNCTION_NOT_AVAILABLE))
+				{
+					reader_waits = FALSE;
+					rc = MI_NOTAGERR;
+				}
+				else
+				{
+					waited = TRUE;
+				}
+			}
+			else
+			{
+				rc = SPROX_API_CALL(FindEx) (WATCH_PARAM_P  watch->WantProtos, &found.proto, found.uid, &found.uidlen, found.info, &found.infolen);
+			}
+
+		t1 = SPROX_GetMonotonicMs();
+
+		if (lpcd && (rc != MI_OK))
+		{
+			if (cancelled)
+			{
+				/* Broken on purpose, go on with the detection afterwards */
+				rc = MI_NOTAGERR;
+				lpcd_again = TRUE;
+			}
+			else
+				if ((rc == MI_QUIT) && ((t1 - t0 + 100) >= slice_s * 1000UL))
+				{
+					/* End of the slice, go on until lpcd_timeout_s */
+					rc = MI_NOTAGERR;
+					lpcd_spent_s += slice_s;
+					if (lpcd_spent_s < profile.lpcd_timeout_s)
+						lpcd_again = TRUE;
+				}
+		}
+
+		if (waited && (rc != MI_OK))
+		{
+			/* MI_QUIT is the normal end of the wait at the timeout of the reader  */
+			/* (its clock may be a little fast) ; anything goes once the wait has  */
+			/* been broken on purpose                                              */
+			if (cancelled || ((rc == MI_QUIT) && ((t1 - t0 + 100) >= WATCH_WAIT_S * 1000UL)))
+				rc = MI_NOTAGERR;
+		}
+
+		WatchLockQueue(watch);
+		if (lpcd)
+		{
+			watch->Stats.lpcd_ms += t1 - t0;
+			if (!lpcd_again)
+				watch->Stats.lpcd_wakeups++;
+		}
+		else
+		{
+			watch->Stats.rf_on_ms += t1 - t0;
+			if (!waited)
+				watch->Stats.polls++;
+		}
+		WatchUnlockQueue(watch);
+
+		if (rc == MI_OK)
+		{
+			failed = FALSE;
+			misses = 0;
+
+			if ((state != WATCH_STATE_PRESENT) || (current.uidlen != found.uidlen) || memcmp(current.uid, found.uid, found.uidlen))
+			{
+				if (state == WATCH_STATE_PRESENT)
+				{
+					current.event = SPROX_WATCH_REMOVAL;
+					WatchPost(watch, &current);
+				}
+
+				/* Counted from the last time the field has been seen empty : an upper bound of the latency */
+				WatchLockQueue(watch);
+				watch->Stats.arrivals++;
+				watch->Stats.detect_ms_total += t1 - seen_empty;
+				if (watch->Stats.detect_ms_max < t1 - seen_empty)
+					watch->Stats.detect_ms_max = t1 - seen_empty;
+				WatchUnlockQueue(watch);
+
+				found.event = SPROX_WATCH_ARRIVAL;
+				WatchPost(watch, &found);
+				current = found;
+				state = WATCH_STATE_PRESENT;
+			}
+		}
+		else
+			if ((rc > -128) && (rc != MI_QUIT))
+			{
+				/* No card, or the card didn't answer well */
+				failed = FALSE;
+				if (!lpcd && !waited)
+					seen_empty = t1;
+
+				if (state == WATCH_STATE_PRESENT)
+				{
+					if (++misses >= WATCH_MISSES)
+					{
+						current.event = SPROX_WATCH_REMOVAL;
+						WatchPost(watch, &current);
+						state = WATCH_STATE_BURST;
+						empty = 0;
+					}
+				}
+				else
+					if (lpcd)
+					{
+						/* Woken up, or timeout : look closer for a while */
+						if (!lpcd_again)
+						{
+							state = WATCH_STATE_BURST;
+							empty = 0;
+						}
+					}
+					else
+						if ((state == WATCH_STATE_BURST) && (++empty >= profile.burst_polls))
+						{
+							state = WATCH_STATE_IDLE;
+							lpcd_spent_s = 0;
+						}
+			}
+			else
+			{
+				/* The reader is gone, doesn't answer, or has stopped waiting too early ; report it once */
+				if (state == WATCH_STATE_PRESENT)
+				{
+					current.event = SPROX_WATCH_REMOVAL;
+					WatchPost(watch, &current);
+				}
+				state = WATCH_STATE_BURST;
+				empty = 0;
+				if (!failed)
+				{
+					memset(&found, 0, sizeof(found));
+					found.event = SPROX_WATCH_ERROR;
+					found.rc = rc;
+					WatchPost(watch, &found);
+					failed = TRUE;
+				}
+			}
+
+#ifdef WIN32
+		LeaveCriticalSection(&watch->Lock);
+#else
+		pthread_mutex_unlock(&watch->Lock);
+#endif
+
+		/* The reader has already spent its time looking for the card */
+		if (state == WATCH_STATE_IDLE)
+			sleep_ms = (lpcd || waited) ? 0 : profile.burst_interval_ms;
+		else
+			if (state == WATCH_STATE_PRESENT)
+				sleep_ms = profile.present_interval_ms;
+			else
+				sleep_ms = (lpcd || waited) ? 0 : profile.burst_interval_ms;
+
+		if (WatchSleep(watch, sleep_ms))
+			break;
+	}
+
+#ifdef WIN32
+	return 0;
+#else
+	return NULL;
+#endif
+}
+
+/**f* SpringProx.API/SPROX_WatchStartEx
+ *
+ * NAME
+ *   SPROX_WatchStartEx
+ *
+ * DESCRIPTION
+ *   Start a thread that reports the arrival and the removal of the cards
+ *
+ * INPUTS
+ *   WORD want_protos   : bit-map of contactless family to look for
+ *   const SPROX_WATCH_PROFILE_ST *profile : how to poll (see sprox_watch.c)
+ *   SPROX_WATCH_CALLBACK callback : function to be called on every event,
+ *                        from the thread of the watch. NULL to queue the
+ *                        events for SPROX_WatchRead instead.
+ *   void *param        : passed to the callback
+ *
+ * RETURNS
+ *   MI_OK              : success
+ *   MI_LIB_CALL_ERROR  : the watch is already running
+ *   MI_OUT_OF_MEMORY_ERROR
+ *   MI_LIB_INTERNAL_ERROR : failed to create the thread
+ *
+ * NOTES
+ *   While the watch is running, the application must take the reader with
+ *   SPROX_WatchLock before calling any other function of the library for
+ *   the same reader, and give it back with SPROX_WatchUnlock. The callback
+ *   is called with the reader already locked.
+ *   A card is reported as removed once the reader has missed it twice
+ *   in a row.
+ *   Stop the watch before closing the reader.
+ *
+ * SEE ALSO
+ *   SPROX_WatchStart
+ *   SPROX_WatchStop
+ *   SPROX_WatchRead
+ *   SPROX_WatchSetProfile
+ *
+ **/
+SPROX_API_FUNC(WatchStartEx) (SPROX_PARAM  WORD want_protos, const SPROX_WATCH_PROFILE_ST* profile, SPROX_WATCH_CALLBACK callback, void* param)
+{
+	SPROX_WATCH_ST* watch;
+	SPROX_PARAM_TO_CTX;
+
+	if (sprox_ctx->watch != NULL)
+		return MI_LIB_CALL_ERROR;
+	if (profile == NULL)
+		return MI_LIB_CALL_ERROR;
+
+	watch = malloc(sizeof(SPROX_WATCH_ST));
+	if (watch == NULL)
+		return MI_OUT_OF_MEMORY_ERROR;
+	memset(watch, 0, sizeof(SPROX_WATCH_ST));
+
+	watch->Ctx = sprox_ctx;
+#ifdef SPROX_API_REENTRANT
+	watch->rInst = rInst;
+#endif
+	watch->WantProtos = want_protos;
+	watch->Profile = *profile;
+	if (!watch->Profile.burst_polls)
+		watch->Profile.burst_polls = 1;
+	watch->StatsSince = SPROX_GetMonotonicMs();
+	watch->Callback = callback;
+	watch->Param = param;
+
+#ifdef WIN32
+	InitializeCriticalSection(&watch->Lock);
+	InitializeCriticalSection(&watch->QueueLock);
+	watch->hQuitEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	watch->hReadyEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	watch->hFreeEvent = CreateEvent(NULL, TRUE, TRUE, NULL);
+	if ((watch->hQuitEvent != NULL) && (watch->hReadyEvent != NULL) && (watch->hFreeEvent != NULL))
+		watch->hThread = CreateThread(NULL, 0, WatchThread, watch, 0, NULL);
+	if (watch->hThread == NULL)
+	{
+		if (watch->hQuitEvent != NULL) CloseHandle(watch->hQuitEvent);
+		if (watch->hReadyEvent != NULL) CloseHandle(watch->hReadyEvent);
+		if (watch->hFreeEvent != NULL) CloseHandle(watch->hFreeEvent);
+		DeleteCriticalSection(&watch->QueueLock);
+		DeleteCriticalSection(&watch->Lock);
+		free(watch);
+		return MI_LIB_INTERNAL_ERROR;
+	}
+#else
+	{
+		pthread_mutexattr_t mattr;
+		pthread_condattr_t cattr;
+
+		/* The callback runs with the reader locked, and may lock it again */
+		pthread_mutexattr_init(&mattr);
+		pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE);
+		pthread_mutex_init(&watch->Lock, &mattr);
+		pthread_mutexattr_destroy(&mattr);
+		pthread_mutex_init(&watch->QueueLock, NULL);
+
+		pthread_condattr_init(&cattr);
+		pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+		pthread_cond_init(&watch->QuitCond, &cattr);
+		pthread_condattr_destroy(&cattr);
+		pthread_cond_init(&watch->FreeCond, NULL);
+	}
+
+	if (pipe(watch->Pipe) == 0)
+	{
+		fcntl(watch->Pipe[0], F_SETFL, fcntl(watch->Pipe[0], F_GETFL) | O_NONBLOCK);
+		fcntl(watch->Pipe[0], F_SETFD, FD_CLOEXEC);
+		fcntl(watch->Pipe[1], F_SETFD, FD_CLOEXEC);
+	}
+	else
+	{
+		watch->Pipe[0] = watch->Pipe[1] = -1;
+	}
+
+	if ((watch->Pipe[0] < 0) || pthread_create(&watch->Thread, NULL, WatchThread, watch))
+	{
+		if (watch->Pipe[0] >= 0)
+		{
+			close(watch->Pipe[0]);
+			close(watch->Pipe[1]);
+		}
+		pthread_cond_destroy(&watch->FreeCond);
+		pthread_cond_destroy(&watch->QuitCond);
+		pthread_mutex_destroy(&watch->QueueLock);
+		pthread_mutex_destroy(&watch->Lock);
+		free(watch);
+		return MI_LIB_INTERNAL_ERROR;
+	}
+#endif
+
+	sprox_ctx->watch = watch;
+	SPROX_Trace(TRACE_ACCESS, "WatchStart(%04X, lpcd=%d, burst=%dx%dms, present=%dms)", want_protos, profile->lpcd_timeout_s, profile->burst_polls, profile->burst_interval_ms, profile->present_interval_ms);
+	return MI_OK;
+}
+
+/**f* SpringProx.API/SPROX_WatchStart
+ *
+ * NAME
+ *   SPROX_WatchStart
+ *
+ * DESCRIPTION
+ *   Same as SPROX_WatchStartEx, without low-power card detection : the
+ *   reader polls by itself when it is able to, the host polls every
+ *   interval_ms otherwise
+ *
+ * INPUTS
+ *   WORD want_protos   : bit-map of contactless family to look for
+ *   WORD interval_ms   : time between two polls
+ *   SPROX_WATCH_CALLBACK callback : see SPROX_WatchStartEx
+ *   void *param        : passed to the callback
+ *
+ **/
+SPROX_API_FUNC(WatchStart) (SPROX_PARAM  WORD want_protos, WORD interval_ms, SPROX_WATCH_CALLBACK callback, void* param)
+{
+	SPROX_WATCH_PROFILE_ST profile;
+	SPROX_PARAM_TO_CTX;
+
+	memset(&profile, 0, sizeof(profile));
+	profile.burst_interval_ms = interval_ms;
+	profile.burst_polls = 1;
+	profile.present_interval_ms = interval_ms;
+
+	return SPROX_API_CALL(WatchStartEx) (SPROX_PARAM_P  want_protos, &profile, callback, param);
+}
+
+/**f* SpringProx.API/SPROX_WatchSetProfile
+ *
+ * NAME
+ *   SPROX_WatchSetProfile
+ *
+ * DESCRIPTION
+ *   Change the profile of a running watch, and clear its statistics
+ *
+ * INPUTS
+ *   const SPROX_WATCH_PROFILE_ST *profile : how to poll from now on
+ *
+ * NOTES
+ *   The new profile applies from the next poll, the statistics given by
+ *   SPROX_WatchGetStats then only cover the new profile.
+ *
+ **/
+SPROX_API_FUNC(WatchSetProfile) (SPROX_PARAM  const SPROX_WATCH_PROFILE_ST* profile)
+{
+	SPROX_WATCH_ST* watch;
+	SPROX_PARAM_TO_CTX;
+
+	watch = sprox_ctx->watch;
+	if ((watch == NULL) || (profile == NULL))
+		return MI_LIB_CALL_ERROR;
+
+	WatchLockQueue(watch);
+	watch->Profile = *profile;
+	if (!watch->Profile.burst_polls)
+		watch->Profile.burst_polls = 1;
+	memset(&watch->Stats, 0, sizeof(watch->Stats));
+	watch->StatsSince = SPROX_GetMonotonicMs();
+	WatchUnlockQueue(watch);
+
+	return MI_OK;
+}
+
+/**f* SpringProx.API/SPROX_WatchGetStats
+ *
+ * NAME
+ *   SPROX_WatchGetStats
+ *
+ * DESCRIPTION
+ *   How the current profile performs : time to detect the cards, time
+ *   spent with the RF field at full power and in low-power detection
+ *
+ * INPUTS
+ *   SPROX_WATCH_STATS_ST *stats : the statistics since the profile has been set
+ *
+ * NOTES
+ *   The time to detect a card is counted from the last time the host has
+ *   seen the field empty, so it is an upper bound of the actual latency.
+ *   RF-on time includes the time the reader spends polling by itself.
+ *
+ **/
+SPROX_API_FUNC(WatchGetStats) (SPROX_PARAM  SPROX_WATCH_STATS_ST* stats)
+{
+	SPROX_WATCH_ST* watch;
+	SPROX_PARAM_TO_CTX;
+
+	watch = sprox_ctx->watch;
+	if ((watch == NULL) || (stats == NULL))
+		return MI_LIB_CALL_ERROR;
+
+	WatchLockQueue(watch);
+	*stats = watch->Stats;
+	stats->elapsed_ms = SPROX_GetMonotonicMs() - watch->StatsSince;
+	WatchUnlockQueue(watch);
+
+	return MI_OK;
+}
+
+/**f* SpringProx.API/SPROX_WatchStop
+ *
+ * NAME
+ *   SPROX_WatchStop
+ *
+ * DESCRIPTION
+ *   Stop the thread started by SPROX_WatchStart, and forget the events
+ *   that have not been read
+ *
+ * NOTES
+ *   Must not be called from the callback. If the reader is waiting for a
+ *   card by itself, the wait is broken with SPROX_FindWaitCancel.
+ *
+ **/
+SPROX_API_FUNC(WatchStop) (SPROX_PARAM_V)
+{
+	SPROX_WATCH_ST* watch;
+	SPROX_PARAM_TO_CTX;
+
+	watch = sprox_ctx->watch;
+	if (watch == NULL)
+		return MI_OK;
+
+#ifdef WIN32
+	EnterCriticalSection(&watch->QueueLock);
+	watch->Quit = TRUE;
+	LeaveCriticalSection(&watch->QueueLock);
+	SetEvent(watch->hQuitEvent);
+
+	WatchCancelWait(watch);
+
+	WaitForSingleObject(watch->hThread, INFINITE);
+	CloseHandle(watch->hThread);
+	CloseHandle(watch->hQuitEvent);
+	CloseHandle(watch->hReadyEvent);
+	CloseHandle(watch->hFreeEvent);
+	DeleteCriticalSection(&watch->QueueLock);
+	DeleteCriticalSection(&watch->Lock);
+#else
+	pthread_mutex_lock(&watch->QueueLock);
+	watch->Quit = TRUE;
+	pthread_cond_broadcast(&watch->QuitCond);
+	pthread_mutex_unlock(&watch->QueueLock);
+
+	WatchCancelWait(watch);
+
+	pthread_join(watch->Thread, NULL);
+	close(watch->Pipe[0]);
+	close(watch->Pipe[1]);
+	pthread_cond_destroy(&watch->FreeCond);
+	pthread_cond_destroy(&watch->QuitCond);
+	pthread_mutex_destroy(&watch->QueueLock);
+	pthread_mutex_destroy(&watch->Lock);
+#endif
+
+	sprox_ctx->watch = NULL;
+	free(watch);
+
+	SPROX_Trace(TRACE_ACCESS, "WatchStop");
+	return MI_OK;
+}
+
+/**f* SpringProx.API/SPROX_WatchRead
+ *
+ * NAME
+ *   SPROX_WatchRead
+ *
+ * DESCRIPTION
+ *   Take the oldest event out of the queue, without waiting
+ *
+ * INPUTS
+ *   SPROX_WATCH_EVENT_ST *event : the event
+ *
+ * RETURNS
+ *   MI_OK              : success, the event is valid
+ *   MI_POLLING         : no event for now
+ *   MI_LIB_CALL_ERROR  : the watch is not running
+ *
+ * NOTES
+ *   Wait on SPROX_WatchGetFd (Linux) or SPROX_WatchGetHandle (Windows)
+ *   to know when an event is there.
+ *
+ **/
+SPROX_API_FUNC(WatchRead) (SPROX_PARAM  SPROX_WATCH_EVENT_ST* event)
+{
+	SPROX_WATCH_ST* watch;
+	SWORD rc = MI_POLLING;
+	SPROX_PARAM_TO_CTX;
+
+	watch = sprox_ctx->watch;
+	if ((watch == NULL) || (event == NULL))
+		return MI_LIB_CALL_ERROR;
+
+	WatchLockQueue(watch);
+
+	if (watch->QueueCount)
+	{
+		*event = watch->Queue[watch->QueueFirst];
+		watch->QueueFirst = (watch->QueueFirst + 1) % WATCH_QUEUE_SZ;
+		watch->QueueCount--;
+#ifdef WIN32
+		if (!watch->QueueCount)
+			ResetEvent(watch->hReadyEvent);
+#else
+		{
+			char c;
+			if (read(watch->Pipe[0], &c, 1) != 1)
+				SPROX_Trace(TRACE_ALL, "Watch: pipe out of sync");
+		}
+#endif
+		rc = MI_OK;
+	}
+
+	WatchUnlockQueue(watch);
+
+	return rc;
+}
+
+#ifdef WIN32
+/**f* SpringProx.API/SPROX_WatchGetHandle
+ *
+ * NAME
+ *   SPROX_WatchGetHandle
+ *
+ * DESCRIPTION
+ *   Event that is signaled as long as SPROX_WatchRead has something to return
+ *
+ * INPUTS
+ *   HANDLE *handle     : the event, owned by the library
+ *
+ **/
+SPROX_API_FUNC(WatchGetHandle) (SPROX_PARAM  HANDLE* handle)
+{
+	SPROX_PARAM_TO_CTX;
+
+	if ((sprox_ctx->watch == NULL) || (handle == NULL))
+		return MI_LIB_CALL_ERROR;
+
+	*handle = ((SPROX_WATCH_ST*)sprox_ctx->watch)->hReadyEvent;
+	return MI_OK;
+}
+#else
+/**f* SpringProx.API/SPROX_WatchGetFd
+ *
+ * NAME
+ *   SPROX_WatchGetFd
+ *
+ * DESCRIPTION
+ *   File descriptor that is readable (select, poll, epoll...) as long as
+ *   SPROX_WatchRead has something to return
+ *
+ * INPUTS
+ *   int *fd            : the descriptor, owned by the library ; don't read it
+ *
+ **/
+SPROX_API_FUNC(WatchGetFd) (SPROX_PARAM  int* fd)
+{
+	SPROX_PARAM_TO_CTX;
+
+	if ((sprox_ctx->watch == NULL) || (fd == NULL))
+		return MI_LIB_CALL_ERROR;
+
+	*fd = ((SPROX_WATCH_ST*)sprox_ctx->watch)->Pipe[0];
+	return MI_OK;
+}
+#endif
+
+/**f* SpringProx.API/SPROX_WatchLock
+ *
+ * NAME
+ *   SPROX_WatchLock
+ *
+ * DESCRIPTION
+ *   Take the reader from the watch, to talk to the card
+ *
+ * NOTES
+ *   Waits for the current poll to end. If the reader is waiting for a card
+ *   by itself, the wait is broken with SPROX_FindWaitCancel, and the watch
+ *   doesn't start another one until SPROX_WatchUnlock. Does nothing if the
+ *   watch is not running.
+ *
+ * SEE ALSO
+ *   SPROX_WatchUnlock
+ *
+ **/
+SPROX_API_FUNC(WatchLock) (SPROX_PARAM_V)
+{
+	SPROX_WATCH_ST* watch;
+	SPROX_PARAM_TO_CTX;
+
+	watch = sprox_ctx->watch;
+	if (watch == NULL)
+		return MI_OK;
+
+	WatchLockQueue(watch);
+	watch->Wanted++;
+	WatchUnlockQueue(watch);
+
+	WatchCancelWait(watch);
+	WatchWaitFree(watch);
+
+#ifdef WIN32
+	EnterCriticalSection(&watch->Lock);
+#else
+	pthread_mutex_lock(&watch->Lock);
+#endif
+
+	WatchLockQueue(watch);
+	watch->Wanted--;
+	WatchUnlockQueue(watch);
+	return MI_OK;
+}
+
+/**f* SpringProx.API/SPROX_WatchUnlock
+ *
+ * NAME
+ *   SPROX_WatchUnlock
+ *
+ * DESCRIPTION
+ *   Give the reader back to the watch
+ *
+ **/
+SPROX_API_FUNC(WatchUnlock) (SPROX_PARAM_V)
+{
+	SPROX_WATCH_ST* watch;
+	SPROX_PARAM_TO_CTX;
+
+	watch = sprox_ctx->watch;
+	if (watch == NULL)
+		return MI_OK;
+
+#ifdef WIN32
+	LeaveCriticalSection(&watch->Lock);
+#else
+	pthread_mutex_unlock(&watch->Lock);
+#endif
+	return MI_OK;
+}
+
+#endif
@@ -0,0 +1,443 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  Copyright (c) 2026 SpringCard SAS, FRANCE - www.springcard.com
+
+  Ref_Calypso_Batch_Decode.c
+  --------------------------
+
+  This is the reference application that shows how to decode stored
+  Calypso records (validation logs, card dumps) on all the cores of the
+  computer, without any reader.
+
+  The input file is a sequence of entries :
+    BYTE Type        : 1=Environment and Holder, 2=Contract, 3=Event
+    BYTE EnvVersion  : EnvVersionNumber from the Environment of the card
+    BYTE Size        : size of the record
+    BYTE Data[Size]  : the record, as read from the card
+
+  The output has one "Record" per entry, in the same order :
+  - JSON : one line per record,
+  - binary : for each record, its length (4 bytes, MSB first) and its
+    self-contained binary stream (see calypso_intercode_to_bin_pc.c),
+  - XML : the records one after the other.
+
+  AGT 19/10/2026 : initial release
+*/
+#include "products/springprox/api/springprox.h"
+#include "cardware/calypso/calypso_api.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char* PROGRAM_NAME = "ref_calypso_batch_decode";
+const char* szInputFileName = NULL;
+const char* szOutputFileName = NULL;
+BYTE bOutputFormat = CALYPSO_OUTPUT_JSON;
+BYTE bOutputOptions = 0;
+DWORD dwThreads = 0;
+
+static BOOL parse_args(int argc, char** argv);
+static void usage(void);
+
+#define RECORDS_PER_JOB  4096      /* Records given to a thread at once */
+#define RECORD_OUTPUT_SZ (16*1024) /* Room kept for every record       */
+#define MAX_THREADS      256
+
+typedef struct
+{
+	const BYTE* Entries;    /* The input file, mapped in memory */
+	const size_t* Offsets;  /* Offset of every entry            */
+	size_t      First;
+	size_t      Count;
+
+	BYTE*       Output;
+	size_t      OutputUsed;
+	size_t      OutputSize;
+	size_t      Errors;
+} JOB_ST;
+
+static BOOL job_reserve(JOB_ST* job, size_t size)
+{
+	BYTE* p;
+	size_t length = job->OutputSize ? job->OutputSize : (RECORDS_PER_JOB * 256);
+
+	if (job->OutputUsed + size <= job->OutputSize)
+		return TRUE;
+
+	while (length < job->OutputUsed + size)
+		length *= 2;
+
+	p = realloc(job->Output, length);
+	if (p == NULL)
+		return FALSE;
+
+	job->Output = p;
+	job->OutputSize = length;
+	return TRUE;
+}
+
+/*
+ * Decode the records of a job, straight into its output buffer
+ */
+#ifdef WIN32
+static DWORD WINAPI job_run(LPVOID param)
+#else
+static void* job_run(void* param)
+#endif
+{
+	JOB_ST* job = (JOB_ST*)param;
+	size_t i;
+
+	job->OutputUsed = 0;
+	job->Errors = 0;
+
+	for (i = job->First; i < job->First + job->Count; i++)
+	{
+		const BYTE* entry = &job->Entries[job->Offsets[i]];
+		size_t head = (bOutputFormat == CALYPSO_OUTPUT_BIN) ? 4 : 0;
+		CALYPSO_SZ length;
+		CALYPSO_RC rc;
+
+		if (!job_reserve(job, head + RECORD_OUTPUT_SZ))
+		{
+			job->Errors++;
+			break;
+		}
+
+		length = (CALYPSO_SZ)(job->OutputSize - job->OutputUsed - head);
+		rc = CalypsoDecodeStoredRecord(entry[0], entry[1], bOutputFormat, bOutputOptions, &entry[3], entry[2], &job->Output[job->OutputUsed + head], &length);
+		if (rc == CALYPSO_ERR_BUFFER_TOO_SHORT)
+		{
+			/* Unlikely, try again with the size the decoder asked for */
+			if (!job_reserve(job, head + length + 1))
+			{
+				job->Errors++;
+				break;
+			}
+			length = (CALYPSO_SZ)(job->OutputSize - job->OutputUsed - head);
+			rc = CalypsoDecodeStoredRecord(entry[0], entry[1], bOutputFormat, bOutputOptions, &entry[3], entry[2], &job->Output[job->OutputUsed + head], &length);
+		}
+		if (rc)
+			job->Errors++;
+		if (rc == CALYPSO_ERR_BUFFER_TOO_SHORT)
+			continue;
+
+		if (head)
+		{
+			job->Output[job->OutputUsed + 0] = (BYTE)(length >> 24);
+			job->Output[job->OutputUsed + 1] = (BYTE)(length >> 16);
+			job->Output[job->OutputUsed + 2] = (BYTE)(length >> 8);
+			job->Output[job->OutputUsed + 3] = (BYTE)length;
+		}
+		job->OutputUsed += head + length;
+	}
+
+#ifdef WIN32
+	return 0;
+#else
+	return NULL;
+#endif
+}
+
+static DWORD count_cores(void)
+{
+#ifdef WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n > 0) ? (DWORD)n : 1;
+#endif
+}
+
+int main(int argc, char** argv)
+{
+	const BYTE* entries = NULL;
+	size_t entries_size = 0;
+	size_t* offsets = NULL;
+	size_t count = 0, errors = 0, offset, first;
+	JOB_ST* jobs = NULL;
+	FILE* fp = NULL;
+	DWORD t;
+	int rc = EXIT_FAILURE;
+#ifdef WIN32
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	HANDLE hMapping = NULL;
+	HANDLE* hThreads = NULL;
+	LARGE_INTEGER file_size;
+#else
+	int fd = -1;
+	struct stat st;
+	pthread_t* threads = NULL;
+#endif
+
+	fprintf(stderr, "SpringCard SpringProx 'Legacy' SDK\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "%s : Calypso demo software (batch decoding of stored records)\n\n", PROGRAM_NAME);
+	fprintf(stderr, "This is a free and unsupported sample provided by www.springcard.com\n");
+	fprintf(stderr, "Please read LICENSE.txt for details\n");
+
+	if (!parse_args(argc, argv) || (szInputFileName == NULL))
+	{
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	if (dwThreads == 0)
+		dwThreads = count_cores();
+	if (dwThreads > MAX_THREADS)
+		dwThreads = MAX_THREADS;
+
+	/* Map the input file */
+#ifdef WIN32
+	hFile = CreateFileA(szInputFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if ((hFile == INVALID_HANDLE_VALUE) || !GetFileSizeEx(hFile, &file_size))
+	{
+		fprintf(stderr, "Failed to open input file '%s'\n", szInputFileName);
+		goto done;
+	}
+	entries_size = (size_t)file_size.QuadPart;
+	if (entries_size)
+	{
+		hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMapping != NULL)
+			entries = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	}
+#else
+	fd = open(szInputFileName, O_RDONLY);
+	if ((fd < 0) || fstat(fd, &st))
+	{
+		fprintf(stderr, "Failed to open input file '%s'\n", szInputFileName);
+		fprintf(stderr, "Err. %d\n", errno);
+		goto done;
+	}
+	entries_size = (size_t)st.st_size;
+	if (entries_size)
+	{
+		void* p = mmap(NULL, entries_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED)
+		{
+			entries = p;
+			madvise(p, entries_size, MADV_SEQUENTIAL);
+		}
+	}
+#endif
+	if ((entries == NULL) && entries_size)
+	{
+		fprintf(stderr, "Failed to map input file '%s'\n", szInputFileName);
+		goto done;
+	}
+
+	/* Locate every entry, so that the threads may start anywhere */
+	for (offset = 0; offset + 3 <= entries_size; offset += 3 + entries[offset + 2])
+		count++;
+	if (offset != entries_size)
+	{
+		fprintf(stderr, "Input file is truncated, the last entry is ignored\n");
+		if (offset > entries_size)
+			count--;
+	}
+
+	offsets = malloc((count ? count : 1) * sizeof(size_t));
+	jobs = calloc(dwThreads, sizeof(JOB_ST));
+#ifdef WIN32
+	hThreads = calloc(dwThreads, sizeof(HANDLE));
+	if ((offsets == NULL) || (jobs == NULL) || (hThreads == NULL))
+#else
+	threads = calloc(dwThreads, sizeof(pthread_t));
+	if ((offsets == NULL) || (jobs == NULL) || (threads == NULL))
+#endif
+	{
+		fprintf(stderr, "Out of memory\n");
+		goto done;
+	}
+
+	for (first = 0, offset = 0; first < count; first++)
+	{
+		offsets[first] = offset;
+		offset += 3 + entries[offset + 2];
+	}
+
+	/* Open the output */
+	if (szOutputFileName != NULL)
+	{
+		fp = fopen(szOutputFileName, "wb");
+		if (fp == NULL)
+		{
+			fprintf(stderr, "Failed to open output file '%s'\n", szOutputFileName);
+			goto done;
+		}
+	}
+	else
+	{
+		fp = stdout;
+	}
+
+	fprintf(stderr, "%lu record(s), %lu thread(s)\n", (unsigned long)count, (unsigned long)dwThreads);
+
+	/* Every round gives RECORDS_PER_JOB records to every thread, the outputs are written in order */
+	for (first = 0; first < count; )
+	{
+		DWORD running = 0;
+
+		for (t = 0; (t < dwThreads) && (first < count); t++)
+		{
+			jobs[t].Entries = entries;
+			jobs[t].Offsets = offsets;
+			jobs[t].First = first;
+			jobs[t].Count = ((count - first) < RECORDS_PER_JOB) ? (count - first) : RECORDS_PER_JOB;
+			first += jobs[t].Count;
+
+#ifdef WIN32
+			hThreads[t] = CreateThread(NULL, 0, job_run, &jobs[t], 0, NULL);
+			if (hThreads[t] == NULL)
+				job_run(&jobs[t]);
+#else
+			if (pthread_create(&threads[t], NULL, job_run, &jobs[t]))
+			{
+				threads[t] = pthread_self();
+				job_run(&jobs[t]);
+			}
+#endif
+			running++;
+		}
+
+		for (t = 0; t < running; t++)
+		{
+#ifdef WIN32
+			if (hThreads[t] != NULL)
+			{
+				WaitForSingleObject(hThreads[t], INFINITE);
+				CloseHandle(hThreads[t]);
+			}
+#else
+			if (!pthread_equal(threads[t], pthread_self()))
+				pthread_join(threads[t], NULL);
+#endif
+			fwrite(jobs[t].Output, 1, jobs[t].OutputUsed, fp);
+			errors += jobs[t].Errors;
+		}
+	}
+
+	fprintf(stderr, "%lu record(s) decoded, %lu error(s)\n", (unsigned long)count, (unsigned long)errors);
+	rc = errors ? EXIT_FAILURE : EXIT_SUCCESS;
+
+done:
+	if ((fp != NULL) && (fp != stdout))
+		fclose(fp);
+
+	if (jobs != NULL)
+	{
+		for (t = 0; t < dwThreads; t++)
+			free(jobs[t].Output);
+		free(jobs);
+	}
+	free(offsets);
+
+#ifdef WIN32
+	free(hThreads);
+	if (entries != NULL)
+		UnmapViewOfFile(entries);
+	if (hMapping != NULL)
+		CloseHandle(hMapping);
+	if (hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(hFile);
+#else
+	free(threads);
+	if (entries != NULL)
+		munmap((void*)entries, entries_size);
+	if (fd >= 0)
+		close(fd);
+#endif
+
+	return rc;
+}
+
+static void usage(void)
+{
+	printf("Usage: %s -i <INPUT FILENAME> [-o <OUTPUT FILENAME>] [-j|-b|-x] [-t <THREADS>]\n", PROGRAM_NAME);
+	printf(" -i <INPUT FILENAME>  the stored records.\n");
+	printf(" -o <OUTPUT FILENAME> writes the output into the specified file (default is stdout).\n");
+	printf("OPTIONS:\n");
+	printf(" -j : JSON output, one line per record (default).\n");
+	printf(" -b : binary output, every record prefixed by its length.\n");
+	printf(" -x : XML output.\n");
+	printf(" -r : don't output the raw records, nor the bitmaps.\n");
+	printf(" -t <THREADS> : number of threads (default is one per core).\n");
+}
+
+static BOOL parse_args(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{ // Start at 1 because argv[0] is the program name
+		if (argv[i][0] == '-')
+		{ // This is an option
+			if (!strcmp(argv[i], "-i") && i + 1 < argc)
+			{
+				szInputFileName = argv[i + 1];
+				i++;  // Skip next item since we just processed it
+			}
+			else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+			{
+				szOutputFileName = argv[i + 1];
+				i++;  // Skip next item since we just processed it
+			}
+			else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+			{
+				dwThreads = (DWORD)atoi(argv[i + 1]);
+				i++;  // Skip next item since we just processed it
+			}
+			else if (!strcmp(argv[i], "-j"))
+			{
+				bOutputFormat = CALYPSO_OUTPUT_JSON;
+			}
+			else if (!strcmp(argv[i], "-b"))
+			{
+				bOutputFormat = CALYPSO_OUTPUT_BIN;
+			}
+			else if (!strcmp(argv[i], "-x"))
+			{
+				bOutputFormat = CALYPSO_OUTPUT_XML;
+			}
+			else if (!strcmp(argv[i], "-r"))
+			{
+				/* PARSER_OUT_NO_RAW | PARSER_OUT_NO_BITMAP */
+				bOutputOptions |= 0x03;
+			}
+			else if (!strcmp(argv[i], "-h"))
+			{
+				/* Return FALSE to display the usage message */
+				return FALSE;
+			}
+			else
+			{
+				printf("Unknown option: %s\n", argv[i]);
+				return FALSE;
+			}
+		}
+		else
+		{
+			// It's not an option, maybe a standalone argument
+			printf("Unsupported argument: %s\n", argv[i]);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
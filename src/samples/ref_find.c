@@ -17,6 +17,7 @@
   JDA 04/02/2013 : minor changes to adapt to release 1.7x of the SDK
   JDA 13/08/2014 : moved to Visual C++ Express 2010, added the 'A'
 				   suffix to all text-related functions
+  AGT 19/10/2026 : added the -b option to benchmark the discovery functions
 
 */
 #include "products/springprox/api/springprox.h"
@@ -31,14 +32,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 const char* PROGRAM_NAME = "ref_find";
 const char* szCommDevice = NULL;
 WORD wFindProtos = 0;
 BOOL fFindOnce = FALSE;
+DWORD dwBenchCount = 0;
 
 static BOOL parse_args(int argc, char** argv);
 static void usage(void);
+static void find_benchmark(void);
 
 int main(int argc, char** argv)
 {
@@ -103,6 +107,12 @@ int main(int argc, char** argv)
 	if (!wFindProtos)
 		wFindProtos = 0xFFFF;
 
+	if (dwBenchCount)
+	{
+		find_benchmark();
+		goto close;
+	}
+
 	printf("\nWaiting for cards... (Press <Ctrl>+C to exit)\n\n");
 
 	for (;;)
@@ -400,6 +410,92 @@ done:
 }
 
 
+static unsigned long clock_ms(void)
+{
+#ifdef WIN32
+	return GetTickCount();
+#else
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (unsigned long)(t.tv_sec * 1000 + t.tv_nsec / 1000000);
+#endif
+}
+
+/*
+ * Time the discovery of the same card, with the UID only (one exchange),
+ * with the protocol bytes through SPROX_FindEx, and with the whole
+ * identification through SPROX_FindIdent. The last two take one exchange
+ * as well when the reader knows SPROX_FIND_IDENT, two otherwise.
+ * SPROX_FIND_IDENT is not documented, it is only tried in this benchmark.
+ */
+static void find_benchmark(void)
+{
+	BYTE uid[32];
+	BYTE uid_len;
+	BYTE info[32];
+	BYTE info_len;
+	BYTE ats[32];
+	BYTE ats_len;
+	DWORD time_us, reader_us = 0;
+	WORD proto;
+	unsigned long t0, t1;
+	DWORD i, ok;
+	int pass;
+	SWORD rc;
+
+	printf("\nPut a card on the reader, %lu discoveries per function\n\n", (unsigned long)dwBenchCount);
+
+	SPROX_FindIdentEnable(TRUE);
+
+	for (pass = 0; pass < 3; pass++)
+	{
+		ok = 0;
+		t0 = clock_ms();
+
+		for (i = 0; i < dwBenchCount; i++)
+		{
+			uid_len = sizeof(uid);
+			info_len = sizeof(info);
+			ats_len = sizeof(ats);
+
+			switch (pass)
+			{
+			case 0:
+				rc = SPROX_Find(wFindProtos, &proto, uid, &uid_len);
+				break;
+			case 1:
+				rc = SPROX_FindEx(wFindProtos, &proto, uid, &uid_len, info, &info_len);
+				break;
+			default:
+				rc = SPROX_FindIdent(wFindProtos, &proto, uid, &uid_len, info, &info_len, ats, &ats_len, &time_us);
+				if (rc == MI_OK)
+					reader_us += time_us;
+				break;
+			}
+
+			if (rc == MI_OK)
+				ok++;
+			else if (rc < -128)
+			{
+				printf("%s (%d)\n", SPROX_GetErrorMessageA(rc), rc);
+				return;
+			}
+		}
+
+		t1 = clock_ms();
+
+		printf("%-16s: %lu/%lu found, %.2fms per call\n", (pass == 0) ? "SPROX_Find" : (pass == 1) ? "SPROX_FindEx" : "SPROX_FindIdent",
+			(unsigned long)ok, (unsigned long)dwBenchCount, (double)(t1 - t0) / dwBenchCount);
+	}
+
+	if (reader_us)
+		printf("Time spent by the reader: %.2fms per call\n", (double)reader_us / 1000.0 / dwBenchCount);
+	else
+		printf("The reader doesn't know SPROX_FIND_IDENT\n");
+
+	SPROX_FindIdentEnable(FALSE);
+}
+
 void usage(void)
 {
 	printf("usage: %s [PROTOCOLS] [OPTIONS] [-d <COMM DEVICE>]\n\n", PROGRAM_NAME);
@@ -416,6 +512,7 @@ void usage(void)
 	printf("If PROTOCOLS is empty, all protocols are tried (same as -*)\n");
 	printf("OPTIONS:\n");
 	printf(" -1 : run only once (exit when first card is found)\n");
+	printf(" -b <COUNT> : benchmark the discovery functions over COUNT calls\n");
 	printf(" -v : verbose (trace library functions)\n");
 	printf("If the name of COMM DEVICE is not specified, default is taken from Registry or from /etc/springprox.cfg\n");
 }
@@ -472,6 +569,11 @@ static BOOL parse_args(int argc, char** argv)
 			{
 				wFindProtos |= PROTO_ST_SR | PROTO_ASK_CTS;
 			}
+			else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+			{
+				dwBenchCount = (DWORD)atol(argv[i + 1]);
+				i++;  // Skip next item since we just processed it
+			}
 			else if (!strcmp(argv[i], "-1"))
 			{
 				fFindOnce = TRUE;
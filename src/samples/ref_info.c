@@ -11,6 +11,8 @@
 
   This is the reference applications that shows how to dump reader info.
   JDA 04/09/2023 : creation
+  AGT 19/10/2026 : added the -l and -w options, to list the readers and watch them come and go (Linux)
+  AGT 19/10/2026 : added the -b option, to measure the throughput of the serial link at each baudrate
 
 */
 #include "products/springprox/api/springprox.h"
@@ -19,12 +21,24 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#ifdef __linux
+#include <sys/select.h>
+#endif
 
 const char* PROGRAM_NAME = "ref_info";
 const char* szCommDevice = NULL;
+BOOL fList = FALSE;
+BOOL fHotplug = FALSE;
+BOOL fBench = FALSE;
 
 static BOOL parse_args(int argc, char** argv);
 static void usage(void);
+static void bench_baudrates(void);
+#ifdef __linux
+static SWORD list_readers(void);
+static SWORD watch_hotplug(void);
+#endif
 
 int main(int argc, char** argv)
 {
@@ -59,6 +73,16 @@ int main(int argc, char** argv)
 	printf("API version : %s\n", s_buffer);
 	printf("\n");
 
+#ifdef __linux
+	if (fList || fHotplug)
+	{
+		rc = list_readers();
+		if ((rc == MI_OK) && fHotplug)
+			rc = watch_hotplug();
+		goto done;
+	}
+#endif
+
 	/* Open the reader */
 	/* --------------- */
 
@@ -121,6 +145,9 @@ int main(int argc, char** argv)
 	printf("\tShell (\"human console\")                 : %s\n", (features & SPROX_WITH_HUMAN_CONSOLE) ? yes : no);
 	printf("\n");
 
+	if (fBench)
+		bench_baudrates();
+
 close:
 
 	/* Close the reader */
@@ -134,11 +161,149 @@ done:
 	return EXIT_SUCCESS;
 }
 
+/*
+ * Milliseconds, for the benchmark
+ */
+static DWORD bench_ms(void)
+{
+#ifdef WIN32
+	return GetTickCount();
+#else
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (DWORD)(t.tv_sec * 1000 + t.tv_nsec / 1000000);
+#endif
+}
+
+/*
+ * Echo exchanges at each baudrate : how many bytes per second go through the link
+ */
+static void bench_baudrates(void)
+{
+	const DWORD baudrates[] = { 38400, 115200, 230400, 460800, 921600 };
+	const WORD echo_len = 250;
+	const WORD echo_count = 20;
+	DWORD initial, t0, elapsed;
+	WORD i, j;
+	SWORD rc;
+
+	SPROX_ReaderGetBaudrate(&initial);
+
+	/* The rates above 115200bps are not in every firmware */
+	SPROX_ReaderBaudrateHighEnable(TRUE);
+
+	printf("Throughput (%d Echo exchanges of %d bytes)\n", echo_count, echo_len);
+	for (i = 0; i < sizeof(baudrates) / sizeof(baudrates[0]); i++)
+	{
+		printf("\t%7lubps : ", baudrates[i]);
+
+		rc = SPROX_ReaderSetBaudrate(baudrates[i]);
+		if (rc != MI_OK)
+		{
+			printf("%s (%d)\n", SPROX_GetErrorMessageA(rc), rc);
+			continue;
+		}
+
+		t0 = bench_ms();
+		for (j = 0; j < echo_count; j++)
+		{
+			rc = SPROX_Echo(echo_len);
+			if (rc != MI_OK)
+				break;
+		}
+		elapsed = bench_ms() - t0;
+		if (elapsed == 0)
+			elapsed = 1;
+
+		if (rc != MI_OK)
+			printf("failed after %d exchanges, %s (%d)\n", j, SPROX_GetErrorMessageA(rc), rc);
+		else
+			printf("%lu bytes/s (%lums per exchange)\n", (DWORD)(2 * echo_len * echo_count) * 1000 / elapsed, elapsed / echo_count);
+	}
+
+	SPROX_ReaderSetBaudrate(initial);
+	SPROX_ReaderBaudrateHighEnable(FALSE);
+	printf("\n");
+}
+
+#ifdef __linux
+/*
+ * List all the readers, and tell how long it takes to find them
+ */
+static SWORD list_readers(void)
+{
+	SPROX_READER_ENUM_ST readers[16];
+	struct timespec t0, t1;
+	WORD count, i;
+	SWORD rc;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	rc = SPROX_EnumReaders(readers, sizeof(readers) / sizeof(readers[0]), &count, SPROX_ENUM_LEGACY_SERIAL);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	if ((rc != MI_OK) && (rc != MI_RESPONSE_OVERFLOW))
+		return rc;
+
+	printf("%d reader(s) found in %ldms\n", count, (long)((t1.tv_sec - t0.tv_sec) * 1000 + (t1.tv_nsec - t0.tv_nsec) / 1000000));
+	for (i = 0; i < count; i++)
+	{
+		printf("%s\t%s\n", readers[i].device, (readers[i].rc == MI_OK) ? readers[i].firmware : "(busy)");
+		printf("\tid=%s", readers[i].stable_id);
+		if (readers[i].vid)
+			printf(" usb=%04X:%04X", readers[i].vid, readers[i].pid);
+		if (readers[i].serial[0])
+			printf(" serial=%s", readers[i].serial);
+		printf("\n");
+	}
+	printf("\n");
+
+	return MI_OK;
+}
+
+/*
+ * Tell when a device comes or goes, and list the readers again
+ */
+static SWORD watch_hotplug(void)
+{
+	char device[64];
+	BYTE event;
+	fd_set fds;
+	int fd;
+	SWORD rc;
+
+	rc = SPROX_HotplugOpen(&fd);
+	if (rc != MI_OK)
+		return rc;
+
+	printf("Waiting for devices... (Press <Ctrl>+C to exit)\n\n");
+
+	for (;;)
+	{
+		FD_ZERO(&fds);
+		FD_SET(fd, &fds);
+		if (select(fd + 1, &fds, NULL, NULL, NULL) < 0)
+			break;
+
+		while (SPROX_HotplugRead(fd, &event, device) == MI_OK)
+		{
+			printf("%s %s\n", (event == SPROX_HOTPLUG_ATTACH) ? "Attached" : "Detached", device);
+			if (event == SPROX_HOTPLUG_ATTACH)
+				list_readers();
+		}
+	}
+
+	SPROX_HotplugClose(fd);
+	return MI_OK;
+}
+#endif
 
 void usage(void)
 {
 	printf("Usage: %s [OPTIONS] [-d <COMM DEVICE]\n", PROGRAM_NAME);
 	printf("OPTIONS:\n");
+	printf(" -b : measure the throughput of the link at each baudrate\n");
+	printf(" -l : list all the readers (Linux only)\n");
+	printf(" -w : list all the readers, then again each time a device is attached (Linux only)\n");
 	printf(" -v : verbose (trace library functions)\n");
 	printf("If the name of COMM DEVICE is not specified, default is taken from Registry or from /etc/springprox.cfg\n");
 }
@@ -159,6 +324,18 @@ static BOOL parse_args(int argc, char** argv)
 				// Ask the library to be verbose
 				SPROX_SetVerbose(255, NULL);
 			}
+			else if (!strcmp(argv[i], "-b"))
+			{
+				fBench = TRUE;
+			}
+			else if (!strcmp(argv[i], "-l"))
+			{
+				fList = TRUE;
+			}
+			else if (!strcmp(argv[i], "-w"))
+			{
+				fHotplug = TRUE;
+			}
 			else if (!strcmp(argv[i], "-h"))
 			{
 				/* Return FALSE to display the usage message */
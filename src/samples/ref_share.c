@@ -0,0 +1,657 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  Copyright (c) 2026 SpringCard SAS, FRANCE - www.springcard.com
+
+  ref_share.c
+  -----------
+
+  This is the reference daemon that shares readers between many applications.
+  The daemon owns the reader(s) ; each application opens a reader with
+  SPROX_ReaderOpen("SHARE:<socket>") instead of SPROX_ReaderOpen("<device>"),
+  and uses SPROX_ReaderLock / SPROX_ReaderUnlock around its card transactions.
+  Every exchange is atomic ; the applications that have a command pending are
+  served in turn, one command each. Linux only.
+  The reader runs one command at a time : a command that keeps it busy (waiting
+  for a card, for instance) holds the commands of all the other applications for
+  as long. They wait for their answer up to 30s in the library, then give up.
+  A client that doesn't read its answers is dropped after SEND_TMO_MS.
+  A client waits for the lock up to SPROX_LOCK_WAIT_MAX, or for ever.
+  AGT 19/10/2026 : creation
+
+*/
+#include "products/springprox/api/springprox.h"
+#include "products/springprox/api/sprox_share.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __linux
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#endif
+
+const char* PROGRAM_NAME = "ref_share";
+
+#ifdef __linux
+
+#define MAX_READERS    8
+#define MAX_CLIENTS   32
+#define LOCK_IDLE_MS  5000  /* The lock is taken back after this time without any command */
+#define BENCH_COUNT    200
+#define SEND_TMO_MS    1000  /* A client that doesn't take its answer in this time is dropped */
+
+typedef struct
+{
+	int   sk;                                   /* -1 : free slot */
+	BYTE  request[SPROX_SHARE_HEADER_SIZE + SPROX_SHARE_MAX_DATA];
+	DWORD got;                                  /* Bytes of the request received so far */
+	BOOL  lock_waiting;                         /* A LOCK request waits for the lock */
+	DWORD lock_ticket;                          /* ...in this order */
+	DWORD lock_deadline;                        /* ...until then */
+	BOOL  lock_forever;                         /* ...or without deadline */
+	DWORD exchanges;
+} CLIENT_ST;
+
+static CLIENT_ST clients[MAX_CLIENTS];
+static int   lock_owner = -1;                   /* Client that holds the lock */
+static DWORD lock_last_ms;                      /* Last command of the lock owner */
+static DWORD lock_tickets;
+static int   round_robin;
+
+const char* szReaders[MAX_READERS];
+const char* szSockets[MAX_READERS];
+int nReaders = 0;
+BOOL fBench = FALSE;
+BOOL fVerbose = FALSE;
+
+static BOOL parse_args(int argc, char** argv);
+static void usage(void);
+static int serve(const char* device, const char* socket_path);
+static int bench(const char* device);
+
+static DWORD now_ms(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (DWORD)(t.tv_sec * 1000 + t.tv_nsec / 1000000);
+}
+
+int main(int argc, char** argv)
+{
+	int i;
+
+	printf("SpringCard SpringProx 'Legacy' SDK\n");
+	printf("\n");
+	printf("%s : share readers between many applications\n\n", PROGRAM_NAME);
+	printf("This is a free and unsupported sample provided by www.springcard.com\n");
+	printf("Please read LICENSE.txt for details\n");
+	printf("\n");
+
+	if (!parse_args(argc, argv))
+	{
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	if (fVerbose)
+		SPROX_SetVerbose(255, NULL);
+
+	if (fBench)
+		return bench(szReaders[0]);
+
+	signal(SIGPIPE, SIG_IGN);
+
+	/* The library drives one reader per process : one process per reader */
+	for (i = 1; i < nReaders; i++)
+	{
+		pid_t pid = fork();
+		if (pid < 0)
+		{
+			perror("fork");
+			return EXIT_FAILURE;
+		}
+		if (pid == 0)
+			return serve(szReaders[i], szSockets[i]);
+	}
+
+	return serve(szReaders[0], szSockets[0]);
+}
+
+/*
+ * Send a whole buffer, or fail if the client doesn't take it within SEND_TMO_MS
+ */
+static BOOL send_all(int sk, const BYTE buffer[], DWORD length)
+{
+	ssize_t done;
+
+	while (length)
+	{
+		done = send(sk, buffer, length, MSG_NOSIGNAL);
+		if (done < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return FALSE;
+		}
+		buffer += done;
+		length -= (DWORD)done;
+	}
+
+	return TRUE;
+}
+
+static void drop_client(int i);
+
+/*
+ * Answer a client ; the client is dropped if it doesn't take the answer
+ */
+static void reply(int i, BYTE seq, SWORD rc, const BYTE data[], WORD length)
+{
+	BYTE frame[SPROX_SHARE_HEADER_SIZE + SPROX_SHARE_MAX_DATA];
+
+	if (length > SPROX_SHARE_MAX_DATA)
+		length = 0;
+
+	frame[0] = SPROX_SHARE_TO_CLIENT;
+	frame[1] = seq;
+	frame[2] = (BYTE)(0 - rc);
+	frame[3] = (BYTE)(length / 0x0100);
+	frame[4] = (BYTE)(length % 0x0100);
+	if (length)
+		memcpy(&frame[SPROX_SHARE_HEADER_SIZE], data, length);
+
+	if (!send_all(clients[i].sk, frame, SPROX_SHARE_HEADER_SIZE + length))
+	{
+		printf("Client %d: answer not taken\n", i);
+		drop_client(i);
+	}
+}
+
+/*
+ * The lock is free again ; if its owner has gone in the middle of a transaction,
+ * reset the RF field so the next application doesn't find the card as it was left
+ */
+static void release_lock(BOOL abnormal)
+{
+	if (abnormal)
+	{
+		printf("Lock of client %d taken back\n", lock_owner);
+		SPROX_ControlRF(FALSE);
+		SPROX_ControlRF(TRUE);
+	}
+	lock_owner = -1;
+}
+
+static void drop_client(int i)
+{
+	if (fVerbose)
+		printf("Client %d gone after %lu exchange(s)\n", i, (unsigned long) clients[i].exchanges);
+	close(clients[i].sk);
+	clients[i].sk = -1;
+	clients[i].got = 0;
+	clients[i].lock_waiting = FALSE;
+	if (lock_owner == i)
+		release_lock(TRUE);
+}
+
+static DWORD request_length(int i)
+{
+	return SPROX_SHARE_HEADER_SIZE + clients[i].request[3] * 0x0100 + clients[i].request[4];
+}
+
+static BOOL request_complete(int i)
+{
+	return (clients[i].got >= SPROX_SHARE_HEADER_SIZE) && (clients[i].got == request_length(i));
+}
+
+/*
+ * While a client holds the lock, the others' commands to the reader wait ; their requests to the daemon don't
+ */
+static BOOL request_allowed(int i)
+{
+	return (lock_owner < 0) || (lock_owner == i) || (clients[i].request[0] != SPROX_SHARE_TO_READER);
+}
+
+/*
+ * Serve the request of a client
+ */
+static void serve_one(int i)
+{
+	static BYTE answer[SPROX_SHARE_MAX_DATA];
+	CLIENT_ST* client = &clients[i];
+	BYTE* header = client->request;
+	BYTE* data = &client->request[SPROX_SHARE_HEADER_SIZE];
+	WORD length = (WORD)(request_length(i) - SPROX_SHARE_HEADER_SIZE);
+	WORD answer_len;
+	DWORD wait;
+	SWORD rc;
+
+	if (header[0] == SPROX_SHARE_TO_READER)
+	{
+		answer_len = sizeof(answer);
+		rc = SPROX_Function(header[2], data, length, answer, &answer_len);
+		if (rc != MI_OK)
+			answer_len = 0;
+		reply(i, header[1], rc, answer, answer_len);
+		client->exchanges++;
+	}
+	else if ((header[0] == SPROX_SHARE_TO_DAEMON) && (header[2] == SPROX_SHARE_LOCK) && (length == 4))
+	{
+		if (lock_owner == i)
+		{
+			reply(i, header[1], MI_OK, NULL, 0);
+		}
+		else
+		{
+			/* Granted in order of arrival, see serve_locks */
+			client->lock_waiting = TRUE;
+			client->lock_ticket = lock_tickets++;
+			wait = ((DWORD)data[0] << 24) | ((DWORD)data[1] << 16) | ((DWORD)data[2] << 8) | data[3];
+			/* The deadline is compared on 31 bits */
+			client->lock_forever = (wait == SPROX_LOCK_WAIT_FOREVER);
+			if (wait > SPROX_LOCK_WAIT_MAX)
+				wait = SPROX_LOCK_WAIT_MAX;
+			client->lock_deadline = now_ms() + wait;
+			return;
+		}
+	}
+	else if ((header[0] == SPROX_SHARE_TO_DAEMON) && (header[2] == SPROX_SHARE_UNLOCK))
+	{
+		if (lock_owner == i)
+			release_lock(FALSE);
+		reply(i, header[1], MI_OK, NULL, 0);
+	}
+	else
+	{
+		reply(i, header[1], MI_UNKNOWN_FUNCTION, NULL, 0);
+	}
+
+	if (lock_owner == i)
+		lock_last_ms = now_ms();
+	client->got = 0;
+}
+
+/*
+ * Take the lock back from an idle owner, give it to the first client in line, or tell the others they've waited too long
+ */
+static void serve_locks(void)
+{
+	DWORD now = now_ms();
+	int i, first = -1;
+
+	if ((lock_owner >= 0) && ((now - lock_last_ms) > LOCK_IDLE_MS))
+		release_lock(TRUE);
+
+	for (i = 0; i < MAX_CLIENTS; i++)
+	{
+		if ((clients[i].sk < 0) || !clients[i].lock_waiting)
+			continue;
+
+		if ((lock_owner < 0) && ((first < 0) || ((clients[i].lock_ticket - clients[first].lock_ticket) & 0x80000000)))
+			first = i;
+	}
+
+	if (first >= 0)
+	{
+		clients[first].lock_waiting = FALSE;
+		clients[first].got = 0;
+		lock_owner = first;
+		lock_last_ms = now;
+		reply(first, clients[first].request[1], MI_OK, NULL, 0);
+	}
+
+	for (i = 0; i < MAX_CLIENTS; i++)
+	{
+		if ((clients[i].sk < 0) || !clients[i].lock_waiting)
+			continue;
+
+		if (!clients[i].lock_forever && ((SDWORD)(now - clients[i].lock_deadline) >= 0))
+		{
+			clients[i].lock_waiting = FALSE;
+			clients[i].got = 0;
+			reply(i, clients[i].request[1], MI_READER_BUSY, NULL, 0);
+		}
+	}
+}
+
+/*
+ * Receive what a client has sent
+ */
+static void receive_one(int i)
+{
+	CLIENT_ST* client = &clients[i];
+	DWORD wanted;
+	ssize_t done;
+
+	wanted = (client->got < SPROX_SHARE_HEADER_SIZE) ? SPROX_SHARE_HEADER_SIZE : request_length(i);
+	if (wanted > sizeof(client->request))
+	{
+		printf("Client %d: request too long\n", i);
+		drop_client(i);
+		return;
+	}
+
+	done = recv(client->sk, &client->request[client->got], wanted - client->got, 0);
+	if (done <= 0)
+	{
+		if ((done < 0) && (errno == EINTR))
+			return;
+		drop_client(i);
+		return;
+	}
+	client->got += (DWORD)done;
+}
+
+static int serve(const char* device, const char* socket_path)
+{
+	struct pollfd pfds[1 + MAX_CLIENTS];
+	int slot_of[1 + MAX_CLIENTS];
+	struct sockaddr_un sa;
+	char s_buffer[64];
+	int listen_sk;
+	int i, n, count, timeout;
+	SWORD rc;
+
+	rc = SPROX_ReaderOpen(device);
+	if (rc != MI_OK)
+	{
+		printf("%s: reader not found, %s (%d)\n", (device != NULL) ? device : "(default)", SPROX_GetErrorMessageA(rc), rc);
+		return EXIT_FAILURE;
+	}
+	SPROX_ReaderGetDevice(s_buffer, sizeof(s_buffer));
+	printf("Reader found on %s\n", s_buffer);
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family = AF_UNIX;
+	if (strlen(socket_path) >= sizeof(sa.sun_path))
+	{
+		printf("%s: path too long\n", socket_path);
+		return EXIT_FAILURE;
+	}
+	strcpy(sa.sun_path, socket_path);
+	unlink(socket_path);
+
+	listen_sk = socket(AF_UNIX, SOCK_STREAM, 0);
+	if ((listen_sk < 0) || (bind(listen_sk, (struct sockaddr*)&sa, sizeof(sa)) < 0) || (listen(listen_sk, 8) < 0))
+	{
+		perror(socket_path);
+		return EXIT_FAILURE;
+	}
+	printf("Serving %s on %s\n", s_buffer, socket_path);
+
+	for (i = 0; i < MAX_CLIENTS; i++)
+		clients[i].sk = -1;
+
+	for (;;)
+	{
+		/* Wait for new clients, and for the requests not yet complete */
+		count = 0;
+		pfds[count].fd = listen_sk;
+		pfds[count].events = POLLIN;
+		slot_of[count++] = -1;
+
+		timeout = -1;
+		for (i = 0; i < MAX_CLIENTS; i++)
+		{
+			if (clients[i].sk < 0)
+				continue;
+			if (clients[i].lock_waiting || (lock_owner >= 0))
+				timeout = 100;
+			if (request_complete(i))
+			{
+				if (!clients[i].lock_waiting && request_allowed(i))
+					timeout = 0;
+				continue;
+			}
+			pfds[count].fd = clients[i].sk;
+			pfds[count].events = POLLIN;
+			slot_of[count++] = i;
+		}
+
+		if (poll(pfds, count, timeout) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			perror("poll");
+			break;
+		}
+
+		for (n = 1; n < count; n++)
+			if (pfds[n].revents)
+				receive_one(slot_of[n]);
+
+		if (pfds[0].revents & POLLIN)
+		{
+			int sk = accept(listen_sk, NULL, NULL);
+			if (sk >= 0)
+			{
+				struct timeval tmo;
+
+				/* Never wait for ever on a client that doesn't read */
+				tmo.tv_sec = SEND_TMO_MS / 1000;
+				tmo.tv_usec = (SEND_TMO_MS % 1000) * 1000;
+				setsockopt(sk, SOL_SOCKET, SO_SNDTIMEO, &tmo, sizeof(tmo));
+
+				for (i = 0; i < MAX_CLIENTS; i++)
+					if (clients[i].sk < 0)
+						break;
+				if (i < MAX_CLIENTS)
+				{
+					memset(&clients[i], 0, sizeof(clients[i]));
+					clients[i].sk = sk;
+					if (fVerbose)
+						printf("Client %d connected\n", i);
+				}
+				else
+				{
+					printf("Too many clients\n");
+					close(sk);
+				}
+			}
+		}
+
+		serve_locks();
+
+		/* One request per client in each round, starting one client further each time */
+		for (n = 0; n < MAX_CLIENTS; n++)
+		{
+			i = (round_robin + n) % MAX_CLIENTS;
+			if ((clients[i].sk < 0) || clients[i].lock_waiting || !request_complete(i) || !request_allowed(i))
+				continue;
+			serve_one(i);
+		}
+		round_robin = (round_robin + 1) % MAX_CLIENTS;
+	}
+
+	close(listen_sk);
+	unlink(socket_path);
+	SPROX_ReaderClose();
+	return EXIT_FAILURE;
+}
+
+/*
+ * Time of an Echo exchange, in us
+ */
+static long bench_echo(void)
+{
+	struct timespec t0, t1;
+	int i;
+	SWORD rc;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < BENCH_COUNT; i++)
+	{
+		rc = SPROX_Echo(16);
+		if (rc != MI_OK)
+		{
+			printf("Echo failed, %s (%d)\n", SPROX_GetErrorMessageA(rc), rc);
+			return -1;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	return ((t1.tv_sec - t0.tv_sec) * 1000000 + (t1.tv_nsec - t0.tv_nsec) / 1000) / BENCH_COUNT;
+}
+
+/*
+ * Latency added by the daemon : the same exchanges, directly then through a daemon of our own
+ */
+static int bench(const char* device)
+{
+	char socket_path[64];
+	char shared[80];
+	long direct_us, shared_us;
+	pid_t pid;
+	int i, status;
+	SWORD rc;
+
+	rc = SPROX_ReaderOpen(device);
+	if (rc != MI_OK)
+	{
+		printf("Reader not found, %s (%d)\n", SPROX_GetErrorMessageA(rc), rc);
+		return EXIT_FAILURE;
+	}
+	direct_us = bench_echo();
+	SPROX_ReaderClose();
+	if (direct_us < 0)
+		return EXIT_FAILURE;
+
+	snprintf(socket_path, sizeof(socket_path), "/tmp/ref_share_bench.%d", (int)getpid());
+	snprintf(shared, sizeof(shared), "SHARE:%s", socket_path);
+
+	pid = fork();
+	if (pid < 0)
+	{
+		perror("fork");
+		return EXIT_FAILURE;
+	}
+	if (pid == 0)
+		exit(serve(device, socket_path));
+
+	/* Give the daemon time to open the reader */
+	for (i = 0; i < 50; i++)
+	{
+		usleep(100000);
+		rc = SPROX_ReaderOpen(shared);
+		if (rc == MI_OK)
+			break;
+	}
+
+	shared_us = -1;
+	if (rc == MI_OK)
+	{
+		shared_us = bench_echo();
+		SPROX_ReaderClose();
+	}
+	else
+		printf("Daemon not reachable, %s (%d)\n", SPROX_GetErrorMessageA(rc), rc);
+
+	kill(pid, SIGTERM);
+	waitpid(pid, &status, 0);
+	unlink(socket_path);
+
+	if (shared_us < 0)
+		return EXIT_FAILURE;
+
+	printf("\n");
+	printf("Echo exchange (%d times)\n", BENCH_COUNT);
+	printf("\tdirect         : %ldus\n", direct_us);
+	printf("\tthrough daemon : %ldus\n", shared_us);
+	printf("\tadded latency  : %ldus\n", shared_us - direct_us);
+	return EXIT_SUCCESS;
+}
+
+static void usage(void)
+{
+	printf("Usage: %s [OPTIONS] -d <COMM DEVICE> [-s <SOCKET>] [-d <COMM DEVICE> -s <SOCKET>]...\n", PROGRAM_NAME);
+	printf("OPTIONS:\n");
+	printf(" -b : measure the latency added by the daemon, with the first reader\n");
+	printf(" -v : verbose (trace library functions)\n");
+	printf("The default socket for the first reader is %s\n", SPROX_SHARE_SOCKET);
+	printf("Applications open the reader with SPROX_ReaderOpen(\"SHARE:<SOCKET>\")\n");
+}
+
+static BOOL parse_args(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{ // Start at 1 because argv[0] is the program name
+		if (!strcmp(argv[i], "-d") && i + 1 < argc)
+		{
+			if (nReaders >= MAX_READERS)
+			{
+				printf("Too many readers\n");
+				return FALSE;
+			}
+			szReaders[nReaders] = argv[i + 1];
+			szSockets[nReaders] = (nReaders == 0) ? SPROX_SHARE_SOCKET : NULL;
+			nReaders++;
+			i++;
+		}
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc && nReaders > 0)
+		{
+			szSockets[nReaders - 1] = argv[i + 1];
+			i++;
+		}
+		else if (!strcmp(argv[i], "-b"))
+		{
+			fBench = TRUE;
+		}
+		else if (!strcmp(argv[i], "-v"))
+		{
+			fVerbose = TRUE;
+		}
+		else if (!strcmp(argv[i], "-h"))
+		{
+			/* Return FALSE to display the usage message */
+			return FALSE;
+		}
+		else
+		{
+			printf("Unsupported argument: %s\n", argv[i]);
+			return FALSE;
+		}
+	}
+
+	if (nReaders == 0)
+	{
+		/* Reader taken from /etc/springprox.cfg */
+		szReaders[0] = NULL;
+		szSockets[0] = SPROX_SHARE_SOCKET;
+		nReaders = 1;
+	}
+
+	for (int i = 0; i < nReaders; i++)
+	{
+		if (szSockets[i] == NULL)
+		{
+			printf("Please give a socket for each reader after the first one\n");
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+#else
+
+int main(int argc, char** argv)
+{
+	(void)argc;
+	(void)argv;
+	printf("%s : Linux only\n", PROGRAM_NAME);
+	return EXIT_FAILURE;
+}
+
+#endif
@@ -17,6 +17,8 @@
   JDA 13/08/2014 : moved to Visual C++ Express 2010, added the 'A'
 				   suffix to all text-related functions
   JDA 04/09/2023 : refreshed the project to build with Visual Studio 2022
+  AGT 19/10/2026 : added the -e option, to be notified by SPROX_WatchStart
+  AGT 19/10/2026 : added the -L option, low-power card detection while idle
 */
 #include "products/springprox/api/springprox.h"
 
@@ -25,20 +27,25 @@
 #endif
 #ifdef __linux
 #include <unistd.h>
+#include <sys/select.h>
 #endif
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 
 const char* PROGRAM_NAME = "ref_wait";
 const char* szCommDevice = NULL;
 WORD wFindProtos = 0;
 BOOL fFindOnce = FALSE;
+BOOL fWatch = FALSE;
+WORD wLpcdTimeout = 0;
 
 static BOOL parse_args(int argc, char** argv);
 static void usage(void);
+static SWORD watch_events(void);
 
 int main(int argc, char** argv)
 {
@@ -101,6 +108,12 @@ int main(int argc, char** argv)
 
 	printf("\nWaiting for cards... (Press <Ctrl>+C to exit)\n\n");
 
+	if (fWatch)
+	{
+		rc = watch_events();
+		goto close;
+	}
+
 	for (;;)
 	{
 		uid_len = sizeof(uid);
@@ -189,6 +202,96 @@ done:
 	return EXIT_SUCCESS;
 }
 
+/*
+ * Let the library poll the reader, and sleep until it tells us something.
+ * The timestamps show when the library has seen the event, the delay shows
+ * how long it took to wake us up. The CPU time used by the whole process is
+ * given at the end.
+ */
+static SWORD watch_events(void)
+{
+	SPROX_WATCH_EVENT_ST event;
+	SWORD rc;
+	int i;
+#ifdef WIN32
+	HANDLE handle;
+#else
+	int fd;
+	fd_set fds;
+#endif
+
+	SPROX_WATCH_PROFILE_ST profile;
+	SPROX_WATCH_STATS_ST stats;
+
+	memset(&profile, 0, sizeof(profile));
+	profile.lpcd_timeout_s = wLpcdTimeout;
+	profile.burst_interval_ms = 50;
+	profile.burst_polls = 10;
+	profile.present_interval_ms = 250;
+
+	rc = SPROX_WatchStartEx(wFindProtos, &profile, NULL, NULL);
+	if (rc != MI_OK)
+		return rc;
+
+#ifdef WIN32
+	SPROX_WatchGetHandle(&handle);
+#else
+	SPROX_WatchGetFd(&fd);
+#endif
+
+	for (;;)
+	{
+#ifdef WIN32
+		if (WaitForSingleObject(handle, 100) != WAIT_OBJECT_0)
+		{
+			if (_kbhit())
+				break;
+			continue;
+		}
+#else
+		FD_ZERO(&fds);
+		FD_SET(fd, &fds);
+		if (select(fd + 1, &fds, NULL, NULL, NULL) < 0)
+			break;
+#endif
+
+		while (SPROX_WatchRead(&event) == MI_OK)
+		{
+			printf("[%lu.%06lu] ", (unsigned long)event.time_s, (unsigned long)event.time_us);
+
+			if (event.event == SPROX_WATCH_ERROR)
+			{
+				printf("Reader error: %s (%d)\n", SPROX_GetErrorMessageA(event.rc), event.rc);
+				continue;
+			}
+
+			printf((event.event == SPROX_WATCH_ARRIVAL) ? "Arrival " : "Removal ");
+			printf("proto=%04X UID=", event.proto);
+			for (i = 0; i < event.uidlen; i++)
+				printf("%02X", event.uid[i]);
+			printf("\n");
+
+			if ((event.event == SPROX_WATCH_REMOVAL) && fFindOnce)
+				goto stop;
+		}
+	}
+
+stop:
+	if (SPROX_WatchGetStats(&stats) == MI_OK)
+	{
+		printf("Cards detected: %lu", (unsigned long)stats.arrivals);
+		if (stats.arrivals)
+			printf(", time to detect: avg %lums, max %lums", (unsigned long)(stats.detect_ms_total / stats.arrivals), (unsigned long)stats.detect_ms_max);
+		printf("\n");
+		printf("Host polls: %lu, RF on: %lums, low-power detection: %lums (%lu wake-ups), over %lums\n",
+			(unsigned long)stats.polls, (unsigned long)stats.rf_on_ms, (unsigned long)stats.lpcd_ms,
+			(unsigned long)stats.lpcd_wakeups, (unsigned long)stats.elapsed_ms);
+	}
+	SPROX_WatchStop();
+	printf("Host CPU time: %.3fs\n", (double)clock() / CLOCKS_PER_SEC);
+	return MI_OK;
+}
+
 void usage(void)
 {
 	printf("usage: %s [PROTOCOLS] [OPTIONS] [-d <COMM. DEVICE>]\n", PROGRAM_NAME);
@@ -205,6 +308,8 @@ void usage(void)
 	printf("If PROTOCOLS is empty, all protocols are tried (same as -*)\n");
 	printf("OPTIONS:");
 	printf(" -1 : run only once (exit when first card is found)\n");
+	printf(" -e : let the library watch the reader and report the events (with -1, exit when the first card leaves)\n");
+	printf(" -L <SECONDS> : with -e, use low-power card detection while idle, for that long at once\n");
 	printf(" -v : verbose (trace library functions)\n");
 	printf("If the name of COMM DEVICE is not specified, default is taken from Registry or from /etc/springprox.cfg\n");
 }
@@ -265,6 +370,15 @@ static BOOL parse_args(int argc, char** argv)
 			{
 				fFindOnce = TRUE;
 			}
+			else if (!strcmp(argv[i], "-e"))
+			{
+				fWatch = TRUE;
+			}
+			else if (!strcmp(argv[i], "-L") && i + 1 < argc)
+			{
+				wLpcdTimeout = (WORD) atoi(argv[i + 1]);
+				i++;
+			}
 			else if (!strcmp(argv[i], "-h"))
 			{
 				/* Return FALSE to display the usage message */
@@ -0,0 +1,265 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  ftdi_mock.c
+  -----------
+
+  libftdi without USB, for test_ftdi : two chips (serial numbers "A" and
+  "B", 0403:6001) with a reader behind each one (see sprox_fake.c). The
+  reader answers FTDI_MOCK_LATENCY_MS after the request ; meanwhile, the
+  thread that waits sleeps in libusb_handle_events_timeout_completed as it
+  would with the real library.
+
+  AGT 19/10/2026 : created
+*/
+#include "mock/ftdi.h"
+#include "sprox_fake.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct libusb_context
+{
+	struct ftdi_transfer_control* pending;   /* The read transfer, if any */
+};
+
+struct ftdi_mock_device
+{
+	int         opened;
+	BYTE        request[FAKE_FRAME_MAX];
+	WORD        request_length;
+	BYTE        answer[4 * FAKE_FRAME_MAX];
+	WORD        answer_length;
+	DWORD       answer_ms;          /* When the reader has answered */
+};
+
+static struct ftdi_mock_device devices[2];
+static pthread_mutex_t devices_lock = PTHREAD_MUTEX_INITIALIZER;
+
+volatile int FtdiMockContexts = 0;
+volatile int FtdiMockWaiting = 0;
+volatile int FtdiMockWaitingMax = 0;
+
+static DWORD mock_ms(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (DWORD)(t.tv_sec * 1000 + t.tv_nsec / 1000000);
+}
+
+struct ftdi_context* ftdi_new(void)
+{
+	struct ftdi_context* ftdi = calloc(1, sizeof(*ftdi));
+
+	if (ftdi == NULL)
+		return NULL;
+	ftdi->usb_ctx = calloc(1, sizeof(*ftdi->usb_ctx));
+	__sync_fetch_and_add(&FtdiMockContexts, 1);
+	return ftdi;
+}
+
+void ftdi_free(struct ftdi_context* ftdi)
+{
+	if (ftdi == NULL)
+		return;
+	free(ftdi->usb_ctx);
+	free(ftdi);
+}
+
+int ftdi_usb_open_desc(struct ftdi_context* ftdi, int vendor, int product, const char* description, const char* serial)
+{
+	static const char* serials[] = { "A", "B" };
+	size_t i;
+	int rc = -3; /* usb device not found */
+
+	(void) description;
+	if ((vendor != 0x0403) || (product != 0x6001))
+		return rc;
+
+	pthread_mutex_lock(&devices_lock);
+	for (i = 0; i < sizeof(devices) / sizeof(devices[0]); i++)
+	{
+		if (devices[i].opened)
+			continue;
+		if ((serial != NULL) && strcmp(serial, serials[i]))
+			continue;
+		devices[i].opened = 1;
+		devices[i].request_length = 0;
+		devices[i].answer_length = 0;
+		ftdi->mock_device = &devices[i];
+		rc = 0;
+		break;
+	}
+	pthread_mutex_unlock(&devices_lock);
+	return rc;
+}
+
+int ftdi_usb_close(struct ftdi_context* ftdi)
+{
+	pthread_mutex_lock(&devices_lock);
+	if (ftdi->mock_device != NULL)
+		ftdi->mock_device->opened = 0;
+	ftdi->mock_device = NULL;
+	pthread_mutex_unlock(&devices_lock);
+	return 0;
+}
+
+const char* ftdi_get_error_string(struct ftdi_context* ftdi)
+{
+	(void) ftdi;
+	return "mock";
+}
+
+const char* libusb_error_name(int errcode)
+{
+	(void) errcode;
+	return "mock";
+}
+
+int ftdi_set_baudrate(struct ftdi_context* ftdi, int baudrate)
+{
+	(void) ftdi;
+	(void) baudrate;
+	return 0;
+}
+
+int ftdi_set_line_property(struct ftdi_context* ftdi, enum ftdi_bits_type bits, enum ftdi_stopbits_type sbit, enum ftdi_parity_type parity)
+{
+	(void) ftdi;
+	(void) bits;
+	(void) sbit;
+	(void) parity;
+	return 0;
+}
+
+int ftdi_setflowctrl(struct ftdi_context* ftdi, int flowctrl)
+{
+	(void) ftdi;
+	(void) flowctrl;
+	return 0;
+}
+
+static struct ftdi_transfer_control* mock_transfer(struct ftdi_context* ftdi, unsigned char* buf, int size)
+{
+	struct ftdi_transfer_control* tc = calloc(1, sizeof(*tc));
+
+	if (tc == NULL)
+		return NULL;
+	tc->transfer = calloc(1, sizeof(*tc->transfer));
+	tc->ftdi = ftdi;
+	tc->buf = buf;
+	tc->size = size;
+	return tc;
+}
+
+/* The reader gets the bytes, and answers the complete requests */
+struct ftdi_transfer_control* ftdi_write_data_submit(struct ftdi_context* ftdi, unsigned char* buf, int size)
+{
+	struct ftdi_mock_device* device = ftdi->mock_device;
+	struct ftdi_transfer_control* tc;
+	BYTE sequence, command;
+	const BYTE* data;
+	WORD data_length, used;
+
+	if ((device == NULL) || (device->request_length + size > (int) sizeof(device->request)))
+		return NULL;
+	tc = mock_transfer(ftdi, buf, size);
+	if (tc == NULL)
+		return NULL;
+
+	memcpy(&device->request[device->request_length], buf, size);
+	device->request_length += size;
+
+	while ((used = FakeReaderRequest(device->request, device->request_length, &sequence, &command, &data, &data_length)) != 0)
+	{
+		if (device->answer_length + FAKE_FRAME_MAX <= (int) sizeof(device->answer))
+			device->answer_length += FakeReaderAnswer(sequence, command, data, data_length, &device->answer[device->answer_length]);
+		device->answer_ms = mock_ms() + FTDI_MOCK_LATENCY_MS;
+		memmove(device->request, &device->request[used], device->request_length - used);
+		device->request_length -= used;
+	}
+
+	tc->offset = size;
+	tc->completed = 1;
+	return tc;
+}
+
+struct ftdi_transfer_control* ftdi_read_data_submit(struct ftdi_context* ftdi, unsigned char* buf, int size)
+{
+	if (ftdi->mock_device == NULL)
+		return NULL;
+	ftdi->usb_ctx->pending = mock_transfer(ftdi, buf, size);
+	return ftdi->usb_ctx->pending;
+}
+
+/* The read transfer completes once the reader has answered enough bytes */
+static int mock_read_done(struct ftdi_transfer_control* tc)
+{
+	struct ftdi_mock_device* device = tc->ftdi->mock_device;
+
+	if ((device->answer_length < tc->size) || ((int)(mock_ms() - device->answer_ms) < 0))
+		return 0;
+
+	memcpy(tc->buf, device->answer, tc->size);
+	memmove(device->answer, &device->answer[tc->size], device->answer_length - tc->size);
+	device->answer_length -= tc->size;
+	tc->offset = tc->size;
+	tc->transfer->status = LIBUSB_TRANSFER_COMPLETED;
+	return 1;
+}
+
+int libusb_handle_events_timeout_completed(libusb_context* ctx, struct timeval* tv, int* completed)
+{
+	struct ftdi_transfer_control* tc = ctx->pending;
+	DWORD deadline_ms = mock_ms() + tv->tv_sec * 1000 + tv->tv_usec / 1000;
+	struct timespec step = { 0, 1000000 };
+	int waiting, max;
+
+	if ((tc == NULL) || (completed != &tc->completed))
+		return -2; /* LIBUSB_ERROR_INVALID_PARAM : no transfer of this context */
+
+	waiting = __sync_add_and_fetch(&FtdiMockWaiting, 1);
+	while ((max = FtdiMockWaitingMax) < waiting)
+		__sync_bool_compare_and_swap(&FtdiMockWaitingMax, max, waiting);
+
+	while (!*completed)
+	{
+		if (mock_read_done(tc))
+		{
+			*completed = 1;
+			break;
+		}
+		if ((int)(mock_ms() - deadline_ms) >= 0)
+			break;
+		nanosleep(&step, NULL);
+	}
+
+	__sync_sub_and_fetch(&FtdiMockWaiting, 1);
+	return 0;
+}
+
+int ftdi_transfer_data_done(struct ftdi_transfer_control* tc)
+{
+	int offset = tc->offset;
+
+	if (tc->ftdi->usb_ctx->pending == tc)
+		tc->ftdi->usb_ctx->pending = NULL;
+	free(tc->transfer);
+	free(tc);
+	return offset;
+}
+
+void ftdi_transfer_data_cancel(struct ftdi_transfer_control* tc, struct timeval* to)
+{
+	(void) to;
+	if (tc->ftdi->usb_ctx->pending == tc)
+		tc->ftdi->usb_ctx->pending = NULL;
+	free(tc->transfer);
+	free(tc);
+}
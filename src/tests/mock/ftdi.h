@@ -0,0 +1,98 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  mock/ftdi.h
+  -----------
+
+  The part of libftdi (>= 1.5) and libusb-1.0 that sprox_ftdi_linux.c uses,
+  with the same names and prototypes, for test_ftdi : the functions are in
+  ftdi_mock.c, and the "USB" readers behind them in sprox_fake.c.
+
+  AGT 19/10/2026 : created
+*/
+#ifndef __FTDI_MOCK_H__
+#define __FTDI_MOCK_H__
+
+#include <sys/time.h>
+
+/* libusb */
+/* ------ */
+
+enum libusb_transfer_status
+{
+	LIBUSB_TRANSFER_COMPLETED,
+	LIBUSB_TRANSFER_ERROR,
+	LIBUSB_TRANSFER_TIMED_OUT,
+	LIBUSB_TRANSFER_CANCELLED,
+	LIBUSB_TRANSFER_STALL,
+	LIBUSB_TRANSFER_NO_DEVICE,
+	LIBUSB_TRANSFER_OVERFLOW
+};
+
+#define LIBUSB_ERROR_INTERRUPTED (-10)
+
+typedef struct libusb_context libusb_context;
+
+struct libusb_transfer
+{
+	enum libusb_transfer_status status;
+};
+
+int libusb_handle_events_timeout_completed(libusb_context* ctx, struct timeval* tv, int* completed);
+const char* libusb_error_name(int errcode);
+
+/* libftdi */
+/* ------- */
+
+enum ftdi_bits_type { BITS_7 = 7, BITS_8 = 8 };
+enum ftdi_stopbits_type { STOP_BIT_1 = 0, STOP_BIT_15 = 1, STOP_BIT_2 = 2 };
+enum ftdi_parity_type { NONE = 0, ODD = 1, EVEN = 2, MARK = 3, SPACE = 4 };
+
+#define SIO_DISABLE_FLOW_CTRL 0x0
+
+struct ftdi_mock_device;
+
+struct ftdi_context
+{
+	struct libusb_context* usb_ctx;
+	int usb_read_timeout;
+	int usb_write_timeout;
+	struct ftdi_mock_device* mock_device;
+};
+
+struct ftdi_transfer_control
+{
+	int completed;
+	unsigned char* buf;
+	int size;
+	int offset;
+	struct ftdi_context* ftdi;
+	struct libusb_transfer* transfer;
+};
+
+struct ftdi_context* ftdi_new(void);
+void ftdi_free(struct ftdi_context* ftdi);
+int ftdi_usb_open_desc(struct ftdi_context* ftdi, int vendor, int product, const char* description, const char* serial);
+int ftdi_usb_close(struct ftdi_context* ftdi);
+const char* ftdi_get_error_string(struct ftdi_context* ftdi);
+int ftdi_set_baudrate(struct ftdi_context* ftdi, int baudrate);
+int ftdi_set_line_property(struct ftdi_context* ftdi, enum ftdi_bits_type bits, enum ftdi_stopbits_type sbit, enum ftdi_parity_type parity);
+int ftdi_setflowctrl(struct ftdi_context* ftdi, int flowctrl);
+struct ftdi_transfer_control* ftdi_write_data_submit(struct ftdi_context* ftdi, unsigned char* buf, int size);
+struct ftdi_transfer_control* ftdi_read_data_submit(struct ftdi_context* ftdi, unsigned char* buf, int size);
+int ftdi_transfer_data_done(struct ftdi_transfer_control* tc);
+void ftdi_transfer_data_cancel(struct ftdi_transfer_control* tc, struct timeval* to);
+
+/* For the test */
+/* ------------ */
+
+#define FTDI_MOCK_LATENCY_MS  10   /* Time the reader takes to answer */
+
+extern volatile int FtdiMockContexts;     /* ftdi_new calls */
+extern volatile int FtdiMockWaiting;      /* Threads waiting for an answer now */
+extern volatile int FtdiMockWaitingMax;   /* ... at most */
+
+#endif
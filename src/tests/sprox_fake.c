@@ -0,0 +1,281 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  sprox_fake.c
+  ------------
+
+  A reader that speaks the binary protocol on a pseudo-terminal, for the
+  tests. The library opens FakeReader.Link, a symbolic link to the slave
+  side ; unplugging closes the master side (the library gets a hang-up),
+  plugging again creates a new pseudo-terminal behind the same link.
+
+  AGT 19/10/2026 : created
+*/
+#define _GNU_SOURCE
+#include "sprox_fake.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define FAKE_SOH            0x16
+#define FAKE_CMD_GET_INFOS  0x4F
+#define FAKE_CMD_GET_FEAT   0x50
+#define FAKE_CMD_ECHO       0x7F
+#define FAKE_ST_UNKNOWN     100
+
+static BOOL FakePlug(SPROX_FAKE_ST* fake)
+{
+	struct termios tio;
+	const char* name;
+
+	fake->Master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (fake->Master < 0)
+		return FALSE;
+	if ((grantpt(fake->Master) < 0) || (unlockpt(fake->Master) < 0) || ((name = ptsname(fake->Master)) == NULL))
+		goto failed;
+
+	/* Keep the slave side open, raw, so the master never sees a hang-up */
+	fake->Slave = open(name, O_RDWR | O_NOCTTY);
+	if (fake->Slave < 0)
+		goto failed;
+	tcgetattr(fake->Slave, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(fake->Slave, TCSANOW, &tio);
+
+	unlink(fake->Link);
+	if (symlink(name, fake->Link) < 0)
+	{
+		close(fake->Slave);
+		goto failed;
+	}
+
+	fake->Plugs++;
+	return TRUE;
+
+failed:
+	close(fake->Master);
+	fake->Master = -1;
+	return FALSE;
+}
+
+static void FakeUnplug(SPROX_FAKE_ST* fake)
+{
+	unlink(fake->Link);
+	close(fake->Master);
+	close(fake->Slave);
+	fake->Master = -1;
+	fake->Slave = -1;
+}
+
+/*
+ * One complete request at the beginning of buffer ? Returns its size, 0 if
+ * it is not complete yet
+ */
+WORD FakeReaderRequest(const BYTE buffer[], WORD length, BYTE* sequence, BYTE* command, const BYTE** data, WORD* data_length)
+{
+	WORD p = 3, l = 0;
+
+	if ((length < 4) || (buffer[0] != FAKE_SOH))
+		return 0;
+	while ((p < length) && (buffer[p] >= 0x80))
+		l += buffer[p++];
+	if (p >= length)
+		return 0;
+	l += buffer[p++];
+	if (length < p + l + 1)
+		return 0;
+
+	*sequence = buffer[1];
+	*command = buffer[2];
+	*data = &buffer[p];
+	*data_length = l;
+	return p + l + 1;
+}
+
+/*
+ * The answer frame of the reader to a request (GET_INFOS, GET_FEATURES and
+ * ECHO are known, the other commands get "unknown function")
+ * Returns the size of the frame
+ */
+WORD FakeReaderAnswer(BYTE sequence, BYTE command, const BYTE data[], WORD data_length, BYTE frame[])
+{
+	const BYTE infos[16] = { 'K', '6', '6', '3', 0x02, 0x10, 0x01 };
+	const BYTE features[4] = { 0x00, 0x0C, 0x42, 0x01 };
+	BYTE status = 0;
+	WORD l = 0, i;
+	BYTE crc = 0;
+
+	switch (command)
+	{
+	case FAKE_CMD_GET_INFOS:
+		data = infos;
+		data_length = sizeof(infos);
+		break;
+	case FAKE_CMD_GET_FEAT:
+		data = features;
+		data_length = sizeof(features);
+		break;
+	case FAKE_CMD_ECHO:
+		break;
+	default:
+		status = FAKE_ST_UNKNOWN;
+		data_length = 0;
+		break;
+	}
+
+	frame[l++] = FAKE_SOH;
+	frame[l++] = sequence;
+	frame[l++] = status;
+	for (i = data_length; i >= 0x80; i -= 0x80)
+		frame[l++] = 0x80;
+	frame[l++] = (BYTE) i;
+	memcpy(&frame[l], data, data_length);
+	l += data_length;
+	for (i = 1; i < l; i++)
+		crc ^= frame[i];
+	frame[l++] = crc;
+
+	return l;
+}
+
+/* One complete frame in buffer ? Returns its size, 0 if it is not complete yet */
+static WORD FakeFrame(SPROX_FAKE_ST* fake, const BYTE buffer[], WORD length)
+{
+	BYTE sequence, command;
+	const BYTE* data;
+	WORD data_length, used, l;
+	BYTE frame[FAKE_FRAME_MAX];
+
+	used = FakeReaderRequest(buffer, length, &sequence, &command, &data, &data_length);
+	if (!used)
+		return 0;
+
+	fake->Counts[command]++;
+
+	if (command == fake->DropCommand)
+	{
+		/* Unplugged while the command runs : no answer */
+		fake->DropCommand = 0;
+		FakeUnplug(fake);
+		usleep(50000);
+		FakePlug(fake);
+		return length;
+	}
+
+	if ((command == fake->SlowCommand) && fake->SlowMs)
+	{
+		/* A command of our own, that takes time and succeeds */
+		usleep(fake->SlowMs * 1000);
+		l = FakeReaderAnswer(sequence, FAKE_CMD_ECHO, NULL, 0, frame);
+	}
+	else
+	{
+		l = FakeReaderAnswer(sequence, command, data, data_length, frame);
+	}
+
+	if (write(fake->Master, frame, l) != l)
+		perror("fake: write");
+
+	return used;
+}
+
+static void* FakeThread(void* param)
+{
+	SPROX_FAKE_ST* fake = param;
+	BYTE buffer[1024];
+	WORD length = 0;
+
+	while (!fake->Stop)
+	{
+		struct pollfd pfd;
+		int done;
+
+		if (fake->UnplugMs)
+		{
+			FakeUnplug(fake);
+			usleep(fake->UnplugMs * 1000);
+			FakePlug(fake);
+			fake->UnplugMs = 0;
+			length = 0;
+			continue;
+		}
+
+		pfd.fd = fake->Master;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, 20) <= 0)
+			continue;
+
+		done = read(fake->Master, &buffer[length], sizeof(buffer) - length);
+		if (done <= 0)
+		{
+			usleep(10000);
+			continue;
+		}
+		length += done;
+
+		for (;;)
+		{
+			WORD start = 0, used;
+
+			while ((start < length) && (buffer[start] != FAKE_SOH))
+				start++;
+			memmove(buffer, &buffer[start], length - start);
+			length -= start;
+
+			used = FakeFrame(fake, buffer, length);
+			if (!used)
+				break;
+			if (used >= length)
+			{
+				length = 0;
+				break;
+			}
+			memmove(buffer, &buffer[used], length - used);
+			length -= used;
+		}
+	}
+
+	FakeUnplug(fake);
+	return NULL;
+}
+
+BOOL FakeReaderStart(SPROX_FAKE_ST* fake, const char* link)
+{
+	memset(fake, 0, sizeof(*fake));
+	snprintf(fake->Link, sizeof(fake->Link), "%s", link);
+	fake->Master = -1;
+	fake->Slave = -1;
+
+	if (!FakePlug(fake))
+		return FALSE;
+	if (pthread_create(&fake->Thread, NULL, FakeThread, fake) != 0)
+	{
+		FakeUnplug(fake);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+void FakeReaderStop(SPROX_FAKE_ST* fake)
+{
+	fake->Stop = TRUE;
+	pthread_join(fake->Thread, NULL);
+}
+
+void FakeReaderUnplug(SPROX_FAKE_ST* fake, DWORD away_ms)
+{
+	DWORD plugs = fake->Plugs;
+
+	fake->UnplugMs = away_ms ? away_ms : 1;
+	while (fake->Plugs == plugs)
+		usleep(1000);
+}
@@ -0,0 +1,50 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  sprox_fake.h
+  ------------
+
+  A reader that speaks the binary protocol on a pseudo-terminal, for the
+  tests : it answers GET_INFOS, GET_FEATURES and ECHO, counts the commands
+  it receives, and can be unplugged and plugged again.
+
+  AGT 19/10/2026 : created
+*/
+#ifndef __SPROX_FAKE_H__
+#define __SPROX_FAKE_H__
+
+#include "products/springprox/api/springprox.h"
+
+#include <pthread.h>
+
+typedef struct
+{
+	char          Link[64];            /* The name the library opens, a link to the slave side */
+	int           Master;
+	int           Slave;
+	pthread_t     Thread;
+	volatile BOOL Stop;
+
+	volatile DWORD Counts[256];        /* Commands received, by command code */
+	volatile DWORD Plugs;              /* Times the device has appeared */
+
+	BYTE          DropCommand;         /* Hang up instead of answering this command (once) */
+	BYTE          SlowCommand;         /* Answer this command after SlowMs */
+	DWORD         SlowMs;
+	volatile DWORD UnplugMs;           /* Set by FakeReaderUnplug */
+
+} SPROX_FAKE_ST;
+
+/* The frames of the binary protocol, without the pseudo-terminal */
+#define FAKE_FRAME_MAX  (8 + 2 * 256)
+WORD FakeReaderRequest(const BYTE buffer[], WORD length, BYTE* sequence, BYTE* command, const BYTE** data, WORD* data_length);
+WORD FakeReaderAnswer(BYTE sequence, BYTE command, const BYTE data[], WORD data_length, BYTE frame[]);
+
+BOOL FakeReaderStart(SPROX_FAKE_ST* fake, const char* link);
+void FakeReaderStop(SPROX_FAKE_ST* fake);
+void FakeReaderUnplug(SPROX_FAKE_ST* fake, DWORD away_ms);
+
+#endif
@@ -0,0 +1,195 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  sprox_fake_tcp.c
+  ----------------
+
+  A reader that speaks the TCP C/S protocol on a local socket, for the
+  tests. One connection at a time, one request after the other.
+
+  AGT 19/10/2026 : created
+*/
+#include "sprox_fake_tcp.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#define RDR_TO_PC_LEGACY    0x28
+#define PC_TO_RDR_LEGACY    0x29
+
+#define FAKE_CMD_GET_INFOS  0x4F
+#define FAKE_CMD_GET_FEAT   0x50
+#define FAKE_CMD_ECHO       0x7F
+#define FAKE_ST_UNKNOWN     100
+
+/*
+ * Close with a RST, as a reader that restarts
+ */
+static void FakeTcpReset(int sk)
+{
+	struct linger l;
+
+	l.l_onoff = 1;
+	l.l_linger = 0;
+	setsockopt(sk, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+	close(sk);
+}
+
+static BOOL FakeTcpAnswer(int sk, const BYTE request[], WORD length)
+{
+	static BYTE frame[5 + 65535];
+	const BYTE infos[16] = { 'K', '6', '6', '3', 0x02, 0x10, 0x01 };
+	const BYTE features[4] = { 0x00, 0x0C, 0x42, 0x01 };
+	const BYTE* data = &request[5];
+	BYTE status = 0;
+
+	switch (request[2])
+	{
+	case FAKE_CMD_GET_INFOS:
+		data = infos;
+		length = sizeof(infos);
+		break;
+	case FAKE_CMD_GET_FEAT:
+		data = features;
+		length = sizeof(features);
+		break;
+	case FAKE_CMD_ECHO:
+		break;
+	default:
+		status = (BYTE)(0 - FAKE_ST_UNKNOWN);
+		length = 0;
+		break;
+	}
+
+	frame[0] = RDR_TO_PC_LEGACY;
+	frame[1] = request[1];
+	frame[2] = status;
+	frame[3] = (BYTE)(length / 0x0100);
+	frame[4] = (BYTE)(length % 0x0100);
+	memcpy(&frame[5], data, length);
+
+	return send(sk, frame, 5 + length, MSG_NOSIGNAL) == (ssize_t)(5 + length);
+}
+
+/*
+ * Serve one connection at a time, one request after the other
+ */
+static void* FakeTcpThread(void* param)
+{
+	SPROX_FAKE_TCP_ST* fake = (SPROX_FAKE_TCP_ST*) param;
+	static BYTE buffer[5 + 65535];
+	struct pollfd pfd;
+	DWORD got = 0, wanted;
+	int sk = -1;
+	ssize_t done;
+
+	while (!fake->Stop)
+	{
+		if ((sk >= 0) && fake->ResetNow)
+		{
+			FakeTcpReset(sk);
+			sk = -1;
+			fake->ResetNow = FALSE;
+		}
+
+		pfd.fd = (sk >= 0) ? sk : fake->Listen;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, 10) <= 0)
+			continue;
+
+		if (sk < 0)
+		{
+			sk = accept(fake->Listen, NULL, NULL);
+			if (sk >= 0)
+				fake->Connections++;
+			got = 0;
+			continue;
+		}
+
+		wanted = (got < 5) ? 5 : 5 + buffer[3] * 0x0100 + buffer[4];
+		done = recv(sk, &buffer[got], wanted - got, 0);
+		if (done <= 0)
+		{
+			close(sk);
+			sk = -1;
+			continue;
+		}
+		got += (DWORD) done;
+		if ((got < 5) || (got < (DWORD)(5 + buffer[3] * 0x0100 + buffer[4])))
+			continue;
+
+		got = 0;
+		if (buffer[0] != PC_TO_RDR_LEGACY)
+			continue;
+		fake->Counts[buffer[2]]++;
+
+		if (fake->DropCommand && (buffer[2] == fake->DropCommand))
+		{
+			fake->DropCommand = 0;
+			FakeTcpReset(sk);
+			sk = -1;
+			continue;
+		}
+
+		if (!FakeTcpAnswer(sk, buffer, (WORD)(buffer[3] * 0x0100 + buffer[4])))
+		{
+			close(sk);
+			sk = -1;
+		}
+	}
+
+	if (sk >= 0)
+		close(sk);
+	return NULL;
+}
+
+int FakeTcpListen(int backlog, WORD* port)
+{
+	struct sockaddr_in sa;
+	socklen_t sa_len = sizeof(sa);
+	int sk;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	sk = socket(AF_INET, SOCK_STREAM, 0);
+	if (sk < 0)
+		return -1;
+	if ((bind(sk, (struct sockaddr*)&sa, sizeof(sa)) < 0) || (listen(sk, backlog) < 0) || (getsockname(sk, (struct sockaddr*)&sa, &sa_len) < 0))
+	{
+		close(sk);
+		return -1;
+	}
+
+	*port = ntohs(sa.sin_port);
+	return sk;
+}
+
+BOOL FakeTcpStart(SPROX_FAKE_TCP_ST* fake)
+{
+	memset(fake, 0, sizeof(*fake));
+	fake->Listen = FakeTcpListen(4, &fake->Port);
+	if (fake->Listen < 0)
+		return FALSE;
+	if (pthread_create(&fake->Thread, NULL, FakeTcpThread, fake) != 0)
+	{
+		close(fake->Listen);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+void FakeTcpStop(SPROX_FAKE_TCP_ST* fake)
+{
+	fake->Stop = TRUE;
+	pthread_join(fake->Thread, NULL);
+	close(fake->Listen);
+}
@@ -0,0 +1,45 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  sprox_fake_tcp.h
+  ----------------
+
+  A reader that speaks the TCP C/S protocol on a local socket, for the
+  tests : it answers GET_INFOS, GET_FEATURES and ECHO, counts the commands
+  and the connections, and can reset the connection as a reader that
+  restarts.
+
+  AGT 19/10/2026 : created
+*/
+#ifndef __SPROX_FAKE_TCP_H__
+#define __SPROX_FAKE_TCP_H__
+
+#include "products/springprox/api/springprox.h"
+
+#include <pthread.h>
+
+typedef struct
+{
+	int            Listen;
+	WORD           Port;
+	pthread_t      Thread;
+	volatile BOOL  Stop;
+
+	volatile DWORD Counts[256];        /* Commands received, by command code */
+	volatile DWORD Connections;
+
+	volatile BYTE  DropCommand;        /* Reset the connection instead of answering this command (once) */
+	volatile BOOL  ResetNow;           /* Reset the connection now, cleared once done */
+
+} SPROX_FAKE_TCP_ST;
+
+BOOL FakeTcpStart(SPROX_FAKE_TCP_ST* fake);
+void FakeTcpStop(SPROX_FAKE_TCP_ST* fake);
+
+/* A listening socket on the loopback, its port in *port */
+int  FakeTcpListen(int backlog, WORD* port);
+
+#endif
@@ -0,0 +1,123 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  test_ftdi.c
+  -----------
+
+  sprox_ftdi_linux.c against a mock of libftdi (see ftdi_mock.c) : two
+  readers are opened and used at the same time, by two threads, each one
+  with its own libftdi context ; they wait for their answers together, and
+  no timer nor SIGALRM is involved.
+
+  AGT 19/10/2026 : created
+*/
+#include "products/springprox/api/springprox.h"
+#include "products/springprox/api/springprox_ex.h"
+#include "mock/ftdi.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_EXCHANGES  20
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: FAILED: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/* The library must not arm a timer : the calls are counted here instead of reaching the C library */
+static volatile int timers_armed = 0;
+static volatile int alarms_received = 0;
+
+int setitimer(int which, const struct itimerval* new_value, struct itimerval* old_value)
+{
+	(void) which;
+	(void) new_value;
+	(void) old_value;
+	timers_armed++;
+	return 0;
+}
+
+unsigned int alarm(unsigned int seconds)
+{
+	(void) seconds;
+	timers_armed++;
+	return 0;
+}
+
+static void on_alarm(int sig)
+{
+	(void) sig;
+	alarms_received++;
+}
+
+typedef struct
+{
+	const char* device;
+	SWORD       open_rc;
+	SWORD       echo_rc;
+	int         exchanges;
+} TEST_READER_ST;
+
+static void* reader_thread(void* param)
+{
+	TEST_READER_ST* reader = param;
+	SPROX_INSTANCE instance = SPROXx_CreateInstance();
+
+	reader->open_rc = SPROXx_ReaderOpen(instance, reader->device);
+	if (reader->open_rc == MI_OK)
+	{
+		for (reader->exchanges = 0; reader->exchanges < TEST_EXCHANGES; reader->exchanges++)
+		{
+			reader->echo_rc = SPROXx_Echo(instance, 16);
+			if (reader->echo_rc != MI_OK)
+				break;
+		}
+		SPROXx_ReaderClose(instance);
+	}
+
+	SPROXx_DestroyInstance(instance);
+	return NULL;
+}
+
+int main(void)
+{
+	TEST_READER_ST readers[2];
+	pthread_t threads[2];
+	struct sigaction sa;
+	int i;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_alarm;
+	sigaction(SIGALRM, &sa, NULL);
+
+	memset(readers, 0, sizeof(readers));
+	readers[0].device = "FTDI:0403:6001:A";
+	readers[1].device = "FTDI:0403:6001:B";
+
+	for (i = 0; i < 2; i++)
+		pthread_create(&threads[i], NULL, reader_thread, &readers[i]);
+	for (i = 0; i < 2; i++)
+		pthread_join(threads[i], NULL);
+
+	for (i = 0; i < 2; i++)
+	{
+		CHECK(readers[i].open_rc == MI_OK);
+		CHECK(readers[i].echo_rc == MI_OK);
+		CHECK(readers[i].exchanges == TEST_EXCHANGES);
+	}
+
+	/* One libftdi (and libusb) context per reader, waiting at the same time */
+	CHECK(FtdiMockContexts >= 2);
+	CHECK(FtdiMockWaitingMax == 2);
+
+	CHECK(timers_armed == 0);
+	CHECK(alarms_received == 0);
+
+	printf("test_ftdi: %s\n", failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  test_reconnect.c
+  ----------------
+
+  The reader is unplugged and plugged again (see sprox_fake.c) :
+  - before a command : the command is sent once more, and succeeds,
+  - while a command runs : it is not sent twice, the caller gets
+    MI_SER_NORESP_ERR and the next command succeeds,
+  - signals arriving while the library waits for an answer are not
+    taken for a failure of the device.
+
+  AGT 19/10/2026 : created
+*/
+#include "sprox_fake.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define TEST_COMMAND  0x44
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: FAILED: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static void on_alarm(int sig)
+{
+	(void) sig;
+}
+
+int main(void)
+{
+	SPROX_FAKE_ST fake;
+	char link[64];
+	struct sigaction sa;
+	struct itimerval timer;
+	BYTE recv_buffer[32];
+	WORD recv_length;
+	SWORD rc;
+
+	snprintf(link, sizeof(link), "/tmp/sprox_test_reconnect_%d", (int) getpid());
+	if (!FakeReaderStart(&fake, link))
+	{
+		printf("FAILED: no pseudo-terminal\n");
+		return 1;
+	}
+
+	rc = SPROX_ReaderOpen(link);
+	CHECK(rc == MI_OK);
+	CHECK(SPROX_Echo(8) == MI_OK);
+
+	/* Unplugged and back before the command : sent once more */
+	FakeReaderUnplug(&fake, 50);
+	rc = SPROX_Echo(8);
+	CHECK(rc == MI_OK);
+
+	/* Unplugged while the command runs : not sent twice */
+	fake.DropCommand = TEST_COMMAND;
+	recv_length = sizeof(recv_buffer);
+	rc = SPROX_Function(TEST_COMMAND, NULL, 0, recv_buffer, &recv_length);
+	CHECK(rc == MI_SER_NORESP_ERR);
+	CHECK(fake.Counts[TEST_COMMAND] == 1);
+	CHECK(SPROX_Echo(8) == MI_OK);
+
+	/* A signal every 2ms while the reader takes 200ms to answer */
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_alarm;
+	sigaction(SIGALRM, &sa, NULL);  /* No SA_RESTART : select and read see EINTR */
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = 2000;
+	timer.it_value = timer.it_interval;
+	setitimer(ITIMER_REAL, &timer, NULL);
+
+	fake.SlowCommand = TEST_COMMAND;
+	fake.SlowMs = 200;
+	recv_length = sizeof(recv_buffer);
+	rc = SPROX_Function(TEST_COMMAND, NULL, 0, recv_buffer, &recv_length);
+
+	memset(&timer, 0, sizeof(timer));
+	setitimer(ITIMER_REAL, &timer, NULL);
+
+	CHECK(rc == MI_OK);
+	CHECK(fake.Counts[TEST_COMMAND] == 2);
+	CHECK(fake.Plugs == 3);
+
+	SPROX_ReaderClose();
+	FakeReaderStop(&fake);
+
+	printf("test_reconnect: %s\n", failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,149 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  test_record.c
+  -------------
+
+  Record the traffic with a network reader (see sprox_fake_tcp.c), single
+  functions, random numbers and a pipelined batch, then replay it without
+  the reader ("replay:<file>", in any case) : the application gets the same
+  answers, and an application that doesn't do the same is stopped.
+
+  AGT 19/10/2026 : created
+*/
+#include "sprox_fake_tcp.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FAKE_CMD_ECHO  0x7F
+#define TEST_COMMAND   0x44
+#define BATCH_COUNT    6
+#define EXCHANGES      (2 + BATCH_COUNT)
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: FAILED: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+typedef struct
+{
+	SWORD echo_rc;
+	SWORD unknown_rc;
+	BYTE  rnd[8];
+	SWORD batch_rc;
+	SWORD rc[BATCH_COUNT];
+	WORD  recv_bytelen[BATCH_COUNT];
+	BYTE  recv_buffers[BATCH_COUNT][16];
+} SCENARIO_ST;
+
+/*
+ * What the application does with the reader, recorded then replayed
+ */
+static void scenario(SCENARIO_ST* result, BYTE rnd_seed)
+{
+	SPROX_FUNCTION_ST functions[BATCH_COUNT];
+	BYTE send_buffers[BATCH_COUNT][16];
+	BYTE recv_buffer[16];
+	WORD recv_length;
+	int i;
+
+	memset(result, 0, sizeof(*result));
+
+	result->echo_rc = SPROX_Echo(8);
+
+	recv_length = sizeof(recv_buffer);
+	result->unknown_rc = SPROX_Function(TEST_COMMAND, NULL, 0, recv_buffer, &recv_length);
+
+	/* Drawn by the host when recorded, given back by the recording when replayed */
+	memset(result->rnd, rnd_seed, sizeof(result->rnd));
+	SPROX_RecordRandom(result->rnd, sizeof(result->rnd));
+
+	SPROX_ReaderSetPipeline(4);
+	for (i = 0; i < BATCH_COUNT; i++)
+	{
+		memset(send_buffers[i], 0x10 + i, sizeof(send_buffers[i]));
+		functions[i].cmd = FAKE_CMD_ECHO;
+		functions[i].send_buffer = send_buffers[i];
+		functions[i].send_bytelen = (WORD)(4 + i);
+		functions[i].recv_buffer = result->recv_buffers[i];
+		functions[i].recv_bytelen = sizeof(result->recv_buffers[i]);
+		functions[i].rc = -1;
+	}
+	result->batch_rc = SPROX_FunctionBatch(functions, BATCH_COUNT);
+	for (i = 0; i < BATCH_COUNT; i++)
+	{
+		result->rc[i] = functions[i].rc;
+		result->recv_bytelen[i] = functions[i].recv_bytelen;
+	}
+}
+
+int main(void)
+{
+	SPROX_FAKE_TCP_ST fake;
+	SCENARIO_ST recorded, replayed;
+	char name[64];
+	char filename[64];
+	char replay[80];
+	DWORD exchanges, reader_ms, host_ms, commands;
+	int i;
+
+	if (!FakeTcpStart(&fake))
+	{
+		printf("FAILED: no local socket\n");
+		return 1;
+	}
+
+	snprintf(filename, sizeof(filename), "/tmp/sprox_test_record_%d.rec", (int) getpid());
+	snprintf(replay, sizeof(replay), "replay:%s", filename);
+
+	/* Record */
+	snprintf(name, sizeof(name), "TCP:127.0.0.1:%u", fake.Port);
+	CHECK(SPROX_ReaderOpen(name) == MI_OK);
+	CHECK(SPROX_RecordStart(filename) == MI_OK);
+	scenario(&recorded, 0xA5);
+	CHECK(SPROX_RecordGetStats(&exchanges, &reader_ms, &host_ms) == MI_OK);
+	CHECK(exchanges == EXCHANGES);
+	CHECK(SPROX_RecordStop() == MI_OK);
+	SPROX_ReaderClose();
+
+	CHECK(recorded.echo_rc == MI_OK);
+	CHECK(recorded.unknown_rc != MI_OK);
+	CHECK(recorded.batch_rc == MI_OK);
+	for (i = 0; i < BATCH_COUNT; i++)
+	{
+		CHECK(recorded.rc[i] == MI_OK);
+		CHECK(recorded.recv_bytelen[i] == 4 + i);
+	}
+
+	commands = 0;
+	for (i = 0; i < 256; i++)
+		commands += fake.Counts[i];
+
+	/* Replay : same answers, without the reader */
+	CHECK(SPROX_ReaderOpen(replay) == MI_OK);
+	scenario(&replayed, 0x00);
+	CHECK(SPROX_RecordGetStats(&exchanges, &reader_ms, &host_ms) == MI_OK);
+	CHECK(exchanges == EXCHANGES);
+	CHECK(!memcmp(&replayed, &recorded, sizeof(recorded)));
+	CHECK(SPROX_Echo(8) == MI_SER_NORESP_ERR);
+	SPROX_ReaderClose();
+
+	for (i = 0; i < 256; i++)
+		commands -= fake.Counts[i];
+	CHECK(commands == 0);
+
+	/* Not what has been recorded */
+	CHECK(SPROX_ReaderOpen(replay) == MI_OK);
+	CHECK(SPROX_Echo(4) == MI_SER_PROTO_ERR);
+	SPROX_ReaderClose();
+
+	unlink(filename);
+	FakeTcpStop(&fake);
+
+	printf("test_record: %s\n", failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}
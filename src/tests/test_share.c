@@ -0,0 +1,270 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  test_share.c
+  ------------
+
+  Two clients of the ref_share daemon, in front of a fake reader (see
+  sprox_fake.c) :
+  - two applications exchange at the same time, and are both served,
+  - a client that sends requests but never reads the answers is dropped,
+    and doesn't hold the other one for longer than the daemon's send timeout,
+  - a lock with a very long wait is granted at once when the reader is free,
+    and in turn when it is not.
+
+  AGT 19/10/2026 : created
+*/
+#include "sprox_fake.h"
+#include "products/springprox/api/sprox_share.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#define FAKE_ECHO      0x7F
+#define ECHO_COUNT     50
+#define FLOOD_CHUNK    100       /* Requests in each write of the flooding client */
+#define FLOOD_MAX      1000000
+#define LOCK_HOLD_MS   300
+#define LONG_WAIT      0xFFFFFFF0  /* Longer than SPROX_LOCK_WAIT_MAX */
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: FAILED: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static long elapsed_ms(const struct timespec* t0)
+{
+	struct timespec t1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	return (t1.tv_sec - t0->tv_sec) * 1000 + (t1.tv_nsec - t0->tv_nsec) / 1000000;
+}
+
+static int echoes(void)
+{
+	int i, ok = 0;
+
+	for (i = 0; i < ECHO_COUNT; i++)
+		if (SPROX_Echo(16) == MI_OK)
+			ok++;
+	return ok;
+}
+
+/*
+ * A client that sends requests for the daemon itself, as fast as the daemon
+ * takes them, and never reads an answer. Returns once the daemon has stopped
+ * taking them (stuck on this client, or dropped it)
+ */
+static int flood(const char* socket_path)
+{
+	struct sockaddr_un sa;
+	BYTE chunk[FLOOD_CHUNK * SPROX_SHARE_HEADER_SIZE];
+	struct pollfd pfd;
+	DWORD sent = 0;
+	int sk, i;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family = AF_UNIX;
+	strncpy(sa.sun_path, socket_path, sizeof(sa.sun_path) - 1);
+
+	sk = socket(AF_UNIX, SOCK_STREAM, 0);
+	if ((sk < 0) || (connect(sk, (struct sockaddr*)&sa, sizeof(sa)) < 0))
+		return -1;
+	fcntl(sk, F_SETFL, O_NONBLOCK);
+
+	for (i = 0; i < FLOOD_CHUNK; i++)
+	{
+		chunk[i * SPROX_SHARE_HEADER_SIZE + 0] = SPROX_SHARE_TO_DAEMON;
+		chunk[i * SPROX_SHARE_HEADER_SIZE + 1] = (BYTE) i;
+		chunk[i * SPROX_SHARE_HEADER_SIZE + 2] = SPROX_SHARE_UNLOCK;
+		chunk[i * SPROX_SHARE_HEADER_SIZE + 3] = 0;
+		chunk[i * SPROX_SHARE_HEADER_SIZE + 4] = 0;
+	}
+
+	while (sent < FLOOD_MAX)
+	{
+		if (send(sk, chunk, sizeof(chunk), MSG_NOSIGNAL) == (ssize_t) sizeof(chunk))
+		{
+			sent += FLOOD_CHUNK;
+			continue;
+		}
+		if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+			break;
+		pfd.fd = sk;
+		pfd.events = POLLOUT;
+		if (poll(&pfd, 1, 200) == 0)
+			break;
+	}
+
+	return sk;
+}
+
+/*
+ * The daemon closes the socket of the client it has dropped : drain the answers it took, until the end
+ */
+static BOOL dropped(int sk)
+{
+	BYTE buffer[4096];
+	struct pollfd pfd;
+	ssize_t done;
+
+	for (;;)
+	{
+		pfd.fd = sk;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, 3000) <= 0)
+			return FALSE;
+		done = recv(sk, buffer, sizeof(buffer), 0);
+		if (done == 0)
+			return TRUE;
+		if ((done < 0) && (errno != EAGAIN) && (errno != EINTR))
+			return TRUE;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	SPROX_FAKE_ST fake;
+	char link[64];
+	char socket_path[64];
+	char shared[80];
+	char daemon_path[256];
+	struct timespec t0;
+	const char* slash;
+	pid_t daemon_pid, other_pid;
+	int i, status, flood_sk;
+	int ready[2], go[2];
+	BYTE byte = 0;
+	SWORD rc;
+
+	(void) argc;
+
+	snprintf(link, sizeof(link), "/tmp/sprox_test_share_%d", (int) getpid());
+	snprintf(socket_path, sizeof(socket_path), "/tmp/sprox_test_share_%d.sock", (int) getpid());
+	snprintf(shared, sizeof(shared), "SHARE:%s", socket_path);
+
+	/* The daemon is in the same directory as the test */
+	slash = strrchr(argv[0], '/');
+	snprintf(daemon_path, sizeof(daemon_path), "%.*sref_share", (slash != NULL) ? (int)(slash - argv[0] + 1) : 0, argv[0]);
+
+	if (!FakeReaderStart(&fake, link))
+	{
+		printf("FAILED: no pseudo-terminal\n");
+		return 1;
+	}
+
+	daemon_pid = fork();
+	if (daemon_pid == 0)
+	{
+		if (freopen("/dev/null", "w", stdout) == NULL)
+			_exit(1);
+		execl(daemon_path, daemon_path, "-d", link, "-s", socket_path, (char*) NULL);
+		_exit(1);
+	}
+	CHECK(daemon_pid > 0);
+
+	/* Give the daemon time to open the reader */
+	rc = MI_SER_ACCESS_ERR;
+	for (i = 0; (i < 50) && (rc != MI_OK); i++)
+	{
+		usleep(100000);
+		rc = SPROX_ReaderOpen(shared);
+	}
+	CHECK(rc == MI_OK);
+
+	if (rc == MI_OK)
+	{
+		/* Two applications at the same time */
+		other_pid = fork();
+		if (other_pid == 0)
+		{
+			SPROX_ReaderClose();
+			if (SPROX_ReaderOpen(shared) != MI_OK)
+				_exit(1);
+			status = echoes();
+			SPROX_ReaderClose();
+			_exit((status == ECHO_COUNT) ? 0 : 1);
+		}
+		CHECK(echoes() == ECHO_COUNT);
+		CHECK((waitpid(other_pid, &status, 0) == other_pid) && WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+		CHECK(fake.Counts[FAKE_ECHO] >= 2 * ECHO_COUNT);
+
+		/* A client that doesn't read its answers */
+		flood_sk = flood(socket_path);
+		CHECK(flood_sk >= 0);
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		CHECK(SPROX_Echo(16) == MI_OK);
+		CHECK(elapsed_ms(&t0) < 3000);
+
+		if (flood_sk >= 0)
+		{
+			CHECK(dropped(flood_sk));
+			close(flood_sk);
+		}
+
+		CHECK(SPROX_Echo(16) == MI_OK);
+
+		/* Very long waits for the lock : the other application is connected before the lock is taken */
+		CHECK((pipe(ready) == 0) && (pipe(go) == 0));
+		other_pid = fork();
+		if (other_pid == 0)
+		{
+			BYTE b = 0;
+
+			SPROX_ReaderClose();
+			if (SPROX_ReaderOpen(shared) != MI_OK)
+				_exit(1);
+			if ((write(ready[1], &b, 1) != 1) || (read(go[0], &b, 1) != 1))
+				_exit(1);
+			clock_gettime(CLOCK_MONOTONIC, &t0);
+			if (SPROX_ReaderLock(SPROX_LOCK_WAIT_FOREVER) != MI_OK)
+				_exit(2);
+			if (elapsed_ms(&t0) < LOCK_HOLD_MS / 2)
+				_exit(3);
+			SPROX_ReaderUnlock();
+			SPROX_ReaderClose();
+			_exit(0);
+		}
+		CHECK(read(ready[0], &byte, 1) == 1);
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		CHECK(SPROX_ReaderLock(LONG_WAIT) == MI_OK);
+		CHECK(elapsed_ms(&t0) < 1000);
+		CHECK(write(go[1], &byte, 1) == 1);
+
+		usleep(LOCK_HOLD_MS * 1000);
+		CHECK(SPROX_Echo(16) == MI_OK);
+		CHECK(SPROX_ReaderUnlock() == MI_OK);
+		CHECK((waitpid(other_pid, &status, 0) == other_pid) && WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+		for (i = 0; i < 2; i++)
+		{
+			close(ready[i]);
+			close(go[i]);
+		}
+
+		SPROX_ReaderClose();
+	}
+
+	if (daemon_pid > 0)
+	{
+		kill(daemon_pid, SIGTERM);
+		waitpid(daemon_pid, &status, 0);
+	}
+	unlink(socket_path);
+	FakeReaderStop(&fake);
+
+	printf("test_share: %s\n", failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,145 @@
+/*
+  THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+  ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED
+  TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+  PARTICULAR PURPOSE.
+
+  test_tcp.c
+  ----------
+
+  A reader that speaks the TCP C/S protocol on a local socket (see
+  sprox_fake_tcp.c) stands in for a network reader :
+  - single functions and pipelined batches,
+  - the connection reset while idle : the request couldn't be sent, the
+    library connects again and sends it once,
+  - the connection reset while the reader runs a command : the command is
+    not sent twice, the next function connects again,
+  - a reader that doesn't accept the connection : SPROX_ReaderOpen gives up
+    after its connect timeout, not the system's one.
+
+  AGT 19/10/2026 : created
+*/
+#include "sprox_fake_tcp.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#define FAKE_CMD_ECHO  0x7F
+#define TEST_COMMAND   0x44
+#define BATCH_COUNT    8
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: FAILED: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static long elapsed_ms(const struct timespec* t0)
+{
+	struct timespec t1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	return (t1.tv_sec - t0->tv_sec) * 1000 + (t1.tv_nsec - t0->tv_nsec) / 1000000;
+}
+
+int main(void)
+{
+	SPROX_FAKE_TCP_ST fake;
+	SPROX_FUNCTION_ST functions[BATCH_COUNT];
+	BYTE send_buffers[BATCH_COUNT][16];
+	BYTE recv_buffers[BATCH_COUNT][16];
+	BYTE recv_buffer[32];
+	WORD recv_length;
+	char name[64];
+	struct timespec t0;
+	struct sockaddr_in sa;
+	int stuck, fillers[4];
+	WORD stuck_port;
+	DWORD echoes;
+	SWORD rc;
+	int i;
+
+	if (!FakeTcpStart(&fake))
+	{
+		printf("FAILED: no local socket\n");
+		return 1;
+	}
+
+	snprintf(name, sizeof(name), "TCP:127.0.0.1:%u", fake.Port);
+	rc = SPROX_ReaderOpen(name);
+	CHECK(rc == MI_OK);
+	CHECK(SPROX_Echo(8) == MI_OK);
+	CHECK(fake.Connections == 1);
+
+	/* A batch, 4 requests in flight */
+	CHECK(SPROX_ReaderSetPipeline(4) == MI_OK);
+	for (i = 0; i < BATCH_COUNT; i++)
+	{
+		memset(send_buffers[i], i, sizeof(send_buffers[i]));
+		functions[i].cmd = FAKE_CMD_ECHO;
+		functions[i].send_buffer = send_buffers[i];
+		functions[i].send_bytelen = sizeof(send_buffers[i]);
+		functions[i].recv_buffer = recv_buffers[i];
+		functions[i].recv_bytelen = sizeof(recv_buffers[i]);
+		functions[i].rc = -1;
+	}
+	CHECK(SPROX_FunctionBatch(functions, BATCH_COUNT) == MI_OK);
+	for (i = 0; i < BATCH_COUNT; i++)
+	{
+		CHECK(functions[i].rc == MI_OK);
+		CHECK(!memcmp(recv_buffers[i], send_buffers[i], sizeof(send_buffers[i])));
+	}
+
+	/* Reset while idle : the request can't be sent, it is sent once on a new connection */
+	fake.ResetNow = TRUE;
+	while (fake.ResetNow)
+		usleep(1000);
+	usleep(50000);
+	echoes = fake.Counts[FAKE_CMD_ECHO];
+	CHECK(SPROX_Echo(8) == MI_OK);
+	CHECK(fake.Counts[FAKE_CMD_ECHO] == echoes + 1);
+	CHECK(fake.Connections == 2);
+
+	/* Reset while the reader runs the command : not sent twice */
+	fake.DropCommand = TEST_COMMAND;
+	recv_length = sizeof(recv_buffer);
+	rc = SPROX_Function(TEST_COMMAND, NULL, 0, recv_buffer, &recv_length);
+	CHECK(rc == MI_SER_ACCESS_ERR);
+	CHECK(fake.Counts[TEST_COMMAND] == 1);
+	CHECK(SPROX_Echo(8) == MI_OK);
+	CHECK(fake.Connections == 3);
+
+	SPROX_ReaderClose();
+
+	/* A reader that doesn't accept : its queue is full, the SYNs are dropped */
+	stuck = FakeTcpListen(0, &stuck_port);
+	CHECK(stuck >= 0);
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sa.sin_port = htons(stuck_port);
+	for (i = 0; i < 4; i++)
+	{
+		fillers[i] = socket(AF_INET, SOCK_STREAM, 0);
+		fcntl(fillers[i], F_SETFL, O_NONBLOCK);
+		connect(fillers[i], (struct sockaddr*)&sa, sizeof(sa));
+	}
+
+	snprintf(name, sizeof(name), "TCP:127.0.0.1:%u", stuck_port);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	rc = SPROX_ReaderOpen(name);
+	CHECK(rc != MI_OK);
+	CHECK(elapsed_ms(&t0) < 6000);
+
+	for (i = 0; i < 4; i++)
+		close(fillers[i]);
+	close(stuck);
+	FakeTcpStop(&fake);
+
+	printf("test_tcp: %s\n", failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}